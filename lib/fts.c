@@ -78,6 +78,24 @@ static char sccsid[] = "@(#)fts.c       8.6 (Berkeley) 8/14/94";
 #endif
 
 #include <dirent.h>
+
+/* Whether to read directories with the getdents64 system call.  */
+#if (defined __linux__ && ! defined _LIBC \
+     && defined _DIRENT_MATCHES_DIRENT64 && _DIRENT_MATCHES_DIRENT64)
+# include <sys/syscall.h>
+#endif
+#ifdef SYS_getdents64
+# define FTS_GETDENTS 1
+/* Use the getdents64 function of glibc 2.30 and later rather than the
+   system call itself, so that the function can be interposed, e.g.,
+   by tests that simulate read errors.  */
+# if ! (2 < __GLIBC__ || (2 == __GLIBC__ && 30 <= __GLIBC_MINOR__))
+#  define getdents64(fd, buf, nbytes) syscall (SYS_getdents64, fd, buf, nbytes)
+# endif
+#else
+# define FTS_GETDENTS 0
+#endif
+
 #ifndef _D_EXACT_NAMLEN
 # define _D_EXACT_NAMLEN(dirent) strlen ((dirent)->d_name)
 #endif
@@ -621,6 +639,8 @@ fts_close (FTS *sp)
 
         free_dir (sp);
 
+        free (sp->fts_free_dirstream);
+
         /* Free up the stream pointer. */
         free(sp);
 
@@ -1263,16 +1283,165 @@ set_stat_type (struct stat *st, unsigned int dtype)
   st->st_mode = type;
 }
 
+#if FTS_GETDENTS
+
+/* On GNU/Linux, when struct dirent has the layout of the entries that
+   the getdents64 system call returns, read directories with that
+   system call into a buffer of our own, as readdir would.  This saves
+   the fstat and fcntl calls that fdopendir makes for each directory,
+   and the allocation of a new buffer for each: the buffer of a closed
+   stream is reused for the next directory.  */
+
+/* Size of the buffer into which directory entries are read.
+   Since the buffer is reused, it can be larger than readdir's.  */
+enum { FTS_DIRSTREAM_BUFSIZE = 128 * 1024 };
+
+struct _fts_dirstream
+{
+  int fd;
+  size_t offset;                /* Offset of the next entry in BUF.  */
+  size_t size;                  /* Number of bytes of entries in BUF.  */
+  union
+  {
+    struct dirent align;
+    char data[FTS_DIRSTREAM_BUFSIZE];
+  } buf;
+};
+
+/* Relative to DIR_FD, open the directory DIR, passing EXTRA_FLAGS to
+   the underlying openat call, as opendirat does.  */
+static struct _fts_dirstream *
+fts_opendirat (FTS *sp, int dir_fd, char const *dir, int extra_flags,
+               int *pnew_fd)
+{
+  struct _fts_dirstream *dirp = sp->fts_free_dirstream;
+  int open_flags = (O_RDONLY | O_CLOEXEC | O_DIRECTORY | O_NOCTTY
+                    | O_NONBLOCK | extra_flags);
+  int new_fd = openat (dir_fd, dir, open_flags);
+
+  if (new_fd < 0)
+    return NULL;
+  if (dirp)
+    sp->fts_free_dirstream = NULL;
+  else
+    {
+      dirp = malloc (sizeof *dirp);
+      if (!dirp)
+        {
+          close (new_fd);
+          __set_errno (ENOMEM);
+          return NULL;
+        }
+    }
+  dirp->fd = new_fd;
+  dirp->offset = dirp->size = 0;
+  *pnew_fd = new_fd;
+  return dirp;
+}
+
+static int
+fts_dirfd (struct _fts_dirstream const *dirp)
+{
+  return dirp->fd;
+}
+
+/* Return the next entry of DIRP, or NULL at its end or on error.
+   Like readdir, leave errno alone at the end.  */
+static struct dirent *
+fts_readdir (struct _fts_dirstream *dirp)
+{
+  struct dirent *dp;
+
+  do
+    {
+      if (dirp->size <= dirp->offset)
+        {
+          ssize_t n = getdents64 (dirp->fd, dirp->buf.data,
+                                  sizeof dirp->buf.data);
+          if (n <= 0)
+            return NULL;
+          dirp->size = n;
+          dirp->offset = 0;
+        }
+
+      /* The kernel aligns each entry as the struct, like the buffer.  */
+      void *entry = dirp->buf.data + dirp->offset;
+      dp = entry;
+      dirp->offset += dp->d_reclen;
+    }
+  /* Skip deleted entries, as readdir does.  */
+  while (dp->d_ino == 0);
+
+  return dp;
+}
+
+static void
+fts_closedir (FTS *sp, struct _fts_dirstream *dirp)
+{
+  close (dirp->fd);
+  if (sp->fts_free_dirstream)
+    free (dirp);
+  else
+    sp->fts_free_dirstream = dirp;
+}
+
+#else
+
+struct _fts_dirstream
+{
+  DIR *dirp;
+};
+
+static struct _fts_dirstream *
+fts_opendirat (FTS *sp _GL_UNUSED, int dir_fd, char const *dir,
+               int extra_flags, int *pnew_fd)
+{
+  struct _fts_dirstream *dirp = malloc (sizeof *dirp);
+  if (!dirp)
+    return NULL;
+  dirp->dirp = opendirat (dir_fd, dir, extra_flags, pnew_fd);
+  if (!dirp->dirp)
+    {
+      int saved_errno = errno;
+      free (dirp);
+      __set_errno (saved_errno);
+      return NULL;
+    }
+  return dirp;
+}
+
+static int
+fts_dirfd (struct _fts_dirstream const *dirp)
+{
+  return dirfd (dirp->dirp);
+}
+
+static struct dirent *
+fts_readdir (struct _fts_dirstream *dirp)
+{
+  return readdir (dirp->dirp);
+}
+
+static void
+fts_closedir (FTS *sp _GL_UNUSED, struct _fts_dirstream *dirp)
+{
+  closedir (dirp->dirp);
+  free (dirp);
+}
+
+#endif
+
 #define closedir_and_clear(dirp)                \
   do                                            \
     {                                           \
-      closedir (dirp);                          \
+      fts_closedir (sp, dirp);                  \
       dirp = NULL;                              \
     }                                           \
   while (0)
 
 #define fts_opendir(file, Pdir_fd)                              \
-        opendirat((! ISSET(FTS_NOCHDIR) && ISSET(FTS_CWDFD)     \
+        fts_opendirat(sp,                                       \
+                  (! ISSET(FTS_NOCHDIR) && ISSET(FTS_CWDFD)     \
                    ? sp->fts_cwd_fd : AT_FDCWD),                \
                   file,                                         \
                   (((ISSET(FTS_PHYSICAL)                        \
@@ -1320,8 +1489,7 @@ fts_build (register FTS *sp, int type)
            rather than opening a new one.  */
         if (continue_readdir)
           {
-            DIR *dp = cur->fts_dirp;
-            dir_fd = dirfd (dp);
+            dir_fd = fts_dirfd (cur->fts_dirp);
             if (dir_fd < 0)
               {
                 closedir_and_clear (cur->fts_dirp);
@@ -1457,7 +1625,7 @@ fts_build (register FTS *sp, int type)
         while (cur->fts_dirp) {
                 size_t d_namelen;
                 __set_errno (0);
-                struct dirent *dp = readdir(cur->fts_dirp);
+                struct dirent *dp = fts_readdir(cur->fts_dirp);
                 if (dp == NULL) {
                         if (errno) {
                                 cur->fts_errno = errno;
@@ -1949,7 +2117,7 @@ fts_lfree (register FTSENT *head)
         while ((p = head)) {
                 head = head->fts_link;
                 if (p->fts_dirp)
-                        closedir (p->fts_dirp);
+                        fts_closedir (p->fts_fts, p->fts_dirp);
                 free(p);
         }
 }
@@ -194,13 +194,17 @@ typedef struct {
            most-recently traversed parent directories.
            Currently used only in FTS_CWDFD mode.  */
         I_ring fts_fd_ring;
+
+        /* A closed directory stream kept for reuse, so that its
+           buffer need not be allocated anew for every directory.  */
+        struct _fts_dirstream *fts_free_dirstream;
 } FTS;
 
 typedef struct _ftsent {
         struct _ftsent *fts_cycle;      /* cycle node */
         struct _ftsent *fts_parent;     /* parent directory */
         struct _ftsent *fts_link;       /* next file in directory */
-        DIR *fts_dirp;                  /* Dir pointer for any directory
+        struct _fts_dirstream *fts_dirp; /* Dir pointer for any directory
                                            containing more entries than we
                                            read at one time.  */
         long fts_number;                /* local numeric value */
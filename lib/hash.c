@@ -19,47 +19,42 @@
 
 /* A generic hash table package.  */
 
-/* Define USE_OBSTACK to 1 if you want the allocator to use obstacks instead
-   of malloc.  If you change USE_OBSTACK, you have to recompile!  */
-
 #include <config.h>
 
 #include "hash.h"
 
 #include "bitrotate.h"
+#include "ignore-value.h"
 #include "xalloc-oversized.h"
 
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#if USE_OBSTACK
-# include "obstack.h"
-# ifndef obstack_chunk_alloc
-#  define obstack_chunk_alloc malloc
-# endif
-# ifndef obstack_chunk_free
-#  define obstack_chunk_free free
-# endif
-#endif
-
-struct hash_entry
+struct hash_slot
   {
     void *data;
-    struct hash_entry *next;
+    size_t hash;
   };
 
 struct hash_table
   {
-    /* The array of buckets starts at BUCKET and extends to BUCKET_LIMIT-1,
-       for a possibility of N_BUCKETS.  Among those, N_BUCKETS_USED buckets
-       are not empty, there are N_ENTRIES active entries in the table.  */
-    struct hash_entry *bucket;
-    struct hash_entry const *bucket_limit;
+    /* The array of slots starts at BUCKET and extends to BUCKET_LIMIT-1,
+       for a possibility of N_BUCKETS, a power of 2.  Among those,
+       N_BUCKETS_USED slots are not empty: N_ENTRIES of them hold active
+       entries, and the others mark entries that have been deleted.  */
+    struct hash_slot *bucket;
+    struct hash_slot const *bucket_limit;
     size_t n_buckets;
     size_t n_buckets_used;
     size_t n_entries;
 
+    /* The number of low-order bits to discard from a scrambled hash
+       to select a group of slots; see home_slot.  */
+    int shift;
+
     /* Tuning arguments, kept in a physically separate structure.  */
     const Hash_tuning *tuning;
 
@@ -71,52 +66,68 @@ struct hash_table
     Hash_hasher hasher;
     Hash_comparator comparator;
     Hash_data_freer data_freer;
+  };
 
-    /* A linked list of freed struct hash_entry structs.  */
-    struct hash_entry *free_entry_list;
-
-#if USE_OBSTACK
-    /* Whenever obstacks are used, it is possible to allocate all overflowed
-       entries into a single stack, so they all can be freed in a single
-       operation.  It is not clear if the speedup is worth the trouble.  */
-    struct obstack entry_stack;
+/* A hash table contains many slots, each empty or holding a pointer to
+   some user-provided data (also called a user entry), along with the hash
+   of that data.  A user entry contents may be hashed by a randomization
+   function (the hashing function, or just "hasher" for short) into a
+   number, which is scrambled to select the "home" slot of the entry.  The
+   entry is stored in the first slot at or after its home slot (wrapping
+   around at the end of the table) that is not in use by another entry, so
+   finding an entry means scanning the slots from its home slot until it is
+   found or an empty slot is reached.  This is called open addressing with
+   linear probing: unlike chaining entries in linked lists, it needs no
+   allocation per entry, and a scan reads consecutive memory.  As the hash
+   of each entry is stored with it, the scan rarely calls the comparator
+   on entries other than the one sought, and the table can be resized
+   without calling the hasher again.
+
+   A deleted entry leaves a marker in its slot, so that scans for the
+   entries after it do not stop there.  Such slots are reused by later
+   insertions, and are all emptied when the table is resized.
+
+   A good "hasher" function will distribute entries rather evenly, but the
+   scrambling makes up for some of the regularities of simpler hashers,
+   such as those returning an inode number.  The scans get longer as the
+   table fills, so the table is grown well before it is full.  */
+
+/* The scrambling multiplier of home_slot, the golden ratio scaled to the
+   width of size_t.  */
+#if SIZE_MAX <= UINT32_MAX
+# define GOLDEN_RATIO 0x9e3779b9u
+#else
+# define GOLDEN_RATIO 0x9e3779b97f4a7c15u
 #endif
-  };
 
-/* A hash table contains many internal entries, each holding a pointer to
-   some user-provided data (also called a user entry).  An entry indistinctly
-   refers to both the internal entry and its associated user entry.  A user
-   entry contents may be hashed by a randomization function (the hashing
-   function, or just "hasher" for short) into a number (or "slot") between 0
-   and the current table size.  At each slot position in the hash table,
-   starts a linked chain of entries for which the user data all hash to this
-   slot.  A bucket is the collection of all entries hashing to the same slot.
-
-   A good "hasher" function will distribute entries rather evenly in buckets.
-   In the ideal case, the length of each bucket is roughly the number of
-   entries divided by the table size.  Finding the slot for a data is usually
-   done in constant time by the "hasher", and the later finding of a precise
-   entry is linear in time with the size of the bucket.  Consequently, a
-   larger hash table size (that is, a larger number of buckets) is prone to
-   yielding shorter chains, *given* the "hasher" function behaves properly.
-
-   Long buckets slow down the lookup algorithm.  One might use big hash table
-   sizes in hope to reduce the average length of buckets, but this might
-   become inordinate, as unused slots in the hash table take some space.  The
-   best bet is to make sure you are using a good "hasher" function (beware
-   that those are not that easy to write! :-), and to use a table size
-   larger than the actual number of entries.  */
+/* The number of slots in a group; see home_slot.  */
+#define SLOT_GROUP_SIZE 4
+
+/* The minimum number of slots of a table.  */
+#define MIN_BUCKETS 16
+
+/* The marker left in the slot of a deleted entry.  */
+static char deleted_entry;
+#define DELETED ((void *) &deleted_entry)
+
+/* Return true if SLOT holds an active entry.  */
+static inline bool
+slot_used (struct hash_slot const *slot)
+{
+  return slot->data != NULL && slot->data != DELETED;
+}
 
 /* If an insertion makes the ratio of nonempty buckets to table size larger
    than the growth threshold (a number between 0.0 and 1.0), then increase
    the table size by multiplying by the growth factor (a number greater than
    1.0).  The growth threshold defaults to 0.8, and the growth factor
-   defaults to 1.414, meaning that the table will have doubled its size
-   every second time 80% of the buckets get used.  */
+   defaults to 1.414, which the rounding of the table size up to a power
+   of 2 turns into a doubling of the size each time 80% of the buckets
+   get used.  */
 #define DEFAULT_GROWTH_THRESHOLD 0.8f
 #define DEFAULT_GROWTH_FACTOR 1.414f
 
-/* If a deletion empties a bucket and causes the ratio of used buckets to
+/* If a deletion causes the ratio of entries to
    table size to become smaller than the shrink threshold (a number between
    0.0 and 1.0), then shrink the table by multiplying by the shrink factor (a
    number greater than the shrink threshold but smaller than 1.0).  The shrink
@@ -168,23 +179,45 @@ hash_get_n_entries (const Hash_table *table)
   return table->n_entries;
 }
 
-/* Return the length of the longest chain (bucket).  */
+/* Hash KEY for TABLE.  The hasher is asked for a number below SIZE_MAX,
+   so that it can be reduced to any table size.  */
+static size_t
+safe_hasher (const Hash_table *table, const void *key)
+{
+  return table->hasher (key, SIZE_MAX);
+}
+
+/* Return the index of the home slot of the entries whose hash is HASH.
+   The slots are in groups of SLOT_GROUP_SIZE, which typically fill a cache
+   line.  Hashes that differ only in their low-order bits, such as the
+   numbers of inodes allocated together, get home slots in the same group.
+   The group is chosen by multiplying the other bits by the golden ratio
+   and keeping the high-order bits of the product, which spreads out even
+   regularly spaced hashes.  */
+static inline size_t
+home_slot (const Hash_table *table, size_t hash)
+{
+  size_t group = ((size_t) ((hash / SLOT_GROUP_SIZE) * GOLDEN_RATIO)
+                  >> table->shift);
+  return group * SLOT_GROUP_SIZE + hash % SLOT_GROUP_SIZE;
+}
+
+/* Return the length of the longest scan (bucket) needed to find
+   an entry.  */
 
 size_t
 hash_get_max_bucket_length (const Hash_table *table)
 {
-  struct hash_entry const *bucket;
+  struct hash_slot const *slot;
+  size_t mask = table->n_buckets - 1;
   size_t max_bucket_length = 0;
 
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
     {
-      if (bucket->data)
+      if (slot_used (slot))
         {
-          struct hash_entry const *cursor = bucket;
-          size_t bucket_length = 1;
-
-          while (cursor = cursor->next, cursor)
-            bucket_length++;
+          size_t bucket_length =
+            ((slot - table->bucket - home_slot (table, slot->hash)) & mask) + 1;
 
           if (bucket_length > max_bucket_length)
             max_bucket_length = bucket_length;
@@ -200,27 +233,20 @@ hash_get_max_bucket_length (const Hash_table *table)
 bool
 hash_table_ok (const Hash_table *table)
 {
-  struct hash_entry const *bucket;
+  struct hash_slot const *slot;
   size_t n_buckets_used = 0;
   size_t n_entries = 0;
 
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
     {
-      if (bucket->data)
-        {
-          struct hash_entry const *cursor = bucket;
-
-          /* Count bucket head.  */
-          n_buckets_used++;
-          n_entries++;
-
-          /* Count bucket overflow.  */
-          while (cursor = cursor->next, cursor)
-            n_entries++;
-        }
+      if (slot->data)
+        n_buckets_used++;
+      if (slot_used (slot))
+        n_entries++;
     }
 
-  if (n_buckets_used == table->n_buckets_used && n_entries == table->n_entries)
+  if (n_buckets_used == table->n_buckets_used && n_entries == table->n_entries
+      && n_buckets_used < table->n_buckets)
     return true;
 
   return false;
@@ -243,15 +269,41 @@ hash_print_statistics (const Hash_table *table, FILE *stream)
            (unsigned long int) max_bucket_length);
 }
 
-/* Hash KEY and return a pointer to the selected bucket.
-   If TABLE->hasher misbehaves, abort.  */
-static struct hash_entry *
-safe_hasher (const Hash_table *table, const void *key)
+/* Return the slot of TABLE holding an entry that matches ENTRY, whose
+   hash is HASH, or NULL if there is none.  In that case, if FREE_SLOT is
+   not NULL, set *FREE_SLOT to the slot where ENTRY should be inserted:
+   the first one of the scan that is empty or holds a deleted entry.  */
+
+static struct hash_slot *
+find_slot (const Hash_table *table, const void *entry, size_t hash,
+           struct hash_slot **free_slot)
 {
-  size_t n = table->hasher (key, table->n_buckets);
-  if (! (n < table->n_buckets))
-    abort ();
-  return table->bucket + n;
+  size_t mask = table->n_buckets - 1;
+  size_t i = home_slot (table, hash);
+  struct hash_slot *deleted = NULL;
+
+  /* There is always an empty slot, which ends the scan.  */
+  for (;; i = (i + 1) & mask)
+    {
+      struct hash_slot *slot = table->bucket + i;
+
+      if (slot->data == NULL)
+        {
+          if (free_slot)
+            *free_slot = deleted ? deleted : slot;
+          return NULL;
+        }
+
+      if (slot->data == DELETED)
+        {
+          if (!deleted)
+            deleted = slot;
+        }
+      else if (slot->hash == hash
+               && (entry == slot->data
+                   || table->comparator (entry, slot->data)))
+        return slot;
+    }
 }
 
 /* If ENTRY matches an entry already in the hash table, return the
@@ -260,17 +312,10 @@ safe_hasher (const Hash_table *table, const void *key)
 void *
 hash_lookup (const Hash_table *table, const void *entry)
 {
-  struct hash_entry const *bucket = safe_hasher (table, entry);
-  struct hash_entry const *cursor;
-
-  if (bucket->data == NULL)
-    return NULL;
-
-  for (cursor = bucket; cursor; cursor = cursor->next)
-    if (entry == cursor->data || table->comparator (entry, cursor->data))
-      return cursor->data;
+  struct hash_slot const *slot =
+    find_slot (table, entry, safe_hasher (table, entry), NULL);
 
-  return NULL;
+  return slot ? slot->data : NULL;
 }
 
 /* Walking.  */
@@ -287,16 +332,16 @@ hash_lookup (const Hash_table *table, const void *entry)
 void *
 hash_get_first (const Hash_table *table)
 {
-  struct hash_entry const *bucket;
+  struct hash_slot const *slot;
 
   if (table->n_entries == 0)
     return NULL;
 
-  for (bucket = table->bucket; ; bucket++)
-    if (! (bucket < table->bucket_limit))
+  for (slot = table->bucket; ; slot++)
+    if (! (slot < table->bucket_limit))
       abort ();
-    else if (bucket->data)
-      return bucket->data;
+    else if (slot_used (slot))
+      return slot->data;
 }
 
 /* Return the user data for the entry following ENTRY, where ENTRY has been
@@ -306,23 +351,16 @@ hash_get_first (const Hash_table *table)
 void *
 hash_get_next (const Hash_table *table, const void *entry)
 {
-  struct hash_entry const *bucket = safe_hasher (table, entry);
-  struct hash_entry const *cursor;
+  struct hash_slot const *slot =
+    find_slot (table, entry, safe_hasher (table, entry), NULL);
 
-  /* Find next entry in the same bucket.  */
-  cursor = bucket;
-  do
-    {
-      if (cursor->data == entry && cursor->next)
-        return cursor->next->data;
-      cursor = cursor->next;
-    }
-  while (cursor != NULL);
+  if (!slot)
+    abort ();
 
-  /* Find first entry in any subsequent bucket.  */
-  while (++bucket < table->bucket_limit)
-    if (bucket->data)
-      return bucket->data;
+  /* Find the first entry in any subsequent slot.  */
+  while (++slot < table->bucket_limit)
+    if (slot_used (slot))
+      return slot->data;
 
   /* None found.  */
   return NULL;
@@ -337,19 +375,15 @@ hash_get_entries (const Hash_table *table, void **buffer,
                   size_t buffer_size)
 {
   size_t counter = 0;
-  struct hash_entry const *bucket;
-  struct hash_entry const *cursor;
+  struct hash_slot const *slot;
 
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
     {
-      if (bucket->data)
+      if (slot_used (slot))
         {
-          for (cursor = bucket; cursor; cursor = cursor->next)
-            {
-              if (counter >= buffer_size)
-                return counter;
-              buffer[counter++] = cursor->data;
-            }
+          if (counter >= buffer_size)
+            return counter;
+          buffer[counter++] = slot->data;
         }
     }
 
@@ -369,19 +403,15 @@ hash_do_for_each (const Hash_table *table, Hash_processor processor,
                   void *processor_data)
 {
   size_t counter = 0;
-  struct hash_entry const *bucket;
-  struct hash_entry const *cursor;
+  struct hash_slot const *slot;
 
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
     {
-      if (bucket->data)
+      if (slot_used (slot))
         {
-          for (cursor = bucket; cursor; cursor = cursor->next)
-            {
-              if (! processor (cursor->data, processor_data))
-                return counter;
-              counter++;
-            }
+          if (! processor (slot->data, processor_data))
+            return counter;
+          counter++;
         }
     }
 
@@ -437,44 +467,6 @@ hash_string (const char *string, size_t n_buckets)
 
 #endif /* not USE_DIFF_HASH */
 
-/* Return true if CANDIDATE is a prime number.  CANDIDATE should be an odd
-   number at least equal to 11.  */
-
-static bool _GL_ATTRIBUTE_CONST
-is_prime (size_t candidate)
-{
-  size_t divisor = 3;
-  size_t square = divisor * divisor;
-
-  while (square < candidate && (candidate % divisor))
-    {
-      divisor++;
-      square += 4 * divisor;
-      divisor++;
-    }
-
-  return (candidate % divisor ? true : false);
-}
-
-/* Round a given CANDIDATE number up to the nearest prime, and return that
-   prime.  Primes lower than 10 are merely skipped.  */
-
-static size_t _GL_ATTRIBUTE_CONST
-next_prime (size_t candidate)
-{
-  /* Skip small primes.  */
-  if (candidate < 10)
-    candidate = 10;
-
-  /* Make it definitely odd.  */
-  candidate |= 1;
-
-  while (SIZE_MAX != candidate && !is_prime (candidate))
-    candidate += 2;
-
-  return candidate;
-}
-
 void
 hash_reset_tuning (Hash_tuning *tuning)
 {
@@ -519,8 +511,9 @@ check_tuning (Hash_table *table)
   /* Be a bit stricter than mathematics would require, so that
      rounding errors in size calculations do not cause allocations to
      fail to grow or shrink as they should.  The smallest allocation
-     is 11 (due to next_prime's algorithm), so an epsilon of 0.1
-     should be good enough.  */
+     is MIN_BUCKETS, so an epsilon of 0.1 should be good enough.  This
+     also keeps a tenth of the slots empty, so that scans stay short
+     and always end.  */
   epsilon = 0.1f;
 
   if (epsilon < tuning->growth_threshold
@@ -543,6 +536,8 @@ check_tuning (Hash_table *table)
 static size_t _GL_ATTRIBUTE_PURE
 compute_bucket_size (size_t candidate, const Hash_tuning *tuning)
 {
+  size_t size = MIN_BUCKETS;
+
   if (!tuning->is_n_buckets)
     {
       float new_candidate = candidate / tuning->growth_threshold;
@@ -550,10 +545,28 @@ compute_bucket_size (size_t candidate, const Hash_tuning *tuning)
         return 0;
       candidate = new_candidate;
     }
-  candidate = next_prime (candidate);
-  if (xalloc_oversized (candidate, sizeof (struct hash_entry *)))
+  while (size < candidate)
+    {
+      if (SIZE_MAX / 2 < size)
+        return 0;
+      size *= 2;
+    }
+  if (xalloc_oversized (size, sizeof (struct hash_slot)))
     return 0;
-  return candidate;
+  return size;
+}
+
+/* Set the slots of TABLE to the N_BUCKETS slots at BUCKET.  */
+
+static void
+set_buckets (Hash_table *table, struct hash_slot *bucket, size_t n_buckets)
+{
+  table->bucket = bucket;
+  table->bucket_limit = bucket + n_buckets;
+  table->n_buckets = n_buckets;
+  table->shift = CHAR_BIT * sizeof (size_t);
+  for (; SLOT_GROUP_SIZE < n_buckets; n_buckets >>= 1)
+    table->shift--;
 }
 
 /* Allocate and return a new hash table, or NULL upon failure.  The initial
@@ -573,13 +586,14 @@ compute_bucket_size (size_t candidate, const Hash_tuning *tuning)
 
    The user-supplied HASHER function, when not NULL, accepts two
    arguments ENTRY and TABLE_SIZE.  It computes, by hashing ENTRY contents, a
-   slot number for that entry which should be in the range 0..TABLE_SIZE-1.
-   This slot number is then returned.
+   number for that entry which should be in the range 0..TABLE_SIZE-1.
+   This number is then returned.  The table passes SIZE_MAX as TABLE_SIZE,
+   and derives the slot number from the result itself.
 
    The user-supplied COMPARATOR function, when not NULL, accepts two
    arguments pointing to user data, it then returns true for a pair of entries
    that compare equal, or false otherwise.  This function is internally called
-   on entries which are already known to hash to the same bucket index,
+   on entries which are already known to have the same hash,
    but which are distinct pointers.
 
    The user-supplied DATA_FREER function, when not NULL, may be later called
@@ -596,6 +610,8 @@ hash_initialize (size_t candidate, const Hash_tuning *tuning,
                  Hash_data_freer data_freer)
 {
   Hash_table *table;
+  struct hash_slot *bucket;
+  size_t n_buckets;
 
   if (hasher == NULL)
     hasher = raw_hasher;
@@ -619,14 +635,14 @@ hash_initialize (size_t candidate, const Hash_tuning *tuning,
       goto fail;
     }
 
-  table->n_buckets = compute_bucket_size (candidate, tuning);
-  if (!table->n_buckets)
+  n_buckets = compute_bucket_size (candidate, tuning);
+  if (!n_buckets)
     goto fail;
 
-  table->bucket = calloc (table->n_buckets, sizeof *table->bucket);
-  if (table->bucket == NULL)
+  bucket = calloc (n_buckets, sizeof *bucket);
+  if (bucket == NULL)
     goto fail;
-  table->bucket_limit = table->bucket + table->n_buckets;
+  set_buckets (table, bucket, n_buckets);
   table->n_buckets_used = 0;
   table->n_entries = 0;
 
@@ -634,10 +650,6 @@ hash_initialize (size_t candidate, const Hash_tuning *tuning,
   table->comparator = comparator;
   table->data_freer = data_freer;
 
-  table->free_entry_list = NULL;
-#if USE_OBSTACK
-  obstack_init (&table->entry_stack);
-#endif
   return table;
 
  fail:
@@ -645,44 +657,20 @@ hash_initialize (size_t candidate, const Hash_tuning *tuning,
   return NULL;
 }
 
-/* Make all buckets empty, placing any chained entries on the free list.
-   Apply the user-specified function data_freer (if any) to the datas of any
-   affected entries.  */
+/* Make all buckets empty.  Apply the user-specified function data_freer
+   (if any) to the datas of any affected entries.  */
 
 void
 hash_clear (Hash_table *table)
 {
-  struct hash_entry *bucket;
-
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
-    {
-      if (bucket->data)
-        {
-          struct hash_entry *cursor;
-          struct hash_entry *next;
-
-          /* Free the bucket overflow.  */
-          for (cursor = bucket->next; cursor; cursor = next)
-            {
-              if (table->data_freer)
-                table->data_freer (cursor->data);
-              cursor->data = NULL;
-
-              next = cursor->next;
-              /* Relinking is done one entry at a time, as it is to be expected
-                 that overflows are either rare or short.  */
-              cursor->next = table->free_entry_list;
-              table->free_entry_list = cursor;
-            }
+  struct hash_slot *slot;
 
-          /* Free the bucket head.  */
-          if (table->data_freer)
-            table->data_freer (bucket->data);
-          bucket->data = NULL;
-          bucket->next = NULL;
-        }
-    }
+  if (table->data_freer)
+    for (slot = table->bucket; slot < table->bucket_limit; slot++)
+      if (slot_used (slot))
+        table->data_freer (slot->data);
 
+  memset (table->bucket, 0, table->n_buckets * sizeof *table->bucket);
   table->n_buckets_used = 0;
   table->n_entries = 0;
 }
@@ -695,48 +683,16 @@ hash_clear (Hash_table *table)
 void
 hash_free (Hash_table *table)
 {
-  struct hash_entry *bucket;
-  struct hash_entry *cursor;
-  struct hash_entry *next;
+  struct hash_slot *slot;
 
   /* Call the user data_freer function.  */
   if (table->data_freer && table->n_entries)
     {
-      for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
-        {
-          if (bucket->data)
-            {
-              for (cursor = bucket; cursor; cursor = cursor->next)
-                table->data_freer (cursor->data);
-            }
-        }
-    }
-
-#if USE_OBSTACK
-
-  obstack_free (&table->entry_stack, NULL);
-
-#else
-
-  /* Free all bucket overflowed entries.  */
-  for (bucket = table->bucket; bucket < table->bucket_limit; bucket++)
-    {
-      for (cursor = bucket->next; cursor; cursor = next)
-        {
-          next = cursor->next;
-          free (cursor);
-        }
-    }
-
-  /* Also reclaim the internal list of previously freed entries.  */
-  for (cursor = table->free_entry_list; cursor; cursor = next)
-    {
-      next = cursor->next;
-      free (cursor);
+      for (slot = table->bucket; slot < table->bucket_limit; slot++)
+        if (slot_used (slot))
+          table->data_freer (slot->data);
     }
 
-#endif
-
   /* Free the remainder of the hash table structure.  */
   free (table->bucket);
   free (table);
@@ -744,190 +700,36 @@ hash_free (Hash_table *table)
 
 /* Insertion and deletion.  */
 
-/* Get a new hash entry for a bucket overflow, possibly by recycling a
-   previously freed one.  If this is not possible, allocate a new one.  */
-
-static struct hash_entry *
-allocate_entry (Hash_table *table)
-{
-  struct hash_entry *new;
-
-  if (table->free_entry_list)
-    {
-      new = table->free_entry_list;
-      table->free_entry_list = new->next;
-    }
-  else
-    {
-#if USE_OBSTACK
-      new = obstack_alloc (&table->entry_stack, sizeof *new);
-#else
-      new = malloc (sizeof *new);
-#endif
-    }
-
-  return new;
-}
-
-/* Free a hash entry which was part of some bucket overflow,
-   saving it for later recycling.  */
-
-static void
-free_entry (Hash_table *table, struct hash_entry *entry)
-{
-  entry->data = NULL;
-  entry->next = table->free_entry_list;
-  table->free_entry_list = entry;
-}
-
-/* This private function is used to help with insertion and deletion.  When
-   ENTRY matches an entry in the table, return a pointer to the corresponding
-   user data and set *BUCKET_HEAD to the head of the selected bucket.
-   Otherwise, return NULL.  When DELETE is true and ENTRY matches an entry in
-   the table, unlink the matching entry.  */
+/* Move the entries of TABLE into a new array of N_BUCKETS slots, which
+   must leave at least one slot empty, dropping the markers of deleted
+   entries.  Return false if the new array cannot be allocated.  */
 
-static void *
-hash_find_entry (Hash_table *table, const void *entry,
-                 struct hash_entry **bucket_head, bool delete)
+static bool
+transfer_entries (Hash_table *table, size_t n_buckets)
 {
-  struct hash_entry *bucket = safe_hasher (table, entry);
-  struct hash_entry *cursor;
-
-  *bucket_head = bucket;
-
-  /* Test for empty bucket.  */
-  if (bucket->data == NULL)
-    return NULL;
-
-  /* See if the entry is the first in the bucket.  */
-  if (entry == bucket->data || table->comparator (entry, bucket->data))
-    {
-      void *data = bucket->data;
-
-      if (delete)
-        {
-          if (bucket->next)
-            {
-              struct hash_entry *next = bucket->next;
-
-              /* Bump the first overflow entry into the bucket head, then save
-                 the previous first overflow entry for later recycling.  */
-              *bucket = *next;
-              free_entry (table, next);
-            }
-          else
-            {
-              bucket->data = NULL;
-            }
-        }
-
-      return data;
-    }
-
-  /* Scan the bucket overflow.  */
-  for (cursor = bucket; cursor->next; cursor = cursor->next)
-    {
-      if (entry == cursor->next->data
-          || table->comparator (entry, cursor->next->data))
-        {
-          void *data = cursor->next->data;
-
-          if (delete)
-            {
-              struct hash_entry *next = cursor->next;
-
-              /* Unlink the entry to delete, then save the freed entry for later
-                 recycling.  */
-              cursor->next = next->next;
-              free_entry (table, next);
-            }
-
-          return data;
-        }
-    }
+  Hash_table new_table;
+  struct hash_slot *bucket = calloc (n_buckets, sizeof *bucket);
+  struct hash_slot const *slot;
 
-  /* No entry found.  */
-  return NULL;
-}
-
-/* Internal helper, to move entries from SRC to DST.  Both tables must
-   share the same free entry list.  If SAFE, only move overflow
-   entries, saving bucket heads for later, so that no allocations will
-   occur.  Return false if the free entry list is exhausted and an
-   allocation fails.  */
+  if (bucket == NULL)
+    return false;
+  set_buckets (&new_table, bucket, n_buckets);
 
-static bool
-transfer_entries (Hash_table *dst, Hash_table *src, bool safe)
-{
-  struct hash_entry *bucket;
-  struct hash_entry *cursor;
-  struct hash_entry *next;
-  for (bucket = src->bucket; bucket < src->bucket_limit; bucket++)
-    if (bucket->data)
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
+    if (slot_used (slot))
       {
-        void *data;
-        struct hash_entry *new_bucket;
-
-        /* Within each bucket, transfer overflow entries first and
-           then the bucket head, to minimize memory pressure.  After
-           all, the only time we might allocate is when moving the
-           bucket head, but moving overflow entries first may create
-           free entries that can be recycled by the time we finally
-           get to the bucket head.  */
-        for (cursor = bucket->next; cursor; cursor = next)
-          {
-            data = cursor->data;
-            new_bucket = safe_hasher (dst, data);
-
-            next = cursor->next;
-
-            if (new_bucket->data)
-              {
-                /* Merely relink an existing entry, when moving from a
-                   bucket overflow into a bucket overflow.  */
-                cursor->next = new_bucket->next;
-                new_bucket->next = cursor;
-              }
-            else
-              {
-                /* Free an existing entry, when moving from a bucket
-                   overflow into a bucket header.  */
-                new_bucket->data = data;
-                dst->n_buckets_used++;
-                free_entry (dst, cursor);
-              }
-          }
-        /* Now move the bucket head.  Be sure that if we fail due to
-           allocation failure that the src table is in a consistent
-           state.  */
-        data = bucket->data;
-        bucket->next = NULL;
-        if (safe)
-          continue;
-        new_bucket = safe_hasher (dst, data);
-
-        if (new_bucket->data)
-          {
-            /* Allocate or recycle an entry, when moving from a bucket
-               header into a bucket overflow.  */
-            struct hash_entry *new_entry = allocate_entry (dst);
-
-            if (new_entry == NULL)
-              return false;
-
-            new_entry->data = data;
-            new_entry->next = new_bucket->next;
-            new_bucket->next = new_entry;
-          }
-        else
-          {
-            /* Move from one bucket header to another.  */
-            new_bucket->data = data;
-            dst->n_buckets_used++;
-          }
-        bucket->data = NULL;
-        src->n_buckets_used--;
+        size_t mask = n_buckets - 1;
+        size_t i = home_slot (&new_table, slot->hash);
+
+        /* The entries are distinct, so merely find an empty slot.  */
+        while (bucket[i].data)
+          i = (i + 1) & mask;
+        bucket[i] = *slot;
       }
+
+  free (table->bucket);
+  set_buckets (table, bucket, n_buckets);
+  table->n_buckets_used = table->n_entries;
   return true;
 }
 
@@ -937,85 +739,27 @@ transfer_entries (Hash_table *dst, Hash_table *src, bool safe)
    the table may receive at least CANDIDATE different user entries, including
    those already in the table, before any other growth of the hash table size
    occurs.  If TUNING->IS_N_BUCKETS is true, then CANDIDATE specifies the
-   exact number of buckets desired.  Return true iff the rehash succeeded.  */
+   number of buckets desired, rounded up to a power of 2.  In either case,
+   the table is kept large enough for the entries already in it.  Return
+   true iff the rehash succeeded.  */
 
 bool
 hash_rehash (Hash_table *table, size_t candidate)
 {
-  Hash_table storage;
-  Hash_table *new_table;
   size_t new_size = compute_bucket_size (candidate, table->tuning);
 
   if (!new_size)
     return false;
-  if (new_size == table->n_buckets)
-    return true;
-  new_table = &storage;
-  new_table->bucket = calloc (new_size, sizeof *new_table->bucket);
-  if (new_table->bucket == NULL)
-    return false;
-  new_table->n_buckets = new_size;
-  new_table->bucket_limit = new_table->bucket + new_size;
-  new_table->n_buckets_used = 0;
-  new_table->n_entries = 0;
-  new_table->tuning = table->tuning;
-  new_table->hasher = table->hasher;
-  new_table->comparator = table->comparator;
-  new_table->data_freer = table->data_freer;
-
-  /* In order for the transfer to successfully complete, we need
-     additional overflow entries when distinct buckets in the old
-     table collide into a common bucket in the new table.  The worst
-     case possible is a hasher that gives a good spread with the old
-     size, but returns a constant with the new size; if we were to
-     guarantee table->n_buckets_used-1 free entries in advance, then
-     the transfer would be guaranteed to not allocate memory.
-     However, for large tables, a guarantee of no further allocation
-     introduces a lot of extra memory pressure, all for an unlikely
-     corner case (most rehashes reduce, rather than increase, the
-     number of overflow entries needed).  So, we instead ensure that
-     the transfer process can be reversed if we hit a memory
-     allocation failure mid-transfer.  */
-
-  /* Merely reuse the extra old space into the new table.  */
-#if USE_OBSTACK
-  new_table->entry_stack = table->entry_stack;
-#endif
-  new_table->free_entry_list = table->free_entry_list;
-
-  if (transfer_entries (new_table, table, false))
+  while (table->tuning->growth_threshold * new_size < table->n_entries)
     {
-      /* Entries transferred successfully; tie up the loose ends.  */
-      free (table->bucket);
-      table->bucket = new_table->bucket;
-      table->bucket_limit = new_table->bucket_limit;
-      table->n_buckets = new_table->n_buckets;
-      table->n_buckets_used = new_table->n_buckets_used;
-      table->free_entry_list = new_table->free_entry_list;
-      /* table->n_entries and table->entry_stack already hold their value.  */
-      return true;
+      if (xalloc_oversized (new_size, 2 * sizeof *table->bucket))
+        return false;
+      new_size *= 2;
     }
-
-  /* We've allocated new_table->bucket (and possibly some entries),
-     exhausted the free list, and moved some but not all entries into
-     new_table.  We must undo the partial move before returning
-     failure.  The only way to get into this situation is if new_table
-     uses fewer buckets than the old table, so we will reclaim some
-     free entries as overflows in the new table are put back into
-     distinct buckets in the old table.
-
-     There are some pathological cases where a single pass through the
-     table requires more intermediate overflow entries than using two
-     passes.  Two passes give worse cache performance and takes
-     longer, but at this point, we're already out of memory, so slow
-     and safe is better than failure.  */
-  table->free_entry_list = new_table->free_entry_list;
-  if (! (transfer_entries (table, new_table, true)
-         && transfer_entries (table, new_table, false)))
-    abort ();
-  /* table->n_entries already holds its value.  */
-  free (new_table->bucket);
-  return false;
+  if (new_size == table->n_buckets
+      && table->n_buckets_used == table->n_entries)
+    return true;
+  return transfer_entries (table, new_size);
 }
 
 /* Insert ENTRY into hash TABLE if there is not already a matching entry.
@@ -1038,30 +782,33 @@ int
 hash_insert_if_absent (Hash_table *table, void const *entry,
                        void const **matched_ent)
 {
-  void *data;
-  struct hash_entry *bucket;
+  struct hash_slot *slot;
+  struct hash_slot *match;
+  size_t hash;
 
   /* The caller cannot insert a NULL entry, since hash_lookup returns NULL
-     to indicate "not found", and hash_find_entry uses "bucket->data == NULL"
-     to indicate an empty bucket.  */
+     to indicate "not found", and find_slot uses "slot->data == NULL"
+     to indicate an empty slot.  */
   if (! entry)
     abort ();
 
   /* If there's a matching entry already in the table, return that.  */
-  if ((data = hash_find_entry (table, entry, &bucket, false)) != NULL)
+  hash = safe_hasher (table, entry);
+  if ((match = find_slot (table, entry, hash, &slot)) != NULL)
     {
       if (matched_ent)
-        *matched_ent = data;
+        *matched_ent = match->data;
       return 0;
     }
 
-  /* If the growth threshold of the buckets in use has been reached, increase
-     the table size and rehash.  There's no point in checking the number of
-     entries:  if the hashing function is ill-conditioned, rehashing is not
-     likely to improve it.  */
+  /* If ENTRY would take an empty slot and the growth threshold of the
+     slots in use has been reached, increase the table size and rehash.
+     If most of the slots in use only mark deleted entries, merely drop
+     those markers, keeping the table size.  */
 
-  if (table->n_buckets_used
-      > table->tuning->growth_threshold * table->n_buckets)
+  if (slot->data == NULL
+      && table->n_buckets_used
+         > table->tuning->growth_threshold * table->n_buckets)
     {
       /* Check more fully, before starting real work.  If tuning arguments
          became invalid, the second check will rely on proper defaults.  */
@@ -1070,48 +817,41 @@ hash_insert_if_absent (Hash_table *table, void const *entry,
           > table->tuning->growth_threshold * table->n_buckets)
         {
           const Hash_tuning *tuning = table->tuning;
-          float candidate =
-            (tuning->is_n_buckets
-             ? (table->n_buckets * tuning->growth_factor)
-             : (table->n_buckets * tuning->growth_factor
-                * tuning->growth_threshold));
 
-          if (SIZE_MAX <= candidate)
-            return -1;
+          if (table->n_entries <= table->n_buckets_used / 2)
+            {
+              if (!transfer_entries (table, table->n_buckets))
+                return -1;
+            }
+          else
+            {
+              float candidate =
+                (tuning->is_n_buckets
+                 ? (table->n_buckets * tuning->growth_factor)
+                 : (table->n_buckets * tuning->growth_factor
+                    * tuning->growth_threshold));
+
+              if (SIZE_MAX <= candidate)
+                return -1;
 
-          /* If the rehash fails, arrange to return NULL.  */
-          if (!hash_rehash (table, candidate))
-            return -1;
+              /* If the rehash fails, arrange to return NULL.  */
+              if (!hash_rehash (table, candidate))
+                return -1;
+            }
 
-          /* Update the bucket we are interested in.  */
-          if (hash_find_entry (table, entry, &bucket, false) != NULL)
+          /* Update the slot we are interested in.  */
+          if (find_slot (table, entry, hash, &slot) != NULL)
             abort ();
         }
     }
 
   /* ENTRY is not matched, it should be inserted.  */
 
-  if (bucket->data)
-    {
-      struct hash_entry *new_entry = allocate_entry (table);
-
-      if (new_entry == NULL)
-        return -1;
-
-      /* Add ENTRY in the overflow of the bucket.  */
-
-      new_entry->data = (void *) entry;
-      new_entry->next = bucket->next;
-      bucket->next = new_entry;
-      table->n_entries++;
-      return 1;
-    }
-
-  /* Add ENTRY right in the bucket head.  */
-
-  bucket->data = (void *) entry;
+  if (slot->data == NULL)
+    table->n_buckets_used++;
+  slot->data = (void *) entry;
+  slot->hash = hash;
   table->n_entries++;
-  table->n_buckets_used++;
 
   return 1;
 }
@@ -1140,56 +880,55 @@ void *
 hash_delete (Hash_table *table, const void *entry)
 {
   void *data;
-  struct hash_entry *bucket;
+  struct hash_slot *slot;
+  size_t mask = table->n_buckets - 1;
+  size_t i;
 
-  data = hash_find_entry (table, entry, &bucket, true);
-  if (!data)
+  slot = find_slot (table, entry, safe_hasher (table, entry), NULL);
+  if (!slot)
     return NULL;
 
+  data = slot->data;
   table->n_entries--;
-  if (!bucket->data)
+
+  /* If the next slot is empty, no scan goes past this one, so empty it
+     along with the slots of deleted entries just before it.  Otherwise,
+     mark the entry as deleted, so that scans go on past it.  */
+  i = slot - table->bucket;
+  if (table->bucket[(i + 1) & mask].data == NULL)
     {
-      table->n_buckets_used--;
+      do
+        {
+          table->bucket[i].data = NULL;
+          table->n_buckets_used--;
+          i = (i - 1) & mask;
+        }
+      while (table->bucket[i].data == DELETED);
+    }
+  else
+    slot->data = DELETED;
 
-      /* If the shrink threshold of the buckets in use has been reached,
-         rehash into a smaller table.  */
+  /* If the shrink threshold of the entries has been reached,
+     rehash into a smaller table.  */
 
-      if (table->n_buckets_used
+  if (table->n_entries < table->tuning->shrink_threshold * table->n_buckets)
+    {
+      /* Check more fully, before starting real work.  If tuning arguments
+         became invalid, the second check will rely on proper defaults.  */
+      check_tuning (table);
+      if (table->n_entries
           < table->tuning->shrink_threshold * table->n_buckets)
         {
-          /* Check more fully, before starting real work.  If tuning arguments
-             became invalid, the second check will rely on proper defaults.  */
-          check_tuning (table);
-          if (table->n_buckets_used
-              < table->tuning->shrink_threshold * table->n_buckets)
-            {
-              const Hash_tuning *tuning = table->tuning;
-              size_t candidate =
-                (tuning->is_n_buckets
-                 ? table->n_buckets * tuning->shrink_factor
-                 : (table->n_buckets * tuning->shrink_factor
-                    * tuning->growth_threshold));
+          const Hash_tuning *tuning = table->tuning;
+          size_t candidate =
+            (tuning->is_n_buckets
+             ? table->n_buckets * tuning->shrink_factor
+             : (table->n_buckets * tuning->shrink_factor
+                * tuning->growth_threshold));
 
-              if (!hash_rehash (table, candidate))
-                {
-                  /* Failure to allocate memory in an attempt to
-                     shrink the table is not fatal.  But since memory
-                     is low, we can at least be kind and free any
-                     spare entries, rather than keeping them tied up
-                     in the free entry list.  */
-#if ! USE_OBSTACK
-                  struct hash_entry *cursor = table->free_entry_list;
-                  struct hash_entry *next;
-                  while (cursor)
-                    {
-                      next = cursor->next;
-                      free (cursor);
-                      cursor = next;
-                    }
-                  table->free_entry_list = NULL;
-#endif
-                }
-            }
+          /* Failure to allocate memory in an attempt to shrink the
+             table is not fatal.  */
+          ignore_value (hash_rehash (table, candidate));
         }
     }
 
@@ -1203,23 +942,16 @@ hash_delete (Hash_table *table, const void *entry)
 void
 hash_print (const Hash_table *table)
 {
-  struct hash_entry *bucket = (struct hash_entry *) table->bucket;
-
-  for ( ; bucket < table->bucket_limit; bucket++)
-    {
-      struct hash_entry *cursor;
+  struct hash_slot const *slot;
 
-      if (bucket)
-        printf ("%lu:\n", (unsigned long int) (bucket - table->bucket));
-
-      for (cursor = bucket; cursor; cursor = cursor->next)
-        {
-          char const *s = cursor->data;
-          /* FIXME */
-          if (s)
-            printf ("  %s\n", s);
-        }
-    }
+  for (slot = table->bucket; slot < table->bucket_limit; slot++)
+    if (slot_used (slot))
+      {
+        char const *s = slot->data;
+        printf ("%lu:\n", (unsigned long int) (slot - table->bucket));
+        /* FIXME */
+        printf ("  %s\n", s);
+      }
 }
 
 #endif /* TESTING */
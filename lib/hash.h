@@ -18,9 +18,6 @@
 
 /* A generic hash table package.  */
 
-/* Make sure USE_OBSTACK is defined to 1 if you want the allocator to use
-   obstacks instead of malloc, and recompile 'hash.c' with same setting.  */
-
 #ifndef HASH_H_
 # define HASH_H_
 
@@ -169,6 +169,19 @@ AC_DEFUN([coreutils_MACROS],
      LIBS="$ac_seq_save_LIBS"
     ])
 
+  # See if linking 'shuf' requires -lm, for the logarithms used in
+  # reservoir sampling.
+  AC_SUBST([SHUF_LIBM])
+  ac_shuf_body='
+     volatile double x = 0.5;
+     return ! (floor (exp (log1p (-x) + log (x))) < 1);'
+  AC_TRY_LINK([#include <math.h>], [$ac_shuf_body], ,
+    [ac_shuf_save_LIBS="$LIBS"
+     LIBS="$LIBS -lm"
+     AC_TRY_LINK([#include <math.h>], [$ac_shuf_body], [SHUF_LIBM=-lm])
+     LIBS="$ac_shuf_save_LIBS"
+    ])
+
 
   # See is fpsetprec() required to use extended double precision
   # This is needed on 32 bit FreeBSD to give accurate conversion of:
@@ -175,13 +175,11 @@ from any other non-alphabet bytes in the encoded stream.\n"),
   exit (status);
 }
 
-#define ENC_BLOCKSIZE (1024*3*10)
+#define ENC_BLOCKSIZE (1024*3*10*4)
 
 #if BASE_TYPE == 32
 # define BASE_LENGTH BASE32_LENGTH
-/* Note that increasing this may decrease performance if --ignore-garbage
-   is used, because of the memmove operation below.  */
-# define DEC_BLOCKSIZE (1024*5)
+# define DEC_BLOCKSIZE (1024*5*16)
 
 /* Ensure that BLOCKSIZE is a multiple of 5 and 8.  */
 verify (ENC_BLOCKSIZE % 40 == 0);  /* So padding chars only on last block.  */
@@ -194,27 +192,27 @@ verify (DEC_BLOCKSIZE % 40 == 0);  /* So complete encoded blocks are used.  */
 # define isbase isbase32
 #elif BASE_TYPE == 64
 # define BASE_LENGTH BASE64_LENGTH
-/* Note that increasing this may decrease performance if --ignore-garbage
-   is used, because of the memmove operation below.  */
-# define DEC_BLOCKSIZE (1024*3)
+# define DEC_BLOCKSIZE (1024*3*32)
 
 /* Ensure that BLOCKSIZE is a multiple of 3 and 4.  */
 verify (ENC_BLOCKSIZE % 12 == 0);  /* So padding chars only on last block.  */
 verify (DEC_BLOCKSIZE % 12 == 0);  /* So complete encoded blocks are used.  */
 
-# define base_encode base64_encode
+# define base_encode base64_encode_fast
 # define base_decode_context base64_decode_context
 # define base_decode_ctx_init base64_decode_ctx_init
-# define base_decode_ctx base64_decode_ctx
+# define base_decode_ctx base64_decode_ctx_fast
 # define isbase isbase64
 #elif BASE_TYPE == 42
 
 
 # define BASE_LENGTH base_length
 
-/* Note that increasing this may decrease performance if --ignore-garbage
-   is used, because of the memmove operation below.  */
-# define DEC_BLOCKSIZE (1024*5)
+# define DEC_BLOCKSIZE (1024*5*3*8)
+
+/* Ensure that complete encoded blocks are used for every encoding.  */
+verify (DEC_BLOCKSIZE % 40 == 0);
+verify (DEC_BLOCKSIZE % 12 == 0);
 
 static int (*base_length) (int i);
 static bool (*isbase) (char ch);
@@ -257,6 +255,410 @@ const char *restrict in, size_t inlen,
 char *restrict out, size_t *outlen);
 #endif
 
+/* Vectorized codecs.  Base64 (and in basenc, base16) is encoded and
+   decoded 16 or 32 bytes at a time where the CPU supports it, using
+   the SSSE3 byte shuffle as a lookup table.  The kernels handle only
+   the bulk of the data: decoding stops at the first vector containing
+   anything but alphabet characters (a newline, padding or garbage),
+   and the scalar code takes over from there, so that the handling of
+   those and of invalid input is unchanged.  */
+
+#if (BASE_TYPE == 64 || BASE_TYPE == 42) && defined __x86_64__ \
+    && (4 < __GNUC__ + (9 <= __GNUC_MINOR__) || defined __clang__)
+# define USE_SIMD_CODECS 1
+# include <immintrin.h>
+# define SSSE3_TARGET __attribute__ ((__target__ ("ssse3")))
+# define AVX2_TARGET __attribute__ ((__target__ ("avx2")))
+#else
+# define USE_SIMD_CODECS 0
+#endif
+
+#if USE_SIMD_CODECS
+
+/* When true, use the corresponding vectorized kernels.  */
+static bool use_ssse3;
+static bool use_avx2;
+
+static void
+simd_init (void)
+{
+  use_ssse3 = __builtin_cpu_supports ("ssse3");
+  use_avx2 = __builtin_cpu_supports ("avx2");
+}
+
+/* Convert the 6-bit values in INDICES to base64 characters.  */
+SSSE3_TARGET static inline __m128i
+base64_chars_ssse3 (__m128i indices)
+{
+  /* Map 0..25 to 13, 26..51 to 0, and 52..63 to 1..12, and use
+     the result to look up the offset from the value to its character.  */
+  __m128i offsets = _mm_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                   '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                   '/' - 63, 'A', 0, 0);
+  __m128i r = _mm_subs_epu8 (indices, _mm_set1_epi8 (51));
+  __m128i upper = _mm_cmpgt_epi8 (_mm_set1_epi8 (26), indices);
+  r = _mm_or_si128 (r, _mm_and_si128 (upper, _mm_set1_epi8 (13)));
+  return _mm_add_epi8 (_mm_shuffle_epi8 (offsets, r), indices);
+}
+
+/* Spread the 12 bytes at the start of X to the 6-bit values of
+   16 base64 characters, one per byte.  */
+SSSE3_TARGET static inline __m128i
+base64_split_ssse3 (__m128i x)
+{
+  x = _mm_shuffle_epi8 (x, _mm_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4,
+                                          7, 6, 8, 7, 10, 9, 11, 10));
+  __m128i t0 = _mm_and_si128 (x, _mm_set1_epi32 (0x0fc0fc00));
+  __m128i t1 = _mm_mulhi_epu16 (t0, _mm_set1_epi32 (0x04000040));
+  __m128i t2 = _mm_and_si128 (x, _mm_set1_epi32 (0x003f03f0));
+  __m128i t3 = _mm_mullo_epi16 (t2, _mm_set1_epi32 (0x01000010));
+  return _mm_or_si128 (t1, t3);
+}
+
+/* Encode the INLEN bytes at IN to OUT for as long as the kernel can,
+   and return the number of bytes encoded, a multiple of 3.  */
+SSSE3_TARGET static size_t
+base64_encode_ssse3 (char const *in, size_t inlen, char *out)
+{
+  size_t i;
+  for (i = 0; 16 <= inlen - i; i += 12, out += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((void const *) (in + i));
+      _mm_storeu_si128 ((void *) out,
+                        base64_chars_ssse3 (base64_split_ssse3 (x)));
+    }
+  return i;
+}
+
+AVX2_TARGET static size_t
+base64_encode_avx2 (char const *in, size_t inlen, char *out)
+{
+  __m256i offsets = _mm256_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                      '/' - 63, 'A', 0, 0,
+                                      'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                      '/' - 63, 'A', 0, 0);
+  __m256i spread = _mm256_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4,
+                                     7, 6, 8, 7, 10, 9, 11, 10,
+                                     1, 0, 2, 1, 4, 3, 5, 4,
+                                     7, 6, 8, 7, 10, 9, 11, 10);
+  size_t i;
+  for (i = 0; 28 <= inlen - i; i += 24, out += 32)
+    {
+      __m128i lo = _mm_loadu_si128 ((void const *) (in + i));
+      __m128i hi = _mm_loadu_si128 ((void const *) (in + i + 12));
+      __m256i x = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo),
+                                           hi, 1);
+      x = _mm256_shuffle_epi8 (x, spread);
+      __m256i t0 = _mm256_and_si256 (x, _mm256_set1_epi32 (0x0fc0fc00));
+      __m256i t1 = _mm256_mulhi_epu16 (t0, _mm256_set1_epi32 (0x04000040));
+      __m256i t2 = _mm256_and_si256 (x, _mm256_set1_epi32 (0x003f03f0));
+      __m256i t3 = _mm256_mullo_epi16 (t2, _mm256_set1_epi32 (0x01000010));
+      __m256i indices = _mm256_or_si256 (t1, t3);
+      __m256i r = _mm256_subs_epu8 (indices, _mm256_set1_epi8 (51));
+      __m256i upper = _mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), indices);
+      r = _mm256_or_si256 (r, _mm256_and_si256 (upper,
+                                                _mm256_set1_epi8 (13)));
+      r = _mm256_add_epi8 (_mm256_shuffle_epi8 (offsets, r), indices);
+      _mm256_storeu_si256 ((void *) out, r);
+    }
+  return i + base64_encode_ssse3 (in + i, inlen - i, out);
+}
+
+/* Convert the base64 characters in X to their 6-bit values, and set
+   *VALID to whether they all were in the alphabet.  A character is
+   valid if the bit for its high nibble in HI_BITS is not in the set of
+   bits for its low nibble in LO_BITS.  */
+SSSE3_TARGET static inline __m128i
+base64_values_ssse3 (__m128i x, bool *valid)
+{
+  __m128i lo_bits = _mm_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                   0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                   0x1b, 0x1b, 0x1b, 0x1a);
+  __m128i hi_bits = _mm_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                   0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                   0x10, 0x10, 0x10, 0x10);
+  __m128i shifts = _mm_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+                                  0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i mask = _mm_set1_epi8 (0x2f);
+  __m128i hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (x, 4), mask);
+  __m128i lo = _mm_shuffle_epi8 (lo_bits, _mm_and_si128 (x, mask));
+  __m128i hi = _mm_shuffle_epi8 (hi_bits, hi_nibbles);
+  __m128i good = _mm_cmpeq_epi8 (_mm_and_si128 (lo, hi),
+                                 _mm_setzero_si128 ());
+  *valid = _mm_movemask_epi8 (good) == 0xffff;
+  /* '/' shares its high nibble with '+', so it is given its own shift.  */
+  __m128i slash = _mm_cmpeq_epi8 (x, mask);
+  return _mm_add_epi8 (x, _mm_shuffle_epi8 (shifts,
+                                            _mm_add_epi8 (slash, hi_nibbles)));
+}
+
+/* Pack the 6-bit values in X into 12 bytes at the start of the result.  */
+SSSE3_TARGET static inline __m128i
+base64_pack_ssse3 (__m128i x)
+{
+  x = _mm_maddubs_epi16 (x, _mm_set1_epi32 (0x01400140));
+  x = _mm_madd_epi16 (x, _mm_set1_epi32 (0x00011000));
+  return _mm_shuffle_epi8 (x, _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                             8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+/* Decode the INLEN characters at IN to the OUTLEN bytes at OUT for as
+   long as they are alphabet characters, and return the number of
+   characters decoded, a multiple of 4.  */
+SSSE3_TARGET static size_t
+base64_decode_ssse3 (char const *in, size_t inlen, char *out, size_t outlen)
+{
+  size_t i;
+  for (i = 0; 16 <= inlen - i && 16 <= outlen - i / 4 * 3;
+       i += 16, out += 12)
+    {
+      bool valid;
+      __m128i x = _mm_loadu_si128 ((void const *) (in + i));
+      x = base64_values_ssse3 (x, &valid);
+      if (!valid)
+        break;
+      _mm_storeu_si128 ((void *) out, base64_pack_ssse3 (x));
+    }
+  return i;
+}
+
+AVX2_TARGET static size_t
+base64_decode_avx2 (char const *in, size_t inlen, char *out, size_t outlen)
+{
+  __m256i lo_bits = _mm256_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                      0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                      0x1b, 0x1b, 0x1b, 0x1a,
+                                      0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                      0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                      0x1b, 0x1b, 0x1b, 0x1a);
+  __m256i hi_bits = _mm256_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                      0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                      0x10, 0x10, 0x10, 0x10,
+                                      0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                      0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                      0x10, 0x10, 0x10, 0x10);
+  __m256i shifts = _mm256_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+                                     0, 0, 0, 0, 0, 0, 0, 0,
+                                     0, 16, 19, 4, -65, -65, -71, -71,
+                                     0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i pack = _mm256_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                   8, 14, 13, 12, -1, -1, -1, -1,
+                                   2, 1, 0, 6, 5, 4, 10, 9,
+                                   8, 14, 13, 12, -1, -1, -1, -1);
+  __m256i mask = _mm256_set1_epi8 (0x2f);
+  size_t i;
+  for (i = 0; 32 <= inlen - i && 32 <= outlen - i / 4 * 3;
+       i += 32, out += 24)
+    {
+      __m256i x = _mm256_loadu_si256 ((void const *) (in + i));
+      __m256i hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (x, 4), mask);
+      __m256i lo = _mm256_shuffle_epi8 (lo_bits, _mm256_and_si256 (x, mask));
+      __m256i hi = _mm256_shuffle_epi8 (hi_bits, hi_nibbles);
+      if (!_mm256_testz_si256 (lo, hi))
+        break;
+      __m256i slash = _mm256_cmpeq_epi8 (x, mask);
+      __m256i shift = _mm256_shuffle_epi8 (shifts,
+                                           _mm256_add_epi8 (slash, hi_nibbles));
+      x = _mm256_add_epi8 (x, shift);
+      x = _mm256_maddubs_epi16 (x, _mm256_set1_epi32 (0x01400140));
+      x = _mm256_madd_epi16 (x, _mm256_set1_epi32 (0x00011000));
+      x = _mm256_shuffle_epi8 (x, pack);
+      x = _mm256_permutevar8x32_epi32 (x, _mm256_setr_epi32 (0, 1, 2, 4,
+                                                             5, 6, 7, 7));
+      _mm256_storeu_si256 ((void *) out, x);
+    }
+  size_t o = i / 4 * 3;
+  return i + base64_decode_ssse3 (in + i, inlen - i, out, outlen - o);
+}
+
+static size_t
+base64_encode_simd (char const *in, size_t inlen, char *out)
+{
+  return (use_avx2 ? base64_encode_avx2 (in, inlen, out)
+          : use_ssse3 ? base64_encode_ssse3 (in, inlen, out)
+          : 0);
+}
+
+static size_t
+base64_decode_simd (char const *in, size_t inlen, char *out, size_t outlen)
+{
+  return (use_avx2 ? base64_decode_avx2 (in, inlen, out, outlen)
+          : use_ssse3 ? base64_decode_ssse3 (in, inlen, out, outlen)
+          : 0);
+}
+
+# if BASE_TYPE == 42
+
+/* Encode the INLEN bytes at IN as base16 to OUT for as long as the
+   kernel can, and return the number of bytes encoded.  */
+SSSE3_TARGET static size_t
+base16_encode_simd (char const *in, size_t inlen, char *out)
+{
+  __m128i digits = _mm_loadu_si128 ((void const *) "0123456789ABCDEF");
+  __m128i low_nibbles = _mm_set1_epi8 (0x0f);
+  size_t i;
+
+  if (!use_ssse3)
+    return 0;
+
+  for (i = 0; 16 <= inlen - i; i += 16, out += 32)
+    {
+      __m128i x = _mm_loadu_si128 ((void const *) (in + i));
+      __m128i hi = _mm_and_si128 (_mm_srli_epi16 (x, 4), low_nibbles);
+      __m128i lo = _mm_and_si128 (x, low_nibbles);
+      hi = _mm_shuffle_epi8 (digits, hi);
+      lo = _mm_shuffle_epi8 (digits, lo);
+      _mm_storeu_si128 ((void *) out, _mm_unpacklo_epi8 (hi, lo));
+      _mm_storeu_si128 ((void *) (out + 16), _mm_unpackhi_epi8 (hi, lo));
+    }
+  return i;
+}
+
+/* Convert the base16 characters in X to their 4-bit values, and set
+   *VALID to whether they all were in the alphabet.  */
+SSSE3_TARGET static inline __m128i
+base16_values_ssse3 (__m128i x, bool *valid)
+{
+  __m128i d = _mm_sub_epi8 (x, _mm_set1_epi8 ('0'));
+  __m128i l = _mm_sub_epi8 (x, _mm_set1_epi8 ('A'));
+  __m128i is_d = _mm_cmpeq_epi8 (_mm_min_epu8 (d, _mm_set1_epi8 (9)), d);
+  __m128i is_l = _mm_cmpeq_epi8 (_mm_min_epu8 (l, _mm_set1_epi8 (5)), l);
+  *valid = _mm_movemask_epi8 (_mm_or_si128 (is_d, is_l)) == 0xffff;
+  l = _mm_add_epi8 (l, _mm_set1_epi8 (10));
+  return _mm_or_si128 (_mm_and_si128 (is_d, d), _mm_and_si128 (is_l, l));
+}
+
+/* Decode the INLEN base16 characters at IN to the OUTLEN bytes at OUT
+   for as long as they are alphabet characters, and return the number
+   of characters decoded, a multiple of 2.  */
+SSSE3_TARGET static size_t
+base16_decode_simd (char const *in, size_t inlen, char *out, size_t outlen)
+{
+  __m128i weights = _mm_set1_epi16 (0x0110);
+  size_t i;
+
+  if (!use_ssse3)
+    return 0;
+
+  for (i = 0; 32 <= inlen - i && 16 <= outlen - i / 2; i += 32, out += 16)
+    {
+      bool valid_a, valid_b;
+      __m128i a = _mm_loadu_si128 ((void const *) (in + i));
+      __m128i b = _mm_loadu_si128 ((void const *) (in + i + 16));
+      a = base16_values_ssse3 (a, &valid_a);
+      b = base16_values_ssse3 (b, &valid_b);
+      if (! (valid_a & valid_b))
+        break;
+      a = _mm_maddubs_epi16 (a, weights);
+      b = _mm_maddubs_epi16 (b, weights);
+      _mm_storeu_si128 ((void *) out, _mm_packus_epi16 (a, b));
+    }
+  return i;
+}
+
+# endif /* BASE_TYPE == 42 */
+
+#else /* !USE_SIMD_CODECS */
+
+static void
+simd_init (void)
+{
+}
+
+# if BASE_TYPE == 64 || BASE_TYPE == 42
+#  define base64_encode_simd(in, inlen, out) 0
+#  define base64_decode_simd(in, inlen, out, outlen) 0
+# endif
+# if BASE_TYPE == 42
+#  define base16_encode_simd(in, inlen, out) 0
+#  define base16_decode_simd(in, inlen, out, outlen) 0
+# endif
+
+#endif
+
+#if BASE_TYPE == 64 || BASE_TYPE == 42
+
+/* Like base64_encode, but using the vectorized kernel if possible.  */
+static void
+base64_encode_fast (const char *restrict in, size_t inlen,
+                    char *restrict out, size_t outlen)
+{
+  size_t n = base64_encode_simd (in, inlen, out);
+  base64_encode (in + n, inlen - n, out + n / 3 * 4, outlen - n / 3 * 4);
+}
+
+/* Like base64_decode_ctx, but using the vectorized kernel if possible.
+   gnulib's decoder ignores newlines, so they are removed first, and the
+   kernel then decodes the input up to any padding or invalid character,
+   which is left to gnulib's decoder to handle.  */
+static bool
+base64_decode_ctx_fast (struct base64_decode_context *ctx,
+                        const char *restrict in, size_t inlen,
+                        char *restrict out, size_t *outlen)
+{
+  static char *lines;
+  static size_t lines_size;
+  size_t outleft = *outlen;
+  bool ok = true;
+
+  if (inlen == 0)
+    return base64_decode_ctx (ctx, in, inlen, out, outlen);
+
+  char const *nl = memchr (in, '\n', inlen);
+  if (nl)
+    {
+      if (lines_size < inlen)
+        {
+          free (lines);
+          lines = xmalloc (inlen);
+          lines_size = inlen;
+        }
+      char *p = lines;
+      char const *in_end = in + inlen;
+      do
+        {
+          p = mempcpy (p, in, nl - in);
+          in = nl + 1;
+        }
+      while ((nl = memchr (in, '\n', in_end - in)));
+      p = mempcpy (p, in, in_end - in);
+      in = lines;
+      inlen = p - lines;
+    }
+
+  while (ok && inlen)
+    {
+      if (ctx->i == 0)
+        {
+          size_t n = base64_decode_simd (in, inlen, out, outleft);
+          in += n;
+          inlen -= n;
+          out += n / 4 * 3;
+          outleft -= n / 4 * 3;
+        }
+
+      /* Decode a few characters past where the kernel stopped, or
+         just enough to complete a group left over from the last call.  */
+      size_t seglen = MIN (inlen, ctx->i ? 4 - ctx->i : 32);
+      size_t n = outleft;
+      ok = base64_decode_ctx (ctx, in, seglen, out, &n);
+      in += seglen;
+      inlen -= seglen;
+      out += n;
+      outleft -= n;
+    }
+
+  *outlen -= outleft;
+  return ok;
+}
+
+#endif
+
 
 
 
@@ -279,7 +681,7 @@ base64_decode_ctx_wrapper (struct base_decode_context *ctx,
                            const char *restrict in, size_t inlen,
                            char *restrict out, size_t *outlen)
 {
-  bool b = base64_decode_ctx (&ctx->ctx.base64, in, inlen, out, outlen);
+  bool b = base64_decode_ctx_fast (&ctx->ctx.base64, in, inlen, out, outlen);
   ctx->i = ctx->ctx.base64.i;
   return b;
 }
@@ -306,7 +708,7 @@ static void
 base64url_encode (const char *restrict in, size_t inlen,
                   char *restrict out, size_t outlen)
 {
-  base64_encode (in, inlen, out, outlen);
+  base64_encode_fast (in, inlen, out, outlen);
   /* translate 62nd and 63rd characters */
   char* p = out;
   while (outlen--)
@@ -359,8 +761,8 @@ base64url_decode_ctx_wrapper (struct base_decode_context *ctx,
       ++p;
     }
 
-  bool b = base64_decode_ctx (&ctx->ctx.base64, ctx->inbuf, inlen,
-                              out, outlen);
+  bool b = base64_decode_ctx_fast (&ctx->ctx.base64, ctx->inbuf, inlen,
+                                   out, outlen);
   ctx->i = ctx->ctx.base64.i;
 
   return b;
@@ -506,6 +908,11 @@ static void
 base16_encode (const char *restrict in, size_t inlen,
                char *restrict out, size_t outlen)
 {
+  size_t n = base16_encode_simd (in, inlen, out);
+  in += n;
+  inlen -= n;
+  out += 2 * n;
+
   while (inlen--)
     {
       unsigned char c = *in;
@@ -532,6 +939,8 @@ base16_decode_ctx (struct base_decode_context *ctx,
 {
   bool ignore_lines = true;  /* for now, always ignore them */
   unsigned int nib;
+  size_t outsize = *outlen;
+  bool at_line_start = true;
 
   *outlen = 0;
 
@@ -541,11 +950,26 @@ base16_decode_ctx (struct base_decode_context *ctx,
   if (inlen == 0)
     return !ctx->ctx.base16.have_nibble;
 
-  while (inlen--)
+  while (inlen)
     {
+      /* Decode what we can of each line with the vectorized kernel.  */
+      if (at_line_start && !ctx->ctx.base16.have_nibble)
+        {
+          size_t n = base16_decode_simd (in, inlen, out, outsize - *outlen);
+          in += n;
+          inlen -= n;
+          out += n / 2;
+          *outlen += n / 2;
+          if (inlen == 0)
+            break;
+        }
+      at_line_start = false;
+      inlen--;
+
       if (ignore_lines && *in == '\n')
         {
           ++in;
+          at_line_start = true;
           continue;
         }
 
@@ -936,6 +1360,8 @@ static void
 wrap_write (const char *buffer, size_t len,
             uintmax_t wrap_column, size_t *current_column, FILE *out)
 {
+  static char *wrap_buf;
+  static size_t wrap_bufsize;
   size_t written;
 
   if (wrap_column == 0)
@@ -943,28 +1369,42 @@ wrap_write (const char *buffer, size_t len,
       /* Simple write. */
       if (fwrite (buffer, 1, len, stdout) < len)
         die (EXIT_FAILURE, errno, _("write error"));
+      return;
     }
-  else
-    for (written = 0; written < len;)
-      {
-        uintmax_t cols_remaining = wrap_column - *current_column;
-        size_t to_write = MIN (cols_remaining, SIZE_MAX);
-        to_write = MIN (to_write, len - written);
-
-        if (to_write == 0)
-          {
-            if (fputc ('\n', out) == EOF)
-              die (EXIT_FAILURE, errno, _("write error"));
-            *current_column = 0;
-          }
-        else
-          {
-            if (fwrite (buffer + written, 1, to_write, stdout) < to_write)
-              die (EXIT_FAILURE, errno, _("write error"));
-            *current_column += to_write;
-            written += to_write;
-          }
-      }
+
+  /* Copy the lines to WRAP_BUF with their newlines, so that
+     they are output with a single write.  */
+  size_t wrap_len = len + len / wrap_column + 1;
+  if (wrap_bufsize < wrap_len)
+    {
+      free (wrap_buf);
+      wrap_buf = xmalloc (wrap_len);
+      wrap_bufsize = wrap_len;
+    }
+  char *p = wrap_buf;
+
+  for (written = 0; written < len;)
+    {
+      uintmax_t cols_remaining = wrap_column - *current_column;
+      size_t to_write = MIN (cols_remaining, SIZE_MAX);
+      to_write = MIN (to_write, len - written);
+
+      if (to_write == 0)
+        {
+          *p++ = '\n';
+          *current_column = 0;
+        }
+      else
+        {
+          p = mempcpy (p, buffer + written, to_write);
+          *current_column += to_write;
+          written += to_write;
+        }
+    }
+
+  size_t wrap_buf_len = p - wrap_buf;
+  if (fwrite (wrap_buf, 1, wrap_buf_len, out) < wrap_buf_len)
+    die (EXIT_FAILURE, errno, _("write error"));
 }
 
 static void
@@ -1022,6 +1462,12 @@ do_decode (FILE *in, FILE *out, bool ignore_garbage)
   inbuf = xmalloc (BASE_LENGTH (DEC_BLOCKSIZE));
   outbuf = xmalloc (DEC_BLOCKSIZE);
 
+  /* The characters to keep with --ignore-garbage.  */
+  bool keep[UCHAR_MAX + 1];
+  if (ignore_garbage)
+    for (int c = 0; c <= UCHAR_MAX; c++)
+      keep[c] = isbase (c) || c == '=';
+
 #if BASE_TYPE == 42
   ctx.inbuf = NULL;
 #endif
@@ -1040,13 +1486,14 @@ do_decode (FILE *in, FILE *out, bool ignore_garbage)
 
           if (ignore_garbage)
             {
-              for (size_t i = 0; n > 0 && i < n;)
+              char *p = inbuf + sum;
+              size_t kept = 0;
+              for (size_t i = 0; i < n; i++)
                 {
-                  if (isbase (inbuf[sum + i]) || inbuf[sum + i] == '=')
-                    i++;
-                  else
-                    memmove (inbuf + sum + i, inbuf + sum + i + 1, --n - i);
+                  p[kept] = p[i];
+                  kept += keep[to_uchar (p[i])];
                 }
+              n = kept;
             }
 
           sum += n;
@@ -1153,7 +1600,7 @@ main (int argc, char **argv)
     case BASE64_OPTION:
       base_length = base64_length_wrapper;
       isbase = isbase64;
-      base_encode = base64_encode;
+      base_encode = base64_encode_fast;
       base_decode_ctx_init = base64_decode_ctx_init_wrapper;
       base_decode_ctx = base64_decode_ctx_wrapper;
       break;
@@ -1245,6 +1692,8 @@ main (int argc, char **argv)
 
   fadvise (input_fh, FADVISE_SEQUENTIAL);
 
+  simd_init ();
+
   if (decode)
     do_decode (input_fh, stdout, ignore_garbage);
   else
@@ -29,6 +29,7 @@
 #include "fts_.h"
 #include "quote.h"
 #include "root-dev-ino.h"
+#include "xdectoint.h"
 #include "xstrtol.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
@@ -52,6 +53,7 @@ enum
 {
   DEREFERENCE_OPTION = CHAR_MAX + 1,
   NO_PRESERVE_ROOT,
+  PARALLEL_OPTION,
   PRESERVE_ROOT,
   REFERENCE_FILE_OPTION
 };
@@ -63,6 +65,7 @@ static struct option const long_options[] =
   {"dereference", no_argument, NULL, DEREFERENCE_OPTION},
   {"no-dereference", no_argument, NULL, 'h'},
   {"no-preserve-root", no_argument, NULL, NO_PRESERVE_ROOT},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"preserve-root", no_argument, NULL, PRESERVE_ROOT},
   {"quiet", no_argument, NULL, 'f'},
   {"silent", no_argument, NULL, 'f'},
@@ -133,6 +136,7 @@ With --reference, change the group of each FILE to that of RFILE.\n\
 "), stdout);
       fputs (_("\
       --no-preserve-root  do not treat '/' specially (the default)\n\
+      --parallel=N       with -R, change up to N files at once\n\
       --preserve-root    fail to operate recursively on '/'\n\
 "), stdout);
       fputs (_("\
@@ -226,6 +230,11 @@ main (int argc, char **argv)
           preserve_root = false;
           break;
 
+        case PARALLEL_OPTION:
+          chopt.n_threads = xdectoumax (optarg, 1, SIZE_MAX / 16, "",
+                                        _("invalid number of threads"), 0);
+          break;
+
         case PRESERVE_ROOT:
           preserve_root = true;
           break;
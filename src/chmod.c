@@ -26,10 +26,12 @@
 #include "die.h"
 #include "error.h"
 #include "filemode.h"
+#include "fts-jobs.h"
 #include "ignore-value.h"
 #include "modechange.h"
 #include "quote.h"
 #include "root-dev-ino.h"
+#include "xdectoint.h"
 #include "xfts.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
@@ -83,11 +85,30 @@ static enum Verbosity verbosity = V_off;
    Otherwise NULL.  */
 static struct dev_ino *root_dev_ino;
 
+/* The number of threads with which to change files, with --recursive.  */
+static size_t n_threads = 1;
+
+/* The changes being made by those threads, or NULL if none.  */
+static struct fts_jobs *jobs;
+
+/* A change of the mode of a file, from OLD_MODE to NEW_MODE.  */
+struct change
+{
+  struct fts_job job;
+  mode_t old_mode;
+  mode_t new_mode;
+  bool chmod_succeeded;
+  int chmod_errno;		/* The errno value if chmod failed.  */
+  mode_t actual_mode;		/* The mode after the change, if verbose.  */
+  int stat_errno;		/* The errno value if that was not found.  */
+};
+
 /* For long options that have no equivalent short option, use a
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
 {
   NO_PRESERVE_ROOT = CHAR_MAX + 1,
+  PARALLEL_OPTION,
   PRESERVE_ROOT,
   REFERENCE_FILE_OPTION
 };
@@ -97,6 +118,7 @@ static struct option const long_options[] =
   {"changes", no_argument, NULL, 'c'},
   {"recursive", no_argument, NULL, 'R'},
   {"no-preserve-root", no_argument, NULL, NO_PRESERVE_ROOT},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"preserve-root", no_argument, NULL, PRESERVE_ROOT},
   {"quiet", no_argument, NULL, 'f'},
   {"reference", required_argument, NULL, REFERENCE_FILE_OPTION},
@@ -107,32 +129,21 @@ static struct option const long_options[] =
   {NULL, 0, NULL, 0}
 };
 
-/* Return true if the chmodable permission bits of FILE changed.
-   The old mode was OLD_MODE, but it was changed to NEW_MODE.  */
+/* Return true if the chmodable permission bits of the file of CH
+   changed.  */
 
 static bool
-mode_changed (int dir_fd, char const *file, char const *file_full_name,
-              mode_t old_mode, mode_t new_mode)
+mode_changed (struct change const *ch)
 {
-  if (new_mode & (S_ISUID | S_ISGID | S_ISVTX))
+  if (ch->stat_errno)
     {
-      /* The new mode contains unusual bits that the call to chmod may
-         have silently cleared.  Check whether they actually changed.  */
-
-      struct stat new_stats;
-
-      if (fstatat (dir_fd, file, &new_stats, 0) != 0)
-        {
-          if (! force_silent)
-            error (0, errno, _("getting new attributes of %s"),
-                   quoteaf (file_full_name));
-          return false;
-        }
-
-      new_mode = new_stats.st_mode;
+      if (! force_silent)
+        error (0, ch->stat_errno, _("getting new attributes of %s"),
+               quoteaf (ch->job.full_name));
+      return false;
     }
 
-  return ((old_mode ^ new_mode) & CHMOD_MODE_BITS) != 0;
+  return ((ch->old_mode ^ ch->actual_mode) & CHMOD_MODE_BITS) != 0;
 }
 
 /* Tell the user how/if the MODE of FILE has been changed.
@@ -180,6 +191,100 @@ describe_change (const char *file, mode_t old_mode, mode_t mode,
           (unsigned long int) (mode & CHMOD_MODE_BITS), &perms[1]);
 }
 
+/* Apply the change of JOB, a struct change, recording the results.
+   This may be called by a helper thread, so it must not output.  */
+
+static void
+apply_change (struct fts_job *job)
+{
+  struct change *ch = (struct change *) job;
+
+  ch->chmod_succeeded = false;
+  ch->chmod_errno = 0;
+  ch->actual_mode = ch->new_mode;
+  ch->stat_errno = 0;
+
+  if (! S_ISLNK (ch->old_mode))
+    {
+      if (chmodat (job->dir_fd, job->file, ch->new_mode) == 0)
+        ch->chmod_succeeded = true;
+      else
+        ch->chmod_errno = errno;
+    }
+
+  if (verbosity != V_off && ch->chmod_succeeded
+      && (ch->new_mode & (S_ISUID | S_ISGID | S_ISVTX)))
+    {
+      /* The new mode contains unusual bits that the call to chmod may
+         have silently cleared.  Check whether they actually changed.  */
+
+      struct stat new_stats;
+
+      if (fstatat (job->dir_fd, job->file, &new_stats, 0) != 0)
+        ch->stat_errno = errno;
+      else
+        ch->actual_mode = new_stats.st_mode;
+    }
+}
+
+/* Report the change of JOB, a struct change, once applied.
+   Return true if successful.  */
+
+static bool
+report_change (struct fts_job *job)
+{
+  struct change *ch = (struct change *) job;
+  char const *file_full_name = job->full_name;
+  mode_t old_mode = ch->old_mode;
+  mode_t new_mode = ch->new_mode;
+  bool chmod_succeeded = ch->chmod_succeeded;
+  bool ok = true;
+
+  if (ch->chmod_errno)
+    {
+      if (! force_silent)
+        error (0, ch->chmod_errno, _("changing permissions of %s"),
+               quoteaf (file_full_name));
+      ok = false;
+    }
+
+  if (verbosity != V_off)
+    {
+      bool changed = chmod_succeeded && mode_changed (ch);
+
+      if (changed || verbosity == V_high)
+        {
+          enum Change_status ch_status =
+            (!ok ? CH_FAILED
+             : !chmod_succeeded ? CH_NOT_APPLIED
+             : !changed ? CH_NO_CHANGE_REQUESTED
+             : CH_SUCCEEDED);
+          describe_change (file_full_name, old_mode, new_mode, ch_status);
+        }
+    }
+
+  if (chmod_succeeded && diagnose_surprises)
+    {
+      mode_t naively_expected_mode =
+        mode_adjust (old_mode, S_ISDIR (old_mode) != 0, 0, change, NULL);
+      if (new_mode & ~naively_expected_mode)
+        {
+          char new_perms[12];
+          char naively_expected_perms[12];
+          strmode (new_mode, new_perms);
+          strmode (naively_expected_mode, naively_expected_perms);
+          new_perms[10] = naively_expected_perms[10] = '\0';
+          error (0, 0,
+                 _("%s: new permissions are %s, not %s"),
+                 quotef (file_full_name),
+                 new_perms + 1, naively_expected_perms + 1);
+          ok = false;
+        }
+    }
+
+  return ok;
+}
+
 /* Change the mode of FILE.
    Return true if successful.  This function is called
    once for every file system object that fts encounters.  */
@@ -188,12 +293,18 @@ static bool
 process_file (FTS *fts, FTSENT *ent)
 {
   char const *file_full_name = ent->fts_path;
-  char const *file = ent->fts_accpath;
   const struct stat *file_stats = ent->fts_statp;
-  mode_t old_mode IF_LINT ( = 0);
-  mode_t new_mode IF_LINT ( = 0);
   bool ok = true;
-  bool chmod_succeeded = false;
+
+  /* Output the changes being made by other threads before any
+     diagnostic for this file.  */
+  if (jobs)
+    switch (ent->fts_info)
+      {
+      case FTS_NS: case FTS_ERR: case FTS_DNR: case FTS_SLNONE: case FTS_DC:
+        fts_jobs_flush (jobs);
+        break;
+      }
 
   switch (ent->fts_info)
     {
@@ -254,6 +365,8 @@ process_file (FTS *fts, FTSENT *ent)
 
   if (ok && ROOT_DEV_INO_CHECK (root_dev_ino, file_stats))
     {
+      if (jobs)
+        fts_jobs_flush (jobs);
       ROOT_DEV_INO_WARN (file_full_name);
       /* Tell fts not to traverse into this hierarchy.  */
       fts_set (fts, ent, FTS_SKIP);
@@ -264,59 +377,40 @@ process_file (FTS *fts, FTSENT *ent)
 
   if (ok)
     {
-      old_mode = file_stats->st_mode;
-      new_mode = mode_adjust (old_mode, S_ISDIR (old_mode) != 0, umask_value,
-                              change, NULL);
+      struct stat stat_buf;
+      bool now = ent->fts_info == FTS_D;
 
-      if (! S_ISLNK (old_mode))
+      /* Start from the current mode of a file that a queued job may
+         already have changed under another name.  */
+      if (jobs && fts_jobs_sync (jobs, fts, ent, &stat_buf))
         {
-          if (chmodat (fts->fts_cwd_fd, file, new_mode) == 0)
-            chmod_succeeded = true;
-          else
-            {
-              if (! force_silent)
-                error (0, errno, _("changing permissions of %s"),
-                       quoteaf (file_full_name));
-              ok = false;
-            }
+          file_stats = &stat_buf;
+          now = true;
         }
-    }
 
-  if (verbosity != V_off)
-    {
-      bool changed = (chmod_succeeded
-                      && mode_changed (fts->fts_cwd_fd, file, file_full_name,
-                                       old_mode, new_mode));
+      struct change local;
+      struct change *ch = jobs ? xmalloc (sizeof *ch) : &local;
+      ch->old_mode = file_stats->st_mode;
+      ch->new_mode = mode_adjust (ch->old_mode, S_ISDIR (ch->old_mode) != 0,
+                                  umask_value, change, NULL);
 
-      if (changed || verbosity == V_high)
+      if (jobs)
         {
-          enum Change_status ch_status =
-            (!ok ? CH_FAILED
-             : !chmod_succeeded ? CH_NOT_APPLIED
-             : !changed ? CH_NO_CHANGE_REQUESTED
-             : CH_SUCCEEDED);
-          describe_change (file_full_name, old_mode, new_mode, ch_status);
+          /* Change a directory before fts reads it, as without threads.
+             Likewise for a file synced above.  */
+          fts_jobs_add (jobs, fts, ent, &ch->job, now);
         }
-    }
-
-  if (chmod_succeeded && diagnose_surprises)
-    {
-      mode_t naively_expected_mode =
-        mode_adjust (old_mode, S_ISDIR (old_mode) != 0, 0, change, NULL);
-      if (new_mode & ~naively_expected_mode)
+      else
         {
-          char new_perms[12];
-          char naively_expected_perms[12];
-          strmode (new_mode, new_perms);
-          strmode (naively_expected_mode, naively_expected_perms);
-          new_perms[10] = naively_expected_perms[10] = '\0';
-          error (0, 0,
-                 _("%s: new permissions are %s, not %s"),
-                 quotef (file_full_name),
-                 new_perms + 1, naively_expected_perms + 1);
-          ok = false;
+          ch->job.dir_fd = fts->fts_cwd_fd;
+          ch->job.file = ent->fts_accpath;
+          ch->job.full_name = ent->fts_path;
+          apply_change (&ch->job);
+          ok = report_change (&ch->job);
         }
     }
+  else if (verbosity == V_high)
+    describe_change (file_full_name, 0, 0, CH_FAILED);
 
   if ( ! recurse)
     fts_set (fts, ent, FTS_SKIP);
@@ -335,6 +429,9 @@ process_files (char **files, int bit_flags)
 
   FTS *fts = xfts_open (files, bit_flags, NULL);
 
+  if (recurse && 1 < n_threads)
+    jobs = fts_jobs_create (n_threads, apply_change, report_change);
+
   while (1)
     {
       FTSENT *ent;
@@ -344,9 +441,12 @@ process_files (char **files, int bit_flags)
         {
           if (errno != 0)
             {
+              int saved_errno = errno;
+              if (jobs)
+                fts_jobs_flush (jobs);
               /* FIXME: try to give a better message  */
               if (! force_silent)
-                error (0, errno, _("fts_read failed"));
+                error (0, saved_errno, _("fts_read failed"));
               ok = false;
             }
           break;
@@ -355,6 +455,12 @@ process_files (char **files, int bit_flags)
       ok &= process_file (fts, ent);
     }
 
+  if (jobs)
+    {
+      ok &= fts_jobs_free (jobs);
+      jobs = NULL;
+    }
+
   if (fts_close (fts) != 0)
     {
       error (0, errno, _("fts_close failed"));
@@ -389,6 +495,7 @@ With --reference, change the mode of each FILE to that of RFILE.\n\
 "), stdout);
       fputs (_("\
       --no-preserve-root  do not treat '/' specially (the default)\n\
+      --parallel=N       with -R, change up to N files at once\n\
       --preserve-root    fail to operate recursively on '/'\n\
 "), stdout);
       fputs (_("\
@@ -484,6 +591,10 @@ main (int argc, char **argv)
         case NO_PRESERVE_ROOT:
           preserve_root = false;
           break;
+        case PARALLEL_OPTION:
+          n_threads = xdectoumax (optarg, 1, SIZE_MAX / 16, "",
+                                  _("invalid number of threads"), 0);
+          break;
         case PRESERVE_ROOT:
           preserve_root = true;
           break;
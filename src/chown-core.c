@@ -25,6 +25,7 @@
 #include "system.h"
 #include "chown-core.h"
 #include "error.h"
+#include "fts-jobs.h"
 #include "ignore-value.h"
 #include "root-dev-ino.h"
 #include "xfts.h"
@@ -54,6 +55,24 @@ enum RCH_status
     RC_error
   };
 
+/* A change of the owner and/or group of a file to UID and/or GID,
+   as requested by change_file_owner.  */
+struct owner_change
+{
+  struct fts_job job;
+  uid_t uid;
+  gid_t gid;
+  uid_t required_uid;
+  gid_t required_gid;
+  struct Chown_option const *chopt;
+  struct stat file_stats;
+  bool have_stats;		/* Whether FILE_STATS is known.  */
+  bool do_chown;
+  bool ok;
+  bool symlink_changed;
+  int chown_errno;		/* The errno value if chown failed.  */
+};
+
 extern void
 chopt_init (struct Chown_option *chopt)
 {
@@ -64,6 +83,7 @@ chopt_init (struct Chown_option *chopt)
   chopt->force_silent = false;
   chopt->user_name = NULL;
   chopt->group_name = NULL;
+  chopt->n_threads = 1;
 }
 
 extern void
@@ -261,17 +281,140 @@ restricted_chown (int cwd_fd, char const *file,
   return status;
 }
 
+/* Apply the change of JOB, a struct owner_change, recording the
+   results.  This may be called by a helper thread, so it must not
+   output.  */
+static void
+apply_owner_change (struct fts_job *job)
+{
+  struct owner_change *oc = (struct owner_change *) job;
+  uid_t uid = oc->uid;
+  gid_t gid = oc->gid;
+
+  if (! oc->do_chown)
+    return;
+
+  if ( ! oc->chopt->affect_symlink_referent)
+    {
+      oc->ok = (lchownat (job->dir_fd, job->file, uid, gid) == 0);
+
+      /* Ignore any error due to lack of support; POSIX requires
+         this behavior for top-level symbolic links with -h, and
+         implies that it's required for all symbolic links.  */
+      if (!oc->ok && errno == EOPNOTSUPP)
+        {
+          oc->ok = true;
+          oc->symlink_changed = false;
+        }
+    }
+  else
+    {
+      /* If possible, avoid a race condition with --from=O:G and without the
+         (-h) --no-dereference option.  If fts's stat call determined
+         that the uid/gid of FILE matched the --from=O:G-selected
+         owner and group IDs, blindly using chown(2) here could lead
+         chown(1) or chgrp(1) mistakenly to dereference a *symlink*
+         to an arbitrary file that an attacker had moved into the
+         place of FILE during the window between the stat and
+         chown(2) calls.  If FILE is a regular file or a directory
+         that can be opened, this race condition can be avoided safely.  */
+
+      enum RCH_status err
+        = restricted_chown (job->dir_fd, job->file, &oc->file_stats,
+                            uid, gid, oc->required_uid, oc->required_gid);
+      switch (err)
+        {
+        case RC_ok:
+          break;
+
+        case RC_do_ordinary_chown:
+          oc->ok = (chownat (job->dir_fd, job->file, uid, gid) == 0);
+          break;
+
+        case RC_error:
+          oc->ok = false;
+          break;
+
+        case RC_inode_changed:
+          /* FIXME: give a diagnostic in this case?  */
+        case RC_excluded:
+          oc->do_chown = false;
+          oc->ok = false;
+          break;
+
+        default:
+          abort ();
+        }
+    }
+
+  oc->chown_errno = errno;
+
+  /* On some systems (e.g., GNU/Linux 2.4.x),
+     the chown function resets the 'special' permission bits.
+     Do *not* restore those bits;  doing so would open a window in
+     which a malicious user, M, could subvert a chown command run
+     by some other user and operating on files in a directory
+     where M has write access.  */
+}
+
+/* Report the change of JOB, a struct owner_change, once applied.
+   Return true if successful.  */
+static bool
+report_owner_change (struct fts_job *job)
+{
+  struct owner_change *oc = (struct owner_change *) job;
+  struct Chown_option const *chopt = oc->chopt;
+  struct stat const *file_stats = oc->have_stats ? &oc->file_stats : NULL;
+  uid_t uid = oc->uid;
+  gid_t gid = oc->gid;
+  bool ok = oc->ok;
+
+  if (oc->do_chown && !ok && ! chopt->force_silent)
+    error (0, oc->chown_errno, (uid != (uid_t) -1
+                                ? _("changing ownership of %s")
+                                : _("changing group of %s")),
+           quoteaf (job->full_name));
+
+  if (chopt->verbosity != V_off)
+    {
+      bool changed =
+        ((oc->do_chown && ok && oc->symlink_changed)
+         && ! ((uid == (uid_t) -1 || uid == file_stats->st_uid)
+               && (gid == (gid_t) -1 || gid == file_stats->st_gid)));
+
+      if (changed || chopt->verbosity == V_high)
+        {
+          enum Change_status ch_status =
+            (!ok ? CH_FAILED
+             : !oc->symlink_changed ? CH_NOT_APPLIED
+             : !changed ? CH_NO_CHANGE_REQUESTED
+             : CH_SUCCEEDED);
+          char *old_usr = file_stats ? uid_to_name (file_stats->st_uid) : NULL;
+          char *old_grp = file_stats ? gid_to_name (file_stats->st_gid) : NULL;
+          describe_change (job->full_name, ch_status,
+                           old_usr, old_grp,
+                           chopt->user_name, chopt->group_name);
+          free (old_usr);
+          free (old_grp);
+        }
+    }
+
+  return ok;
+}
+
 /* Change the owner and/or group of the file specified by FTS and ENT
    to UID and/or GID as appropriate.
    If REQUIRED_UID is not -1, then skip files with any other user ID.
    If REQUIRED_GID is not -1, then skip files with any other group ID.
    CHOPT specifies additional options.
+   If JOBS is not NULL, queue the change to be made by its threads.
    Return true if successful.  */
 static bool
 change_file_owner (FTS *fts, FTSENT *ent,
                    uid_t uid, gid_t gid,
                    uid_t required_uid, gid_t required_gid,
-                   struct Chown_option const *chopt)
+                   struct Chown_option const *chopt,
+                   struct fts_jobs *jobs)
 {
   char const *file_full_name = ent->fts_path;
   char const *file = ent->fts_accpath;
@@ -279,7 +422,17 @@ change_file_owner (FTS *fts, FTSENT *ent,
   struct stat stat_buf;
   bool ok = true;
   bool do_chown;
-  bool symlink_changed = true;
+  bool now = false;
+
+  /* Output the changes being made by other threads before any
+     diagnostic for this file.  */
+  if (jobs)
+    switch (ent->fts_info)
+      {
+      case FTS_NS: case FTS_ERR: case FTS_DNR: case FTS_DC:
+        fts_jobs_flush (jobs);
+        break;
+      }
 
   switch (ent->fts_info)
     {
@@ -288,6 +441,8 @@ change_file_owner (FTS *fts, FTSENT *ent,
         {
           if (ROOT_DEV_INO_CHECK (chopt->root_dev_ino, ent->fts_statp))
             {
+              if (jobs)
+                fts_jobs_flush (jobs);
               /* This happens e.g., with "chown -R --preserve-root 0 /"
                  and with "chown -RH --preserve-root 0 symlink-to-root".  */
               ROOT_DEV_INO_WARN (file_full_name);
@@ -368,14 +523,28 @@ change_file_owner (FTS *fts, FTSENT *ent,
     {
       file_stats = ent->fts_statp;
 
+      /* Match --from and report against the current owner of a file
+         that a queued job may already have changed under another name.  */
+      if (jobs
+          && (chopt->verbosity != V_off
+              || required_uid != (uid_t) -1 || required_gid != (gid_t) -1)
+          && fts_jobs_sync (jobs, fts, ent, &stat_buf))
+        {
+          file_stats = &stat_buf;
+          now = true;
+        }
+
       /* If this is a symlink and we're dereferencing them,
          stat it to get info on the referent.  */
       if (chopt->affect_symlink_referent && S_ISLNK (file_stats->st_mode))
         {
           if (fstatat (fts->fts_cwd_fd, file, &stat_buf, 0) != 0)
             {
+              int saved_errno = errno;
+              if (jobs)
+                fts_jobs_flush (jobs);
               if (! chopt->force_silent)
-                error (0, errno, _("cannot dereference %s"),
+                error (0, saved_errno, _("cannot dereference %s"),
                        quoteaf (file_full_name));
               ok = false;
             }
@@ -395,101 +564,35 @@ change_file_owner (FTS *fts, FTSENT *ent,
       && FTSENT_IS_DIRECTORY (ent)
       && ROOT_DEV_INO_CHECK (chopt->root_dev_ino, file_stats))
     {
+      if (jobs)
+        fts_jobs_flush (jobs);
       ROOT_DEV_INO_WARN (file_full_name);
       return false;
     }
 
-  if (do_chown)
-    {
-      if ( ! chopt->affect_symlink_referent)
-        {
-          ok = (lchownat (fts->fts_cwd_fd, file, uid, gid) == 0);
-
-          /* Ignore any error due to lack of support; POSIX requires
-             this behavior for top-level symbolic links with -h, and
-             implies that it's required for all symbolic links.  */
-          if (!ok && errno == EOPNOTSUPP)
-            {
-              ok = true;
-              symlink_changed = false;
-            }
-        }
-      else
-        {
-          /* If possible, avoid a race condition with --from=O:G and without the
-             (-h) --no-dereference option.  If fts's stat call determined
-             that the uid/gid of FILE matched the --from=O:G-selected
-             owner and group IDs, blindly using chown(2) here could lead
-             chown(1) or chgrp(1) mistakenly to dereference a *symlink*
-             to an arbitrary file that an attacker had moved into the
-             place of FILE during the window between the stat and
-             chown(2) calls.  If FILE is a regular file or a directory
-             that can be opened, this race condition can be avoided safely.  */
-
-          enum RCH_status err
-            = restricted_chown (fts->fts_cwd_fd, file, file_stats, uid, gid,
-                                required_uid, required_gid);
-          switch (err)
-            {
-            case RC_ok:
-              break;
-
-            case RC_do_ordinary_chown:
-              ok = (chownat (fts->fts_cwd_fd, file, uid, gid) == 0);
-              break;
-
-            case RC_error:
-              ok = false;
-              break;
-
-            case RC_inode_changed:
-              /* FIXME: give a diagnostic in this case?  */
-            case RC_excluded:
-              do_chown = false;
-              ok = false;
-              break;
-
-            default:
-              abort ();
-            }
-        }
-
-      /* On some systems (e.g., GNU/Linux 2.4.x),
-         the chown function resets the 'special' permission bits.
-         Do *not* restore those bits;  doing so would open a window in
-         which a malicious user, M, could subvert a chown command run
-         by some other user and operating on files in a directory
-         where M has write access.  */
-
-      if (do_chown && !ok && ! chopt->force_silent)
-        error (0, errno, (uid != (uid_t) -1
-                          ? _("changing ownership of %s")
-                          : _("changing group of %s")),
-               quoteaf (file_full_name));
-    }
-
-  if (chopt->verbosity != V_off)
+  struct owner_change local;
+  struct owner_change *oc = jobs && ok ? xmalloc (sizeof *oc) : &local;
+  oc->uid = uid;
+  oc->gid = gid;
+  oc->required_uid = required_uid;
+  oc->required_gid = required_gid;
+  oc->chopt = chopt;
+  oc->have_stats = !!file_stats;
+  if (file_stats)
+    oc->file_stats = *file_stats;
+  oc->do_chown = do_chown;
+  oc->ok = ok;
+  oc->symlink_changed = true;
+
+  if (oc != &local)
+    fts_jobs_add (jobs, fts, ent, &oc->job, now || !do_chown);
+  else
     {
-      bool changed =
-        ((do_chown && ok && symlink_changed)
-         && ! ((uid == (uid_t) -1 || uid == file_stats->st_uid)
-               && (gid == (gid_t) -1 || gid == file_stats->st_gid)));
-
-      if (changed || chopt->verbosity == V_high)
-        {
-          enum Change_status ch_status =
-            (!ok ? CH_FAILED
-             : !symlink_changed ? CH_NOT_APPLIED
-             : !changed ? CH_NO_CHANGE_REQUESTED
-             : CH_SUCCEEDED);
-          char *old_usr = file_stats ? uid_to_name (file_stats->st_uid) : NULL;
-          char *old_grp = file_stats ? gid_to_name (file_stats->st_gid) : NULL;
-          describe_change (file_full_name, ch_status,
-                           old_usr, old_grp,
-                           chopt->user_name, chopt->group_name);
-          free (old_usr);
-          free (old_grp);
-        }
+      oc->job.dir_fd = fts->fts_cwd_fd;
+      oc->job.file = ent->fts_accpath;
+      oc->job.full_name = ent->fts_path;
+      apply_owner_change (&oc->job);
+      ok = report_owner_change (&oc->job);
     }
 
   if ( ! chopt->recurse)
@@ -524,6 +627,11 @@ chown_files (char **files, int bit_flags,
 
   FTS *fts = xfts_open (files, bit_flags | stat_flags, NULL);
 
+  struct fts_jobs *jobs = NULL;
+  if (chopt->recurse && 1 < chopt->n_threads)
+    jobs = fts_jobs_create (chopt->n_threads,
+                            apply_owner_change, report_owner_change);
+
   while (1)
     {
       FTSENT *ent;
@@ -533,18 +641,24 @@ chown_files (char **files, int bit_flags,
         {
           if (errno != 0)
             {
+              int saved_errno = errno;
+              if (jobs)
+                fts_jobs_flush (jobs);
               /* FIXME: try to give a better message  */
               if (! chopt->force_silent)
-                error (0, errno, _("fts_read failed"));
+                error (0, saved_errno, _("fts_read failed"));
               ok = false;
             }
           break;
         }
 
       ok &= change_file_owner (fts, ent, uid, gid,
-                               required_uid, required_gid, chopt);
+                               required_uid, required_gid, chopt, jobs);
     }
 
+  if (jobs)
+    ok &= fts_jobs_free (jobs);
+
   if (fts_close (fts) != 0)
     {
       error (0, errno, _("fts_close failed"));
@@ -63,6 +63,9 @@ struct Chown_option
 
   /* The name of the group to which ownership of the files is being given. */
   char *group_name;
+
+  /* The number of threads with which to change files, when recursive.  */
+  size_t n_threads;
 };
 
 void
@@ -28,6 +28,7 @@
 #include "fts_.h"
 #include "quote.h"
 #include "root-dev-ino.h"
+#include "xdectoint.h"
 #include "userspec.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
@@ -48,6 +49,7 @@ enum
   DEREFERENCE_OPTION = CHAR_MAX + 1,
   FROM_OPTION,
   NO_PRESERVE_ROOT,
+  PARALLEL_OPTION,
   PRESERVE_ROOT,
   REFERENCE_FILE_OPTION
 };
@@ -60,6 +62,7 @@ static struct option const long_options[] =
   {"from", required_argument, NULL, FROM_OPTION},
   {"no-dereference", no_argument, NULL, 'h'},
   {"no-preserve-root", no_argument, NULL, NO_PRESERVE_ROOT},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"preserve-root", no_argument, NULL, PRESERVE_ROOT},
   {"quiet", no_argument, NULL, 'f'},
   {"silent", no_argument, NULL, 'f'},
@@ -110,6 +113,7 @@ With --reference, change the owner and group of each FILE to those of RFILE.\n\
 "), stdout);
       fputs (_("\
       --no-preserve-root  do not treat '/' specially (the default)\n\
+      --parallel=N       with -R, change up to N files at once\n\
       --preserve-root    fail to operate recursively on '/'\n\
 "), stdout);
       fputs (_("\
@@ -217,6 +221,11 @@ main (int argc, char **argv)
           preserve_root = false;
           break;
 
+        case PARALLEL_OPTION:
+          chopt.n_threads = xdectoumax (optarg, 1, SIZE_MAX / 16, "",
+                                        _("invalid number of threads"), 0);
+          break;
+
         case PRESERVE_ROOT:
           preserve_root = true;
           break;
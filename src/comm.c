@@ -22,6 +22,7 @@
 #include <sys/types.h>
 #include "system.h"
 #include "linebuffer.h"
+#include "line-reader.h"
 #include "die.h"
 #include "error.h"
 #include "fadvise.h"
@@ -245,6 +246,38 @@ check_order (struct linebuffer const *prev,
     }
 }
 
+/* For each file, we have four linebuffers in lba.  These are usually
+   views into the buffer of the file's reader, and are copied into the
+   corresponding lba_store entries when that buffer is refilled.  */
+static struct linebuffer lba[2][4];
+static struct linebuffer lba_store[2][4];
+
+/* The readers for the two files.  reader[1] is reader[0] if both files
+   are standard input.  */
+static struct line_reader readers[2];
+static struct line_reader *reader[2];
+
+/* Save the lines of the files read by the reader ARG,
+   before it refills its buffer.  */
+
+static void
+keep_lines (void *arg)
+{
+  for (int i = 0; i < 2; i++)
+    if (reader[i] == arg)
+      for (int j = 0; j < 4; j++)
+        line_reader_keep (reader[i], &lba[i][j], &lba_store[i][j]);
+}
+
+/* Read the next line of file I into LINE.
+   Return LINE, or NULL at end of file or upon read error.  */
+
+static struct linebuffer *
+next_line (struct linebuffer *line, int i)
+{
+  return line_reader_next (reader[i], line) ? line : NULL;
+}
+
 /* Compare INFILES[0] and INFILES[1].
    If either is "-", use the standard input for that file.
    Assume that each input file is sorted;
@@ -253,9 +286,6 @@ check_order (struct linebuffer const *prev,
 static void
 compare_files (char **infiles)
 {
-  /* For each file, we have four linebuffers in lba. */
-  struct linebuffer lba[2][4];
-
   /* thisline[i] points to the linebuffer holding the next available line
      in file i, or is NULL if there are no lines left in that file.  */
   struct linebuffer *thisline[2];
@@ -282,6 +312,7 @@ compare_files (char **infiles)
       for (j = 0; j < 4; j++)
         {
           initbuffer (&lba[i][j]);
+          initbuffer (&lba_store[i][j]);
           all_line[i][j] = &lba[i][j];
         }
       alt[i][0] = 0;
@@ -293,10 +324,24 @@ compare_files (char **infiles)
 
       fadvise (streams[i], FADVISE_SEQUENTIAL);
 
-      thisline[i] = readlinebuffer_delim (all_line[i][alt[i][0]], streams[i],
-                                          delim);
-      if (ferror (streams[i]))
-        die (EXIT_FAILURE, errno, "%s", quotef (infiles[i]));
+      /* When both files are standard input, they share a reader,
+         just as they would share a stream.  */
+      if (i == 1 && streams[1] == streams[0])
+        reader[1] = reader[0];
+      else
+        {
+          reader[i] = &readers[i];
+          line_reader_init (reader[i], fileno (streams[i]), delim);
+          reader[i]->before_refill = keep_lines;
+          reader[i]->before_refill_arg = reader[i];
+        }
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      thisline[i] = next_line (all_line[i][alt[i][0]], i);
+      if (reader[i]->errnum)
+        die (EXIT_FAILURE, reader[i]->errnum, "%s", quotef (infiles[i]));
     }
 
   while (thisline[0] || thisline[1])
@@ -365,8 +410,7 @@ compare_files (char **infiles)
             alt[i][1] = alt[i][0];
             alt[i][0] = (alt[i][0] + 1) & 0x03;
 
-            thisline[i] = readlinebuffer_delim (all_line[i][alt[i][0]],
-                                                streams[i], delim);
+            thisline[i] = next_line (all_line[i][alt[i][0]], i);
 
             if (thisline[i])
               check_order (all_line[i][alt[i][1]], thisline[i], i + 1);
@@ -378,8 +422,9 @@ compare_files (char **infiles)
               check_order (all_line[i][alt[i][2]],
                            all_line[i][alt[i][1]], i + 1);
 
-            if (ferror (streams[i]))
-              die (EXIT_FAILURE, errno, "%s", quotef (infiles[i]));
+            if (reader[i]->errnum)
+              die (EXIT_FAILURE, reader[i]->errnum, "%s",
+                   quotef (infiles[i]));
 
             fill_up[i] = false;
           }
@@ -389,6 +434,14 @@ compare_files (char **infiles)
     if (fclose (streams[i]) != 0)
       die (EXIT_FAILURE, errno, "%s", quotef (infiles[i]));
 
+  for (i = 0; i < 2; i++)
+    {
+      if (reader[i] == &readers[i])
+        line_reader_free (reader[i]);
+      for (j = 0; j < 4; j++)
+        free (lba_store[i][j].buffer);
+    }
+
   if (total_option)
     {
       /* Print the summary, minding the column and line delimiters.  */
@@ -34,6 +34,8 @@
 #include "fadvise.h"
 #include "getndelim2.h"
 #include "hash.h"
+#include "ioblksize.h"
+#include "safe-read.h"
 #include "xstrndup.h"
 
 #include "set-fields.h"
@@ -111,9 +113,22 @@ static size_t output_delimiter_length;
    string consisting of the input delimiter.  */
 static char *output_delimiter_string;
 
+/* True if the output delimiter is the input delimiter, so that a run
+   of consecutive selected fields can be copied to the output as is.  */
+static bool output_delimiter_is_delim;
+
 /* True if we have ever read standard input. */
 static bool have_read_stdin;
 
+/* The input buffer.  Lines and fields may span its boundaries.  */
+static char io_buf[IO_BUFSIZE];
+
+/* The output buffer, and the number of bytes in it.  It is flushed
+   after each input block, so output is not delayed when reading from
+   a pipe.  */
+static char out_buf[IO_BUFSIZE];
+static size_t out_len;
+
 /* For long options that have no equivalent short option, use a
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
@@ -227,63 +242,142 @@ is_range_start_index (uintmax_t k)
   return k == current_rp->lo;
 }
 
-/* Read from stream STREAM, printing to standard output any selected bytes.  */
+/* Write the contents of OUT_BUF to standard output.  */
 
 static void
+flush_output (void)
+{
+  fwrite (out_buf, sizeof (char), out_len, stdout);
+  out_len = 0;
+}
+
+/* Append the N bytes at BUF to the output.  */
+
+static inline void
+write_bytes (char const *buf, size_t n)
+{
+  if (sizeof out_buf - out_len < n)
+    {
+      flush_output ();
+      if (sizeof out_buf < n)
+        {
+          fwrite (buf, sizeof (char), n, stdout);
+          return;
+        }
+    }
+  memcpy (out_buf + out_len, buf, n);
+  out_len += n;
+}
+
+/* Append a line delimiter to the output.  */
+
+static inline void
+write_line_delim (void)
+{
+  if (out_len == sizeof out_buf)
+    flush_output ();
+  out_buf[out_len++] = line_delim;
+}
+
+/* Read the next block of STREAM into IO_BUF.  Return the number of
+   bytes read, 0 at end of file, or SAFE_READ_ERROR on failure.  */
+
+static size_t
+read_block (FILE *stream)
+{
+  return safe_read (fileno (stream), io_buf, sizeof io_buf);
+}
+
+/* Read from stream STREAM, printing to standard output any selected bytes.
+   Input is read in blocks, and each selected range within a line is
+   copied to the output with a single call.  Return false, with errno
+   set, upon read error.  */
+
+static bool
 cut_bytes (FILE *stream)
 {
   uintmax_t byte_idx;	/* Number of bytes in the line so far. */
   /* Whether to begin printing delimiters between ranges for the current line.
      Set after we've begun printing data corresponding to the first range.  */
   bool print_delimiter;
+  size_t nread;
 
   byte_idx = 0;
   print_delimiter = false;
   current_rp = frp;
-  while (true)
+  while ((nread = read_block (stream)) != 0)
     {
-      int c;		/* Each character from the file. */
+      if (nread == SAFE_READ_ERROR)
+        return false;
 
-      c = getc (stream);
+      char *p = io_buf;
+      char *lim = io_buf + nread;
 
-      if (c == line_delim)
+      while (p < lim)
         {
-          putchar (c);
-          byte_idx = 0;
-          print_delimiter = false;
-          current_rp = frp;
-        }
-      else if (c == EOF)
-        {
-          if (byte_idx > 0)
-            putchar (line_delim);
-          break;
-        }
-      else
-        {
-          next_item (&byte_idx);
-          if (print_kth (byte_idx))
+          char *eol = memchr (p, line_delim, lim - p);
+          char *end = eol ? eol : lim;
+
+          while (p < end)
             {
-              if (output_delimiter_specified)
+              /* P points to byte number BYTE_IDX + 1 of the line.  */
+              uintmax_t k = byte_idx + 1;
+              size_t avail = end - p;
+              size_t n;
+
+              while (current_rp->hi < k)
+                current_rp++;
+
+              if (k < current_rp->lo)
                 {
-                  if (print_delimiter && is_range_start_index (byte_idx))
+                  /* Skip to the start of the next range, or to the
+                     end of the line if no range remains.  */
+                  n = MIN (current_rp->lo - k, avail);
+                }
+              else
+                {
+                  if (output_delimiter_specified)
                     {
-                      fwrite (output_delimiter_string, sizeof (char),
-                              output_delimiter_length, stdout);
+                      if (print_delimiter && is_range_start_index (k))
+                        write_bytes (output_delimiter_string,
+                                     output_delimiter_length);
+                      print_delimiter = true;
                     }
-                  print_delimiter = true;
+                  n = MIN (current_rp->hi - k + 1, avail);
+                  write_bytes (p, n);
                 }
+              p += n;
+              byte_idx += n;
+            }
 
-              putchar (c);
+          if (eol)
+            {
+              write_line_delim ();
+              byte_idx = 0;
+              print_delimiter = false;
+              current_rp = frp;
+              p = eol + 1;
             }
         }
+
+      flush_output ();
     }
+
+  if (byte_idx > 0)
+    {
+      write_line_delim ();
+      flush_output ();
+    }
+  return true;
 }
 
-/* Read from stream STREAM, printing to standard output any selected fields.  */
+/* Read from stream STREAM, printing to standard output any selected fields.
+   This is used only when the field delimiter is also the line delimiter,
+   where whether a delimiter ends a field depends on whether any input
+   follows it.  */
 
 static void
-cut_fields (FILE *stream)
+cut_fields_getc (FILE *stream)
 {
   int c;
   uintmax_t field_idx = 1;
@@ -425,13 +519,208 @@ cut_fields (FILE *stream)
     }
 }
 
-static void
+/* Append the N bytes at BUF to the N_SAVED bytes of the first field
+   already saved in FIELD_1_BUFFER, and return the new length.  */
+
+static size_t
+save_field_1 (size_t n_saved, char const *buf, size_t n)
+{
+  if (field_1_bufsize - n_saved < n)
+    {
+      field_1_bufsize = n_saved + n;
+      field_1_buffer = x2nrealloc (field_1_buffer, &field_1_bufsize, 1);
+    }
+  memcpy (field_1_buffer + n_saved, buf, n);
+  return n_saved + n;
+}
+
+/* Return the first field delimiter in the bytes from P up to END,
+   or NULL if there is none.  Fields are usually short, so look at a
+   few bytes directly before paying the setup cost of memchr.  */
+
+static inline char *
+find_delim (char *p, char const *end)
+{
+  for (int i = 0; i < 16; i++, p++)
+    {
+      if (p == end)
+        return NULL;
+      if (to_uchar (*p) == delim)
+        return p;
+    }
+  return memchr (p, delim, end - p);
+}
+
+/* Read from stream STREAM, printing to standard output any selected fields.
+   Input is read in blocks, each line is located with memchr and its
+   fields are then found with find_delim.  When the output delimiter is
+   the input delimiter, each run of consecutive selected fields is copied
+   to the output with a single call.  Return false, with errno set, upon
+   read error.  */
+
+static bool
+cut_fields (FILE *stream)
+{
+  uintmax_t field_idx = 1;
+  bool found_any_selected_field = false;
+  bool buffer_first_field;
+  /* True if the current field started in a previous buffer.  */
+  bool in_field = false;
+  /* True if the current line has at least one byte.  */
+  bool in_line = false;
+  /* The number of bytes of the first field saved in FIELD_1_BUFFER,
+     when the first field spans a buffer boundary.  */
+  size_t field_1_len = 0;
+  size_t nread;
+
+  if (delim == line_delim)
+    {
+      cut_fields_getc (stream);
+      return true;
+    }
+
+  current_rp = frp;
+
+  /* To support the semantics of the -s flag, we may have to buffer
+     all of the first field to determine whether it is 'delimited.'
+     But that is unnecessary if all non-delimited lines must be printed
+     and the first field has been selected, or if non-delimited lines
+     must be suppressed and the first field has *not* been selected.
+     That is because a non-delimited line has exactly one field.  */
+  buffer_first_field = (suppress_non_delimited ^ !print_kth (1));
+
+  while ((nread = read_block (stream)) != 0)
+    {
+      if (nread == SAFE_READ_ERROR)
+        return false;
+
+      char *p = io_buf;
+      char *lim = io_buf + nread;
+
+      while (p < lim)
+        {
+          /* Process the fields in the part of the line from P to END.  */
+          char *eol = memchr (p, line_delim, lim - p);
+          char *end = eol ? eol : lim;
+          in_line |= p < end;
+
+          while (true)
+            {
+              char *q;
+
+              if (field_idx == 1 && buffer_first_field)
+                {
+                  q = find_delim (p, end);
+                  if (!q && !eol)
+                    {
+                      field_1_len = save_field_1 (field_1_len, p, end - p);
+                      break;
+                    }
+
+                  /* Print the field if it is delimited and selected,
+                     or if it is the whole of a non-delimited line and
+                     we are printing all non-delimited lines.  */
+                  if (q ? print_kth (1) : !suppress_non_delimited)
+                    {
+                      if (field_1_len)
+                        write_bytes (field_1_buffer, field_1_len);
+                      write_bytes (p, (q ? q : end) - p);
+                      found_any_selected_field = !!q;
+                    }
+                  field_1_len = 0;
+                  if (!q)
+                    break;
+                }
+              else if (!print_kth (field_idx))
+                {
+                  /* Once past the first field, skip the rest of the
+                     line if no later field is selected.  */
+                  q = (field_idx == 1 || current_rp->lo != UINTMAX_MAX
+                       ? find_delim (p, end) : NULL);
+                }
+              else
+                {
+                  if (!in_field)
+                    {
+                      if (found_any_selected_field)
+                        write_bytes (output_delimiter_string,
+                                     output_delimiter_length);
+                      found_any_selected_field = true;
+                    }
+
+                  if (output_delimiter_is_delim)
+                    {
+                      /* Copy this and any following selected fields as
+                         one span, delimiters included.  */
+                      if (current_rp->hi == UINTMAX_MAX)
+                        q = NULL;
+                      else
+                        for (q = find_delim (p, end);
+                             q && field_idx < current_rp->hi;
+                             q = find_delim (q + 1, end))
+                          field_idx++;
+                    }
+                  else
+                    q = find_delim (p, end);
+
+                  write_bytes (p, (q ? q : end) - p);
+                }
+
+              in_field = !q && !eol;
+              if (!q)
+                break;
+              next_item (&field_idx);
+              p = q + 1;
+            }
+
+          if (!eol)
+            break;
+
+          if (found_any_selected_field
+              || !(suppress_non_delimited && field_idx == 1))
+            write_line_delim ();
+          field_idx = 1;
+          current_rp = frp;
+          found_any_selected_field = false;
+          in_line = false;
+          p = eol + 1;
+        }
+
+      flush_output ();
+    }
+
+  /* Terminate the last line if it was not terminated in the input.  */
+  if (in_line)
+    {
+      if (field_idx == 1 && buffer_first_field)
+        {
+          if (!suppress_non_delimited && field_1_len)
+            write_bytes (field_1_buffer, field_1_len);
+        }
+      else if (!in_field && print_kth (field_idx))
+        {
+          /* A delimiter just before EOF starts an empty last field.  */
+          if (found_any_selected_field)
+            write_bytes (output_delimiter_string, output_delimiter_length);
+          found_any_selected_field = true;
+        }
+      if (found_any_selected_field
+          || !(suppress_non_delimited && field_idx == 1))
+        write_line_delim ();
+      flush_output ();
+    }
+  return true;
+}
+
+/* Process STREAM.  Return false, with errno set, upon read error.  */
+
+static bool
 cut_stream (FILE *stream)
 {
   if (operating_mode == byte_mode)
-    cut_bytes (stream);
+    return cut_bytes (stream);
   else
-    cut_fields (stream);
+    return cut_fields (stream);
 }
 
 /* Process file FILE to standard output.
@@ -459,9 +748,7 @@ cut_file (char const *file)
 
   fadvise (stream, FADVISE_SEQUENTIAL);
 
-  cut_stream (stream);
-
-  if (ferror (stream))
+  if (!cut_stream (stream) || ferror (stream))
     {
       error (0, errno, "%s", quotef (file));
       return false;
@@ -589,6 +876,8 @@ main (int argc, char **argv)
       output_delimiter_string = dummy;
       output_delimiter_length = 1;
     }
+  output_delimiter_is_delim = (output_delimiter_length == 1
+                               && to_uchar (output_delimiter_string[0]) == delim);
 
   if (optind == argc)
     ok = cut_file ("-");
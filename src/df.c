@@ -23,12 +23,14 @@
 #include <sys/types.h>
 #include <getopt.h>
 #include <assert.h>
+#include <pthread.h>
 #include <c-ctype.h>
 #include <wchar.h>
 #include <wctype.h>
 
 #include "system.h"
 #include "canonicalize.h"
+#include "cl-strtod.h"
 #include "die.h"
 #include "error.h"
 #include "fsusage.h"
@@ -39,6 +41,9 @@
 #include "quote.h"
 #include "find-mount-point.h"
 #include "hash.h"
+#include "hash-pjw.h"
+#include "timespec.h"
+#include "xstrtod.h"
 #include "xstrtol-error.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
@@ -86,6 +91,10 @@ static bool file_systems_processed;
    SunOS 4.1.3, for one.  It is *not* necessary on GNU/Linux.  */
 static bool require_sync;
 
+/* If nonnegative, examine mount points with helper threads, and give up
+   on any that take more than this many seconds, or never if zero.  */
+static double probe_timeout = -1;
+
 /* Desired exit status.  */
 static int exit_status;
 
@@ -251,7 +260,8 @@ enum
   NO_SYNC_OPTION = CHAR_MAX + 1,
   SYNC_OPTION,
   TOTAL_OPTION,
-  OUTPUT_OPTION
+  OUTPUT_OPTION,
+  TIMEOUT_OPTION
 };
 
 static struct option const long_options[] =
@@ -267,6 +277,7 @@ static struct option const long_options[] =
   {"print-type", no_argument, NULL, 'T'},
   {"sync", no_argument, NULL, SYNC_OPTION},
   {"no-sync", no_argument, NULL, NO_SYNC_OPTION},
+  {"timeout", required_argument, NULL, TIMEOUT_OPTION},
   {"total", no_argument, NULL, TOTAL_OPTION},
   {"type", required_argument, NULL, 't'},
   {"exclude-type", required_argument, NULL, 'x'},
@@ -690,6 +701,322 @@ devlist_free (void *p)
   free (p);
 }
 
+/* Should file systems of type FSTYPE, with ME_DUMMY and ME_REMOTE
+   as in struct mount_entry, be omitted?  */
+
+static bool
+skip_mount (char const *fstype, bool me_dummy, bool me_remote)
+{
+  return ((me_remote && show_local_fs)
+          || (me_dummy && !show_all_fs && !show_listed_fs)
+          || !selected_fstype (fstype) || excluded_fstype (fstype));
+}
+
+/* With --timeout, mount points are examined by helper threads, so that
+   a file system that does not respond, such as a stale network mount,
+   delays df by at most the timeout rather than hanging it.  The main
+   thread still uses the results in the usual order.  */
+
+/* The most helper threads examining mount points at once.  */
+enum { PROBE_THREADS = 16 };
+
+/* The examination of a mount point by a helper thread.  */
+struct probe
+{
+  char *file;			/* The mount point.  */
+  char *disk;			/* Its device, for get_fs_usage.  */
+  enum { PROBE_PENDING, PROBE_RUNNING, PROBE_DONE, PROBE_TIMED_OUT } state;
+  struct timespec deadline;	/* When to give up, once running.  */
+  int stat_errno;		/* The errno value of stat, or 0.  */
+  struct stat st;
+  int fsu_errno;		/* The errno value of get_fs_usage, or 0.  */
+  struct fs_usage fsu;
+};
+
+/* The probes, looked up by file name.  They are never freed, as a
+   thread may still be examining one that timed out.  */
+static Hash_table *probe_table;
+
+/* The probes in the order queued, which is the order the threads take
+   them in.  The first PROBES_TAKEN have been taken, and those before
+   PROBES_FINISHED are done or timed out.  */
+static struct probe **probes;
+static size_t n_probes;
+static size_t n_probes_alloc;
+static size_t probes_taken;
+static size_t probes_finished;
+
+/* The number of threads, not counting those still examining a probe
+   that timed out.  */
+static size_t probe_threads;
+
+/* Protects the above.  Broadcast when a probe is queued or done.  */
+static pthread_mutex_t probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t probe_cond = PTHREAD_COND_INITIALIZER;
+
+static size_t
+probe_hash (void const *x, size_t table_size)
+{
+  struct probe const *p = x;
+  return hash_pjw (p->file, table_size);
+}
+
+static bool
+probe_compare (void const *x, void const *y)
+{
+  struct probe const *a = x;
+  struct probe const *b = y;
+  return STREQ (a->file, b->file);
+}
+
+/* Examine the mount point of P, recording the results in P.  */
+
+static void
+run_probe (struct probe *p)
+{
+  p->stat_errno = stat (p->file, &p->st) == 0 ? 0 : errno;
+  p->fsu_errno = get_fs_usage (p->file, p->disk, &p->fsu) == 0 ? 0 : errno;
+}
+
+/* Set the deadline of P to the timeout from now.  */
+
+static void
+set_probe_deadline (struct probe *p)
+{
+  struct timespec now = current_timespec ();
+  struct timespec timeout = dtotimespec (probe_timeout);
+
+  if (TYPE_MAXIMUM (time_t) - timeout.tv_sec <= now.tv_sec)
+    p->deadline = make_timespec (TYPE_MAXIMUM (time_t), TIMESPEC_HZ - 1);
+  else
+    {
+      p->deadline.tv_sec = now.tv_sec + timeout.tv_sec;
+      p->deadline.tv_nsec = now.tv_nsec + timeout.tv_nsec;
+      if (TIMESPEC_HZ <= p->deadline.tv_nsec)
+        {
+          p->deadline.tv_sec++;
+          p->deadline.tv_nsec -= TIMESPEC_HZ;
+        }
+    }
+}
+
+/* Examine the queued mount points as they are queued.  The threads
+   are never stopped, as some may be stuck in a system call.  */
+
+static void *
+probe_mounts (void *arg _GL_UNUSED)
+{
+  pthread_mutex_lock (&probe_lock);
+  while (true)
+    {
+      if (probes_taken < n_probes)
+        {
+          struct probe *p = probes[probes_taken++];
+          if (p->state != PROBE_PENDING)
+            continue;
+          p->state = PROBE_RUNNING;
+          set_probe_deadline (p);
+          /* Let the main thread wait for the deadline.  */
+          pthread_cond_broadcast (&probe_cond);
+          pthread_mutex_unlock (&probe_lock);
+
+          run_probe (p);
+
+          pthread_mutex_lock (&probe_lock);
+          if (p->state == PROBE_RUNNING)
+            p->state = PROBE_DONE;
+          else
+            probe_threads++;	/* Back from a probe that timed out.  */
+          pthread_cond_broadcast (&probe_cond);
+        }
+      else
+        pthread_cond_wait (&probe_cond, &probe_lock);
+    }
+  return NULL;
+}
+
+/* Start threads for the pending probes, up to PROBE_THREADS.
+   Make do with fewer threads if some cannot be created.
+   Called with PROBE_LOCK held, as are the functions below.  */
+
+static void
+start_probe_threads (void)
+{
+  while (probe_threads < MIN (PROBE_THREADS, n_probes - probes_taken))
+    {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, probe_mounts, NULL) != 0)
+        break;
+      pthread_detach (thread);
+      probe_threads++;
+    }
+}
+
+/* Return the probe of the mount point FILE of device DISK,
+   queuing a new one if FILE has not been probed yet.  */
+
+static struct probe *
+queue_probe (char const *file, char const *disk)
+{
+  if (probe_table == NULL)
+    {
+      probe_table = hash_initialize (0, NULL, probe_hash, probe_compare,
+                                     NULL);
+      if (probe_table == NULL)
+        xalloc_die ();
+    }
+
+  struct probe key;
+  key.file = (char *) file;
+  struct probe *p = hash_lookup (probe_table, &key);
+  if (p)
+    return p;
+
+  p = xmalloc (sizeof *p);
+  p->file = xstrdup (file);
+  p->disk = disk ? xstrdup (disk) : NULL;
+  p->state = PROBE_PENDING;
+  if (hash_insert (probe_table, p) == NULL)
+    xalloc_die ();
+
+  if (n_probes == n_probes_alloc)
+    probes = x2nrealloc (probes, &n_probes_alloc, sizeof *probes);
+  probes[n_probes++] = p;
+  start_probe_threads ();
+  pthread_cond_broadcast (&probe_cond);
+  return p;
+}
+
+/* Give up on the running probes whose deadline has passed, replacing
+   their threads.  Return the earliest deadline of the others, or NULL
+   if there is none.  */
+
+static struct timespec const *
+expire_probes (void)
+{
+  while (probes_finished < probes_taken
+         && PROBE_DONE <= probes[probes_finished]->state)
+    probes_finished++;
+
+  if (probe_timeout == 0)
+    return NULL;
+
+  struct timespec now = current_timespec ();
+  struct timespec const *earliest = NULL;
+  bool expired = false;
+
+  for (size_t i = probes_finished; i < probes_taken; i++)
+    {
+      struct probe *p = probes[i];
+      if (p->state != PROBE_RUNNING)
+        continue;
+      if (timespec_cmp (p->deadline, now) <= 0)
+        {
+          p->state = PROBE_TIMED_OUT;
+          probe_threads--;
+          expired = true;
+        }
+      else if (!earliest || timespec_cmp (p->deadline, *earliest) < 0)
+        earliest = &p->deadline;
+    }
+
+  if (expired)
+    start_probe_threads ();
+  return earliest;
+}
+
+/* Return the probe of the mount point FILE of device DISK, once it is
+   done or has timed out.  */
+
+static struct probe *
+wait_probe (char const *file, char const *disk)
+{
+  pthread_mutex_lock (&probe_lock);
+  struct probe *p = queue_probe (file, disk);
+  while (true)
+    {
+      struct timespec const *deadline = expire_probes ();
+      if (PROBE_DONE <= p->state)
+        break;
+
+      if (p->state == PROBE_PENDING && probe_threads == 0)
+        {
+          /* No thread could be created; examine FILE directly.  */
+          p->state = PROBE_RUNNING;
+          pthread_mutex_unlock (&probe_lock);
+          run_probe (p);
+          pthread_mutex_lock (&probe_lock);
+          p->state = PROBE_DONE;
+        }
+      else if (deadline)
+        pthread_cond_timedwait (&probe_cond, &probe_lock, deadline);
+      else
+        pthread_cond_wait (&probe_cond, &probe_lock);
+    }
+  pthread_mutex_unlock (&probe_lock);
+  return p;
+}
+
+/* Queue probes of the mount points that would be examined by
+   filter_mount_list and get_dev, so that they are examined at once.  */
+
+static void
+queue_mount_probes (void)
+{
+  pthread_mutex_lock (&probe_lock);
+  for (struct mount_entry const *me = mount_list; me; me = me->me_next)
+    if (! skip_mount (me->me_type, me->me_dummy, me->me_remote))
+      queue_probe (me->me_mountdir, me->me_devname);
+  pthread_mutex_unlock (&probe_lock);
+}
+
+/* Like stat, but for the mount point FILE of device DISK.  With
+   --timeout, fail with errno ETIMEDOUT if that takes too long.  */
+
+static int
+mount_stat (char const *file, char const *disk, struct stat *st)
+{
+  if (probe_timeout < 0)
+    return stat (file, st);
+
+  struct probe *p = wait_probe (file, disk);
+  if (p->state == PROBE_TIMED_OUT)
+    {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+  if (p->stat_errno)
+    {
+      errno = p->stat_errno;
+      return -1;
+    }
+  *st = p->st;
+  return 0;
+}
+
+/* Likewise for get_fs_usage.  */
+
+static int
+mount_fs_usage (char const *file, char const *disk, struct fs_usage *fsu)
+{
+  if (probe_timeout < 0)
+    return get_fs_usage (file, disk, fsu);
+
+  struct probe *p = wait_probe (file, disk);
+  if (p->state == PROBE_TIMED_OUT)
+    {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+  if (p->fsu_errno)
+    {
+      errno = p->fsu_errno;
+      return -1;
+    }
+  *fsu = p->fsu;
+  return 0;
+}
+
 /* Filter mount list by skipping duplicate entries.
    In the case of duplicates - based on the device number - the mount entry
    with a '/' in its me_devname (i.e., not pseudo name like tmpfs) wins.
@@ -725,10 +1052,8 @@ filter_mount_list (bool devices_only)
       /* Avoid stating remote file systems as that may hang.
          On Linux we probably have me_dev populated from /proc/self/mountinfo,
          however we still stat() in case another device was mounted later.  */
-      if ((me->me_remote && show_local_fs)
-          || (me->me_dummy && !show_all_fs && !show_listed_fs)
-          || (!selected_fstype (me->me_type) || excluded_fstype (me->me_type))
-          || -1 == stat (me->me_mountdir, &buf))
+      if (skip_mount (me->me_type, me->me_dummy, me->me_remote)
+          || -1 == mount_stat (me->me_mountdir, me->me_devname, &buf))
         {
           /* If remote, and showing just local, or FS type is excluded,
              add ME for filtering later.
@@ -997,13 +1322,7 @@ get_dev (char const *disk, char const *mount_point, char const* file,
          const struct fs_usage *force_fsu,
          bool process_all)
 {
-  if (me_remote && show_local_fs)
-    return;
-
-  if (me_dummy && !show_all_fs && !show_listed_fs)
-    return;
-
-  if (!selected_fstype (fstype) || excluded_fstype (fstype))
+  if (skip_mount (fstype, me_dummy, me_remote))
     return;
 
   /* Ignore relative MOUNT_POINTs, which are present for example
@@ -1021,14 +1340,22 @@ get_dev (char const *disk, char const *mount_point, char const* file,
   struct fs_usage fsu;
   if (force_fsu)
     fsu = *force_fsu;
-  else if (get_fs_usage (stat_file, disk, &fsu))
+  else if (mount_fs_usage (stat_file, disk, &fsu))
     {
       /* If we can't access a system provided entry due
          to it not being present (now), or due to permissions,
-         just output placeholder values rather than failing.  */
-      if (process_all && (errno == EACCES || errno == ENOENT))
+         just output placeholder values rather than failing.
+         Likewise for a file system that did not respond in time,
+         though that is diagnosed.  */
+      if ((process_all && (errno == EACCES || errno == ENOENT))
+          || (0 <= probe_timeout && errno == ETIMEDOUT))
         {
-          if (! show_all_fs)
+          if (errno == ETIMEDOUT)
+            {
+              error (0, errno, "%s", quotef (stat_file));
+              exit_status = EXIT_FAILURE;
+            }
+          else if (! show_all_fs)
             return;
 
           fstype = "-";
@@ -1050,7 +1377,7 @@ get_dev (char const *disk, char const *mount_point, char const* file,
          discard when used and current mount entries are both remote due
          to the possibility of aliased host names or exports.  */
       struct stat sb;
-      if (stat (stat_file, &sb) == 0)
+      if (mount_stat (stat_file, disk, &sb) == 0)
         {
           struct mount_entry const * dev_me = me_for_dev (sb.st_dev);
           if (dev_me && ! STREQ (dev_me->me_devname, disk)
@@ -1305,7 +1632,8 @@ get_disk (char const *disk)
               struct stat disk_stats;
               bool this_match_accessible = false;
 
-              if (stat (me->me_mountdir, &disk_stats) == 0)
+              if (mount_stat (me->me_mountdir, me->me_devname,
+                              &disk_stats) == 0)
                 best_match_accessible = this_match_accessible = true;
 
               if (this_match_accessible
@@ -1387,7 +1715,8 @@ get_point (const char *point, const struct stat *statp)
     }
   free (resolved);
   if (best_match
-      && (stat (best_match->me_mountdir, &disk_stats) != 0
+      && (mount_stat (best_match->me_mountdir, best_match->me_devname,
+                      &disk_stats) != 0
           || disk_stats.st_dev != statp->st_dev))
     best_match = NULL;
 
@@ -1396,14 +1725,15 @@ get_point (const char *point, const struct stat *statp)
       {
         if (me->me_dev == (dev_t) -1)
           {
-            if (stat (me->me_mountdir, &disk_stats) == 0)
+            if (mount_stat (me->me_mountdir, me->me_devname, &disk_stats) == 0)
               me->me_dev = disk_stats.st_dev;
             else
               {
-                /* Report only I/O errors.  Other errors might be
-                   caused by shadowed mount points, which means POINT
-                   can't possibly be on this file system.  */
-                if (errno == EIO)
+                /* Report only I/O errors and time outs.  Other errors
+                   might be caused by shadowed mount points, which means
+                   POINT can't possibly be on this file system.  */
+                if (errno == EIO
+                    || (0 <= probe_timeout && errno == ETIMEDOUT))
                   {
                     error (0, errno, "%s", quotef (me->me_mountdir));
                     exit_status = EXIT_FAILURE;
@@ -1419,7 +1749,7 @@ get_point (const char *point, const struct stat *statp)
             && (!best_match || best_match->me_dummy || !me->me_dummy))
           {
             /* Skip bogus mtab entries.  */
-            if (stat (me->me_mountdir, &disk_stats) != 0
+            if (mount_stat (me->me_mountdir, me->me_devname, &disk_stats) != 0
                 || disk_stats.st_dev != me->me_dev)
               me->me_dev = (dev_t) -2;
             else
@@ -1468,6 +1798,9 @@ get_all_entries (void)
 {
   struct mount_entry *me;
 
+  if (0 <= probe_timeout)
+    queue_mount_probes ();
+
   filter_mount_list (show_all_fs);
 
   for (me = mount_list; me; me = me->me_next)
@@ -1475,6 +1808,42 @@ get_all_entries (void)
              me->me_dummy, me->me_remote, NULL, true);
 }
 
+/* Return the number of seconds in the duration STR, a nonnegative
+   floating point number with an optional suffix of 's' for seconds,
+   'm' for minutes, 'h' for hours or 'd' for days, as in timeout.  */
+
+static double
+parse_duration (char const *str)
+{
+  double duration;
+  char const *ep;
+  int multiplier = 0;
+
+  if ((xstrtod (str, &ep, &duration, cl_strtod) || errno == ERANGE)
+      && 0 <= duration && (!*ep || !ep[1]))
+    switch (*ep)
+      {
+      case '\0':
+      case 's':
+        multiplier = 1;
+        break;
+      case 'm':
+        multiplier = 60;
+        break;
+      case 'h':
+        multiplier = 60 * 60;
+        break;
+      case 'd':
+        multiplier = 60 * 60 * 24;
+        break;
+      }
+
+  if (! multiplier)
+    die (EXIT_FAILURE, 0, _("invalid time interval %s"), quote (str));
+
+  return duration * multiplier;
+}
+
 /* Add FSTYPE to the list of file system types to display.  */
 
 static void
@@ -1538,6 +1907,10 @@ or all file systems by default.\n\
                                or print all fields if FIELD_LIST is omitted.\n\
   -P, --portability     use the POSIX output format\n\
       --sync            invoke sync before getting usage info\n\
+"), stdout);
+      fputs (_("\
+      --timeout=DURATION  examine file systems in parallel, and report as\n\
+                            unknown any that take longer than DURATION\n\
 "), stdout);
       fputs (_("\
       --total           elide all entries insignificant to available space,\n\
@@ -1697,6 +2070,10 @@ main (int argc, char **argv)
             decode_output_arg (optarg);
           break;
 
+        case TIMEOUT_OPTION:
+          probe_timeout = parse_duration (optarg);
+          break;
+
         case TOTAL_OPTION:
           print_grand_total = true;
           break;
@@ -52,6 +52,10 @@
     (3) Factor any remaining composite part using the Pollard-Brent rho
         algorithm or if USE_SQUFOF is defined to 1, try that first.
         Status of found factors are checked again using Miller-Rabin and Lucas.
+    (4) In the GMP code, if Pollard-Brent rho finds nothing within a bounded
+        number of iterations, switch to Lenstra's elliptic curve method (ECM)
+        with Montgomery curves, a stage 1 and a simple prime continuation
+        stage 2, raising the bounds as more curves fail.
 
     We prefer using Hensel norm in the divisions, not the more familiar
     Euclidian norm, since the former leads to much faster code.  In the
@@ -112,13 +116,16 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
 
 #include "system.h"
 #include "die.h"
 #include "error.h"
 #include "full-write.h"
+#include "ioblksize.h"
 #include "quote.h"
-#include "readtokens.h"
+#include "safe-read.h"
+#include "xdectoint.h"
 #include "xstrtol.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
@@ -129,9 +136,6 @@
   proper_name_utf8 ("Torbjorn Granlund", "Torbj\303\266rn Granlund"),   \
   proper_name_utf8 ("Niels Moller", "Niels M\303\266ller")
 
-/* Token delimiters when reading from a file.  */
-#define DELIM "\n\t "
-
 #ifndef USE_LONGLONG_H
 /* With the way we use longlong.h, it's only safe to use
    when UWtype = UHWtype, as there were various cases
@@ -227,12 +231,14 @@ const unsigned char factor_clz_tab[129] =
 
 enum
 {
-  DEV_DEBUG_OPTION = CHAR_MAX + 1
+  DEV_DEBUG_OPTION = CHAR_MAX + 1,
+  PARALLEL_OPTION
 };
 
 static struct option const long_options[] =
 {
   {"-debug", no_argument, NULL, DEV_DEBUG_OPTION},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
   {NULL, 0, NULL, 0}
@@ -1118,6 +1124,77 @@ powm2 (uintmax_t *r1m,
   return r0;
 }
 
+/* Set RP[i] = B^EP[i] mod N for 0 <= i < NE.  The powers are computed
+   right to left, so the squarings of B are shared between all the
+   exponents, and the multiplications into the separate RP[i] are
+   independent of each other, letting the processor overlap them.  */
+static void
+powm_multi (uintmax_t *rp, uintmax_t b, const uintmax_t *ep, unsigned int ne,
+            uintmax_t n, uintmax_t ni, uintmax_t one)
+{
+  uintmax_t emax = 0;
+  unsigned int i;
+
+  for (i = 0; i < ne; i++)
+    {
+      rp[i] = one;
+      emax |= ep[i];
+    }
+
+  for (uintmax_t bit = 1; ; bit <<= 1)
+    {
+      for (i = 0; i < ne; i++)
+        if (ep[i] & bit)
+          rp[i] = mulredc (rp[i], b, n, ni);
+
+      emax >>= 1;
+      if (emax == 0)
+        break;
+      b = mulredc (b, b, n, ni);
+    }
+}
+
+/* Likewise for two-word B, N and exponents.  RP and EP hold NE
+   numbers of two words each, least significant word first.  */
+static void
+powm2_multi (uintmax_t *rp, const uintmax_t *bp, const uintmax_t *ep,
+             unsigned int ne, const uintmax_t *np, uintmax_t ni,
+             const uintmax_t *one)
+{
+  uintmax_t b1, b0, r1m;
+  uintmax_t emax[2] = { 0, 0 };
+  unsigned int i;
+
+  b0 = bp[0];
+  b1 = bp[1];
+
+  for (i = 0; i < ne; i++)
+    {
+      rp[2 * i] = one[0];
+      rp[2 * i + 1] = one[1];
+      emax[0] |= ep[2 * i];
+      emax[1] |= ep[2 * i + 1];
+    }
+
+  for (unsigned int w = 0; w < 2; w++)
+    for (uintmax_t bit = 1; bit != 0; bit <<= 1)
+      {
+        if (w == 0 ? emax[1] == 0 && emax[0] < bit : emax[1] < bit)
+          return;
+
+        for (i = 0; i < ne; i++)
+          if (ep[2 * i + w] & bit)
+            {
+              rp[2 * i] = mulredc2 (&r1m, rp[2 * i + 1], rp[2 * i],
+                                    b1, b0, np[1], np[0], ni);
+              rp[2 * i + 1] = r1m;
+            }
+
+        b0 = mulredc2 (&r1m, b1, b0, b1, b0, np[1], np[0], ni);
+        b1 = r1m;
+      }
+}
+
 static bool _GL_ATTRIBUTE_CONST
 millerrabin (uintmax_t n, uintmax_t ni, uintmax_t b, uintmax_t q,
              unsigned int k, uintmax_t one)
@@ -1224,10 +1301,13 @@ prime_p (uintmax_t n)
   if (!millerrabin (n, ni, a_prim, q, k, one))
     return false;
 
+  uintmax_t e[MAX_NFACTS];
   if (flag_prove_primality)
     {
       /* Factor n-1 for Lucas.  */
       factor (0, n - 1, &factors);
+      for (unsigned int i = 0; i < factors.nfactors; i++)
+        e[i] = (n - 1) / factors.p[i];
     }
 
   /* Loop until Lucas proves our number prime, or Miller-Rabin proves our
@@ -1236,12 +1316,11 @@ prime_p (uintmax_t n)
     {
       if (flag_prove_primality)
         {
+          uintmax_t y[MAX_NFACTS];
+          powm_multi (y, a_prim, e, factors.nfactors, n, ni, one);
           is_prime = true;
-          for (unsigned int i = 0; i < factors.nfactors && is_prime; i++)
-            {
-              is_prime
-                = powm (a_prim, (n - 1) / factors.p[i], n, ni, one) != one;
-            }
+          for (unsigned int i = 0; i < factors.nfactors; i++)
+            is_prime &= y[i] != one;
         }
       else
         {
@@ -1319,10 +1398,33 @@ prime2_p (uintmax_t n1, uintmax_t n0)
   if (!millerrabin2 (na, ni, a_prim, q, k, one))
     return false;
 
+  /* The Lucas exponents (n-1)/p, two words each.  */
+  uintmax_t e[2 * (MAX_NFACTS + 1)];
+  unsigned int ne = 0;
   if (flag_prove_primality)
     {
       /* Factor n-1 for Lucas.  */
       factor (nm1[1], nm1[0], &factors);
+
+      if (factors.plarge[1])
+        {
+          uintmax_t pi;
+          binv (pi, factors.plarge[0]);
+          e[0] = pi * nm1[0];
+          e[1] = 0;
+          ne++;
+        }
+      for (unsigned int i = 0; i < factors.nfactors; i++, ne++)
+        {
+          /* FIXME: We always have the factor 2. Do we really need to
+             handle it here? We have done the same powering as part
+             of millerrabin. */
+          if (factors.p[i] == 2)
+            rsh2 (e[2 * ne + 1], e[2 * ne], nm1[1], nm1[0], 1);
+          else
+            divexact_21 (e[2 * ne + 1], e[2 * ne], nm1[1], nm1[0],
+                         factors.p[i]);
+        }
     }
 
   /* Loop until Lucas proves our number prime, or Miller-Rabin proves our
@@ -1330,32 +1432,14 @@ prime2_p (uintmax_t n1, uintmax_t n0)
   for (unsigned int r = 0; r < PRIMES_PTAB_ENTRIES; r++)
     {
       bool is_prime;
-      uintmax_t e[2], y[2];
 
       if (flag_prove_primality)
         {
+          uintmax_t y[2 * (MAX_NFACTS + 1)];
+          powm2_multi (y, a_prim, e, ne, na, ni, one);
           is_prime = true;
-          if (factors.plarge[1])
-            {
-              uintmax_t pi;
-              binv (pi, factors.plarge[0]);
-              e[0] = pi * nm1[0];
-              e[1] = 0;
-              y[0] = powm2 (&y[1], a_prim, e, na, ni, one);
-              is_prime = (y[0] != one[0] || y[1] != one[1]);
-            }
-          for (unsigned int i = 0; i < factors.nfactors && is_prime; i++)
-            {
-              /* FIXME: We always have the factor 2. Do we really need to
-                 handle it here? We have done the same powering as part
-                 of millerrabin. */
-              if (factors.p[i] == 2)
-                rsh2 (e[1], e[0], nm1[1], nm1[0], 1);
-              else
-                divexact_21 (e[1], e[0], nm1[1], nm1[0], factors.p[i]);
-              y[0] = powm2 (&y[1], a_prim, e, na, ni, one);
-              is_prime = (y[0] != one[0] || y[1] != one[1]);
-            }
+          for (unsigned int i = 0; i < ne; i++)
+            is_prime &= y[2 * i] != one[0] || y[2 * i + 1] != one[1];
         }
       else
         {
@@ -1670,6 +1754,415 @@ factor_using_pollard_rho2 (uintmax_t n1, uintmax_t n0, unsigned long int a,
 }
 
 #if HAVE_GMP
+/* Pollard-rho gives way to ECM after this many iterations.  It is the
+   faster method for factors below about 10^10.  */
+# define MP_RHO_ITERATIONS (1 << 17)
+
+/* An iterator over the odd primes up to a limit, using a segmented
+   sieve of Eratosthenes over the odd numbers.  */
+enum { SIEVE_SEGMENT = 1 << 15 };
+struct prime_sieve
+{
+  unsigned long int *base;      /* Odd primes up to sqrt (limit).  */
+  size_t n_base;
+  unsigned long int limit;
+  unsigned long int lo;         /* The number represented by seg[0].  */
+  size_t pos;                   /* The next position to look at in seg.  */
+  size_t len;                   /* The number of valid entries in seg.  */
+  char seg[SIEVE_SEGMENT];      /* Nonzero for composite lo + 2*i.  */
+};
+
+static void
+sieve_init (struct prime_sieve *s, unsigned long int limit)
+{
+  unsigned long int r = 1;
+  while ((r + 1) * (r + 1) <= limit)
+    r++;
+
+  char *composite = xzalloc (r + 1);
+  s->base = xnmalloc (r / 2 + 1, sizeof *s->base);
+  s->n_base = 0;
+  for (unsigned long int i = 3; i <= r; i += 2)
+    if (!composite[i])
+      {
+        s->base[s->n_base++] = i;
+        for (unsigned long int j = i * i; j <= r; j += 2 * i)
+          composite[j] = 1;
+      }
+  free (composite);
+
+  s->limit = limit;
+  s->lo = 3;
+  s->pos = s->len = 0;
+}
+
+/* Sieve the segment starting at S->lo.  */
+static void
+sieve_fill (struct prime_sieve *s)
+{
+  s->len = MIN (SIEVE_SEGMENT, (s->limit - s->lo) / 2 + 1);
+  s->pos = 0;
+  memset (s->seg, 0, s->len);
+
+  unsigned long int hi = s->lo + 2 * (s->len - 1);
+  for (size_t i = 0; i < s->n_base; i++)
+    {
+      unsigned long int q = s->base[i];
+      if (q * q > hi)
+        break;
+      unsigned long int m = MAX (q * q, (s->lo + q - 1) / q * q);
+      if (m % 2 == 0)
+        m += q;
+      for (size_t j = (m - s->lo) / 2; j < s->len; j += q)
+        s->seg[j] = 1;
+    }
+}
+
+/* Return the next odd prime, or 0 after the limit.  */
+static unsigned long int
+sieve_next (struct prime_sieve *s)
+{
+  for (;;)
+    {
+      for (; s->pos < s->len; s->pos++)
+        if (!s->seg[s->pos])
+          return s->lo + 2 * s->pos++;
+
+      if (s->len != 0)
+        {
+          if (s->limit - s->lo < 2 * s->len)
+            return 0;
+          s->lo += 2 * s->len;
+        }
+      else if (s->limit < s->lo)
+        return 0;
+      sieve_fill (s);
+    }
+}
+
+static void
+sieve_free (struct prime_sieve *s)
+{
+  free (s->base);
+}
+
+/* A Montgomery curve B*y^2 = x^3 + A*x^2 + x modulo N, with scratch
+   space for its arithmetic.  Points are kept in projective x-only
+   coordinates X:Z, so neither inverses nor y-coordinates are needed.  */
+struct ecm_curve
+{
+  mpz_srcptr n;
+  mpz_t a24;                    /* (A + 2) / 4 */
+  mpz_t t, u, v, w;
+  mpz_t x0, z0, x1, z1, xd, zd;
+};
+
+static void
+ecm_mulmod (struct ecm_curve *c, mpz_ptr r, mpz_srcptr a, mpz_srcptr b)
+{
+  mpz_mul (r, a, b);
+  mpz_mod (r, r, c->n);
+}
+
+/* (X2:Z2) = 2 * (X:Z).  */
+static void
+ecm_dbl (struct ecm_curve *c, mpz_ptr x2, mpz_ptr z2,
+         mpz_srcptr x, mpz_srcptr z)
+{
+  mpz_add (c->u, x, z);
+  ecm_mulmod (c, c->u, c->u, c->u);
+  mpz_sub (c->v, x, z);
+  ecm_mulmod (c, c->v, c->v, c->v);
+  mpz_sub (c->t, c->u, c->v);
+  ecm_mulmod (c, x2, c->u, c->v);
+  ecm_mulmod (c, c->w, c->a24, c->t);
+  mpz_add (c->w, c->w, c->v);
+  ecm_mulmod (c, z2, c->t, c->w);
+}
+
+/* (X3:Z3) = (XP:ZP) + (XQ:ZQ), given their difference (XD:ZD),
+   which must not overlap the result.  */
+static void
+ecm_add (struct ecm_curve *c, mpz_ptr x3, mpz_ptr z3,
+         mpz_srcptr xp, mpz_srcptr zp, mpz_srcptr xq, mpz_srcptr zq,
+         mpz_srcptr xd, mpz_srcptr zd)
+{
+  mpz_sub (c->t, xp, zp);
+  mpz_add (c->u, xq, zq);
+  ecm_mulmod (c, c->u, c->t, c->u);
+  mpz_add (c->t, xp, zp);
+  mpz_sub (c->v, xq, zq);
+  ecm_mulmod (c, c->v, c->t, c->v);
+  mpz_add (c->t, c->u, c->v);
+  ecm_mulmod (c, c->t, c->t, c->t);
+  mpz_sub (c->w, c->u, c->v);
+  ecm_mulmod (c, c->w, c->w, c->w);
+  ecm_mulmod (c, x3, zd, c->t);
+  ecm_mulmod (c, z3, xd, c->w);
+}
+
+/* (X:Z) = K * (X:Z) for K >= 1, using the Montgomery ladder.  */
+static void
+ecm_mul (struct ecm_curve *c, mpz_ptr x, mpz_ptr z, unsigned long int k)
+{
+  unsigned long int mask = 1;
+  while (mask <= k / 2)
+    mask <<= 1;
+  if (mask == 1)
+    return;
+
+  mpz_set (c->xd, x);
+  mpz_set (c->zd, z);
+  mpz_set (c->x0, x);
+  mpz_set (c->z0, z);
+  ecm_dbl (c, c->x1, c->z1, x, z);
+
+  /* Invariant: (x1:z1) - (x0:z0) = (xd:zd).  */
+  for (mask >>= 1; mask != 0; mask >>= 1)
+    {
+      if (k & mask)
+        {
+          ecm_add (c, c->x0, c->z0, c->x0, c->z0, c->x1, c->z1, c->xd, c->zd);
+          ecm_dbl (c, c->x1, c->z1, c->x1, c->z1);
+        }
+      else
+        {
+          ecm_add (c, c->x1, c->z1, c->x0, c->z0, c->x1, c->z1, c->xd, c->zd);
+          ecm_dbl (c, c->x0, c->z0, c->x0, c->z0);
+        }
+    }
+
+  mpz_set (x, c->x0);
+  mpz_set (z, c->z0);
+}
+
+/* Set F to a factor of N, and return true if it is a proper one.  */
+static bool
+ecm_gcd (mpz_ptr f, mpz_srcptr g, mpz_srcptr n)
+{
+  mpz_gcd (f, g, n);
+  return mpz_cmp_ui (f, 1) != 0 && mpz_cmp (f, n) != 0;
+}
+
+/* Run a single ECM curve with Suyama's parameter SIGMA on the odd
+   composite N, with stage 1 bound B1 and stage 2 bound B2.  Return true
+   and set F to a proper factor of N if one was found.  */
+static bool
+ecm_one_curve (mpz_ptr f, mpz_srcptr n, unsigned long int sigma,
+               unsigned long int b1, unsigned long int b2)
+{
+  /* The stage 2 giant step, and the number of baby steps.  */
+  enum { D = 2 * 3 * 5 * 7, NBABY = D / 4 };
+
+  struct ecm_curve c;
+  struct prime_sieve *s;
+  mpz_t x, z, gx, gz, hx, hz, dx, dz, g;
+  mpz_t bx[NBABY], bz[NBABY];
+  unsigned long int p;
+  bool found;
+
+  c.n = n;
+  mpz_inits (c.a24, c.t, c.u, c.v, c.w, c.x0, c.z0, c.x1, c.z1, c.xd, c.zd,
+             x, z, gx, gz, hx, hz, dx, dz, g, NULL);
+  for (unsigned int i = 0; i < NBABY; i++)
+    mpz_inits (bx[i], bz[i], NULL);
+  s = xmalloc (sizeof *s);
+  sieve_init (s, b2);
+
+  /* Suyama's parametrization, which gives group orders divisible by 12:
+     u = sigma^2 - 5, v = 4*sigma, the starting point is u^3 : v^3
+     and (A + 2) / 4 = (v - u)^3 * (3*u + v) / (16 * u^3 * v).  */
+  mpz_set_ui (c.u, sigma);
+  mpz_mul (c.u, c.u, c.u);
+  mpz_sub_ui (c.u, c.u, 5);
+  mpz_set_ui (c.v, sigma);
+  mpz_mul_ui (c.v, c.v, 4);
+  mpz_powm_ui (x, c.u, 3, n);
+  mpz_powm_ui (z, c.v, 3, n);
+  mpz_sub (c.t, c.v, c.u);
+  mpz_powm_ui (c.t, c.t, 3, n);
+  mpz_mul_ui (c.w, c.u, 3);
+  mpz_add (c.w, c.w, c.v);
+  ecm_mulmod (&c, c.a24, c.t, c.w);
+  mpz_mul_ui (c.t, x, 16);
+  ecm_mulmod (&c, c.t, c.t, c.v);
+  if (!mpz_invert (c.w, c.t, n))
+    {
+      found = ecm_gcd (f, c.t, n);
+      goto done;
+    }
+  ecm_mulmod (&c, c.a24, c.a24, c.w);
+
+  /* Stage 1: multiply by all the prime powers up to B1.  */
+  for (unsigned long int q = 2; q <= b1; q *= 2)
+    ecm_mul (&c, x, z, 2);
+  while ((p = sieve_next (s)) != 0 && p <= b1)
+    {
+      unsigned long int q = p;
+      while (q <= b1 / p)
+        q *= p;
+      ecm_mul (&c, x, z, q);
+    }
+
+  found = ecm_gcd (f, z, n);
+  if (found || mpz_cmp_ui (f, 1) != 0 || p == 0)
+    goto done;
+
+  /* Stage 2: look for a single prime P in (B1, B2] in the group order.
+     With P = m*D +- j, P*Q is the point at infinity modulo a prime r
+     exactly when (m*D)*Q and j*Q have the same x-coordinate modulo r.
+     The baby steps j*Q for odd j < D/2 are tabulated, and the giant
+     steps (m*D)*Q are walked in order as the primes increase.  */
+  mpz_set (bx[0], x);
+  mpz_set (bz[0], z);
+  ecm_dbl (&c, dx, dz, x, z);
+  ecm_add (&c, bx[1], bz[1], dx, dz, x, z, x, z);
+  for (unsigned int i = 2; i < NBABY; i++)
+    ecm_add (&c, bx[i], bz[i], bx[i - 1], bz[i - 1], dx, dz,
+             bx[i - 2], bz[i - 2]);
+
+  unsigned long int m = (p + D / 2) / D;
+  mpz_set (dx, x);
+  mpz_set (dz, z);
+  ecm_mul (&c, dx, dz, D);
+  mpz_set (gx, x);
+  mpz_set (gz, z);
+  ecm_mul (&c, gx, gz, m * D);
+  mpz_set (hx, x);
+  mpz_set (hz, z);
+  ecm_mul (&c, hx, hz, (m - 1) * D);
+
+  mpz_set_ui (g, 1);
+  for (; p != 0; p = sieve_next (s))
+    {
+      for (; m < (p + D / 2) / D; m++)
+        {
+          /* (m+1)*D*Q = m*D*Q + D*Q, given (m-1)*D*Q.  */
+          ecm_add (&c, x, z, gx, gz, dx, dz, hx, hz);
+          mpz_swap (hx, gx);
+          mpz_swap (hz, gz);
+          mpz_swap (gx, x);
+          mpz_swap (gz, z);
+        }
+
+      unsigned long int j = p < m * D ? m * D - p : p - m * D;
+      ecm_mulmod (&c, c.t, gx, bz[j / 2]);
+      ecm_mulmod (&c, c.u, bx[j / 2], gz);
+      mpz_sub (c.t, c.t, c.u);
+      ecm_mulmod (&c, g, g, c.t);
+    }
+
+  found = ecm_gcd (f, g, n);
+
+ done:
+  sieve_free (s);
+  free (s);
+  for (unsigned int i = 0; i < NBABY; i++)
+    mpz_clears (bx[i], bz[i], NULL);
+  mpz_clears (c.a24, c.t, c.u, c.v, c.w, c.x0, c.z0, c.x1, c.z1, c.xd, c.zd,
+              x, z, gx, gz, hx, hz, dx, dz, g, NULL);
+  return found;
+}
+
+/* If N is a perfect power r^k, put the prime factors of N in FACTORS
+   and return true.  */
+static bool
+mp_factor_using_root (mpz_t n, struct mp_factors *factors)
+{
+  if (!mpz_perfect_power_p (n))
+    return false;
+
+  mpz_t r;
+  mpz_init (r);
+
+  /* Find the largest K, so that R is not a perfect power itself.  */
+  for (unsigned long int k = mpz_sizeinbase (n, 2); 2 <= k; k--)
+    if (mpz_root (r, n, k))
+      {
+        struct mp_factors rf;
+
+        devmsg ("[perfect power %lu] ", k);
+        mp_factor (r, &rf);
+        for (unsigned long int i = 0; i < rf.nfactors; i++)
+          for (unsigned long int j = 0; j < rf.e[i] * k; j++)
+            mp_factor_insert (factors, rf.p[i]);
+        mp_factor_clear (&rf);
+        break;
+      }
+
+  mpz_clear (r);
+  return true;
+}
+
+/* Use the elliptic curve method to compute the prime factors of the
+   composite N, which has no small factors, and put the results in
+   FACTORS.  The bounds grow with the number of curves tried, following
+   the usual table for finding factors of increasing size.  */
+static void
+mp_factor_using_ecm (mpz_t n, struct mp_factors *factors)
+{
+  static struct
+  {
+    unsigned long int b1;
+    unsigned int curves;
+  } const ecm_params[] =
+  {
+    {     2000,    25 },            /* 15 digits */
+    {    11000,    90 },            /* 20 digits */
+    {    50000,   300 },            /* 25 digits */
+    {   250000,   700 },            /* 30 digits */
+    {  1000000,  1800 },            /* 35 digits */
+    {  3000000,  5100 },            /* 40 digits */
+    { 11000000, 10600 },            /* 45 digits */
+  };
+  size_t level = 0;
+  unsigned int curves = 0;
+  unsigned long int sigma = 6;
+  mpz_t f;
+
+  mpz_init (f);
+
+  while (!mp_factor_using_root (n, factors))
+    {
+      unsigned long int b1 = ecm_params[level].b1;
+
+      if (curves == 0)
+        devmsg ("[ecm (B1=%lu)] ", b1);
+
+      if (ecm_one_curve (f, n, sigma++, b1, 100 * b1))
+        {
+          mpz_divexact (n, n, f);
+
+          if (mp_prime_p (f))
+            mp_factor_insert (factors, f);
+          else
+            {
+              devmsg ("[composite factor--restarting ecm] ");
+              mp_factor_using_ecm (f, factors);
+            }
+
+          if (mp_prime_p (n))
+            {
+              mp_factor_insert (factors, n);
+              break;
+            }
+        }
+      else if (++curves == ecm_params[level].curves
+               && level + 1 < ARRAY_CARDINALITY (ecm_params))
+        {
+          level++;
+          curves = 0;
+        }
+    }
+
+  mpz_clear (f);
+}
+#endif
+
+#if HAVE_GMP
+/* Use Pollard-rho to compute the prime factors of the composite N, and put
+   the results in FACTORS.  Hand what remains of N to ECM if no factor
+   turns up within MP_RHO_ITERATIONS iterations.  */
 static void
 mp_factor_using_pollard_rho (mpz_t n, unsigned long int a,
                              struct mp_factors *factors)
@@ -1715,6 +2208,11 @@ mp_factor_using_pollard_rho (mpz_t n, unsigned long int a,
           mpz_set (z, x);
           k = l;
           l = 2 * l;
+          if (MP_RHO_ITERATIONS < l)
+            {
+              mp_factor_using_ecm (n, factors);
+              goto done;
+            }
           for (unsigned long long int i = 0; i < k; i++)
             {
               mpz_mul (t, x, x);
@@ -1759,6 +2257,7 @@ mp_factor_using_pollard_rho (mpz_t n, unsigned long int a,
       mpz_mod (y, y, n);
     }
 
+ done:
   mpz_clears (P, t2, t, z, x, y, NULL);
 }
 #endif
@@ -2252,7 +2751,7 @@ factor (uintmax_t t1, uintmax_t t0, struct factors *factors)
 }
 
 #if HAVE_GMP
-/* Use Pollard-rho to compute the prime factors of
+/* Use Pollard-rho and ECM to compute the prime factors of
    arbitrary-precision T, and put the results in FACTORS.  */
 static void
 mp_factor (mpz_t t, struct mp_factors *factors)
@@ -2353,11 +2852,31 @@ strto2uintmax (uintmax_t *hip, uintmax_t *lop, const char *s)
 
 /* Structure and routines for buffering and outputting full lines,
    to support parallel operation efficiently.  */
-static struct lbuf_
+struct lbuf_
 {
   char *buf;
   char *end;
-} lbuf;
+  size_t size;			/* Bytes allocated for BUF.  */
+
+  /* Whether the lines are collected for a batch of input numbers
+     factored by a thread, rather than written as they are completed.  */
+  bool batch;
+
+  /* For a batch, the invalid input numbers, and the offsets in BUF at
+     which to diagnose them.  */
+  struct bad_input *bad;
+  size_t n_bad;
+  size_t bad_alloc;
+};
+
+struct bad_input
+{
+  size_t offset;
+  char const *format;
+  char *input;
+};
+
+static struct lbuf_ lbuf;
 
 /* 512 is chosen to give good performance,
    and also is the max guaranteed size that
@@ -2367,15 +2886,29 @@ static struct lbuf_
 #define FACTOR_PIPE_BUF 512
 
 static void
-lbuf_alloc (void)
+lbuf_alloc (struct lbuf_ *lb)
 {
-  if (lbuf.buf)
+  if (lb->buf)
     return;
 
   /* Double to ensure enough space for
      previous numbers + next number.  */
-  lbuf.buf = xmalloc (FACTOR_PIPE_BUF * 2);
-  lbuf.end = lbuf.buf;
+  lb->size = FACTOR_PIPE_BUF * 2;
+  lb->buf = xmalloc (lb->size);
+  lb->end = lb->buf;
+}
+
+/* Ensure that LB has room for N more bytes.  */
+static void
+lbuf_reserve (struct lbuf_ *lb, size_t n)
+{
+  size_t used = lb->end - lb->buf;
+  if (lb->size - used < n)
+    {
+      lb->size = MAX (lb->size * 2, used + n);
+      lb->buf = xrealloc (lb->buf, lb->size);
+      lb->end = lb->buf + used;
+    }
 }
 
 /* Write complete LBUF to standard output.  */
@@ -2388,69 +2921,109 @@ lbuf_flush (void)
   lbuf.end = lbuf.buf;
 }
 
-/* Add a character C to LBUF and if it's a newline
+/* Add a character C to LB and if it's a newline
    and enough bytes are already buffered,
    then write atomically to standard output.  */
 static void
-lbuf_putc (char c)
+lbuf_putc (struct lbuf_ *lb, char c)
 {
-  *lbuf.end++ = c;
+  lbuf_reserve (lb, 1);
+  *lb->end++ = c;
 
   if (c == '\n')
     {
-      size_t buffered = lbuf.end - lbuf.buf;
+      size_t buffered = lb->end - lb->buf;
 
-      /* Provide immediate output for interactive use.  */
-      static int line_buffered = -1;
-      if (line_buffered == -1)
-        line_buffered = isatty (STDIN_FILENO) || isatty (STDOUT_FILENO);
-      if (line_buffered)
-        lbuf_flush ();
-      else if (buffered >= FACTOR_PIPE_BUF)
+      if (lb->batch)
+        lbuf_reserve (lb, FACTOR_PIPE_BUF);
+      else
         {
-          /* Write output in <= PIPE_BUF chunks
-             so consumers can read atomically.  */
-          char const *tend = lbuf.end;
-
-          /* Since a umaxint_t's factors must fit in 512
-             we're guaranteed to find a newline here.  */
-          char *tlend = lbuf.buf + FACTOR_PIPE_BUF;
-          while (*--tlend != '\n');
-          tlend++;
-
-          lbuf.end = tlend;
-          lbuf_flush ();
-
-          /* Buffer the remainder.  */
-          memcpy (lbuf.buf, tlend, tend - tlend);
-          lbuf.end = lbuf.buf + (tend - tlend);
+          /* Provide immediate output for interactive use.  */
+          static int line_buffered = -1;
+          if (line_buffered == -1)
+            line_buffered = isatty (STDIN_FILENO) || isatty (STDOUT_FILENO);
+          if (line_buffered)
+            lbuf_flush ();
+          else if (buffered >= FACTOR_PIPE_BUF)
+            {
+              /* Write output in <= PIPE_BUF chunks
+                 so consumers can read atomically.
+                 A line of a multi-precision number may be longer,
+                 in which case write it all.  */
+              char const *tend = lbuf.end;
+              char *tlend = memrchr (lbuf.buf, '\n', FACTOR_PIPE_BUF);
+              tlend = tlend ? tlend + 1 : lbuf.end;
+
+              lbuf.end = tlend;
+              lbuf_flush ();
+
+              /* Buffer the remainder, which may overlap.  */
+              memmove (lbuf.buf, tlend, tend - tlend);
+              lbuf.end = lbuf.buf + (tend - tlend);
+            }
         }
     }
 }
 
-/* Buffer an int to the internal LBUF.  */
+/* Buffer an int to LB.  */
 static void
-lbuf_putint (uintmax_t i, size_t min_width)
+lbuf_putint (struct lbuf_ *lb, uintmax_t i, size_t min_width)
 {
   char buf[INT_BUFSIZE_BOUND (uintmax_t)];
   char const *umaxstr = umaxtostr (i, buf);
   size_t width = sizeof (buf) - (umaxstr - buf) - 1;
   size_t z = width;
 
+  lbuf_reserve (lb, MAX (width, min_width));
   for (; z < min_width; z++)
-    *lbuf.end++ = '0';
+    *lb->end++ = '0';
+
+  memcpy (lb->end, umaxstr, width);
+  lb->end += width;
+}
 
-  memcpy (lbuf.end, umaxstr, width);
-  lbuf.end += width;
+#if HAVE_GMP
+/* Buffer a multi-precision number to LB.  */
+static void
+lbuf_putmpz (struct lbuf_ *lb, mpz_t const i)
+{
+  /* Room for the digits, a sign, the terminating null
+     and a following newline.  */
+  lbuf_reserve (lb, mpz_sizeinbase (i, 10) + 3);
+  mpz_get_str (lb->end, 10, i);
+  lb->end += strlen (lb->end);
 }
+#endif
 
+/* Diagnose the invalid INPUT to be factored with the message FORMAT,
+   after the output for the preceding input, or for a batch, arrange for
+   it to be diagnosed when LB is output.  */
 static void
-print_uintmaxes (uintmax_t t1, uintmax_t t0)
+bad_input (struct lbuf_ *lb, char const *format, char const *input)
+{
+  if (! lb->batch)
+    {
+      lbuf_flush ();
+      error (0, 0, format, quote (input));
+    }
+  else
+    {
+      if (lb->n_bad == lb->bad_alloc)
+        lb->bad = X2NREALLOC (lb->bad, &lb->bad_alloc);
+      lb->bad[lb->n_bad].offset = lb->end - lb->buf;
+      lb->bad[lb->n_bad].format = format;
+      lb->bad[lb->n_bad].input = xstrdup (input);
+      lb->n_bad++;
+    }
+}
+
+static void
+print_uintmaxes (struct lbuf_ *lb, uintmax_t t1, uintmax_t t0)
 {
   uintmax_t q, r;
 
   if (t1 == 0)
-    lbuf_putint (t0, 0);
+    lbuf_putint (lb, t0, 0);
   else
     {
       /* Use very plain code here since it seems hard to write fast code
@@ -2458,45 +3031,45 @@ print_uintmaxes (uintmax_t t1, uintmax_t t0)
       q = t1 / 1000000000;
       r = t1 % 1000000000;
       udiv_qrnnd (t0, r, r, t0, 1000000000);
-      print_uintmaxes (q, t0);
-      lbuf_putint (r, 9);
+      print_uintmaxes (lb, q, t0);
+      lbuf_putint (lb, r, 9);
     }
 }
 
 /* Single-precision factoring */
 static void
-print_factors_single (uintmax_t t1, uintmax_t t0)
+print_factors_single (struct lbuf_ *lb, uintmax_t t1, uintmax_t t0)
 {
   struct factors factors;
 
-  print_uintmaxes (t1, t0);
-  lbuf_putc (':');
+  print_uintmaxes (lb, t1, t0);
+  lbuf_putc (lb, ':');
 
   factor (t1, t0, &factors);
 
   for (unsigned int j = 0; j < factors.nfactors; j++)
     for (unsigned int k = 0; k < factors.e[j]; k++)
       {
-        lbuf_putc (' ');
-        print_uintmaxes (0, factors.p[j]);
+        lbuf_putc (lb, ' ');
+        print_uintmaxes (lb, 0, factors.p[j]);
       }
 
   if (factors.plarge[1])
     {
-      lbuf_putc (' ');
-      print_uintmaxes (factors.plarge[1], factors.plarge[0]);
+      lbuf_putc (lb, ' ');
+      print_uintmaxes (lb, factors.plarge[1], factors.plarge[0]);
     }
 
-  lbuf_putc ('\n');
+  lbuf_putc (lb, '\n');
 }
 
-/* Emit the factors of the indicated number.  If we have the option of using
-   either algorithm, we select on the basis of the length of the number.
-   For longer numbers, we prefer the MP algorithm even if the native algorithm
-   has enough digits, because the algorithm is better.  The turnover point
-   depends on the value.  */
+/* Emit the factors of the indicated number to LB.  If we have the option
+   of using either algorithm, we select on the basis of the length of the
+   number.  For longer numbers, we prefer the MP algorithm even if the
+   native algorithm has enough digits, because the algorithm is better.
+   The turnover point depends on the value.  */
 static bool
-print_factors (const char *input)
+print_factors (struct lbuf_ *lb, const char *input)
 {
   uintmax_t t1, t0;
 
@@ -2512,7 +3085,7 @@ print_factors (const char *input)
       if (((t1 << 1) >> 1) == t1)
         {
           devmsg ("[using single-precision arithmetic] ");
-          print_factors_single (t1, t0);
+          print_factors_single (lb, t1, t0);
           return true;
         }
       break;
@@ -2522,7 +3095,7 @@ print_factors (const char *input)
       break;
 
     default:
-      error (0, 0, _("%s is not a valid positive integer"), quote (input));
+      bad_input (lb, _("%s is not a valid positive integer"), input);
       return false;
     }
 
@@ -2533,24 +3106,103 @@ print_factors (const char *input)
 
   mpz_init_set_str (t, input, 10);
 
-  gmp_printf ("%Zd:", t);
+  lbuf_putmpz (lb, t);
+  lbuf_putc (lb, ':');
   mp_factor (t, &factors);
 
   for (unsigned int j = 0; j < factors.nfactors; j++)
     for (unsigned int k = 0; k < factors.e[j]; k++)
-      gmp_printf (" %Zd", factors.p[j]);
+      {
+        lbuf_putc (lb, ' ');
+        lbuf_putmpz (lb, factors.p[j]);
+      }
 
   mp_factor_clear (&factors);
   mpz_clear (t);
-  putchar ('\n');
-  fflush (stdout);
+  lbuf_putc (lb, '\n');
   return true;
 #else
-  error (0, 0, _("%s is too large"), quote (input));
+  bad_input (lb, _("%s is too large"), input);
   return false;
 #endif
 }
 
+/* A reader of the numbers delimited by newlines, tabs or spaces on
+   standard input, read in large blocks.  */
+struct tokenizer
+{
+  char *buf;
+  size_t size;			/* Bytes allocated for BUF.  */
+  char *next;			/* The start of the unread data in BUF.  */
+  char *lim;			/* The end of the data in BUF.  */
+  bool eof;
+};
+
+static void
+tokenizer_init (struct tokenizer *t)
+{
+  t->size = IO_BUFSIZE;
+  t->buf = xmalloc (t->size);
+  t->next = t->lim = t->buf;
+  t->eof = false;
+}
+
+static bool
+is_delim (char c)
+{
+  return c == '\n' || c == '\t' || c == ' ';
+}
+
+/* Return the next null-terminated number from T, which is valid
+   until the next call, or NULL at end of input.  Store its length
+   in *LEN.  */
+static char *
+next_token (struct tokenizer *t, size_t *len)
+{
+  char *p = t->next;
+
+  while (true)
+    {
+      while (p < t->lim && is_delim (*p))
+        p++;
+      char *start = p;
+      while (p < t->lim && ! is_delim (*p))
+        p++;
+
+      if (p < t->lim || (t->eof && start < p))
+        {
+          *p = '\0';
+          t->next = p + (p < t->lim);
+          *len = p - start;
+          return start;
+        }
+      if (t->eof)
+        return NULL;
+
+      /* Move the partial number to the start of the buffer, leaving
+         room for its terminating null, and read more data.  */
+      size_t pending = p - start;
+      if (pending + 1 >= t->size)
+        {
+          size_t offset = start - t->buf;
+          t->buf = x2realloc (t->buf, &t->size);
+          start = t->buf + offset;
+        }
+      memmove (t->buf, start, pending);
+      t->next = t->buf;
+      t->lim = t->buf + pending;
+
+      size_t nread = safe_read (STDIN_FILENO, t->lim,
+                                t->size - 1 - pending);
+      if (nread == SAFE_READ_ERROR)
+        die (EXIT_FAILURE, errno, "%s", _("read error"));
+      if (nread == 0)
+        t->eof = true;
+      t->lim += nread;
+      p = t->next;
+    }
+}
+
 void
 usage (int status)
 {
@@ -2559,14 +3211,16 @@ usage (int status)
   else
     {
       printf (_("\
-Usage: %s [NUMBER]...\n\
-  or:  %s OPTION\n\
+Usage: %s [OPTION]... [NUMBER]...\n\
 "),
-              program_name, program_name);
+              program_name);
       fputs (_("\
 Print the prime factors of each specified integer NUMBER.  If none\n\
 are specified on the command line, read them from standard input.\n\
 \n\
+"), stdout);
+      fputs (_("\
+      --parallel=N  factor numbers from standard input with N threads\n\
 "), stdout);
       fputs (HELP_OPTION_DESCRIPTION, stdout);
       fputs (VERSION_OPTION_DESCRIPTION, stdout);
@@ -2579,19 +3233,216 @@ static bool
 do_stdin (void)
 {
   bool ok = true;
-  token_buffer tokenbuffer;
+  struct tokenizer tokenizer;
+  char *number;
+  size_t len;
+
+  tokenizer_init (&tokenizer);
+  while ((number = next_token (&tokenizer, &len)))
+    ok &= print_factors (&lbuf, number);
+  free (tokenizer.buf);
+
+  return ok;
+}
+
+/* The number of input numbers that a thread factors at once.  */
+enum { BATCH_NUMBERS = 1024 };
+
+/* A batch of input numbers, and the output of factoring them.  */
+struct batch
+{
+  char *numbers;		/* The null-terminated numbers.  */
+  size_t n_numbers;
+  size_t numbers_size;		/* Bytes used in NUMBERS.  */
+  size_t numbers_alloc;		/* Bytes allocated for NUMBERS.  */
+  struct lbuf_ out;
+  bool ok;			/* Whether all the numbers were valid.  */
+  bool done;			/* Whether the batch has been factored.  */
+};
+
+/* Batches of numbers read by the main thread, factored by the other
+   threads, and output in order by the main thread.  BATCHES is used as
+   a ring of N_BATCHES elements, indexed by a count of batches modulo
+   N_BATCHES.  */
+struct batch_queue
+{
+  struct batch *batches;
+  size_t n_batches;
+  uintmax_t filled;		/* The number of batches read.  */
+  uintmax_t taken;		/* The number of those being factored.  */
+  bool eof;			/* Whether all batches have been read.  */
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+};
+
+/* Factor the batches of the queue ARG as they are read, until the
+   end of input.  */
+static void *
+factor_batches (void *arg)
+{
+  struct batch_queue *q = arg;
+
+  pthread_mutex_lock (&q->lock);
+  while (true)
+    {
+      if (q->taken < q->filled)
+        {
+          struct batch *b = &q->batches[q->taken++ % q->n_batches];
+          pthread_mutex_unlock (&q->lock);
+
+          bool ok = true;
+          char const *number = b->numbers;
+          for (size_t i = 0; i < b->n_numbers; i++)
+            {
+              ok &= print_factors (&b->out, number);
+              number += strlen (number) + 1;
+            }
+
+          pthread_mutex_lock (&q->lock);
+          b->ok = ok;
+          b->done = true;
+          pthread_cond_broadcast (&q->cond);
+        }
+      else if (q->eof)
+        break;
+      else
+        pthread_cond_wait (&q->cond, &q->lock);
+    }
+  pthread_mutex_unlock (&q->lock);
+
+  return NULL;
+}
+
+/* Read into B up to BATCH_NUMBERS numbers from T.
+   Return false if there were none.  */
+static bool
+fill_batch (struct batch *b, struct tokenizer *t)
+{
+  char *number;
+  size_t len;
+
+  b->n_numbers = b->numbers_size = 0;
+  while (b->n_numbers < BATCH_NUMBERS && (number = next_token (t, &len)))
+    {
+      if (b->numbers_alloc - b->numbers_size <= len)
+        {
+          b->numbers_alloc = MAX (b->numbers_alloc * 2,
+                                  b->numbers_size + len + 1);
+          b->numbers = xrealloc (b->numbers, b->numbers_alloc);
+        }
+      memcpy (b->numbers + b->numbers_size, number, len + 1);
+      b->numbers_size += len + 1;
+      b->n_numbers++;
+    }
+
+  return b->n_numbers != 0;
+}
 
-  init_tokenbuffer (&tokenbuffer);
+/* Wait until B of queue Q is factored, then output it, diagnosing
+   its invalid numbers in turn.  Return true if they were all valid.  */
+static bool
+write_batch (struct batch_queue *q, struct batch *b)
+{
+  pthread_mutex_lock (&q->lock);
+  while (! b->done)
+    pthread_cond_wait (&q->cond, &q->lock);
+  pthread_mutex_unlock (&q->lock);
+
+  char const *p = b->out.buf;
+  for (size_t i = 0; i <= b->out.n_bad; i++)
+    {
+      char const *end = (i < b->out.n_bad
+                         ? b->out.buf + b->out.bad[i].offset : b->out.end);
+      size_t size = end - p;
+      if (full_write (STDOUT_FILENO, p, size) != size)
+        die (EXIT_FAILURE, errno, "%s", _("write error"));
+      p = end;
+      if (i < b->out.n_bad)
+        {
+          error (0, 0, b->out.bad[i].format, quote (b->out.bad[i].input));
+          free (b->out.bad[i].input);
+        }
+    }
+
+  b->out.end = b->out.buf;
+  b->out.n_bad = 0;
+  return b->ok;
+}
+
+/* Factor the numbers on standard input with N_THREADS threads, reading
+   them in batches, and output the results in the order of the input.  */
+static bool
+do_stdin_parallel (size_t n_threads)
+{
+  struct batch_queue q;
+  q.n_batches = 2 * n_threads;
+  q.batches = xcalloc (q.n_batches, sizeof *q.batches);
+  q.filled = q.taken = 0;
+  q.eof = false;
+  pthread_mutex_init (&q.lock, NULL);
+  pthread_cond_init (&q.cond, NULL);
+
+  for (size_t i = 0; i < q.n_batches; i++)
+    {
+      q.batches[i].out.batch = true;
+      lbuf_alloc (&q.batches[i].out);
+    }
+
+  /* Make do with fewer threads if some cannot be created.  */
+  pthread_t *threads = xnmalloc (n_threads, sizeof *threads);
+  size_t n_created = 0;
+  while (n_created < n_threads
+         && pthread_create (&threads[n_created], NULL, factor_batches, &q)
+            == 0)
+    n_created++;
+  if (n_created == 0)
+    {
+      free (threads);
+      return do_stdin ();
+    }
+
+  bool ok = true;
+  uintmax_t written = 0;
+  struct tokenizer tokenizer;
+  tokenizer_init (&tokenizer);
 
   while (true)
     {
-      size_t token_length = readtoken (stdin, DELIM, sizeof (DELIM) - 1,
-                                       &tokenbuffer);
-      if (token_length == (size_t) -1)
+      struct batch *b = &q.batches[q.filled % q.n_batches];
+      if (q.filled - written == q.n_batches)
+        ok &= write_batch (&q, &q.batches[written++ % q.n_batches]);
+      if (! fill_batch (b, &tokenizer))
         break;
-      ok &= print_factors (tokenbuffer.buffer);
+
+      pthread_mutex_lock (&q.lock);
+      b->done = false;
+      q.filled++;
+      pthread_cond_broadcast (&q.cond);
+      pthread_mutex_unlock (&q.lock);
     }
-  free (tokenbuffer.buffer);
+
+  pthread_mutex_lock (&q.lock);
+  q.eof = true;
+  pthread_cond_broadcast (&q.cond);
+  pthread_mutex_unlock (&q.lock);
+
+  while (written < q.filled)
+    ok &= write_batch (&q, &q.batches[written++ % q.n_batches]);
+
+  for (size_t i = 0; i < n_created; i++)
+    pthread_join (threads[i], NULL);
+
+#ifdef lint
+  for (size_t i = 0; i < q.n_batches; i++)
+    {
+      free (q.batches[i].numbers);
+      free (q.batches[i].out.buf);
+      free (q.batches[i].out.bad);
+    }
+  free (q.batches);
+  free (threads);
+  free (tokenizer.buf);
+#endif
 
   return ok;
 }
@@ -2605,10 +3456,11 @@ main (int argc, char **argv)
   bindtextdomain (PACKAGE, LOCALEDIR);
   textdomain (PACKAGE);
 
-  lbuf_alloc ();
+  lbuf_alloc (&lbuf);
   atexit (close_stdout);
   atexit (lbuf_flush);
 
+  size_t n_threads = 1;
   int c;
   while ((c = getopt_long (argc, argv, "", long_options, NULL)) != -1)
     {
@@ -2618,6 +3470,11 @@ main (int argc, char **argv)
           dev_debug = true;
           break;
 
+        case PARALLEL_OPTION:
+          n_threads = xdectoumax (optarg, 1, SIZE_MAX / 2, "",
+                                  _("invalid number of threads"), 0);
+          break;
+
         case_GETOPT_HELP_CHAR;
 
         case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
@@ -2633,12 +3490,12 @@ main (int argc, char **argv)
 
   bool ok;
   if (argc <= optind)
-    ok = do_stdin ();
+    ok = n_threads <= 1 ? do_stdin () : do_stdin_parallel (n_threads);
   else
     {
       ok = true;
       for (int i = optind; i < argc; i++)
-        if (! print_factors (argv[i]))
+        if (! print_factors (&lbuf, argv[i]))
           ok = false;
     }
 
@@ -0,0 +1,285 @@
+/* fts-jobs -- change the files of an fts traversal with helper threads
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+
+#include <pthread.h>
+#include <sys/types.h>
+#include "system.h"
+#include "xalloc.h"
+
+#include "fts-jobs.h"
+
+/* The number of jobs queued per thread.  Each job can hold open a
+   duplicate of the descriptor of its directory, so this is kept small;
+   a few jobs per thread suffice to keep the threads busy.  */
+enum { JOBS_PER_THREAD = 16 };
+
+/* A duplicate of the descriptor of a directory, shared by the jobs on
+   the files in it.  SOURCE_FD, DEV and INO identify the directory at
+   the time it was duplicated, as fts closes and reuses descriptors.  */
+struct fts_job_dir
+{
+  int fd;
+  int source_fd;
+  dev_t dev;
+  ino_t ino;
+  size_t refs;
+};
+
+/* Jobs queued by the main thread, applied by the helper threads, and
+   reported in order by the main thread.  RING holds N_RING jobs,
+   indexed by a count of jobs modulo N_RING.  */
+struct fts_jobs
+{
+  struct fts_job **ring;
+  size_t n_ring;
+  uintmax_t queued;		/* The number of jobs queued.  */
+  uintmax_t taken;		/* The number of those taken by a thread.  */
+  uintmax_t reported;		/* The number of those reported.  */
+  bool finished;		/* Whether all jobs have been queued.  */
+  void (*apply) (struct fts_job *);
+  bool (*report) (struct fts_job *);
+  bool ok;			/* Whether all jobs reported success.  */
+  struct fts_job_dir *dir;	/* The directory of the last job queued.  */
+  pthread_t *threads;
+  size_t n_threads;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+};
+
+/* Apply the jobs of the queue ARG as they are queued, until all have
+   been queued.  */
+static void *
+apply_jobs (void *arg)
+{
+  struct fts_jobs *jobs = arg;
+
+  pthread_mutex_lock (&jobs->lock);
+  while (true)
+    {
+      if (jobs->taken < jobs->queued)
+        {
+          struct fts_job *job = jobs->ring[jobs->taken++ % jobs->n_ring];
+          if (job->done)
+            continue;
+          pthread_mutex_unlock (&jobs->lock);
+
+          jobs->apply (job);
+
+          pthread_mutex_lock (&jobs->lock);
+          job->done = true;
+          pthread_cond_broadcast (&jobs->cond);
+        }
+      else if (jobs->finished)
+        break;
+      else
+        pthread_cond_wait (&jobs->cond, &jobs->lock);
+    }
+  pthread_mutex_unlock (&jobs->lock);
+
+  return NULL;
+}
+
+struct fts_jobs *
+fts_jobs_create (size_t n_threads, void (*apply) (struct fts_job *),
+                 bool (*report) (struct fts_job *))
+{
+  struct fts_jobs *jobs = xmalloc (sizeof *jobs);
+  jobs->n_ring = n_threads * JOBS_PER_THREAD;
+  jobs->ring = xnmalloc (jobs->n_ring, sizeof *jobs->ring);
+  jobs->queued = jobs->taken = jobs->reported = 0;
+  jobs->finished = false;
+  jobs->apply = apply;
+  jobs->report = report;
+  jobs->ok = true;
+  jobs->dir = NULL;
+  pthread_mutex_init (&jobs->lock, NULL);
+  pthread_cond_init (&jobs->cond, NULL);
+
+  /* Make do with fewer threads if some cannot be created.  */
+  jobs->threads = xnmalloc (n_threads, sizeof *jobs->threads);
+  jobs->n_threads = 0;
+  while (jobs->n_threads < n_threads
+         && pthread_create (&jobs->threads[jobs->n_threads], NULL,
+                            apply_jobs, jobs) == 0)
+    jobs->n_threads++;
+  if (jobs->n_threads == 0)
+    {
+      pthread_mutex_destroy (&jobs->lock);
+      pthread_cond_destroy (&jobs->cond);
+      free (jobs->threads);
+      free (jobs->ring);
+      free (jobs);
+      return NULL;
+    }
+
+  return jobs;
+}
+
+/* Drop a reference to DIR, closing it when no longer used.  */
+static void
+release_dir (struct fts_job_dir *dir)
+{
+  if (dir && --dir->refs == 0)
+    {
+      close (dir->fd);
+      free (dir);
+    }
+}
+
+/* Wait for the oldest job of JOBS to be applied, then report it.  */
+static void
+report_job (struct fts_jobs *jobs)
+{
+  struct fts_job *job = jobs->ring[jobs->reported % jobs->n_ring];
+
+  pthread_mutex_lock (&jobs->lock);
+  while (! job->done)
+    pthread_cond_wait (&jobs->cond, &jobs->lock);
+  /* A job applied by fts_jobs_add may not have been taken yet.
+     Skip it, so that no thread looks at it once freed.  */
+  if (jobs->taken == jobs->reported)
+    jobs->taken++;
+  pthread_mutex_unlock (&jobs->lock);
+
+  jobs->ok &= jobs->report (job);
+  jobs->reported++;
+
+  release_dir (job->dir);
+  free (job->file);
+  free (job->full_name);
+  free (job);
+}
+
+/* Return the directory that the files of ENT's directory are relative
+   to, duplicating the descriptor of FTS's working directory if that
+   has changed since the last job.  Return NULL upon failure.  */
+static struct fts_job_dir *
+job_dir (struct fts_jobs *jobs, FTS const *fts, FTSENT const *ent)
+{
+  struct stat const *st = ent->fts_parent->fts_statp;
+  struct fts_job_dir *dir = jobs->dir;
+
+  if (! (dir && dir->source_fd == fts->fts_cwd_fd
+         && dir->dev == st->st_dev && dir->ino == st->st_ino))
+    {
+      int fd = fcntl (fts->fts_cwd_fd, F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+      if (fd < 0)
+        return NULL;
+      release_dir (jobs->dir);
+      dir = jobs->dir = xmalloc (sizeof *dir);
+      dir->fd = fd;
+      dir->source_fd = fts->fts_cwd_fd;
+      dir->dev = st->st_dev;
+      dir->ino = st->st_ino;
+      dir->refs = 1;
+    }
+
+  dir->refs++;
+  return dir;
+}
+
+void
+fts_jobs_add (struct fts_jobs *jobs, FTS const *fts, FTSENT const *ent,
+              struct fts_job *job, bool now)
+{
+  if (jobs->queued - jobs->reported == jobs->n_ring)
+    report_job (jobs);
+
+  job->file = xstrdup (ent->fts_accpath);
+  job->full_name = xstrdup (ent->fts_path);
+  job->dir = NULL;
+  job->dir_fd = fts->fts_cwd_fd;
+  job->done = false;
+
+  /* Names at the top level are relative to the working directory,
+     which does not change.  Otherwise, if out of descriptors, apply
+     the job now, while FTS's descriptor is valid.  */
+  if (0 <= fts->fts_cwd_fd)
+    {
+      job->dir = job_dir (jobs, fts, ent);
+      if (job->dir)
+        job->dir_fd = job->dir->fd;
+      else
+        now = true;
+    }
+
+  if (now)
+    {
+      jobs->apply (job);
+      job->done = true;
+    }
+
+  pthread_mutex_lock (&jobs->lock);
+  jobs->ring[jobs->queued++ % jobs->n_ring] = job;
+  pthread_cond_broadcast (&jobs->cond);
+  pthread_mutex_unlock (&jobs->lock);
+}
+
+void
+fts_jobs_flush (struct fts_jobs *jobs)
+{
+  while (jobs->reported < jobs->queued)
+    report_job (jobs);
+}
+
+bool
+fts_jobs_sync (struct fts_jobs *jobs, FTS const *fts, FTSENT const *ent,
+               struct stat *st)
+{
+  struct stat const *ent_st = ent->fts_statp;
+
+  if (! (ent->fts_level == FTS_ROOTLEVEL
+         || (! S_ISDIR (ent_st->st_mode) && 1 < ent_st->st_nlink)
+         || ((fts->fts_options & FTS_LOGICAL)
+             && fstatat (fts->fts_cwd_fd, ent->fts_accpath, st,
+                         AT_SYMLINK_NOFOLLOW) == 0
+             && S_ISLNK (st->st_mode))))
+    return false;
+
+  fts_jobs_flush (jobs);
+
+  /* Follow a symlink as FTS did, unless ENT is the symlink itself.  */
+  if (fstatat (fts->fts_cwd_fd, ent->fts_accpath, st,
+               S_ISLNK (ent_st->st_mode) ? AT_SYMLINK_NOFOLLOW : 0) != 0)
+    *st = *ent_st;
+  return true;
+}
+
+bool
+fts_jobs_free (struct fts_jobs *jobs)
+{
+  fts_jobs_flush (jobs);
+
+  pthread_mutex_lock (&jobs->lock);
+  jobs->finished = true;
+  pthread_cond_broadcast (&jobs->cond);
+  pthread_mutex_unlock (&jobs->lock);
+
+  for (size_t i = 0; i < jobs->n_threads; i++)
+    pthread_join (jobs->threads[i], NULL);
+
+  bool ok = jobs->ok;
+  release_dir (jobs->dir);
+  pthread_mutex_destroy (&jobs->lock);
+  pthread_cond_destroy (&jobs->cond);
+  free (jobs->threads);
+  free (jobs->ring);
+  free (jobs);
+  return ok;
+}
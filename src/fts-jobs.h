@@ -0,0 +1,72 @@
+/* fts-jobs -- change the files of an fts traversal with helper threads
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef FTS_JOBS_H
+# define FTS_JOBS_H
+
+# include "fts_.h"
+
+/* A change to one file of a traversal.  The change is applied by a
+   helper thread, which must only make system calls and record their
+   results in the job, and is then reported by the thread that queued
+   it, in the order the jobs were queued.  Callers embed this structure
+   at the start of a larger one that holds the details of the change.  */
+struct fts_job
+{
+  int dir_fd;			/* The directory FILE is relative to.  */
+  char *file;			/* The name of the file, relative to DIR_FD.  */
+  char *full_name;		/* The name of the file, for diagnostics.  */
+
+  /* Private to fts-jobs.c.  */
+  struct fts_job_dir *dir;
+  bool done;
+};
+
+struct fts_jobs;
+
+/* Return a queue of jobs applied by N_THREADS helper threads with APPLY,
+   and reported with REPORT, which returns false if the change failed.
+   Return NULL if no threads could be created.  */
+extern struct fts_jobs *fts_jobs_create (size_t n_threads,
+                                         void (*apply) (struct fts_job *),
+                                         bool (*report) (struct fts_job *));
+
+/* Queue JOB, allocated with malloc, to change the file of the entry ENT
+   returned by fts_read from FTS, which must be opened with FTS_CWDFD.
+   If NOW, apply JOB before returning, as for a directory that FTS may
+   go on to read.  JOB is freed once it has been reported.  */
+extern void fts_jobs_add (struct fts_jobs *jobs, FTS const *fts,
+                          FTSENT const *ent, struct fts_job *job, bool now);
+
+/* If the file of ENT may also be reached by FTS under another name,
+   e.g., through a hard link or, with FTS_LOGICAL, a symbolic link,
+   wait for the jobs queued so far and store the current status of the
+   file into *ST, as a job queued since ENT was read may have changed it.
+   Return true if so; the caller should then apply its change now, so
+   that it is visible to the other names as without threads.  */
+extern bool fts_jobs_sync (struct fts_jobs *jobs, FTS const *fts,
+                           FTSENT const *ent, struct stat *st);
+
+/* Wait for the jobs queued so far and report them, so that a diagnostic
+   can be output after them.  */
+extern void fts_jobs_flush (struct fts_jobs *jobs);
+
+/* Report all the queued jobs, then stop the threads and free JOBS.
+   Return false if any job failed to report success.  */
+extern bool fts_jobs_free (struct fts_jobs *jobs);
+
+#endif
@@ -28,8 +28,11 @@
 #include "fadvise.h"
 #include "hard-locale.h"
 #include "linebuffer.h"
+#include "line-reader.h"
 #include "memcasecmp.h"
+#include "obstack.h"
 #include "quote.h"
+#include "spill.h"
 #include "stdio--.h"
 #include "xmemcoll.h"
 #include "xstrtol.h"
@@ -42,6 +45,9 @@
 
 #define join system_join
 
+#define obstack_chunk_alloc xmalloc
+#define obstack_chunk_free free
+
 #define SWAPLINES(a, b) do { \
   struct line *tmp = a; \
   a = b; \
@@ -73,6 +79,7 @@ struct field
 struct line
   {
     struct linebuffer buf;	/* The line itself.  */
+    struct linebuffer store;	/* Storage for BUF once it is kept.  */
     size_t nfields;		/* Number of elements in 'fields'.  */
     size_t nfields_allocated;	/* Number of elements allocated for 'fields'. */
     struct field *fields;
@@ -101,6 +108,15 @@ static char *g_names[2];
    want to overwrite the previous buffer before we check order. */
 static struct line *spareline[2] = {NULL, NULL};
 
+/* Every line allocated by init_linep.  Lines usually view the buffer
+   of their file's reader, and these are all kept when it is refilled.  */
+static struct line **all_lines;
+static size_t n_all_lines;
+static size_t all_lines_alloc;
+
+/* The readers of the two input files.  */
+static struct line_reader readers[2];
+
 /* True if the LC_COLLATE locale is hard.  */
 static bool hard_LC_COLLATE;
 
@@ -153,7 +169,9 @@ enum
 {
   CHECK_ORDER_OPTION = CHAR_MAX + 1,
   NOCHECK_ORDER_OPTION,
-  HEADER_LINE_OPTION
+  HEADER_LINE_OPTION,
+  HASH_OPTION,
+  BUFFER_SIZE_OPTION
 };
 
 
@@ -164,6 +182,8 @@ static struct option const longopts[] =
   {"nocheck-order", no_argument, NULL, NOCHECK_ORDER_OPTION},
   {"zero-terminated", no_argument, NULL, 'z'},
   {"header", no_argument, NULL, HEADER_LINE_OPTION},
+  {"hash", no_argument, NULL, HASH_OPTION},
+  {"buffer-size", required_argument, NULL, BUFFER_SIZE_OPTION},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
   {NULL, 0, NULL, 0}
@@ -223,6 +243,12 @@ When FILE1 or FILE2 (not both) is -, read standard input.\n\
   --nocheck-order   do not check that the input is correctly sorted\n\
   --header          treat the first line in each file as field headers,\n\
                       print them without trying to pair them\n\
+"), stdout);
+      fputs (_("\
+  --hash            join unsorted input by keeping the lines of the smaller\n\
+                      file in a hash table, in memory if they fit\n\
+  --buffer-size=SIZE  with --hash, use about SIZE of memory for the table\n\
+                        before partitioning both files into temporary files\n\
 "), stdout);
       fputs (_("\
   -z, --zero-terminated     line delimiter is NUL, not newline\n\
@@ -245,6 +271,13 @@ or use \"join -t ''\" if 'sort' has no options.\n\
 Note, comparisons honor the rules specified by 'LC_COLLATE'.\n\
 If the input is not sorted and some lines cannot be joined, a\n\
 warning message will be given.\n\
+"), stdout);
+      fputs (_("\
+\n\
+With --hash, the files need not be sorted, join fields are compared\n\
+byte by byte, and the output is in the order of the larger file.\n\
+SIZE may be followed by one of the multiplicative suffixes\n\
+b, K, M, G, T, P, E, Z, Y, with K (1024) being the default.\n\
 "), stdout);
       emit_ancillary_info (PROGRAM_NAME);
     }
@@ -313,8 +346,10 @@ freeline (struct line *line)
     return;
   free (line->fields);
   line->fields = NULL;
-  free (line->buf.buffer);
-  line->buf.buffer = NULL;
+  line->nfields = line->nfields_allocated = 0;
+  free (line->store.buffer);
+  initbuffer (&line->store);
+  initbuffer (&line->buf);
 }
 
 /* Return <0 if the join field in LINE1 compares less than the one in LINE2;
@@ -436,15 +471,39 @@ static struct line *
 init_linep (struct line **linep)
 {
   struct line *line = xcalloc (1, sizeof *line);
+  if (n_all_lines == all_lines_alloc)
+    all_lines = X2NREALLOC (all_lines, &all_lines_alloc);
+  all_lines[n_all_lines++] = line;
   *linep = line;
   return line;
 }
 
-/* Read a line from FP into LINE and split it into fields.
+/* Save the lines viewing the buffer of the reader ARG,
+   before it is refilled.  */
+
+static void
+keep_lines (void *arg)
+{
+  struct line_reader const *r = arg;
+
+  for (size_t i = 0; i < n_all_lines; i++)
+    {
+      struct line *line = all_lines[i];
+      char const *old = line->buf.buffer;
+      if (line_reader_keep (r, &line->buf, &line->store))
+        for (size_t j = 0; j < line->nfields; j++)
+          {
+            struct field *f = &line->fields[j];
+            f->beg = line->buf.buffer + (f->beg - old);
+          }
+    }
+}
+
+/* Read a line from R into LINE and split it into fields.
    Return true if successful.  */
 
 static bool
-get_line (FILE *fp, struct line **linep, int which)
+get_line (struct line_reader *r, struct line **linep, int which)
 {
   struct line *line = *linep;
 
@@ -459,10 +518,10 @@ get_line (FILE *fp, struct line **linep, int which)
   else
     line = init_linep (linep);
 
-  if (! readlinebuffer_delim (&line->buf, fp, eolchar))
+  if (! line_reader_next (r, &line->buf))
     {
-      if (ferror (fp))
-        die (EXIT_FAILURE, errno, _("read error"));
+      if (r->errnum)
+        die (EXIT_FAILURE, r->errnum, _("read error"));
       freeline (line);
       return false;
     }
@@ -498,10 +557,10 @@ initseq (struct seq *seq)
   seq->lines = NULL;
 }
 
-/* Read a line from FP and add it to SEQ.  Return true if successful.  */
+/* Read a line from R and add it to SEQ.  Return true if successful.  */
 
 static bool
-getseq (FILE *fp, struct seq *seq, int whichfile)
+getseq (struct line_reader *r, struct seq *seq, int whichfile)
 {
   if (seq->count == seq->alloc)
     {
@@ -510,7 +569,7 @@ getseq (FILE *fp, struct seq *seq, int whichfile)
         seq->lines[i] = NULL;
     }
 
-  if (get_line (fp, &seq->lines[seq->count], whichfile))
+  if (get_line (r, &seq->lines[seq->count], whichfile))
     {
       ++seq->count;
       return true;
@@ -518,15 +577,16 @@ getseq (FILE *fp, struct seq *seq, int whichfile)
   return false;
 }
 
-/* Read a line from FP and add it to SEQ, as the first item if FIRST is
+/* Read a line from R and add it to SEQ, as the first item if FIRST is
    true, else as the next.  */
 static bool
-advance_seq (FILE *fp, struct seq *seq, bool first, int whichfile)
+advance_seq (struct line_reader *r, struct seq *seq, bool first,
+             int whichfile)
 {
   if (first)
     seq->count = 0;
 
-  return getseq (fp, seq, whichfile);
+  return getseq (r, seq, whichfile);
 }
 
 static void
@@ -659,14 +719,23 @@ join (FILE *fp1, FILE *fp2)
   int diff;
   bool eof1, eof2;
 
+  struct line_reader *r1 = &readers[0];
+  struct line_reader *r2 = &readers[1];
+
   fadvise (fp1, FADVISE_SEQUENTIAL);
   fadvise (fp2, FADVISE_SEQUENTIAL);
 
+  line_reader_init (r1, fileno (fp1), eolchar);
+  line_reader_init (r2, fileno (fp2), eolchar);
+  r1->before_refill = r2->before_refill = keep_lines;
+  r1->before_refill_arg = r1;
+  r2->before_refill_arg = r2;
+
   /* Read the first line of each file.  */
   initseq (&seq1);
-  getseq (fp1, &seq1, 1);
+  getseq (r1, &seq1, 1);
   initseq (&seq2);
-  getseq (fp2, &seq2, 2);
+  getseq (r2, &seq2, 2);
 
   if (autoformat)
     {
@@ -682,9 +751,9 @@ join (FILE *fp1, FILE *fp2)
       prevline[0] = NULL;
       prevline[1] = NULL;
       if (seq1.count)
-        advance_seq (fp1, &seq1, true, 1);
+        advance_seq (r1, &seq1, true, 1);
       if (seq2.count)
-        advance_seq (fp2, &seq2, true, 2);
+        advance_seq (r2, &seq2, true, 2);
     }
 
   while (seq1.count && seq2.count)
@@ -695,7 +764,7 @@ join (FILE *fp1, FILE *fp2)
         {
           if (print_unpairables_1)
             prjoin (seq1.lines[0], &uni_blank);
-          advance_seq (fp1, &seq1, true, 1);
+          advance_seq (r1, &seq1, true, 1);
           seen_unpairable = true;
           continue;
         }
@@ -703,7 +772,7 @@ join (FILE *fp1, FILE *fp2)
         {
           if (print_unpairables_2)
             prjoin (&uni_blank, seq2.lines[0]);
-          advance_seq (fp2, &seq2, true, 2);
+          advance_seq (r2, &seq2, true, 2);
           seen_unpairable = true;
           continue;
         }
@@ -712,7 +781,7 @@ join (FILE *fp1, FILE *fp2)
          match the current line from file2.  */
       eof1 = false;
       do
-        if (!advance_seq (fp1, &seq1, false, 1))
+        if (!advance_seq (r1, &seq1, false, 1))
           {
             eof1 = true;
             ++seq1.count;
@@ -725,7 +794,7 @@ join (FILE *fp1, FILE *fp2)
          match the current line from file1.  */
       eof2 = false;
       do
-        if (!advance_seq (fp2, &seq2, false, 2))
+        if (!advance_seq (r2, &seq2, false, 2))
           {
             eof2 = true;
             ++seq2.count;
@@ -778,7 +847,7 @@ join (FILE *fp1, FILE *fp2)
         prjoin (seq1.lines[0], &uni_blank);
       if (seq2.count)
         seen_unpairable = true;
-      while (get_line (fp1, &line, 1))
+      while (get_line (r1, &line, 1))
         {
           if (print_unpairables_1)
             prjoin (line, &uni_blank);
@@ -793,7 +862,7 @@ join (FILE *fp1, FILE *fp2)
         prjoin (&uni_blank, seq2.lines[0]);
       if (seq1.count)
         seen_unpairable = true;
-      while (get_line (fp2, &line, 2))
+      while (get_line (r2, &line, 2))
         {
           if (print_unpairables_2)
             prjoin (&uni_blank, line);
@@ -807,6 +876,463 @@ join (FILE *fp1, FILE *fp2)
 
   delseq (&seq1);
   delseq (&seq2);
+  free (all_lines);
+  line_reader_free (r1);
+  line_reader_free (r2);
+}
+
+/* A line of the build input, whose lines are kept in a hash table.  */
+struct hash_line
+{
+  struct line line;		/* The line, with its fields.  */
+  uint64_t hash;		/* Hash value of its join field.  */
+  size_t next;			/* One more than the index of the next
+                                   line with the same key, or 0.  */
+  bool paired;			/* True once joined with a probe line.  */
+};
+
+/* A slot of the open-addressing table.  HEAD is 0 if the slot is
+   unused, or else one more than the index of the first line with the
+   key, and TAIL likewise for the last.  */
+struct hash_slot
+{
+  uint64_t hash;
+  size_t head;
+  size_t tail;
+
+  /* The join field of the lines, kept here so that a probe need not
+     chase the line and its fields.  */
+  char const *key;
+  size_t key_len;
+};
+
+/* A table of the lines of the build input, by join field.  */
+struct hash_table
+{
+  /* The slots, linearly probed.  N_SLOTS is a power of 2.  */
+  struct hash_slot *slots;
+  size_t n_slots;
+  size_t n_keys;
+
+  /* The lines, in input order, and their contents.  */
+  struct hash_line *lines;
+  size_t n_lines;
+  size_t n_lines_allocated;
+  struct obstack arena;
+
+  /* Approximate number of bytes of memory in use.  */
+  size_t bytes;
+};
+
+/* If true, join unsorted inputs with a hash table, rather than merging
+   sorted ones.  */
+static bool hash_mode;
+
+/* With --hash, the approximate number of bytes of memory to use for the
+   lines of the smaller input before partitioning both inputs.
+   Zero means use a default based on the amount of physical memory.  */
+static size_t hash_buffer_size;
+
+/* With --hash, the line last read from each file.  */
+static struct line *hash_input[2];
+
+/* With --hash, whether the first line of each file has been read,
+   for -o auto.  */
+static bool hash_first_line_read[2];
+
+/* Store into *BEG and *LEN the join field of LINE from file WHICH.  */
+
+static void
+join_key (struct line const *line, int which, char **beg, size_t *len)
+{
+  size_t jf = which == 1 ? join_field_1 : join_field_2;
+
+  if (jf < line->nfields)
+    {
+      *beg = line->fields[jf].beg;
+      *len = line->fields[jf].len;
+    }
+  else
+    {
+      *beg = NULL;
+      *len = 0;
+    }
+}
+
+/* Return true if the keys BEG1 of length LEN1 and BEG2 of length LEN2
+   are equal.  Unlike keycmp, compare bytes rather than collate.  */
+
+static bool
+keys_equal (char const *beg1, size_t len1, char const *beg2, size_t len2)
+{
+  return (len1 == len2
+          && (len1 == 0
+              || (ignore_case
+                  ? memcasecmp (beg1, beg2, len1)
+                  : memcmp (beg1, beg2, len1)) == 0));
+}
+
+/* Append LINE to the partition of the key with hash value H at level
+   DEPTH among the temporary files PARTS, creating it if need be.  */
+
+static void
+write_part (FILE **parts, int depth, uint64_t h, struct line const *line)
+{
+  int part = spill_part (h, depth);
+
+  if (! parts[part])
+    parts[part] = spill_temp_file ("joinXXXXXX");
+  if (fwrite (line->buf.buffer, 1, line->buf.length, parts[part])
+      != line->buf.length)
+    die (EXIT_FAILURE, errno, _("cannot write temporary file"));
+}
+
+/* Initialize R to read the lines written to the temporary file FP,
+   which is empty if null.  */
+
+static void
+open_part (struct line_reader *r, FILE *fp)
+{
+  if (fp && (fflush (fp) != 0 || fseeko (fp, 0, SEEK_SET) != 0))
+    die (EXIT_FAILURE, errno, _("cannot read temporary file"));
+  line_reader_init (r, fp ? fileno (fp) : -1, eolchar);
+  r->eof = !fp;
+}
+
+/* Read a line from R into *LINEP as for get_line, noting the number of
+   fields of the first line of file WHICH for -o auto.  */
+
+static bool
+hash_get_line (struct line_reader *r, struct line **linep, int which)
+{
+  if (! get_line (r, linep, which))
+    return false;
+
+  if (! hash_first_line_read[which - 1])
+    {
+      hash_first_line_read[which - 1] = true;
+      if (autoformat)
+        *(which == 1 ? &autocount_1 : &autocount_2) = (*linep)->nfields;
+    }
+  return true;
+}
+
+static void
+hash_table_init (struct hash_table *t)
+{
+  t->n_slots = 1024;
+  t->slots = xcalloc (t->n_slots, sizeof *t->slots);
+  t->n_keys = 0;
+  t->lines = NULL;
+  t->n_lines = t->n_lines_allocated = 0;
+  obstack_init (&t->arena);
+  t->bytes = t->n_slots * sizeof *t->slots;
+}
+
+static void
+hash_table_free (struct hash_table *t)
+{
+  free (t->slots);
+  free (t->lines);
+  obstack_free (&t->arena, NULL);
+}
+
+/* Double the number of slots in T.  */
+
+static void
+hash_grow (struct hash_table *t)
+{
+  size_t n_slots = t->n_slots * 2;
+  struct hash_slot *slots = xcalloc (n_slots, sizeof *slots);
+
+  for (size_t i = 0; i < t->n_slots; i++)
+    if (t->slots[i].head)
+      {
+        size_t j = t->slots[i].hash & (n_slots - 1);
+        while (slots[j].head)
+          j = (j + 1) & (n_slots - 1);
+        slots[j] = t->slots[i];
+      }
+
+  free (t->slots);
+  t->bytes += (n_slots - t->n_slots) * sizeof *slots;
+  t->slots = slots;
+  t->n_slots = n_slots;
+}
+
+/* Return the slot of T for the key BEG of length LEN with hash value
+   H.  The slot is unused if T lacks the key.  */
+
+static struct hash_slot * _GL_ATTRIBUTE_PURE
+hash_lookup (struct hash_table const *t, uint64_t h,
+             char const *beg, size_t len)
+{
+  size_t mask = t->n_slots - 1;
+
+  for (size_t i = h & mask; ; i = (i + 1) & mask)
+    {
+      struct hash_slot *slot = &t->slots[i];
+      if (! slot->head)
+        return slot;
+      if (slot->hash == h)
+        {
+          if (keys_equal (slot->key, slot->key_len, beg, len))
+            return slot;
+        }
+    }
+}
+
+/* Return true if LINE fits in T without exceeding the buffer size.  */
+
+static bool
+hash_fits (struct hash_table const *t, struct line const *line)
+{
+  /* Allow for the line and its fields, and for the doubling of the
+     slots and lines that adding it may trigger.  */
+  size_t more = (line->buf.length + line->nfields * sizeof *line->fields
+                 + 2 * sizeof *t->lines);
+  if (t->n_slots <= 2 * (t->n_keys + 1))
+    more += 2 * t->n_slots * sizeof *t->slots;
+  return more <= hash_buffer_size && t->bytes <= hash_buffer_size - more;
+}
+
+/* Add a copy of LINE from file WHICH, with key BEG of length LEN
+   and hash value H, to T.  */
+
+static void
+hash_insert (struct hash_table *t, struct line const *line, int which,
+             uint64_t h, char const *beg, size_t len)
+{
+  struct hash_slot *slot = hash_lookup (t, h, beg, len);
+
+  if (t->n_lines == t->n_lines_allocated)
+    {
+      size_t old = t->n_lines_allocated;
+      t->lines = X2NREALLOC (t->lines, &t->n_lines_allocated);
+      t->bytes += (t->n_lines_allocated - old) * sizeof *t->lines;
+    }
+
+  struct hash_line *hl = &t->lines[t->n_lines];
+  char *buf = obstack_copy (&t->arena, line->buf.buffer, line->buf.length);
+  size_t fields_size = line->nfields * sizeof *line->fields;
+  struct field *fields = obstack_alloc (&t->arena, MAX (fields_size, 1));
+  for (size_t i = 0; i < line->nfields; i++)
+    {
+      fields[i].beg = buf + (line->fields[i].beg - line->buf.buffer);
+      fields[i].len = line->fields[i].len;
+    }
+  hl->line.buf.buffer = buf;
+  hl->line.buf.length = hl->line.buf.size = line->buf.length;
+  initbuffer (&hl->line.store);
+  hl->line.fields = fields;
+  hl->line.nfields = hl->line.nfields_allocated = line->nfields;
+  hl->hash = h;
+  hl->next = 0;
+  hl->paired = false;
+  t->bytes += line->buf.length + fields_size;
+  t->n_lines++;
+
+  if (slot->head)
+    {
+      t->lines[slot->tail - 1].next = t->n_lines;
+      slot->tail = t->n_lines;
+    }
+  else
+    {
+      slot->hash = h;
+      slot->head = slot->tail = t->n_lines;
+      slot->key = beg ? buf + (beg - line->buf.buffer) : NULL;
+      slot->key_len = len;
+      if (t->n_slots <= 2 * ++t->n_keys)
+        hash_grow (t);
+    }
+}
+
+/* Print the unpairable LINE of file WHICH, if requested.  */
+
+static void
+prunpaired (struct line const *line, int which)
+{
+  if (which == 1 ? print_unpairables_1 : print_unpairables_2)
+    {
+      if (which == 1)
+        prjoin (line, &uni_blank);
+      else
+        prjoin (&uni_blank, line);
+    }
+}
+
+/* Join the lines read by BUILD from file BUILD_WHICH with those read by
+   PROBE from the other file, by keeping the lines of the former in a
+   hash table and looking up those of the latter in it.  If the build
+   lines do not fit, partition the lines of both inputs by the hash
+   values of their keys at level DEPTH, and join each pair of parts.  */
+
+static void
+hash_join (struct line_reader *build, int build_which,
+           struct line_reader *probe, int probe_which, int depth)
+{
+  struct line **build_line = &hash_input[build_which - 1];
+  struct line **probe_line = &hash_input[probe_which - 1];
+  struct hash_table table;
+  FILE *build_parts[SPILL_PARTS] = { NULL, };
+  FILE *probe_parts[SPILL_PARTS] = { NULL, };
+  bool partitioned = false;
+
+  hash_table_init (&table);
+
+  while (hash_get_line (build, build_line, build_which))
+    {
+      struct line const *line = *build_line;
+      char *beg;
+      size_t len;
+      join_key (line, build_which, &beg, &len);
+      uint64_t h = spill_hash (beg, len, ignore_case);
+
+      if (! partitioned && depth < SPILL_MAX_DEPTH
+          && ! hash_fits (&table, line))
+        {
+          /* Move the lines read so far to the partitions.  */
+          partitioned = true;
+          for (size_t i = 0; i < table.n_lines; i++)
+            write_part (build_parts, depth, table.lines[i].hash,
+                        &table.lines[i].line);
+          hash_table_free (&table);
+        }
+
+      if (partitioned)
+        write_part (build_parts, depth, h, line);
+      else
+        hash_insert (&table, line, build_which, h, beg, len);
+    }
+
+  if (partitioned)
+    {
+      while (hash_get_line (probe, probe_line, probe_which))
+        {
+          char *beg;
+          size_t len;
+          join_key (*probe_line, probe_which, &beg, &len);
+          write_part (probe_parts, depth, spill_hash (beg, len, ignore_case),
+                      *probe_line);
+        }
+
+      for (int i = 0; i < SPILL_PARTS; i++)
+        if (build_parts[i] || probe_parts[i])
+          {
+            struct line_reader part_build, part_probe;
+            open_part (&part_build, build_parts[i]);
+            open_part (&part_probe, probe_parts[i]);
+            hash_join (&part_build, build_which, &part_probe, probe_which,
+                       depth + 1);
+            line_reader_free (&part_build);
+            line_reader_free (&part_probe);
+            if (build_parts[i])
+              fclose (build_parts[i]);
+            if (probe_parts[i])
+              fclose (probe_parts[i]);
+          }
+      return;
+    }
+
+  while (hash_get_line (probe, probe_line, probe_which))
+    {
+      struct line const *line = *probe_line;
+      char *beg;
+      size_t len;
+      join_key (line, probe_which, &beg, &len);
+      struct hash_slot const *slot
+        = hash_lookup (&table, spill_hash (beg, len, ignore_case),
+                       beg, len);
+
+      if (! slot->head)
+        {
+          prunpaired (line, probe_which);
+          continue;
+        }
+
+      for (size_t i = slot->head; i; i = table.lines[i - 1].next)
+        {
+          struct hash_line *hl = &table.lines[i - 1];
+          hl->paired = true;
+          if (print_pairables)
+            {
+              if (build_which == 1)
+                prjoin (&hl->line, line);
+              else
+                prjoin (line, &hl->line);
+            }
+        }
+    }
+
+  for (size_t i = 0; i < table.n_lines; i++)
+    if (! table.lines[i].paired)
+      prunpaired (&table.lines[i].line, build_which);
+
+  hash_table_free (&table);
+}
+
+/* Join the unsorted files FP1 and FP2 using a hash table of the lines
+   of the smaller one, as for --hash.  */
+
+static void
+join_hash (FILE *fp1, FILE *fp2)
+{
+  struct stat st1, st2;
+  bool reg1 = fstat (fileno (fp1), &st1) == 0 && S_ISREG (st1.st_mode);
+  bool reg2 = fstat (fileno (fp2), &st2) == 0 && S_ISREG (st2.st_mode);
+  int build_which = reg2 && (!reg1 || st2.st_size < st1.st_size) ? 2 : 1;
+  struct line_reader *r1 = &readers[0];
+  struct line_reader *r2 = &readers[1];
+
+  fadvise (fp1, FADVISE_SEQUENTIAL);
+  fadvise (fp2, FADVISE_SEQUENTIAL);
+
+  line_reader_init (r1, fileno (fp1), eolchar);
+  line_reader_init (r2, fileno (fp2), eolchar);
+
+  if (hash_buffer_size == 0)
+    hash_buffer_size = spill_default_buffer_size ();
+  hash_buffer_size = MAX (hash_buffer_size, SPILL_MIN_BUFFER_SIZE);
+
+  if (join_header_lines)
+    {
+      struct line *hline[2] = { NULL, NULL };
+      bool got1 = get_line (r1, &hline[0], 1);
+      bool got2 = get_line (r2, &hline[1], 2);
+      if (got1 || got2)
+        {
+          struct line const *hline1 = got1 ? hline[0] : &uni_blank;
+          struct line const *hline2 = got2 ? hline[1] : &uni_blank;
+          if (autoformat)
+            {
+              autocount_1 = got1 ? hline1->nfields : 0;
+              autocount_2 = got2 ? hline2->nfields : 0;
+            }
+          prjoin (hline1, hline2);
+        }
+      hash_first_line_read[0] = hash_first_line_read[1] = true;
+      prevline[0] = prevline[1] = NULL;
+      for (int i = 0; i < 2; i++)
+        {
+          freeline (hline[i]);
+          free (hline[i]);
+        }
+    }
+
+  if (build_which == 1)
+    hash_join (r1, 1, r2, 2, 0);
+  else
+    hash_join (r2, 2, r1, 1, 0);
+
+  for (int i = 0; i < 2; i++)
+    {
+      freeline (hash_input[i]);
+      free (hash_input[i]);
+    }
+  free (all_lines);
+  line_reader_free (r1);
+  line_reader_free (r2);
 }
 
 /* Add a field spec for field FIELD of file FILE to 'outlist'.  */
@@ -1136,6 +1662,14 @@ main (int argc, char **argv)
           join_header_lines = true;
           break;
 
+        case HASH_OPTION:
+          hash_mode = true;
+          break;
+
+        case BUFFER_SIZE_OPTION:
+          hash_buffer_size = spill_buffer_size_opt (optarg);
+          break;
+
         case_GETOPT_HELP_CHAR;
 
         case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
@@ -1184,7 +1718,13 @@ main (int argc, char **argv)
     die (EXIT_FAILURE, errno, "%s", quotef (g_names[1]));
   if (fp1 == fp2)
     die (EXIT_FAILURE, errno, _("both files cannot be standard input"));
-  join (fp1, fp2);
+  if (hash_mode)
+    {
+      check_input_order = CHECK_ORDER_DISABLED;
+      join_hash (fp1, fp2);
+    }
+  else
+    join (fp1, fp2);
 
   if (fclose (fp1) != 0)
     die (EXIT_FAILURE, errno, "%s", quotef (g_names[0]));
@@ -0,0 +1,167 @@
+/* line-reader -- read delimited lines from a file in large blocks
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "system.h"
+#include "ioblksize.h"
+#include "safe-read.h"
+
+#include "line-reader.h"
+
+void
+line_reader_init (struct line_reader *r, int fd, char delim)
+{
+  r->fd = fd;
+  r->delim = delim;
+  r->eof = false;
+  r->delim_added = false;
+  r->errnum = 0;
+  r->bufsize = IO_BUFSIZE;
+  r->buf = xmalloc (r->bufsize);
+  r->next = r->lim = r->buf;
+  r->before_refill = NULL;
+  r->before_refill_arg = NULL;
+}
+
+void
+line_reader_free (struct line_reader *r)
+{
+  free (r->buf);
+  r->buf = NULL;
+}
+
+/* Move the partial line at the end of R's buffer to its start, growing
+   the buffer if the line fills it, and read more data after it.
+   One byte is always left free, for a delimiter to be appended to an
+   unterminated last line.  Return false upon read error.  */
+
+static bool
+refill (struct line_reader *r)
+{
+  size_t pending = r->lim - r->next;
+
+  if (r->before_refill)
+    r->before_refill (r->before_refill_arg);
+
+  if (r->next != r->buf)
+    memmove (r->buf, r->next, pending);
+  else if (pending == r->bufsize - 1)
+    r->buf = x2realloc (r->buf, &r->bufsize);
+  r->next = r->buf;
+  r->lim = r->buf + pending;
+
+  size_t nread = safe_read (r->fd, r->lim, r->bufsize - 1 - pending);
+  if (nread == SAFE_READ_ERROR)
+    {
+      r->errnum = errno;
+      return false;
+    }
+  if (nread == 0)
+    r->eof = true;
+  r->lim += nread;
+  return true;
+}
+
+bool
+line_reader_next (struct line_reader *r, struct linebuffer *line)
+{
+  char *end;
+  size_t scanned = 0;		/* Bytes after R->next without a delimiter.  */
+
+  while (! (end = memchr (r->next + scanned, r->delim,
+                          r->lim - r->next - scanned)))
+    {
+      /* Resume the search after the refill where it stopped, so that
+         a long line is scanned only once.  */
+      scanned = r->lim - r->next;
+      if (r->eof)
+        {
+          if (r->next == r->lim)
+            return false;
+          *r->lim = r->delim;
+          end = r->lim++;
+          r->delim_added = true;
+          break;
+        }
+      if (r->errnum || !refill (r))
+        return false;
+    }
+
+  line->buffer = r->next;
+  line->length = end + 1 - r->next;
+  r->next = end + 1;
+  return true;
+}
+
+uintmax_t
+line_reader_skip (struct line_reader *r, uintmax_t n)
+{
+  uintmax_t skipped = 0;
+  bool partial = false;		/* Whether a line start was discarded.  */
+
+  while (skipped < n)
+    {
+      char *end = memchr (r->next, r->delim, r->lim - r->next);
+      if (end)
+        {
+          r->next = end + 1;
+          skipped++;
+          partial = false;
+        }
+      else if (r->eof)
+        {
+          if (partial || r->next != r->lim)
+            {
+              r->next = r->lim;
+              skipped++;
+            }
+          break;
+        }
+      else
+        {
+          /* Discard the start of the partial line, rather than
+             keeping it across the refill.  */
+          partial |= r->next != r->lim;
+          r->next = r->lim;
+          if (r->errnum || !refill (r))
+            break;
+        }
+    }
+
+  return skipped;
+}
+
+bool
+line_reader_keep (struct line_reader const *r, struct linebuffer *line,
+                  struct linebuffer *store)
+{
+  if (! (r->buf <= line->buffer && line->buffer < r->buf + r->bufsize))
+    return false;
+
+  if (store->size < line->length)
+    {
+      free (store->buffer);
+      store->size = line->length;
+      store->buffer = x2nrealloc (NULL, &store->size, 1);
+    }
+  memcpy (store->buffer, line->buffer, line->length);
+  line->buffer = store->buffer;
+  return true;
+}
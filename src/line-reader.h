@@ -0,0 +1,69 @@
+/* line-reader -- read delimited lines from a file in large blocks
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef LINE_READER_H
+# define LINE_READER_H
+
+# include "linebuffer.h"
+
+/* A reader of lines from a file descriptor.  Lines are returned as
+   views into a large buffer, and are not copied.  A view stays valid
+   until the buffer is next refilled; just before that happens, the
+   BEFORE_REFILL hook, if set, is called so that the caller can save
+   with line_reader_keep any lines it still needs.  */
+struct line_reader
+{
+  int fd;			/* The input file descriptor.  */
+  char delim;			/* The line delimiter.  */
+  bool eof;			/* True once end of file has been read.  */
+  bool delim_added;		/* True if the delimiter of the last line
+                                   returned was appended by the reader.  */
+  int errnum;			/* The errno value of a read error, or 0.  */
+  char *buf;			/* The buffer.  */
+  size_t bufsize;		/* Bytes allocated for BUF.  */
+  char *next;			/* The start of the next line in BUF.  */
+  char *lim;			/* The end of the data in BUF.  */
+  void (*before_refill) (void *);
+  void *before_refill_arg;
+};
+
+/* Initialize R to read lines delimited by DELIM from FD.  */
+extern void line_reader_init (struct line_reader *r, int fd, char delim);
+
+/* Free the storage of R.  This does not close its file descriptor.  */
+extern void line_reader_free (struct line_reader *r);
+
+/* Point LINE at the next line from R.  As with readlinebuffer_delim,
+   the line includes its delimiter, which is appended if the last line
+   lacks one.  Return true if successful, false at end of file or upon
+   read error, in which case R->errnum is nonzero.  */
+extern bool line_reader_next (struct line_reader *r, struct linebuffer *line);
+
+/* Skip up to N lines from R, without returning them.  Lines are only
+   scanned for their delimiters, so the buffer does not grow to hold
+   long lines.  Return the number of lines skipped, which is less than N
+   only at end of file or upon read error.  */
+extern uintmax_t line_reader_skip (struct line_reader *r, uintmax_t n);
+
+/* If LINE is a view into the buffer of R, copy it into STORE, growing
+   STORE as needed, and point LINE at the copy.  Return true if LINE
+   was moved.  STORE must not be the storage of another live line.  */
+extern bool line_reader_keep (struct line_reader const *r,
+                              struct linebuffer *line,
+                              struct linebuffer *store);
+
+#endif
@@ -48,16 +48,19 @@ noinst_HEADERS =		\
   src/expand-common.h		\
   src/fiemap.h			\
   src/find-mount-point.h	\
+  src/fts-jobs.h		\
   src/fs.h			\
   src/fs-is-local.h		\
   src/group-list.h		\
   src/ioblksize.h		\
+  src/line-reader.h		\
   src/longlong.h		\
   src/ls.h			\
   src/operand2sig.h		\
   src/prog-fprintf.h		\
   src/remove.h			\
   src/set-fields.h		\
+  src/spill.h			\
   src/statx.h			\
   src/system.h			\
   src/uname.h
@@ -253,6 +256,7 @@ src_stat_LDADD += $(LIB_NVPAIR)
 # for gettime, settime, utimecmp, utimens
 copy_ldadd += $(LIB_CLOCK_GETTIME)
 src_date_LDADD += $(LIB_CLOCK_GETTIME)
+src_df_LDADD += $(LIB_CLOCK_GETTIME)
 src_ginstall_LDADD += $(LIB_CLOCK_GETTIME)
 src_ls_LDADD += $(LIB_CLOCK_GETTIME)
 src_pr_LDADD += $(LIB_CLOCK_GETTIME)
@@ -314,8 +318,20 @@ src_uname_LDADD += $(GETHOSTNAME_LIB)
 # for strsignal
 src_kill_LDADD += $(LIBTHREAD)
 
+# for log, exp
+src_shuf_LDADD += $(SHUF_LIBM)
+
 # for pthread
+src_chgrp_LDADD += $(LIB_PTHREAD)
+src_chmod_LDADD += $(LIB_PTHREAD)
+src_chown_LDADD += $(LIB_PTHREAD)
+src_df_LDADD += $(LIB_PTHREAD)
+src_factor_LDADD += $(LIB_PTHREAD)
+src_ls_LDADD += $(LIB_PTHREAD)
+src_shred_LDADD += $(LIB_PTHREAD)
+src_shuf_LDADD += $(LIB_PTHREAD)
 src_sort_LDADD += $(LIB_PTHREAD)
+src_stat_LDADD += $(LIB_PTHREAD)
 
 # Get the release year from lib/version-etc.c.
 RELEASE_YEAR = \
@@ -365,8 +381,9 @@ src_ls_SOURCES = src/ls.c src/ls-ls.c
 src_ln_SOURCES = src/ln.c \
   src/force-link.c src/force-link.h \
   src/relpath.c src/relpath.h
-src_chown_SOURCES = src/chown.c src/chown-core.c
-src_chgrp_SOURCES = src/chgrp.c src/chown-core.c
+src_chmod_SOURCES = src/chmod.c src/fts-jobs.c
+src_chown_SOURCES = src/chown.c src/chown-core.c src/fts-jobs.c
+src_chgrp_SOURCES = src/chgrp.c src/chown-core.c src/fts-jobs.c
 src_kill_SOURCES = src/kill.c src/operand2sig.c
 src_realpath_SOURCES = src/realpath.c src/relpath.c src/relpath.h
 src_timeout_SOURCES = src/timeout.c src/operand2sig.c
@@ -387,7 +404,12 @@ src_uname_SOURCES = src/uname.c src/uname-uname.c
 src_arch_SOURCES = src/uname.c src/uname-arch.c
 
 src_cut_SOURCES = src/cut.c src/set-fields.c
-src_numfmt_SOURCES = src/numfmt.c src/set-fields.c
+src_numfmt_SOURCES = src/numfmt.c src/set-fields.c src/line-reader.c
+
+src_comm_SOURCES = src/comm.c src/line-reader.c
+src_join_SOURCES = src/join.c src/line-reader.c src/spill.c
+src_shuf_SOURCES = src/shuf.c src/line-reader.c src/spill.c
+src_uniq_SOURCES = src/uniq.c src/line-reader.c src/spill.c
 
 src_md5sum_CPPFLAGS = -DHASH_ALGO_MD5=1 $(AM_CPPFLAGS)
 src_sha1sum_SOURCES = src/md5sum.c
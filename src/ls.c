@@ -58,6 +58,7 @@
 #include <setjmp.h>
 #include <pwd.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <signal.h>
 #include <selinux/selinux.h>
 #include <wchar.h>
@@ -104,6 +105,7 @@
 #include "ls.h"
 #include "mbswidth.h"
 #include "mpsort.h"
+#include "nproc.h"
 #include "obstack.h"
 #include "quote.h"
 #include "smack.h"
@@ -207,6 +209,11 @@ struct fileinfo
     /* The file name.  */
     char *name;
 
+    /* For sorting, the file name and its extension, or their collation
+       keys, as set by sort_files.  */
+    char const *name_key;
+    char const *ext_key;
+
     /* For symbolic link, name of the file linked to, otherwise zero.  */
     char *linkname;
 
@@ -303,9 +310,12 @@ static size_t print_name_with_quoting (const struct fileinfo *f,
 static void prep_non_filename_text (void);
 static bool print_type_indicator (bool stat_ok, mode_t mode,
                                   enum filetype type);
+static void print_separated_files (char sep, size_t *pos);
 static void print_with_separator (char sep);
 static void queue_directory (char const *name, char const *realname,
                              bool command_line_arg);
+static void queue_subdirectory (struct fileinfo *f, char const *dirname,
+                                bool command_line_arg);
 static void sort_files (void);
 static void parse_ls_color (void);
 
@@ -2884,6 +2894,23 @@ queue_directory (char const *name, char const *realname, bool command_line_arg)
   pending_dirs = new;
 }
 
+/* Reverse the order of the directories queued since STOP was at the
+   head of the queue.  */
+
+static void
+reverse_pending_dirs (struct pending *stop)
+{
+  struct pending *reversed = stop;
+  while (pending_dirs != stop)
+    {
+      struct pending *p = pending_dirs;
+      pending_dirs = p->next;
+      p->next = reversed;
+      reversed = p;
+    }
+  pending_dirs = reversed;
+}
+
 /* Read directory NAME, and list the files in it.
    If REALNAME is nonzero, print its name instead of NAME;
    this is used for symbolic links to directories.
@@ -2898,6 +2925,15 @@ print_dir (char const *name, char const *realname, bool command_line_arg)
   static bool first = true;
   bool found_any_entries = false;
 
+  /* In this narrow case, print out each name right away, so ls uses
+     memory proportional only to the number of subdirectories while
+     processing the entries of this directory.  Useful when there are
+     many (millions) of entries in a directory.  */
+  bool stream = ((format == one_per_line || format == with_commas)
+                 && sort_type == sort_none && !print_block_size);
+  size_t stream_pos = SIZE_MAX;
+  struct pending *stream_dirs = NULL;
+
   errno = 0;
   dirp = opendir (name);
   if (!dirp)
@@ -2961,6 +2997,15 @@ print_dir (char const *name, char const *realname, bool command_line_arg)
       DIRED_FPUTS_LITERAL (":\n", stdout);
     }
 
+  if (stream && recursive)
+    {
+      /* Queue the marker that extract_dirs_from_files would, and
+         remember where the subdirectories queued while streaming start.  */
+      if (LOOP_DETECT)
+        queue_directory (NULL, name, false);
+      stream_dirs = pending_dirs;
+    }
+
   /* Read the directory entries, and insert the subfiles into the 'cwd_file'
      table.  */
 
@@ -2996,18 +3041,18 @@ print_dir (char const *name, char const *realname, bool command_line_arg)
                                            RELIABLE_D_INO (next),
                                            false, name);
 
-              /* In this narrow case, print out each name right away, so
-                 ls uses constant memory while processing the entries of
-                 this directory.  Useful when there are many (millions)
-                 of entries in a directory.  */
-              if (format == one_per_line && sort_type == sort_none
-                      && !print_block_size && !recursive)
+              if (stream)
                 {
                   /* We must call sort_files in spite of
                      "sort_type == sort_none" for its initialization
                      of the sorted_file vector.  */
                   sort_files ();
-                  print_current_files ();
+                  if (recursive)
+                    queue_subdirectory (sorted_file[0], name, false);
+                  if (format == with_commas)
+                    print_separated_files (',', &stream_pos);
+                  else
+                    print_current_files ();
                   clear_files ();
                 }
             }
@@ -3049,6 +3094,18 @@ print_dir (char const *name, char const *realname, bool command_line_arg)
       /* Don't return; print whatever we got.  */
     }
 
+  if (stream)
+    {
+      if (stream_pos != SIZE_MAX)
+        putchar ('\n');
+
+      /* Subdirectories were queued in the order they were read, so
+         reverse them to be listed in that order.  */
+      if (recursive)
+        reverse_pending_dirs (stream_dirs);
+      return;
+    }
+
   /* Sort the directory contents.  */
   sort_files ();
 
@@ -3691,6 +3748,29 @@ basename_is_dot_or_dotdot (const char *name)
   return dot_or_dotdot (base);
 }
 
+/* If F is a directory, queue it to be listed as a directory.
+   DIRNAME and COMMAND_LINE_ARG are as for extract_dirs_from_files.  */
+
+static void
+queue_subdirectory (struct fileinfo *f, char const *dirname,
+                    bool command_line_arg)
+{
+  if (is_directory (f)
+      && (! dirname || ! basename_is_dot_or_dotdot (f->name)))
+    {
+      if (!dirname || f->name[0] == '/')
+        queue_directory (f->name, f->linkname, command_line_arg);
+      else
+        {
+          char *name = file_name_concat (dirname, f->name, NULL);
+          queue_directory (name, f->linkname, command_line_arg);
+          free (name);
+        }
+      if (f->filetype == arg_directory)
+        free_ent (f);
+    }
+}
+
 /* Remove any entries from CWD_FILE that are for directories,
    and queue them to be listed as directories instead.
    DIRNAME is the prefix to prepend to each dirname
@@ -3704,7 +3784,6 @@ extract_dirs_from_files (char const *dirname, bool command_line_arg)
 {
   size_t i;
   size_t j;
-  bool ignore_dot_and_dot_dot = (dirname != NULL);
 
   if (dirname && LOOP_DETECT)
     {
@@ -3717,25 +3796,7 @@ extract_dirs_from_files (char const *dirname, bool command_line_arg)
   /* Queue the directories last one first, because queueing reverses the
      order.  */
   for (i = cwd_n_used; i-- != 0; )
-    {
-      struct fileinfo *f = sorted_file[i];
-
-      if (is_directory (f)
-          && (! ignore_dot_and_dot_dot
-              || ! basename_is_dot_or_dotdot (f->name)))
-        {
-          if (!dirname || f->name[0] == '/')
-            queue_directory (f->name, f->linkname, command_line_arg);
-          else
-            {
-              char *name = file_name_concat (dirname, f->name, NULL);
-              queue_directory (name, f->linkname, command_line_arg);
-              free (name);
-            }
-          if (f->filetype == arg_directory)
-            free_ent (f);
-        }
-    }
+    queue_subdirectory (sorted_file[i], dirname, command_line_arg);
 
   /* Now delete the directories from the table, compacting all the remaining
      entries.  */
@@ -3826,7 +3887,7 @@ cmp_ctime (struct fileinfo const *a, struct fileinfo const *b,
 {
   int diff = timespec_cmp (get_stat_ctime (&b->stat),
                            get_stat_ctime (&a->stat));
-  return diff ? diff : cmp (a->name, b->name);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 static inline int
@@ -3835,7 +3896,7 @@ cmp_mtime (struct fileinfo const *a, struct fileinfo const *b,
 {
   int diff = timespec_cmp (get_stat_mtime (&b->stat),
                            get_stat_mtime (&a->stat));
-  return diff ? diff : cmp (a->name, b->name);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 static inline int
@@ -3844,7 +3905,7 @@ cmp_atime (struct fileinfo const *a, struct fileinfo const *b,
 {
   int diff = timespec_cmp (get_stat_atime (&b->stat),
                            get_stat_atime (&a->stat));
-  return diff ? diff : cmp (a->name, b->name);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 static inline int
@@ -3853,7 +3914,7 @@ cmp_btime (struct fileinfo const *a, struct fileinfo const *b,
 {
   int diff = timespec_cmp (get_stat_btime (&b->stat),
                            get_stat_btime (&a->stat));
-  return diff ? diff : cmp (a->name, b->name);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 static inline int
@@ -3861,14 +3922,14 @@ cmp_size (struct fileinfo const *a, struct fileinfo const *b,
           int (*cmp) (char const *, char const *))
 {
   int diff = longdiff (b->stat.st_size, a->stat.st_size);
-  return diff ? diff : cmp (a->name, b->name);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 static inline int
 cmp_name (struct fileinfo const *a, struct fileinfo const *b,
           int (*cmp) (char const *, char const *))
 {
-  return cmp (a->name, b->name);
+  return cmp (a->name_key, b->name_key);
 }
 
 /* Compare file extensions.  Files with no extension are 'smallest'.
@@ -3878,10 +3939,8 @@ static inline int
 cmp_extension (struct fileinfo const *a, struct fileinfo const *b,
                int (*cmp) (char const *, char const *))
 {
-  char const *base1 = strrchr (a->name, '.');
-  char const *base2 = strrchr (b->name, '.');
-  int diff = cmp (base1 ? base1 : "", base2 ? base2 : "");
-  return diff ? diff : cmp (a->name, b->name);
+  int diff = cmp (a->ext_key, b->ext_key);
+  return diff ? diff : cmp (a->name_key, b->name_key);
 }
 
 DEFINE_SORT_FUNCTIONS (ctime, cmp_ctime)
@@ -3988,24 +4047,164 @@ initialize_ordering_vector (void)
     sorted_file[i] = &cwd_file[i];
 }
 
-/* Sort the files now in the table.  */
+/* The collation keys of the files being sorted.  */
+static struct obstack sort_key_obstack;
+
+/* Return a collation key for STR, allocated in sort_key_obstack, that
+   compares with strcmp as STR does with strcoll.  Return NULL if
+   strxfrm fails.  */
+
+static char const *
+xfrm_key (char const *str)
+{
+  size_t size = 2 * strlen (str) + 1;
+
+  while (true)
+    {
+      obstack_make_room (&sort_key_obstack, size);
+      char *key = obstack_next_free (&sort_key_obstack);
+      errno = 0;
+      size_t len = strxfrm (key, str, size);
+      if (errno)
+        return NULL;
+      if (len < size)
+        {
+          obstack_blank_fast (&sort_key_obstack, len + 1);
+          return obstack_finish (&sort_key_obstack);
+        }
+      size = len + 1;
+    }
+}
+
+/* Set the sort keys of the files now in the table: their names and
+   extensions, or if XFRM, the collation keys of those.  Return false
+   if a collation key cannot be computed.  */
+
+static bool
+set_sort_keys (bool xfrm)
+{
+  static bool initialized;
+  if (initialized)
+    obstack_free (&sort_key_obstack, NULL);
+  obstack_init (&sort_key_obstack);
+  initialized = true;
+
+  for (size_t i = 0; i < cwd_n_used; i++)
+    {
+      struct fileinfo *f = &cwd_file[i];
+      char const *ext = "";
+
+      if (sort_type == sort_extension)
+        {
+          ext = strrchr (f->name, '.');
+          if (! ext)
+            ext = "";
+        }
+
+      if (! xfrm)
+        {
+          f->name_key = f->name;
+          f->ext_key = ext;
+        }
+      else if (! ((f->name_key = xfrm_key (f->name))
+                  && (f->ext_key = xfrm_key (ext))))
+        return false;
+    }
+
+  return true;
+}
+
+/* The minimum number of files for each thread to sort.  */
+enum { MIN_FILES_PER_THREAD = 1 << 15 };
+
+/* The maximum number of threads to sort with.  */
+enum { DEFAULT_MAX_THREADS = 8 };
+
+static void sort_in_parallel (void const **, size_t, void const **,
+                              qsortFunc, size_t);
+
+/* Arguments to sort_thread.  */
+struct sort_task
+{
+  void const **base;
+  size_t n;
+  void const **tmp;
+  qsortFunc cmp;
+  size_t nthreads;
+};
+
+static void *
+sort_thread (void *arg)
+{
+  struct sort_task const *task = arg;
+  sort_in_parallel (task->base, task->n, task->tmp, task->cmp,
+                    task->nthreads);
+  return NULL;
+}
+
+/* Sort the N pointers at BASE with CMP, as mpsort does, using up to
+   NTHREADS threads, and N + N / 2 pointers at TMP for temporary
+   storage.  CMP must not longjmp.  */
 
 static void
-sort_files (void)
+sort_in_parallel (void const **base, size_t n, void const **tmp,
+                  qsortFunc cmp, size_t nthreads)
 {
-  bool use_strcmp;
+  size_t n1 = n / 2;
+  struct sort_task task = { base, n1, tmp, cmp, nthreads / 2 };
+  pthread_t thread;
 
-  if (sorted_file_alloc < cwd_n_used + cwd_n_used / 2)
+  if (nthreads < 2 || n < 2 * MIN_FILES_PER_THREAD
+      || pthread_create (&thread, NULL, sort_thread, &task) != 0)
     {
-      free (sorted_file);
-      sorted_file = xnmalloc (cwd_n_used, 3 * sizeof *sorted_file);
-      sorted_file_alloc = 3 * cwd_n_used;
+      /* mpsort uses the N / 2 pointers after those it sorts for
+         temporary storage, so sort a copy at TMP rather than disturb
+         the pointers that other threads are sorting.  */
+      memcpy (tmp, base, n * sizeof *base);
+      mpsort (tmp, n, cmp);
+      memcpy (base, tmp, n * sizeof *base);
+      return;
     }
 
-  initialize_ordering_vector ();
+  sort_in_parallel (base + n1, n - n1, tmp + n1 + n1 / 2, cmp,
+                    nthreads - nthreads / 2);
+  pthread_join (thread, NULL);
+
+  /* Merge the two halves, preferring the first upon ties so that the
+     sort is stable, as mpsort is.  Whatever remains of the second half
+     is already in place.  */
+  void const **a = base;
+  void const **alim = base + n1;
+  void const **b = alim;
+  void const **blim = base + n;
+  void const **out = tmp;
+  while (a < alim && b < blim)
+    *out++ = cmp (*a, *b) <= 0 ? *a++ : *b++;
+  while (a < alim)
+    *out++ = *a++;
+  memcpy (base, tmp, (out - tmp) * sizeof *base);
+}
 
-  if (sort_type == sort_none)
-    return;
+/* Return the function to compare files with, comparing names with
+   strcmp if USE_STRCMP.  */
+
+static qsortFunc
+sort_function (bool use_strcmp)
+{
+  /* When sort_type == sort_time, use time_type as subindex.  */
+  return sort_functions[sort_type + (sort_type == sort_time ? time_type : 0)]
+                       [use_strcmp][sort_reverse]
+                       [directories_first];
+}
+
+/* Sort the files now in the table with strcoll, in one thread.  This
+   is separate from sort_files, so that no locals of that function are
+   live across the setjmp.  */
+
+static void
+sort_files_with_strcoll (void)
+{
+  bool use_strcmp;
 
   /* Try strcoll.  If it fails, fall back on strcmp.  We can't safely
      ignore strcoll failures, as a failing strcoll might be a
@@ -4021,11 +4220,67 @@ sort_files (void)
       initialize_ordering_vector ();
     }
 
-  /* When sort_type == sort_time, use time_type as subindex.  */
   mpsort ((void const **) sorted_file, cwd_n_used,
-          sort_functions[sort_type + (sort_type == sort_time ? time_type : 0)]
-                        [use_strcmp][sort_reverse]
-                        [directories_first]);
+          sort_function (use_strcmp));
+}
+
+/* Sort the files now in the table.  */
+
+static void
+sort_files (void)
+{
+  bool use_strcmp;
+  size_t nthreads = 1;
+
+  if (sorted_file_alloc / 3 < cwd_n_used)
+    {
+      free (sorted_file);
+      sorted_file = xnmalloc (cwd_n_used, 3 * sizeof *sorted_file);
+      sorted_file_alloc = 3 * cwd_n_used;
+    }
+
+  initialize_ordering_vector ();
+
+  if (sort_type == sort_none)
+    return;
+
+  if (2 * MIN_FILES_PER_THREAD <= cwd_n_used)
+    {
+      unsigned long int np = num_processors (NPROC_CURRENT_OVERRIDABLE);
+      nthreads = MIN (np, DEFAULT_MAX_THREADS);
+    }
+
+  /* Compare names with strcmp in the C locale, where it is equivalent
+     to strcoll, and otherwise compare their collation keys with strcmp
+     if the names are compared often enough to be worth transforming,
+     which also lets the sort use threads.  */
+  if (sort_type == sort_version)
+    use_strcmp = false;
+  else if (! hard_locale (LC_COLLATE))
+    {
+      set_sort_keys (false);
+      use_strcmp = true;
+    }
+  else if ((sort_type == sort_name || sort_type == sort_extension
+            || 1 < nthreads)
+           && set_sort_keys (true))
+    use_strcmp = true;
+  else
+    {
+      set_sort_keys (false);
+      sort_files_with_strcoll ();
+      return;
+    }
+
+  qsortFunc cmp = sort_function (use_strcmp);
+
+  /* SORTED_FILE has room for 3 * CWD_N_USED pointers.  */
+  if (nthreads == 1)
+    mpsort ((void const **) sorted_file, cwd_n_used, cmp);
+  else
+    sort_in_parallel ((void const **) sorted_file, cwd_n_used,
+                      (void const **) sorted_file + cwd_n_used,
+                      cmp, nthreads);
 }
 
 /* List all the files now in the table.  */
@@ -5126,20 +5381,24 @@ print_horizontal (void)
   putchar ('\n');
 }
 
-/* Output name + SEP + ' '.  */
+/* Output name + SEP + ' ', starting at output column *POS, or at the
+   start of the line if *POS is SIZE_MAX.  Update *POS to the column
+   after the last name output, and do not end the line.  */
 
 static void
-print_with_separator (char sep)
+print_separated_files (char sep, size_t *ppos)
 {
   size_t filesno;
-  size_t pos = 0;
+  size_t pos = *ppos;
 
   for (filesno = 0; filesno < cwd_n_used; filesno++)
     {
       struct fileinfo const *f = sorted_file[filesno];
       size_t len = line_length ? length_of_file_name_and_frills (f) : 0;
 
-      if (filesno != 0)
+      if (pos == SIZE_MAX)
+        pos = 0;
+      else
         {
           char separator;
 
@@ -5163,6 +5422,16 @@ print_with_separator (char sep)
       print_file_name_and_frills (f, pos);
       pos += len;
     }
+  *ppos = pos;
+}
+
+/* Output name + SEP + ' '.  */
+
+static void
+print_with_separator (char sep)
+{
+  size_t pos = SIZE_MAX;
+  print_separated_files (sep, &pos);
   putchar ('\n');
 }
 
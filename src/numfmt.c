@@ -30,6 +30,8 @@
 #include "system.h"
 #include "xstrtol.h"
 #include "xstrndup.h"
+#include "inttostr.h"
+#include "line-reader.h"
 
 #include "set-fields.h"
 
@@ -513,6 +515,36 @@ simple_strtod_int (const char *input_str,
   return e;
 }
 
+/* If INPUT_STR is a plain integer, an optional '-' followed by at most
+   MAX_UNSCALED_DIGITS significant digits and nothing else, store its
+   value in VALUE, as simple_strtod_human would, and return true.
+   Otherwise return false, leaving the general parser to handle it.  */
+static bool
+simple_strtod_plain (const char *input_str, long double *value)
+{
+  bool negative = *input_str == '-';
+  char const *p = input_str + negative;
+  uintmax_t val = 0;
+  int digits = 0;
+
+  if (! c_isdigit (*p))
+    return false;
+
+  for (; c_isdigit (*p); p++)
+    {
+      int digit = *p - '0';
+      if ((val || digit) && MAX_UNSCALED_DIGITS < ++digits)
+        return false;
+      val = 10 * val + digit;
+    }
+
+  if (*p)
+    return false;
+
+  *value = negative ? - (long double) val : val;
+  return true;
+}
+
 /* Read a floating-point INPUT_STR represented as "NNNN[.NNNNN]",
    and return the value in a 'long double' VALUE.
    ENDPTR is required (unlike strtod) and is used to store a pointer
@@ -716,6 +748,106 @@ simple_strtod_fatal (enum simple_strtod_error err, char const *input_str)
     error (conv_exit_code, 0, gettext (msgid), quote (input_str));
 }
 
+/* Round the quotient N / D according to ROUND, as simple_round would
+   round the quotient of a value with magnitude N and sign NEGATIVE.  */
+static uintmax_t _GL_ATTRIBUTE_PURE
+round_quotient (uintmax_t n, uintmax_t d, enum round_type round,
+                bool negative)
+{
+  uintmax_t q = n / d;
+  uintmax_t r = n % d;
+
+  if (r == 0)
+    return q;
+
+  switch (round)
+    {
+    case round_ceiling:
+      return q + !negative;
+
+    case round_floor:
+      return q + negative;
+
+    case round_from_zero:
+      return q + 1;
+
+    case round_to_zero:
+      return q;
+
+    case round_nearest:
+      return q + (d - r <= r);
+
+    default:
+      abort ();
+    }
+}
+
+/* Convert the integer VAL, whose magnitude is less than
+   10^MAX_UNSCALED_DIGITS, to a human format string at BUF, as
+   double_to_human does with no grouping, padding or precision given,
+   but with exact integer arithmetic.  */
+static void
+integer_to_human (long double val, char *buf,
+                  enum scale_type scale, enum round_type round)
+{
+  bool negative = val < 0;
+  uintmax_t n = negative ? -val : val;
+  char numbuf[INT_BUFSIZE_BOUND (uintmax_t)];
+  char *p = buf;
+
+  if (negative)
+    *p++ = '-';
+
+  if (scale == scale_none)
+    {
+      strcpy (p, umaxtostr (n, numbuf));
+      return;
+    }
+
+  unsigned int scale_base = default_scale_base (scale);
+  unsigned int power = 0;
+  uintmax_t d = 1;
+  while (n / d >= scale_base)
+    {
+      d *= scale_base;
+      power++;
+    }
+
+  if (power == 0)
+    p = stpcpy (p, umaxtostr (n, numbuf));
+  else if (n / d < 10)
+    {
+      /* Show one decimal digit, unless rounding reaches 10.  */
+      uintmax_t tenths = round_quotient (n * 10, d, round, negative);
+      if (tenths < 100)
+        {
+          *p++ = '0' + tenths / 10;
+          p = stpcpy (p, decimal_point);
+          *p++ = '0' + tenths % 10;
+        }
+      else
+        p = stpcpy (p, "10");
+    }
+  else
+    {
+      uintmax_t units = round_quotient (n, d, round, negative);
+      if (units < scale_base)
+        p = stpcpy (p, umaxtostr (units, numbuf));
+      else
+        {
+          /* "999.99" turned into 1000, so scale down.  */
+          *p++ = '1';
+          p = stpcpy (p, decimal_point);
+          *p++ = '0';
+          power++;
+        }
+    }
+
+  p = stpcpy (p, suffix_power_char (power));
+  if (scale == scale_IEC_I && power > 0)
+    strcpy (p, "i");
+}
+
 /* Convert VAL to a human format string in BUF.  */
 static void
 double_to_human (long double val, int precision,
@@ -739,6 +871,16 @@ double_to_human (long double val, int precision,
 
   devmsg ("double_to_human:\n");
 
+  /* Integers are common, and can be converted exactly and more
+     quickly without long double arithmetic.  */
+  if (!group && !zero_padding_width && !dev_debug
+      && (scale == scale_none ? precision == 0 : user_precision == -1)
+      && absld (val) < 1e18L && val == (intmax_t) val)
+    {
+      integer_to_human (val, buf, scale, round);
+      return;
+    }
+
   if (scale == scale_none)
     {
       val *= powerld (10, precision);
@@ -1198,9 +1340,12 @@ prepare_padded_number (const long double val, size_t precision)
 
   size_t precision_used = user_precision == -1 ? precision : user_precision;
 
-  /* Can't reliably print too-large values without auto-scaling. */
-  unsigned int x;
-  expld (val, 10, &x);
+  /* Can't reliably print too-large values without auto-scaling.
+     Smaller values have fewer than MAX_UNSCALED_DIGITS integer digits,
+     so need not be measured unless a precision is also to be shown.  */
+  unsigned int x = 0;
+  if (precision_used || absld (val) >= 1e17L)
+    expld (val, 10, &x);
 
   if (scale_to == scale_none
       && x + precision_used > MAX_UNSCALED_DIGITS)
@@ -1306,7 +1451,15 @@ process_suffixed_number (char *text, long double *result,
     }
 
   long double val = 0;
-  enum simple_strtod_error e = parse_human_number (p, &val, precision);
+  enum simple_strtod_error e;
+  if (!dev_debug && scale_from != scale_IEC_I
+      && simple_strtod_plain (p, &val))
+    {
+      e = SSE_OK;
+      *precision = 0;
+    }
+  else
+    e = parse_human_number (p, &val, precision);
   if (e == SSE_OK_PRECISION_LOSS && debug)
     error (0, 0, _("large input value %s: possible precision loss"),
            quote (p));
@@ -1609,27 +1762,29 @@ main (int argc, char **argv)
     }
   else
     {
-      char *line = NULL;
-      size_t line_allocated = 0;
-      ssize_t len;
+      struct line_reader reader;
+      struct linebuffer line;
+
+      line_reader_init (&reader, STDIN_FILENO, line_delim);
 
-      while (header-- && getdelim (&line, &line_allocated,
-                                   line_delim, stdin) > 0)
-        fputs (line, stdout);
+      /* Output header lines up to any NUL, as with fputs.  */
+      while (header-- && line_reader_next (&reader, &line))
+        fwrite (line.buffer, 1,
+                strnlen (line.buffer, line.length - reader.delim_added),
+                stdout);
 
-      while ((len = getdelim (&line, &line_allocated,
-                              line_delim, stdin)) > 0)
+      /* Lines are processed in place in the reader's buffer, with their
+         delimiter replaced by a NUL.  */
+      while (line_reader_next (&reader, &line))
         {
-          bool newline = line[len - 1] == line_delim;
-          if (newline)
-            line[len - 1] = '\0';
-          valid_numbers &= process_line (line, newline);
+          line.buffer[line.length - 1] = '\0';
+          valid_numbers &= process_line (line.buffer, !reader.delim_added);
         }
 
-      IF_LINT (free (line));
+      line_reader_free (&reader);
 
-      if (ferror (stdin))
-        error (0, errno, _("error reading input"));
+      if (reader.errnum)
+        error (0, reader.errnum, _("error reading input"));
     }
 
 #ifdef lint
@@ -30,7 +30,6 @@
 #include "quote.h"
 #include "stat-size.h"
 #include "xbinary-io.h"
-#include "xprintf.h"
 #include "xstrtol.h"
 #include "xstrtol-error.h"
 
@@ -105,9 +104,11 @@ struct tspec
     /* FIELDS is the number of fields per line, BLANK is the number of
        fields to leave blank.  WIDTH is width of one field, excluding
        leading space, and PAD is total pad to divide among FIELDS.
-       PAD is at least as large as FIELDS.  */
-    void (*print_function) (size_t fields, size_t blank, void const *data,
-                            char const *fmt, int width, int pad);
+       PAD is at least as large as FIELDS.  The fields are formatted
+       into BUF, and the end of the formatted text is returned.  */
+    char *(*print_function) (char *buf, size_t fields, size_t blank,
+                             void const *data, enum output_format fmt,
+                             int width, int pad);
     char fmt_string[FMT_BYTES_ALLOCATED]; /* Of the style "%*d".  */
     bool hexl_mode_trailer;
     int field_width; /* Minimum width of a field, excluding leading space.  */
@@ -251,6 +252,10 @@ static char const *const *file_list;
    were specified on the command line.  */
 static char const *const default_file_list[] = {"-", NULL};
 
+/* The buffer in which write_block formats each output line.
+   It is large enough for the widest line of any format spec.  */
+static char *line_buffer;
+
 /* The input stream associated with the current file.  */
 static FILE *in_stream;
 
@@ -425,12 +430,94 @@ Binary prefixes can be used, too: KiB=K, MiB=M, and so on.\n\
   exit (status);
 }
 
+/* Digit pairs, for converting decimal numbers two digits at a time.  */
+static char const decimal_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233"
+  "34353637383940414243444546474849505152535455565758596061626364656667"
+  "6869707172737475767778798081828384858687888990919293949596979899";
+
+/* Format the integer X (or S, if FMT is SIGNED_DECIMAL) right-aligned
+   in a field of WIDTH bytes at BUF, in the manner of the printf formats
+   "%*.DIGITSo", "%*.DIGITSx", "%*u" and "%*d" respectively.  WIDTH must
+   be large enough for the result.  Return the end of the field.  */
+
+static inline char *
+format_integer (char *buf, int width, enum output_format fmt, int digits,
+                uintmax_t x, intmax_t s)
+{
+  char *end = buf + width;
+  char *p = end;
+  bool negative = false;
+
+  switch (fmt)
+    {
+    case HEXADECIMAL:
+      for (; 0 < digits; digits--)
+        {
+          *--p = "0123456789abcdef"[x & 0xf];
+          x >>= 4;
+        }
+      break;
+
+    case OCTAL:
+      for (; 0 < digits; digits--)
+        {
+          *--p = '0' + (x & 7);
+          x >>= 3;
+        }
+      break;
+
+    case SIGNED_DECIMAL:
+      negative = s < 0;
+      x = negative ? - (uintmax_t) s : s;
+      FALLTHROUGH;
+    case UNSIGNED_DECIMAL:
+      while (100 <= x)
+        {
+          p -= 2;
+          memcpy (p, decimal_pairs + 2 * (x % 100), 2);
+          x /= 100;
+        }
+      if (10 <= x)
+        {
+          p -= 2;
+          memcpy (p, decimal_pairs + 2 * x, 2);
+        }
+      else
+        *--p = '0' + x;
+      if (negative)
+        *--p = '-';
+      break;
+
+    default:
+      abort ();
+    }
+
+  memset (buf, ' ', p - buf);
+  return end;
+}
+
+/* Format the string S right-aligned in a field of at least WIDTH bytes
+   at BUF.  Return the end of the field.  */
+
+static char *
+format_string (char *buf, int width, char const *s)
+{
+  int len = strlen (s);
+  if (len < width)
+    {
+      memset (buf, ' ', width - len);
+      buf += width - len;
+    }
+  return mempcpy (buf, s, len);
+}
+
 /* Define the print functions.  */
 
-#define PRINT_FIELDS(N, T, FMT_STRING, ACTION)                          \
-static void                                                             \
-N (size_t fields, size_t blank, void const *block,                      \
-   char const *FMT_STRING, int width, int pad)                          \
+#define PRINT_FIELDS(N, T, FMT, ACTION)                                 \
+static char *                                                           \
+N (char *buf, size_t fields, size_t blank, void const *block,           \
+   enum output_format FMT, int width, int pad)                          \
 {                                                                       \
   T const *p = block;                                                   \
   uintmax_t i;                                                          \
@@ -457,24 +544,30 @@ N (size_t fields, size_t blank, void const *block,                      \
       ACTION;                                                           \
       pad_remaining = next_pad;                                         \
     }                                                                   \
+  return buf;                                                           \
 }
 
-#define PRINT_TYPE(N, T)                                                \
-  PRINT_FIELDS (N, T, fmt_string, xprintf (fmt_string, adjusted_width, x))
+/* Integers are converted directly rather than with printf, as that
+   dominates the run time otherwise.  ST is the signed type that
+   corresponds to T, for signed decimal output.  */
+#define PRINT_TYPE(N, T, ST)                                            \
+  PRINT_FIELDS (N, T, fmt,                                              \
+                buf = format_integer (buf, adjusted_width, fmt, width,  \
+                                      x, (ST) x))
 
 #define PRINT_FLOATTYPE(N, T, FTOASTR, BUFSIZE)                         \
-  PRINT_FIELDS (N, T, fmt_string _GL_UNUSED,                      \
-                char buf[BUFSIZE];                                      \
-                FTOASTR (buf, sizeof buf, 0, 0, x);                     \
-                xprintf ("%*s", adjusted_width, buf))
-
-PRINT_TYPE (print_s_char, signed char)
-PRINT_TYPE (print_char, unsigned char)
-PRINT_TYPE (print_s_short, short int)
-PRINT_TYPE (print_short, unsigned short int)
-PRINT_TYPE (print_int, unsigned int)
-PRINT_TYPE (print_long, unsigned long int)
-PRINT_TYPE (print_long_long, unsigned_long_long_int)
+  PRINT_FIELDS (N, T, fmt _GL_UNUSED,                                   \
+                char fbuf[BUFSIZE];                                     \
+                FTOASTR (fbuf, sizeof fbuf, 0, 0, x);                   \
+                buf = format_string (buf, adjusted_width, fbuf))
+
+PRINT_TYPE (print_s_char, signed char, signed char)
+PRINT_TYPE (print_char, unsigned char, signed char)
+PRINT_TYPE (print_s_short, short int, short int)
+PRINT_TYPE (print_short, unsigned short int, short int)
+PRINT_TYPE (print_int, unsigned int, int)
+PRINT_TYPE (print_long, unsigned long int, long int)
+PRINT_TYPE (print_long_long, unsigned_long_long_int, intmax_t)
 
 PRINT_FLOATTYPE (print_float, float, ftoastr, FLT_BUFSIZE_BOUND)
 PRINT_FLOATTYPE (print_double, double, dtoastr, DBL_BUFSIZE_BOUND)
@@ -483,22 +576,23 @@ PRINT_FLOATTYPE (print_long_double, long double, ldtoastr, LDBL_BUFSIZE_BOUND)
 #undef PRINT_TYPE
 #undef PRINT_FLOATTYPE
 
-static void
-dump_hexl_mode_trailer (size_t n_bytes, const char *block)
+static char *
+dump_hexl_mode_trailer (char *buf, size_t n_bytes, const char *block)
 {
-  fputs ("  >", stdout);
+  buf = mempcpy (buf, "  >", 3);
   for (size_t i = n_bytes; i > 0; i--)
     {
       unsigned char c = *block++;
       unsigned char c2 = (isprint (c) ? c : '.');
-      putchar (c2);
+      *buf++ = c2;
     }
-  putchar ('<');
+  *buf++ = '<';
+  return buf;
 }
 
-static void
-print_named_ascii (size_t fields, size_t blank, void const *block,
-                   const char *unused_fmt_string _GL_UNUSED,
+static char *
+print_named_ascii (char *out, size_t fields, size_t blank, void const *block,
+                   enum output_format unused_fmt _GL_UNUSED,
                    int width, int pad)
 {
   unsigned char const *p = block;
@@ -522,14 +616,15 @@ print_named_ascii (size_t fields, size_t blank, void const *block,
           s = buf;
         }
 
-      xprintf ("%*s", pad_remaining - next_pad + width, s);
+      out = format_string (out, pad_remaining - next_pad + width, s);
       pad_remaining = next_pad;
     }
+  return out;
 }
 
-static void
-print_ascii (size_t fields, size_t blank, void const *block,
-             const char *unused_fmt_string _GL_UNUSED, int width,
+static char *
+print_ascii (char *out, size_t fields, size_t blank, void const *block,
+             enum output_format unused_fmt _GL_UNUSED, int width,
              int pad)
 {
   unsigned char const *p = block;
@@ -577,13 +672,25 @@ print_ascii (size_t fields, size_t blank, void const *block,
           break;
 
         default:
-          sprintf (buf, (isprint (c) ? "%c" : "%03o"), c);
+          if (isprint (c))
+            {
+              buf[0] = c;
+              buf[1] = '\0';
+            }
+          else
+            {
+              buf[0] = '0' + (c >> 6);
+              buf[1] = '0' + ((c >> 3) & 7);
+              buf[2] = '0' + (c & 7);
+              buf[3] = '\0';
+            }
           s = buf;
         }
 
-      xprintf ("%*s", pad_remaining - next_pad + width, s);
+      out = format_string (out, pad_remaining - next_pad + width, s);
       pad_remaining = next_pad;
     }
+  return out;
 }
 
 /* Convert a null-terminated (possibly zero-length) string S to an
@@ -638,8 +745,8 @@ decode_one_format (const char *s_orig, const char *s, const char **next,
   enum size_spec size_spec;
   unsigned long int size;
   enum output_format fmt;
-  void (*print_function) (size_t, size_t, void const *, char const *,
-                          int, int);
+  char *(*print_function) (char *, size_t, size_t, void const *,
+                           enum output_format, int, int);
   const char *p;
   char c;
   int field_width;
@@ -1216,23 +1323,27 @@ write_block (uintmax_t current_offset, size_t n_bytes,
           int datum_width = width_bytes[spec[i].size];
           int fields_per_block = bytes_per_block / datum_width;
           int blank_fields = (bytes_per_block - n_bytes) / datum_width;
+          char *p = line_buffer;
           if (i == 0)
             format_address (current_offset, '\0');
           else
-            printf ("%*s", address_pad_len, "");
-          (*spec[i].print_function) (fields_per_block, blank_fields,
-                                     curr_block, spec[i].fmt_string,
-                                     spec[i].field_width, spec[i].pad_width);
+            p = format_string (p, address_pad_len, "");
+          p = (*spec[i].print_function) (p, fields_per_block, blank_fields,
+                                         curr_block, spec[i].fmt,
+                                         spec[i].field_width,
+                                         spec[i].pad_width);
           if (spec[i].hexl_mode_trailer)
             {
               /* space-pad out to full line width, then dump the trailer */
               int field_width = spec[i].field_width;
               int pad_width = (spec[i].pad_width * blank_fields
                                / fields_per_block);
-              printf ("%*s", blank_fields * field_width + pad_width, "");
-              dump_hexl_mode_trailer (n_bytes, curr_block);
+              p = format_string (p, blank_fields * field_width + pad_width,
+                                 "");
+              p = dump_hexl_mode_trailer (p, n_bytes, curr_block);
             }
-          putchar ('\n');
+          *p++ = '\n';
+          fwrite (line_buffer, 1, p - line_buffer, stdout);
         }
     }
   first = false;
@@ -1962,6 +2073,11 @@ main (int argc, char **argv)
       spec[i].pad_width = width_per_block - block_width;
     }
 
+  /* Room for the address padding, the fields, the hexl trailer
+     "  >...<", and the newline.  */
+  line_buffer = xmalloc (address_pad_len + width_per_block
+                         + bytes_per_block + 5);
+
 #ifdef DEBUG
   printf ("lcm=%d, width_per_block=%"PRIuMAX"\n", l_c_m,
           (uintmax_t) width_per_block);
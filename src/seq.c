@@ -25,6 +25,7 @@
 #include "die.h"
 #include "cl-strtod.h"
 #include "error.h"
+#include "ioblksize.h"
 #include "quote.h"
 #include "xstrtod.h"
 
@@ -37,11 +38,6 @@
 # define isnan(x) ((x) != (x))
 #endif
 
-/* Limit below which seq_fast has more throughput.
-   Determined with: seq 0 200 inf | pv > /dev/null  */
-#define SEQ_FAST_STEP_LIMIT 200
-#define SEQ_FAST_STEP_LIMIT_DIGITS 3
-
 /* The official name of this program (e.g., no 'g' prefix).  */
 #define PROGRAM_NAME "seq"
 
@@ -367,202 +363,466 @@ print_numbers (char const *fmt, struct layout layout,
     }
 }
 
+/* Set *WIDTH and *PREC to the field width (0 for none) and precision
+   of the default fixed point format given FIRST, STEP, and LAST, and
+   return true.  Return false if there is no such format.  */
+static bool
+get_default_layout (operand first, operand step, operand last,
+                    int *width, int *prec)
+{
+  *prec = MAX (first.precision, step.precision);
+  *width = 0;
+
+  if (*prec == INT_MAX || last.precision == INT_MAX)
+    return false;
+
+  if (equal_width)
+    {
+      /* increase first_width by any increased precision in step */
+      size_t first_width = first.width + (*prec - first.precision);
+      /* adjust last_width to use precision from first/step */
+      size_t last_width = last.width + (*prec - last.precision);
+      if (last.precision && *prec == 0)
+        last_width--;  /* don't include space for '.' */
+      if (last.precision == 0 && *prec)
+        last_width++;  /* include space for '.' */
+      if (first.precision == 0 && *prec)
+        first_width++;  /* include space for '.' */
+      size_t width_needed = MAX (first_width, last_width);
+      if (INT_MAX < width_needed)
+        return false;
+      *width = width_needed;
+    }
+
+  return true;
+}
+
 /* Return the default format given FIRST, STEP, and LAST.  */
 static char const *
 get_default_format (operand first, operand step, operand last)
 {
   static char format_buf[sizeof "%0.Lf" + 2 * INT_STRLEN_BOUND (int)];
+  int width, prec;
 
-  int prec = MAX (first.precision, step.precision);
+  if (! get_default_layout (first, step, last, &width, &prec))
+    return "%Lg";
 
-  if (prec != INT_MAX && last.precision != INT_MAX)
-    {
-      if (equal_width)
-        {
-          /* increase first_width by any increased precision in step */
-          size_t first_width = first.width + (prec - first.precision);
-          /* adjust last_width to use precision from first/step */
-          size_t last_width = last.width + (prec - last.precision);
-          if (last.precision && prec == 0)
-            last_width--;  /* don't include space for '.' */
-          if (last.precision == 0 && prec)
-            last_width++;  /* include space for '.' */
-          if (first.precision == 0 && prec)
-            first_width++;  /* include space for '.' */
-          size_t width = MAX (first_width, last_width);
-          if (width <= INT_MAX)
-            {
-              int w = width;
-              sprintf (format_buf, "%%0%d.%dLf", w, prec);
-              return format_buf;
-            }
-        }
-      else
-        {
-          sprintf (format_buf, "%%.%dLf", prec);
-          return format_buf;
-        }
-    }
+  if (equal_width)
+    sprintf (format_buf, "%%0%d.%dLf", width, prec);
+  else
+    sprintf (format_buf, "%%.%dLf", prec);
+  return format_buf;
+}
+
+/* The decimal point of the current locale, as output by printf.  */
+static char decimal_point_char;
+
+/* The number of digits after the decimal point of the numbers used by
+   seq_fast, or 0 if they have no decimal point.  */
+static size_t fraction_digits;
 
-  return "%Lg";
+/* A number for seq_fast, held as text: NEGATIVE, and the digits of the
+   absolute value from S to the end of the ALLOC bytes at BUF, with the
+   decimal point FRACTION_DIGITS + 1 bytes from the end, if any.  Apart
+   from "0" before the decimal point, there are no leading zeros.  */
+struct decimal
+{
+  char *buf;
+  size_t alloc;
+  char *s;
+  bool negative;
+};
+
+static char *
+decimal_end (struct decimal const *d)
+{
+  return d->buf + d->alloc;
+}
+
+static size_t
+decimal_len (struct decimal const *d)
+{
+  return decimal_end (d) - d->s;
 }
 
-/* The NUL-terminated string S0 of length S_LEN represents a valid
-   non-negative decimal integer.  Adjust the string and length so
-   that the pair describe the next-larger value.  */
+/* Double the storage of D, keeping the text at its end.  */
 static void
-incr (char **s0, size_t *s_len)
+decimal_grow (struct decimal *d)
 {
-  char *s = *s0;
-  char *endp = s + *s_len - 1;
+  size_t len = decimal_len (d);
+  d->buf = x2nrealloc (d->buf, &d->alloc, 1);
+  d->s = memmove (decimal_end (d) - len, d->buf, len);
+}
 
-  do
+/* If ARG is a decimal number in fixed point notation, set D to it with
+   FRACTION_DIGITS digits after the decimal point, and return true.
+   Set *FRACTION_LEN to the number of digits after the decimal point
+   in ARG.  */
+static bool
+decimal_scan (struct decimal *d, char const *arg, size_t *fraction_len)
+{
+  bool negative = *arg == '-';
+  arg += negative || *arg == '+';
+  size_t int_len = strspn (arg, "0123456789");
+  char const *fraction = arg + int_len;
+  size_t frac_len = 0;
+  if (*fraction == '.')
+    frac_len = strspn (++fraction, "0123456789");
+  if (fraction[frac_len] || int_len + frac_len == 0)
+    return false;
+
+  if (fraction_len)
+    *fraction_len = frac_len;
+  if (! d)
+    return true;
+
+  while (int_len && *arg == '0')
+    arg++, int_len--;
+
+  size_t len = MAX (int_len, 1) + (fraction_digits ? fraction_digits + 1 : 0);
+  d->alloc = MAX (2 * len, 32);
+  d->buf = xmalloc (d->alloc);
+  d->s = decimal_end (d) - len;
+
+  char *p = d->s;
+  if (int_len)
+    p = mempcpy (p, arg, int_len);
+  else
+    *p++ = '0';
+  if (fraction_digits)
     {
-      if ((*endp)++ < '9')
-        return;
-      *endp-- = '0';
+      *p++ = decimal_point_char;
+      frac_len = MIN (frac_len, fraction_digits);
+      p = mempcpy (p, fraction, frac_len);
+      memset (p, '0', fraction_digits - frac_len);
     }
-  while (endp >= s);
-  *--(*s0) = '1';
-  ++*s_len;
+
+  d->negative = negative;
+  return true;
+}
+
+static bool _GL_ATTRIBUTE_PURE
+decimal_zero_p (struct decimal const *d)
+{
+  for (char const *p = d->s; p < decimal_end (d); p++)
+    if (*p != '0' && *p != decimal_point_char)
+      return false;
+  return true;
 }
 
-/* Compare A and B (each a NUL-terminated digit string), with lengths
-   given by A_LEN and B_LEN.  Return +1 if A < B, -1 if B < A, else 0.  */
+/* Compare the absolute values of A and B.  */
 static int
-cmp (char const *a, size_t a_len, char const *b, size_t b_len)
+decimal_cmp (struct decimal const *a, struct decimal const *b)
 {
-  if (a_len < b_len)
-    return -1;
-  if (b_len < a_len)
-    return 1;
-  return (memcmp (a, b, a_len));
+  size_t a_len = decimal_len (a);
+  size_t b_len = decimal_len (b);
+  if (a_len != b_len)
+    return a_len < b_len ? -1 : 1;
+  return memcmp (a->s, b->s, a_len);
 }
 
-/* Trim leading 0's from S, but if S is all 0's, leave one.
-   Return a pointer to the trimmed string.  */
-static char const * _GL_ATTRIBUTE_PURE
-trim_leading_zeros (char const *s)
+/* Add the absolute value of Y to that of X.  */
+static void
+decimal_add (struct decimal *x, struct decimal const *y)
 {
-  char const *p = s;
-  while (*s == '0')
-    ++s;
+  while (decimal_len (x) < decimal_len (y))
+    {
+      if (x->s == x->buf)
+        decimal_grow (x);
+      *--x->s = '0';
+    }
 
-  /* If there were only 0's, back up, to leave one.  */
-  if (!*s && s != p)
-    --s;
-  return s;
+  char *p = decimal_end (x);
+  char const *q = decimal_end (y);
+  bool carry = false;
+
+  while (y->s < q)
+    {
+      --p;
+      if (*--q == decimal_point_char)
+        continue;
+      int d = (*p - '0') + (*q - '0') + carry;
+      carry = 10 <= d;
+      *p = '0' + d - 10 * carry;
+    }
+
+  for (; carry; *p = '0')
+    {
+      if (p == x->s)
+        {
+          if (x->s == x->buf)
+            decimal_grow (x);
+          *--x->s = '1';
+          break;
+        }
+      if (*--p < '9')
+        {
+          ++*p;
+          break;
+        }
+    }
 }
 
-/* Print all whole numbers from A to B, inclusive -- to stdout, each
-   followed by a newline.  If B < A, return false and print nothing.
-   Otherwise, return true.  */
-static bool
-seq_fast (char const *a, char const *b, uintmax_t step)
+/* Subtract the absolute value of Y from that of X, which must not be
+   smaller.  */
+static void
+decimal_sub (struct decimal *x, struct decimal const *y)
 {
-  bool inf = STREQ (b, "inf");
-
-  /* Skip past any leading 0's.  Without this, our naive cmp
-     function would declare 000 to be larger than 99.  */
-  a = trim_leading_zeros (a);
-  b = trim_leading_zeros (b);
-
-  size_t p_len = strlen (a);
-  size_t q_len = inf ? 0 : strlen (b);
-
-  /* Allow for at least 31 digits without realloc.
-     1 more than p_len is needed for the inf case.  */
-#define INITIAL_ALLOC_DIGITS 31
-  size_t inc_size = MAX (MAX (p_len + 1, q_len), INITIAL_ALLOC_DIGITS);
-  /* Ensure we only increase by at most 1 digit at buffer boundaries.  */
-  verify (SEQ_FAST_STEP_LIMIT_DIGITS < INITIAL_ALLOC_DIGITS - 1);
-
-  /* Copy input strings (incl NUL) to end of new buffers.  */
-  char *p0 = xmalloc (inc_size + 1);
-  char *p = memcpy (p0 + inc_size - p_len, a, p_len + 1);
-  char *q;
-  char *q0;
-  if (! inf)
+  char *p = decimal_end (x);
+  char const *q = decimal_end (y);
+  bool borrow = false;
+
+  while (y->s < q)
     {
-      q0 = xmalloc (inc_size + 1);
-      q = memcpy (q0 + inc_size - q_len, b, q_len + 1);
+      --p;
+      if (*--q == decimal_point_char)
+        continue;
+      int d = (*p - '0') - (*q - '0') - borrow;
+      borrow = d < 0;
+      *p = '0' + d + 10 * borrow;
     }
-  else
-    q = q0 = NULL;
 
-  bool ok = inf || cmp (p, p_len, q, q_len) <= 0;
-  if (ok)
-    {
-      /* Reduce number of fwrite calls which is seen to
-         give a speed-up of more than 2x over the unbuffered code
-         when printing the first 10^9 integers.  */
-      size_t buf_size = MAX (BUFSIZ, (inc_size + 1) * 2);
-      char *buf = xmalloc (buf_size);
-      char const *buf_end = buf + buf_size;
+  for (; borrow; *p = '9')
+    if ('0' < *--p)
+      {
+        --*p;
+        break;
+      }
 
-      char *bufp = buf;
+  char const *int_end = decimal_end (x) - (fraction_digits
+                                           ? fraction_digits + 1 : 0);
+  while (x->s < int_end - 1 && *x->s == '0')
+    x->s++;
+}
 
-      /* Write first number to buffer.  */
-      bufp = mempcpy (bufp, p, p_len);
+/* Add Y to X, using TMP as scratch space.  */
+static void
+decimal_step (struct decimal *x, struct decimal const *y, struct decimal *tmp)
+{
+  if (x->negative == y->negative)
+    decimal_add (x, y);
+  else if (0 <= decimal_cmp (x, y))
+    {
+      decimal_sub (x, y);
+      if (x->negative && decimal_zero_p (x))
+        x->negative = false;
+    }
+  else
+    {
+      /* X changes sign, which happens at most once.  */
+      size_t len = decimal_len (y);
+      while (tmp->alloc < len)
+        decimal_grow (tmp);
+      tmp->s = memcpy (decimal_end (tmp) - len, y->s, len);
+      decimal_sub (tmp, x);
+      tmp->negative = y->negative;
+      struct decimal t = *x;
+      *x = *tmp;
+      *tmp = t;
+    }
+}
 
-      /* Append separator then number.  */
-      while (true)
-        {
-          for (uintmax_t n_incr = step; n_incr; n_incr--)
-            incr (&p, &p_len);
+/* Compare X and Y.  */
+static int
+decimal_signed_cmp (struct decimal const *x, struct decimal const *y)
+{
+  if (x->negative != y->negative)
+    return x->negative ? -1 : 1;
+  int c = decimal_cmp (x, y);
+  return x->negative ? -c : c;
+}
 
-          if (! inf && 0 < cmp (p, p_len, q, q_len))
-            break;
+/* Print the numbers from A to B by STEP, given as decimal numbers in
+   fixed point notation, in the default format, zero padded to WIDTH.
+   B may also be "inf" or "-inf".  The numbers are computed exactly,
+   with digit strings rather than floating point, and output in large
+   blocks.  Return false without output if this cannot be done.  */
+static bool
+seq_fast (char const *a, char const *step, char const *b, size_t width)
+{
+  struct decimal first, incr, last, tmp;
+  size_t a_frac, step_frac, b_frac = 0;
+  bool unbounded = STREQ (b, "inf") || STREQ (b, "-inf");
+
+  if (! decimal_scan (NULL, a, &a_frac)
+      || ! decimal_scan (NULL, step, &step_frac)
+      || ! (unbounded || decimal_scan (NULL, b, &b_frac)))
+    return false;
+
+  /* Output with the precision of FIRST and STEP, but compare with
+     LAST at its full precision.  */
+  size_t out_digits = MAX (a_frac, step_frac);
+  fraction_digits = MAX (out_digits, b_frac);
+
+  char const *point = localeconv ()->decimal_point;
+  if (fraction_digits && (! *point || point[1]))
+    return false;
+  decimal_point_char = *point;
+
+  decimal_scan (&first, a, NULL);
+  decimal_scan (&incr, step, NULL);
+  if (unbounded)
+    last.buf = NULL;
+  else
+    decimal_scan (&last, b, NULL);
 
-          *bufp++ = *separator;
+  /* Leave zero increments and "-0" to the general code.  */
+  bool ok = ! decimal_zero_p (&incr)
+            && ! (first.negative && decimal_zero_p (&first));
+  if (ok && ! (unbounded && (*b == '-') != incr.negative))
+    {
+      if (! unbounded && decimal_zero_p (&last))
+        last.negative = false;
+
+      /* Drop the digits beyond the output precision on output.  */
+      size_t trim = (fraction_digits - out_digits
+                     + (out_digits == 0 && fraction_digits != 0));
+
+      bool down = incr.negative;
+      tmp.alloc = decimal_len (&incr);
+      tmp.buf = xmalloc (tmp.alloc);
+      tmp.s = tmp.buf;
+
+      size_t sep_len = strlen (separator);
+      size_t buf_size = 0;
+      char *buf = NULL;
+      char *bufp = NULL;
+
+      /* If the increment is less than 100 in units of the last place,
+         the numbers that follow one another until the last two digits
+         wrap around differ only in those digits, and are output in a
+         run without arithmetic or comparisons.  */
+      int unit = 0;
+      if (trim == 0)
+        {
+          char const *incr_end = decimal_end (&incr);
+          char const *p = incr_end - 1;
+          if (incr.s < p && p[-1] != decimal_point_char)
+            p--;
+          for (; p < incr_end; p++)
+            unit = 10 * unit + *p - '0';
+          for (p = incr.s; p < incr_end - 2; p++)
+            if (*p != '0' && *p != decimal_point_char)
+              unit = 0;
+        }
 
-          /* Double up the buffers when needed for the inf case.  */
-          if (p_len == inc_size)
+      bool first_number = true;
+      while (unbounded
+             || (down
+                 ? 0 <= decimal_signed_cmp (&first, &last)
+                 : decimal_signed_cmp (&first, &last) <= 0))
+        {
+          size_t len = decimal_len (&first) - trim;
+          size_t n = len + first.negative;
+          size_t pad = n < width ? width - n : 0;
+          char *tail = first.s + len - 1;
+          int tail_len = 1;
+          if (first.s < tail && tail[-1] != decimal_point_char)
+            tail--, tail_len++;
+          int tail_val = 0;
+          for (int i = 0; i < tail_len; i++)
+            tail_val = 10 * tail_val + tail[i] - '0';
+
+          int run = 0;
+          if (unit && first.negative == incr.negative)
             {
-              inc_size *= 2;
-              p0 = xrealloc (p0, inc_size + 1);
-              p = memmove (p0 + p_len, p0, p_len + 1);
-
-              if (buf_size < (inc_size + 1) * 2)
+              run = ((tail_len == 2 ? 99 : 9) - tail_val) / unit;
+              if (! unbounded && decimal_len (&last) == len
+                  && memcmp (first.s, last.s, len - tail_len) == 0)
                 {
-                  size_t buf_offset = bufp - buf;
-                  buf_size = (inc_size + 1) * 2;
-                  buf = xrealloc (buf, buf_size);
-                  buf_end = buf + buf_size;
-                  bufp = buf + buf_offset;
+                  int last_val = 0;
+                  for (int i = len - tail_len; i < len; i++)
+                    last_val = 10 * last_val + last.s[i] - '0';
+                  run = MIN (run, (last_val - tail_val) / unit);
                 }
+              run = MAX (run, 0);
             }
 
-          bufp = mempcpy (bufp, p, p_len);
-          /* If no place for another separator + number then
-             output buffer so far, and reset to start of buffer.  */
-          if (buf_end - (p_len + 1) < bufp)
+          size_t need = (run + 1) * (sep_len + n + pad) + 1;
+          if (buf_size - (bufp - buf) < need)
             {
-              if (fwrite (buf, bufp - buf, 1, stdout) != 1)
+              if (bufp != buf && fwrite (buf, bufp - buf, 1, stdout) != 1)
                 io_error ();
+              if (buf_size < need)
+                {
+                  /* Write in large blocks, reducing the number of
+                     fwrite calls.  */
+                  buf_size = MAX (IO_BUFSIZE, 2 * need);
+                  free (buf);
+                  buf = xmalloc (buf_size);
+                }
               bufp = buf;
             }
+
+          for (int i = 0; i <= run; i++)
+            {
+              if (! first_number)
+                {
+                  if (sep_len == 1)
+                    *bufp++ = *separator;
+                  else
+                    bufp = mempcpy (bufp, separator, sep_len);
+                }
+              first_number = false;
+              if (first.negative)
+                *bufp++ = '-';
+              if (pad)
+                {
+                  memset (bufp, '0', pad);
+                  bufp += pad;
+                }
+              bufp = mempcpy (bufp, first.s, len);
+              if (i)
+                {
+                  int val = tail_val + i * unit;
+                  bufp[-1] = '0' + val % 10;
+                  if (tail_len == 2)
+                    bufp[-2] = '0' + val / 10;
+                }
+            }
+          if (run)
+            {
+              int val = tail_val + run * unit;
+              tail[tail_len - 1] = '0' + val % 10;
+              if (tail_len == 2)
+                tail[0] = '0' + val / 10;
+            }
+
+          decimal_step (&first, &incr, &tmp);
         }
 
-      /* Write any remaining buffered output, and the terminator.  */
-      *bufp++ = *terminator;
-      if (fwrite (buf, bufp - buf, 1, stdout) != 1)
-        io_error ();
+      if (! first_number)
+        {
+          /* Write any remaining buffered output, and the terminator.  */
+          *bufp++ = *terminator;
+          if (fwrite (buf, bufp - buf, 1, stdout) != 1)
+            io_error ();
+        }
 
-      IF_LINT (free (buf));
+      free (buf);
+      free (tmp.buf);
     }
 
-  free (p0);
-  free (q0);
+  free (first.buf);
+  free (incr.buf);
+  free (last.buf);
   return ok;
 }
 
-/* Return true if S consists of at least one digit and no non-digits.  */
-static bool _GL_ATTRIBUTE_PURE
-all_digits_p (char const *s)
+/* Return the operand OP, given as ARG, as a string for seq_fast.  */
+static char *
+fast_operand (char const *arg, operand op)
 {
-  size_t n = strlen (s);
-  return ISDIGIT (s[0]) && n == strspn (s, "0123456789");
+  char *s;
+
+  if (! isfinite (op.value))
+    return xstrdup (op.value < 0 ? "-inf" : "inf");
+  if (decimal_scan (NULL, arg, NULL))
+    return xstrdup (arg);
+  if (op.precision == INT_MAX
+      || asprintf (&s, "%.*Lf", op.precision, op.value) < 0)
+    return xstrdup ("");
+  return s;
 }
 
 int
@@ -650,33 +910,22 @@ main (int argc, char **argv)
       usage (EXIT_FAILURE);
     }
 
-  /* If the following hold:
-     - no format string, [FIXME: relax this, eventually]
-     - integer start (or no start)
-     - integer end
-     - integer increment <= SEQ_FAST_STEP_LIMIT
-     then use the much more efficient integer-only code,
-     operating on arbitrarily large numbers.  */
-  bool fast_step_ok = false;
-  if (n_args != 3
-      || (all_digits_p (argv[optind + 1])
-          && xstrtold (argv[optind + 1], NULL, &step.value, cl_strtold)
-          && 0 < step.value && step.value <= SEQ_FAST_STEP_LIMIT))
-    fast_step_ok = true;
-
-  if (all_digits_p (argv[optind])
-      && (n_args == 1 || all_digits_p (argv[optind + 1]))
-      && (n_args < 3 || (fast_step_ok
-                         && all_digits_p (argv[optind + 2])))
-      && !equal_width && !format_str && strlen (separator) == 1)
-    {
-      char const *s1 = n_args == 1 ? "1" : argv[optind];
-      char const *s2 = argv[optind + (n_args - 1)];
-      if (seq_fast (s1, s2, step.value))
-        return EXIT_SUCCESS;
-
-      /* Upon any failure, let the more general code deal with it.  */
-    }
+  /* If there is no format string, and the operands are decimal numbers
+     in fixed point notation, use the much more efficient exact code,
+     operating on arbitrarily large numbers.  This is tried before
+     parsing the operands as floating point, which would lose
+     precision, but -w needs the widths determined by that.  */
+  char const *first_arg = "1";
+  char const *step_arg = "1";
+  char const *last_arg = argv[optind + n_args - 1];
+  if (2 <= n_args)
+    first_arg = argv[optind];
+  if (n_args == 3)
+    step_arg = argv[optind + 1];
+
+  if (! format_str && ! equal_width
+      && seq_fast (first_arg, step_arg, last_arg, 0))
+    return EXIT_SUCCESS;
 
   last = scan_arg (argv[optind++]);
 
@@ -699,31 +948,22 @@ main (int argc, char **argv)
         }
     }
 
-  /* Try the fast method again, for integers of the form 1e1 etc.,
-     or "inf" end value.  */
-  if (first.precision == 0 && step.precision == 0 && last.precision == 0
-      && isfinite (first.value) && 0 <= first.value && 0 <= last.value
-      && 0 < step.value && step.value <= SEQ_FAST_STEP_LIMIT
-      && !equal_width && !format_str && strlen (separator) == 1)
+  /* Try the fast method again, with -w, or for numbers of the form 1e1
+     etc., or "inf" end value.  */
+  int width, prec;
+  if (! format_str && get_default_layout (first, step, last, &width, &prec))
     {
-      char *s1;
-      char *s2;
-      if (asprintf (&s1, "%0.Lf", first.value) < 0)
-        xalloc_die ();
-      if (! isfinite (last.value))
-        s2 = xstrdup ("inf"); /* Ensure "inf" is used.  */
-      else if (asprintf (&s2, "%0.Lf", last.value) < 0)
-        xalloc_die ();
-
-      if (*s1 != '-' && *s2 != '-' && seq_fast (s1, s2, step.value))
-        {
-          IF_LINT (free (s1));
-          IF_LINT (free (s2));
-          return EXIT_SUCCESS;
-        }
+      char *s1 = fast_operand (first_arg, first);
+      char *s2 = fast_operand (step_arg, step);
+      char *s3 = fast_operand (last_arg, last);
+      bool done = seq_fast (s1, s2, s3, width);
 
       free (s1);
       free (s2);
+      free (s3);
+      if (done)
+        return EXIT_SUCCESS;
+
       /* Upon any failure, let the more general code deal with it.  */
     }
 
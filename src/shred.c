@@ -78,6 +78,7 @@
 #include <getopt.h>
 #include <stdio.h>
 #include <assert.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <sys/types.h>
 #if defined __linux__ && HAVE_SYS_MTIO_H
@@ -142,7 +143,8 @@ struct Options
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
 {
-  RANDOM_SOURCE_OPTION = CHAR_MAX + 1
+  PARALLEL_OPTION = CHAR_MAX + 1,
+  RANDOM_SOURCE_OPTION
 };
 
 static struct option const long_opts[] =
@@ -150,6 +152,7 @@ static struct option const long_opts[] =
   {"exact", no_argument, NULL, 'x'},
   {"force", no_argument, NULL, 'f'},
   {"iterations", required_argument, NULL, 'n'},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"size", required_argument, NULL, 's'},
   {"random-source", required_argument, NULL, RANDOM_SOURCE_OPTION},
   {"remove", optional_argument, NULL, 'u'},
@@ -182,6 +185,7 @@ If FILE is -, shred standard output.\n\
       printf (_("\
   -f, --force    change permissions to allow writing if necessary\n\
   -n, --iterations=N  overwrite N times instead of the default (%d)\n\
+      --parallel=N  generate random data for the random passes with N threads\n\
       --random-source=FILE  get random bytes from FILE\n\
   -s, --size=N   shred this many bytes (suffixes like K, M, G accepted)\n\
 "), DEFAULT_PASSES);
@@ -382,6 +386,182 @@ known (off_t size)
   return 0 <= size;
 }
 
+/* The size of the buffers of random data generated by helper threads.
+   Larger than NONPERIODIC_OUTPUT_SIZE, so that direct I/O issues fewer
+   and larger writes to fast devices.  */
+enum { RANDOM_OUTPUT_SIZE = 1024 * 1024 };
+
+/* The number of buffers in the ring per helper thread, so that each
+   thread can fill one while the writer uses another.  */
+enum { BUFFERS_PER_THREAD = 2 };
+
+/* A helper thread, and the random data source that only it uses.  */
+struct random_filler
+{
+  struct random_ring *ring;
+  struct randread_source *source;
+  pthread_t thread;
+};
+
+/* Random data generated by helper threads for the random passes, and
+   written by the main thread.  BUF holds N_BUFS page-aligned buffers of
+   RANDOM_OUTPUT_SIZE bytes, indexed by a count of buffers modulo N_BUFS;
+   FULL[I] says whether buffer I has been filled and not yet used.  */
+struct random_ring
+{
+  void *mem;
+  unsigned char *buf;
+  bool *full;
+  size_t n_bufs;
+  uintmax_t taken;		/* The number of buffers taken to fill.  */
+  uintmax_t used;		/* The number of those used by the writer.  */
+  bool held;			/* Whether the writer holds buffer USED.  */
+  bool finished;		/* Whether the threads should stop.  */
+  struct random_filler *fillers;
+  size_t n_fillers;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+};
+
+/* The ring used by the random passes, or null to generate random data
+   in the main thread.  */
+static struct random_ring *random_ring;
+
+/* Fill the buffers of the ring of the filler ARG as they are used,
+   until told to stop.  */
+static void *
+fill_random (void *arg)
+{
+  struct random_filler *filler = arg;
+  struct random_ring *ring = filler->ring;
+
+  pthread_mutex_lock (&ring->lock);
+  while (! ring->finished)
+    {
+      if (ring->taken - ring->used < ring->n_bufs)
+        {
+          size_t i = ring->taken++ % ring->n_bufs;
+          pthread_mutex_unlock (&ring->lock);
+
+          randread (filler->source, ring->buf + i * RANDOM_OUTPUT_SIZE,
+                    RANDOM_OUTPUT_SIZE);
+
+          pthread_mutex_lock (&ring->lock);
+          ring->full[i] = true;
+          pthread_cond_broadcast (&ring->cond);
+        }
+      else
+        pthread_cond_wait (&ring->cond, &ring->lock);
+    }
+  pthread_mutex_unlock (&ring->lock);
+
+  return NULL;
+}
+
+/* Return a ring filled by N_THREADS helper threads, each generating
+   random data from its own default source.  Return NULL if no threads
+   could be created.  */
+static struct random_ring *
+random_ring_new (size_t n_threads)
+{
+  size_t page_size = getpagesize ();
+  struct random_ring *ring = xmalloc (sizeof *ring);
+  ring->n_bufs = n_threads * BUFFERS_PER_THREAD;
+  ring->mem = xnmalloc (ring->n_bufs + 1, RANDOM_OUTPUT_SIZE);
+  ring->buf = ptr_align (ring->mem, page_size);
+  ring->full = xcalloc (ring->n_bufs, sizeof *ring->full);
+  ring->taken = ring->used = 0;
+  ring->held = false;
+  ring->finished = false;
+  pthread_mutex_init (&ring->lock, NULL);
+  pthread_cond_init (&ring->cond, NULL);
+
+  /* Make do with fewer threads if some cannot be created.  */
+  ring->fillers = xnmalloc (n_threads, sizeof *ring->fillers);
+  ring->n_fillers = 0;
+  while (ring->n_fillers < n_threads)
+    {
+      struct random_filler *filler = &ring->fillers[ring->n_fillers];
+      filler->ring = ring;
+      filler->source = randread_new (NULL, SIZE_MAX);
+      if (! filler->source)
+        break;
+      if (pthread_create (&filler->thread, NULL, fill_random, filler) != 0)
+        {
+          randread_free (filler->source);
+          break;
+        }
+      ring->n_fillers++;
+    }
+  if (ring->n_fillers == 0)
+    {
+      pthread_mutex_destroy (&ring->lock);
+      pthread_cond_destroy (&ring->cond);
+      free (ring->fillers);
+      free (ring->full);
+      free (ring->mem);
+      free (ring);
+      return NULL;
+    }
+
+  return ring;
+}
+
+/* Give the buffer held by the writer of RING back to the threads.  */
+static void
+random_ring_release (struct random_ring *ring)
+{
+  if (ring->held)
+    {
+      pthread_mutex_lock (&ring->lock);
+      ring->full[ring->used++ % ring->n_bufs] = false;
+      pthread_cond_broadcast (&ring->cond);
+      pthread_mutex_unlock (&ring->lock);
+      ring->held = false;
+    }
+}
+
+/* Release the buffer held by the writer of RING, if any, and return the
+   next one, waiting for it to be filled.  */
+static unsigned char *
+random_ring_get (struct random_ring *ring)
+{
+  random_ring_release (ring);
+
+  size_t i = ring->used % ring->n_bufs;
+  pthread_mutex_lock (&ring->lock);
+  while (! ring->full[i])
+    pthread_cond_wait (&ring->cond, &ring->lock);
+  pthread_mutex_unlock (&ring->lock);
+
+  ring->held = true;
+  return ring->buf + i * RANDOM_OUTPUT_SIZE;
+}
+
+/* Stop the threads of RING, then wipe and free it.  */
+static void
+random_ring_free (struct random_ring *ring)
+{
+  pthread_mutex_lock (&ring->lock);
+  ring->finished = true;
+  pthread_cond_broadcast (&ring->cond);
+  pthread_mutex_unlock (&ring->lock);
+
+  for (size_t i = 0; i < ring->n_fillers; i++)
+    {
+      pthread_join (ring->fillers[i].thread, NULL);
+      randread_free (ring->fillers[i].source);
+    }
+
+  explicit_bzero (ring->buf, ring->n_bufs * RANDOM_OUTPUT_SIZE);
+  pthread_mutex_destroy (&ring->lock);
+  pthread_cond_destroy (&ring->cond);
+  free (ring->fillers);
+  free (ring->full);
+  free (ring->mem);
+  free (ring);
+}
+
 /*
  * Do pass number K of N, writing *SIZEP bytes of the given pattern TYPE
  * to the file descriptor FD.  K and N are passed in only for verbose
@@ -418,6 +598,11 @@ dopass (int fd, struct stat const *st, char const *qname, off_t *sizep,
   void *fill_pattern_mem = xmalloc (PATTERNBUF_SIZE);
   unsigned char *pbuf = ptr_align (fill_pattern_mem, page_size);
 
+  /* Random data from helper threads comes in larger buffers.  */
+  struct random_ring *ring = type < 0 ? random_ring : NULL;
+  if (ring)
+    output_size = RANDOM_OUTPUT_SIZE;
+
   char pass_string[PASS_NAME_SIZE];	/* Name of current pass */
   bool write_error = false;
   bool other_error = false;
@@ -473,7 +658,9 @@ dopass (int fd, struct stat const *st, char const *qname, off_t *sizep,
           if (!lim)
             break;
         }
-      if (type < 0)
+      if (ring)
+        pbuf = random_ring_get (ring);
+      else if (type < 0)
         randread (s, pbuf, lim);
       /* Loop to retry partial writes. */
       for (soff = 0; soff < lim; soff += ssize)
@@ -516,6 +703,7 @@ dopass (int fd, struct stat const *st, char const *qname, off_t *sizep,
                      also enables direct I/O on some (file) systems.  */
                   verify (PERIODIC_OUTPUT_SIZE % SECTOR_SIZE == 0);
                   verify (NONPERIODIC_OUTPUT_SIZE % SECTOR_SIZE == 0);
+                  verify (RANDOM_OUTPUT_SIZE % SECTOR_SIZE == 0);
                   if (errnum == EIO && known (size)
                       && (soff | SECTOR_MASK) < lim)
                     {
@@ -620,6 +808,8 @@ dopass (int fd, struct stat const *st, char const *qname, off_t *sizep,
     }
 
 free_pattern_mem:
+  if (ring)
+    random_ring_release (ring);
   free (fill_pattern_mem);
 
   return other_error ? -1 : write_error;
@@ -1162,6 +1352,8 @@ static struct randint_source *randint_source;
 static void
 clear_random_data (void)
 {
+  if (random_ring)
+    random_ring_free (random_ring);
   randint_all_free (randint_source);
 }
 
@@ -1176,6 +1368,7 @@ main (int argc, char **argv)
   int c;
   int i;
   char const *random_source = NULL;
+  size_t n_threads = 0;
 
   initialize_main (&argc, &argv);
   set_program_name (argv[0]);
@@ -1203,6 +1396,13 @@ main (int argc, char **argv)
                                            _("invalid number of passes"), 0);
           break;
 
+        case PARALLEL_OPTION:
+          n_threads = xdectoumax (optarg, 1,
+                                  SIZE_MAX / (BUFFERS_PER_THREAD
+                                              * RANDOM_OUTPUT_SIZE),
+                                  "", _("invalid number of threads"), 0);
+          break;
+
         case RANDOM_SOURCE_OPTION:
           if (random_source && !STREQ (random_source, optarg))
             die (EXIT_FAILURE, 0, _("multiple random sources specified"));
@@ -1257,6 +1457,11 @@ main (int argc, char **argv)
     die (EXIT_FAILURE, errno, "%s", quotef (random_source));
   atexit (clear_random_data);
 
+  /* Random data from a --random-source file is read in the main thread,
+     so that what is written depends only on that data.  */
+  if (n_threads && ! random_source)
+    random_ring = random_ring_new (n_threads);
+
   for (i = 0; i < n_files; i++)
     {
       char *qname = xstrdup (quotef (file[i]));
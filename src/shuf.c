@@ -19,6 +19,9 @@
 
 #include <config.h>
 
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include "system.h"
 
@@ -27,10 +30,12 @@
 #include "fadvise.h"
 #include "getopt.h"
 #include "linebuffer.h"
+#include "line-reader.h"
+#include "nproc.h"
 #include "quote.h"
 #include "randint.h"
 #include "randperm.h"
-#include "read-file.h"
+#include "spill.h"
 #include "stdio--.h"
 #include "xdectoint.h"
 #include "xstrtol.h"
@@ -51,6 +56,58 @@ enum { RESERVOIR_LINES_INCREMENT = 1024 };
      $ for p in $(seq 7); do time shuf -n10 10p$p.in >/dev/null; done  .*/
 enum { RESERVOIR_MIN_INPUT = 8192 * 1024 };
 
+/* When the input exceeds the buffer size, the maximum number of
+   temporary files among which to scatter its lines at once.  */
+enum { MAX_BUCKETS = 256 };
+
+/* The number of times a temporary file too large for memory is
+   scattered in turn, before reading it into memory regardless.
+   This matters only for files of a few long lines.  */
+enum { MAX_SCATTER_DEPTH = 8 };
+
+/* The memory used by each line held in memory, besides its bytes:
+   its pointer in the array of lines and its entry in the permutation.  */
+enum { LINE_OVERHEAD = sizeof (char *) + sizeof (size_t) };
+
+/* The default maximum number of threads shuffling temporary files.  */
+enum { DEFAULT_MAX_THREADS = 8 };
+
+/* A temporary file holding a random subset of the input lines.  */
+struct bucket
+{
+  FILE *fp;
+  uintmax_t size;		/* Number of bytes written to FP.  */
+  uintmax_t n_lines;		/* Number of lines written to FP.  */
+};
+
+/* The temporary files being shuffled to the output, and the state
+   shared by the threads shuffling them.  */
+struct shuffle
+{
+  struct bucket *buckets;
+  size_t n_buckets;
+  char eolbyte;
+
+  /* The maximum size of a bucket to read into memory.  */
+  size_t budget;
+
+  /* Under LOCK, the next bucket to shuffle, the next bucket whose
+     lines to output, and the number of lines left to output.  */
+  pthread_mutex_t lock;
+  pthread_cond_t turn;
+  size_t next_bucket;
+  size_t next_output;
+  size_t remaining;
+};
+
+/* A thread shuffling buckets, with its own source of random numbers.  */
+struct shuffler
+{
+  struct shuffle *shuffle;
+  struct randint_source *source;
+  pthread_t thread;
+};
+
 
 void
 usage (int status)
@@ -77,14 +134,22 @@ Write a random permutation of the input lines to standard output.\n\
   -i, --input-range=LO-HI   treat each number LO through HI as an input line\n\
   -n, --head-count=COUNT    output at most COUNT lines\n\
   -o, --output=FILE         write result to FILE instead of standard output\n\
+      --parallel=N          shuffle up to N temporary files at once\n\
       --random-source=FILE  get random bytes from FILE\n\
   -r, --repeat              output lines can be repeated\n\
+  -S, --buffer-size=SIZE    use SIZE for the main memory buffer; shuffle\n\
+                              larger input through temporary files\n\
 "), stdout);
       fputs (_("\
   -z, --zero-terminated     line delimiter is NUL, not newline\n\
 "), stdout);
       fputs (HELP_OPTION_DESCRIPTION, stdout);
       fputs (VERSION_OPTION_DESCRIPTION, stdout);
+      fputs (_("\
+\n\
+SIZE may be followed by one of the multiplicative suffixes\n\
+b, K, M, G, T, P, E, Z, Y, with K (1024) being the default.\n\
+"), stdout);
       emit_ancillary_info (PROGRAM_NAME);
     }
 
@@ -95,7 +160,8 @@ Write a random permutation of the input lines to standard output.\n\
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
 {
-  RANDOM_SOURCE_OPTION = CHAR_MAX + 1
+  RANDOM_SOURCE_OPTION = CHAR_MAX + 1,
+  PARALLEL_OPTION
 };
 
 static struct option const long_opts[] =
@@ -104,8 +170,10 @@ static struct option const long_opts[] =
   {"input-range", required_argument, NULL, 'i'},
   {"head-count", required_argument, NULL, 'n'},
   {"output", required_argument, NULL, 'o'},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"random-source", required_argument, NULL, RANDOM_SOURCE_OPTION},
   {"repeat", no_argument, NULL, 'r'},
+  {"buffer-size", required_argument, NULL, 'S'},
   {"zero-terminated", no_argument, NULL, 'z'},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
@@ -168,26 +236,45 @@ input_size (void)
   return file_size;
 }
 
+/* Return a random number uniformly distributed in (0, 1].  */
+
+static double
+random_fraction (struct randint_source *s)
+{
+  randint const scale = (randint) 1 << DBL_MANT_DIG;
+  return (randint_genmax (s, scale - 1) + 1.0) / scale;
+}
+
 /* Read all lines and store up to K permuted lines in *OUT_RSRV.
-   Return the number of lines read, up to a maximum of K.  */
+   Return the number of lines read, up to a maximum of K.
+
+   Once the reservoir is full, rather than drawing a random number for
+   each further line, draw from the geometric distribution the number of
+   lines to skip before the next one that enters the reservoir, and only
+   scan the skipped lines for their delimiters (Li's Algorithm L, ACM
+   TOMS 20, 4 (1994), 481-493).  This draws O(K log (N/K)) random numbers
+   for N input lines, rather than N.  */
 
 static size_t
 read_input_reservoir_sampling (FILE *in, char eolbyte, size_t k,
                                struct randint_source *s,
                                struct linebuffer **out_rsrv)
 {
-  randint n_lines = 0;
+  size_t n_lines = 0;
   size_t n_alloc_lines = MIN (k, RESERVOIR_LINES_INCREMENT);
-  struct linebuffer *line = NULL;
   struct linebuffer *rsrv;
+  struct line_reader r;
+  struct linebuffer line;
+  bool more = k != 0;
 
   rsrv = xcalloc (n_alloc_lines, sizeof (struct linebuffer));
+  line_reader_init (&r, fileno (in), eolbyte);
 
   /* Fill the first K lines, directly into the reservoir.  */
-  while (n_lines < k
-         && (line =
-             readlinebuffer_delim (&rsrv[n_lines], in, eolbyte)) != NULL)
+  while (more && n_lines < k && (more = line_reader_next (&r, &line)))
     {
+      line_reader_keep (&r, &line, &rsrv[n_lines]);
+      rsrv[n_lines].length = line.length;
       n_lines++;
 
       /* Enlarge reservoir.  */
@@ -200,40 +287,34 @@ read_input_reservoir_sampling (FILE *in, char eolbyte, size_t k,
         }
     }
 
-  /* last line wasn't NULL - so there may be more lines to read.  */
-  if (line != NULL)
+  /* The reservoir is full, so there may be more lines to read.
+     W is the largest of K random fractions; each line seen so far has
+     entered the reservoir with probability W, in effect.  */
+  if (more)
     {
-      struct linebuffer dummy;
-      initbuffer (&dummy);  /* space for lines not put in reservoir.  */
-
-      /* Choose the fate of the next line, with decreasing probability (as
-         n_lines increases in size).
+      double w = exp (log (random_fraction (s)) / k);
 
-         If the line will be used, store it directly in the reservoir.
-         Otherwise, store it in dummy space.
-
-         With 'struct linebuffer', storing into existing buffer will reduce
-         re-allocations (will only re-allocate if the new line is longer than
-         the currently allocated space).  */
-      do
+      while (true)
         {
-          randint j = randint_choose (s, n_lines + 1);  /* 0 .. n_lines.  */
-          line = (j < k) ? (&rsrv[j]) : (&dummy);
+          double skip = floor (log (random_fraction (s)) / log1p (-w));
+          uintmax_t n_skip = (skip < UINTMAX_MAX ? skip : UINTMAX_MAX);
+          if (line_reader_skip (&r, n_skip) < n_skip
+              || ! line_reader_next (&r, &line))
+            break;
+          struct linebuffer *slot = &rsrv[randint_choose (s, k)];
+          line_reader_keep (&r, &line, slot);
+          slot->length = line.length;
+          w *= exp (log (random_fraction (s)) / k);
         }
-      while (readlinebuffer_delim (line, in, eolbyte) != NULL && n_lines++);
-
-      if (! n_lines)
-        die (EXIT_FAILURE, EOVERFLOW, _("too many input lines"));
-
-      freebuffer (&dummy);
     }
 
   /* no more input lines, or an input error.  */
-  if (ferror (in))
-    die (EXIT_FAILURE, errno, _("read error"));
+  if (r.errnum)
+    die (EXIT_FAILURE, r.errnum, _("read error"));
+  line_reader_free (&r);
 
   *out_rsrv = rsrv;
-  return MIN (k, n_lines);
+  return n_lines;
 }
 
 static int
@@ -250,34 +331,19 @@ write_permuted_output_reservoir (size_t n_lines, struct linebuffer *lines,
   return 0;
 }
 
-/* Read data from file IN.  Input lines are delimited by EOLBYTE;
-   silently append a trailing EOLBYTE if the file ends in some other
-   byte.  Store a pointer to the resulting array of lines into *PLINE.
-   Return the number of lines read.  Report an error and exit on
-   failure.  */
+/* Split the USED bytes of data at BUF into lines delimited by EOLBYTE,
+   appending a trailing EOLBYTE if the data ends in some other byte;
+   BUF must have room for it.  Store a pointer to the resulting array
+   of lines into *PLINE, and return the number of lines.  */
 
 static size_t
-read_input (FILE *in, char eolbyte, char ***pline)
+split_lines (char *buf, size_t used, char eolbyte, char ***pline)
 {
   char *p;
-  char *buf = NULL;
-  size_t used;
   char *lim;
   char **line;
   size_t n_lines;
 
-  /* TODO: We should limit the amount of data read here,
-     to less than RESERVOIR_MIN_INPUT.  I.e., adjust fread_file() to support
-     taking a byte limit.  We'd then need to ensure we handle a line spanning
-     this boundary.  With that in place we could set use_reservoir_sampling
-     when used==RESERVOIR_MIN_INPUT, and have read_input_reservoir_sampling()
-     call a wrapper function to populate a linebuffer from the internal pline
-     or if none left, stdin.  Doing that would give better performance by
-     avoiding the reservoir CPU overhead when reading < RESERVOIR_MIN_INPUT
-     from a pipe, and allow us to dispense with the input_size() function.  */
-  if (!(buf = fread_file (in, &used)))
-    die (EXIT_FAILURE, errno, _("read error"));
-
   if (used && buf[used - 1] != eolbyte)
     buf[used++] = eolbyte;
 
@@ -296,6 +362,56 @@ read_input (FILE *in, char eolbyte, char ***pline)
   return n_lines;
 }
 
+/* Read data from file IN.  Input lines are delimited by EOLBYTE;
+   silently append a trailing EOLBYTE if the file ends in some other
+   byte.  Store a pointer to the resulting array of lines into *PLINE.
+   Return the number of lines read.  Report an error and exit on
+   failure.
+
+   If the input and the arrays to shuffle its lines would exceed LIMIT
+   bytes, stop reading it, store the bytes read into *PBUF, which then
+   has room for one more byte, and their number into *PUSED, and return
+   SIZE_MAX.  */
+
+static size_t
+read_input (FILE *in, char eolbyte, size_t limit, char **pbuf,
+            size_t *pused, char ***pline)
+{
+  size_t alloc = MIN (limit, BUFSIZ) + 1;
+  char *buf = xmalloc (alloc);
+  size_t used = 0;
+  size_t n_delims = 0;
+
+  while (true)
+    {
+      if (used == alloc - 1)
+        {
+          if (used == limit)
+            break;
+          alloc = (alloc <= limit / 2 ? alloc * 2 : limit + 1);
+          buf = xrealloc (buf, alloc);
+        }
+
+      size_t n_read = fread (buf + used, 1, alloc - 1 - used, in);
+      if (n_read == 0 && ferror (in))
+        die (EXIT_FAILURE, errno, _("read error"));
+
+      for (char const *p = buf + used, *lim = p + n_read;
+           (p = memchr (p, eolbyte, lim - p)); p++)
+        n_delims++;
+      used += n_read;
+
+      if ((limit - used) / LINE_OVERHEAD < n_delims)
+        break;
+      if (n_read == 0)
+        return split_lines (buf, used, eolbyte, pline);
+    }
+
+  *pbuf = buf;
+  *pused = used;
+  return SIZE_MAX;
+}
+
 /* Output N_LINES lines to stdout from LINE array,
    chosen by the indices in PERMUTATION.
    PERMUTATION and LINE must have at least N_LINES elements.
@@ -368,6 +484,274 @@ write_random_lines (struct randint_source *s, size_t count,
   return 0;
 }
 
+/* Return the memory needed to shuffle the lines of bucket B.  */
+
+static uintmax_t _GL_ATTRIBUTE_PURE
+bucket_cost (struct bucket const *b)
+{
+  return b->size + b->n_lines * LINE_OVERHEAD;
+}
+
+/* Return the number of buckets among which to scatter lines that need
+   SIZE bytes of memory, so that each is likely to fit in BUDGET bytes.  */
+
+static size_t _GL_ATTRIBUTE_CONST
+bucket_count (uintmax_t size, size_t budget)
+{
+  uintmax_t n = size / budget * 2 + 2;
+  return MIN (n, MAX_BUCKETS);
+}
+
+/* Return N_BUCKETS new empty buckets.  */
+
+static struct bucket *
+new_buckets (size_t n_buckets)
+{
+  struct bucket *buckets = xnmalloc (n_buckets, sizeof *buckets);
+  for (size_t i = 0; i < n_buckets; i++)
+    {
+      buckets[i].fp = spill_temp_file ("shufXXXXXX");
+      buckets[i].size = 0;
+      buckets[i].n_lines = 0;
+    }
+  return buckets;
+}
+
+/* Write each line read from IN to one of the N_BUCKETS BUCKETS,
+   chosen uniformly at random using S.  The USED bytes at BUF, which
+   has room for ALLOC bytes, precede the data still to be read from IN.
+   Lines are delimited by EOLBYTE, and one is appended to an
+   unterminated last line.  Free BUF.  */
+
+static void
+scatter (FILE *in, char eolbyte, char *buf, size_t alloc, size_t used,
+         struct bucket *buckets, size_t n_buckets,
+         struct randint_source *s)
+{
+  bool eof = false;
+
+  while (true)
+    {
+      char *p = buf;
+      char *lim = buf + used;
+      char *eol;
+
+      while ((eol = memchr (p, eolbyte, lim - p)))
+        {
+          size_t len = eol + 1 - p;
+          struct bucket *b = &buckets[randint_choose (s, n_buckets)];
+          if (fwrite (p, 1, len, b->fp) != len)
+            die (EXIT_FAILURE, errno, _("cannot write temporary file"));
+          b->size += len;
+          b->n_lines++;
+          p = eol + 1;
+        }
+
+      used = lim - p;
+      memmove (buf, p, used);
+
+      if (eof)
+        break;
+
+      /* Make room for a line longer than the buffer, and for the
+         delimiter appended to an unterminated last line.  */
+      if (alloc - 1 <= used)
+        buf = x2realloc (buf, &alloc);
+
+      size_t n_read = fread (buf + used, 1, alloc - 1 - used, in);
+      used += n_read;
+      if (n_read == 0)
+        {
+          if (ferror (in))
+            die (EXIT_FAILURE, errno, _("read error"));
+          eof = true;
+          if (used)
+            buf[used++] = eolbyte;
+        }
+    }
+
+  free (buf);
+}
+
+/* Read the lines of bucket B, delimited by EOLBYTE, into memory, and
+   permute them randomly using S.  Store the lines into *PLINE and the
+   permutation into *PPERMUTATION, and return the number of lines.  */
+
+static size_t
+load_bucket (struct bucket const *b, char eolbyte, struct randint_source *s,
+             char ***pline, size_t **ppermutation)
+{
+  if (SIZE_MAX - 1 < b->size)
+    xalloc_die ();
+  size_t size = b->size;
+  char *buf = xmalloc (size + 1);
+  if (fseeko (b->fp, 0, SEEK_SET) != 0
+      || fread (buf, 1, size, b->fp) != size)
+    die (EXIT_FAILURE, errno, _("cannot read temporary file"));
+
+  size_t n_lines = split_lines (buf, size, eolbyte, pline);
+  *ppermutation = randperm_new (s, n_lines, n_lines);
+  return n_lines;
+}
+
+/* Output up to *REMAINING lines of the N_LINES lines LINE, in the order
+   given by PERMUTATION, decrementing *REMAINING accordingly, and free
+   them.  */
+
+static void
+write_bucket (size_t n_lines, char **line, size_t *permutation,
+              size_t *remaining)
+{
+  size_t n = MIN (n_lines, *remaining);
+  if (write_permuted_lines (n, line, permutation) != 0)
+    die (EXIT_FAILURE, errno, _("write error"));
+  *remaining -= n;
+
+  free (line[0]);
+  free (line);
+  free (permutation);
+}
+
+/* Output up to *REMAINING lines of bucket B in random order, using S,
+   and close it.  If it does not fit in BUDGET bytes, first scatter it
+   among further buckets, having done so DEPTH times already.  */
+
+static void
+shuffle_bucket (struct bucket *b, char eolbyte, size_t budget,
+                struct randint_source *s, size_t *remaining, int depth)
+{
+  if (*remaining == 0)
+    ;
+  else if (bucket_cost (b) <= budget || depth == MAX_SCATTER_DEPTH)
+    {
+      char **line;
+      size_t *permutation;
+      size_t n_lines = load_bucket (b, eolbyte, s, &line, &permutation);
+      write_bucket (n_lines, line, permutation, remaining);
+    }
+  else
+    {
+      size_t n_buckets = bucket_count (bucket_cost (b), budget);
+      struct bucket *buckets = new_buckets (n_buckets);
+      size_t alloc = MIN (budget, b->size) + 1;
+      if (fseeko (b->fp, 0, SEEK_SET) != 0)
+        die (EXIT_FAILURE, errno, _("cannot read temporary file"));
+      scatter (b->fp, eolbyte, xmalloc (alloc), alloc, 0,
+               buckets, n_buckets, s);
+      for (size_t i = 0; i < n_buckets; i++)
+        shuffle_bucket (&buckets[i], eolbyte, budget, s, remaining,
+                        depth + 1);
+      free (buckets);
+    }
+
+  fclose (b->fp);
+}
+
+/* Shuffle the buckets of the shuffler ARG in turn with the other
+   threads, each outputting its lines only when the lines of the
+   previous buckets have been output.  */
+
+static void *
+shuffle_buckets (void *arg)
+{
+  struct shuffler *shuffler = arg;
+  struct shuffle *sh = shuffler->shuffle;
+
+  while (true)
+    {
+      pthread_mutex_lock (&sh->lock);
+      size_t i = sh->remaining ? sh->next_bucket++ : sh->n_buckets;
+      pthread_mutex_unlock (&sh->lock);
+      if (sh->n_buckets <= i)
+        break;
+
+      /* Read and permute the lines of a bucket that fits in memory
+         while other threads output theirs.  */
+      struct bucket *b = &sh->buckets[i];
+      bool fits = bucket_cost (b) <= sh->budget;
+      char **line IF_LINT ( = NULL);
+      size_t *permutation IF_LINT ( = NULL);
+      size_t n_lines IF_LINT ( = 0);
+      if (fits)
+        n_lines = load_bucket (b, sh->eolbyte, shuffler->source,
+                               &line, &permutation);
+
+      pthread_mutex_lock (&sh->lock);
+      while (sh->next_output != i)
+        pthread_cond_wait (&sh->turn, &sh->lock);
+      size_t remaining = sh->remaining;
+      pthread_mutex_unlock (&sh->lock);
+
+      if (fits)
+        {
+          write_bucket (n_lines, line, permutation, &remaining);
+          fclose (b->fp);
+        }
+      else
+        shuffle_bucket (b, sh->eolbyte, sh->budget, shuffler->source,
+                        &remaining, 1);
+
+      pthread_mutex_lock (&sh->lock);
+      sh->remaining = remaining;
+      sh->next_output++;
+      pthread_cond_broadcast (&sh->turn);
+      pthread_mutex_unlock (&sh->lock);
+    }
+
+  return NULL;
+}
+
+/* Output up to COUNT lines, delimited by EOLBYTE, of the N_BUCKETS
+   BUCKETS, the lines of each in random order.  Use up to N_THREADS
+   threads, the first with random source S and any others with their
+   own, each reading a bucket of up to BUDGET bytes into memory.  */
+
+static void
+output_buckets (struct bucket *buckets, size_t n_buckets, char eolbyte,
+                size_t count, size_t budget, size_t n_threads,
+                struct randint_source *s)
+{
+  struct shuffle sh;
+  sh.buckets = buckets;
+  sh.n_buckets = n_buckets;
+  sh.eolbyte = eolbyte;
+  sh.budget = budget;
+  sh.next_bucket = sh.next_output = 0;
+  sh.remaining = count;
+  pthread_mutex_init (&sh.lock, NULL);
+  pthread_cond_init (&sh.turn, NULL);
+
+  n_threads = MIN (n_threads, n_buckets);
+  struct shuffler *shufflers = xnmalloc (n_threads, sizeof *shufflers);
+  for (size_t i = 0; i < n_threads; i++)
+    {
+      shufflers[i].shuffle = &sh;
+      shufflers[i].source = i ? randint_all_new (NULL, SIZE_MAX) : s;
+      if (! shufflers[i].source)
+        die (EXIT_FAILURE, errno, _("cannot get random numbers"));
+    }
+
+  /* If a thread cannot be created, make do with fewer.  */
+  size_t n_created = 1;
+  while (n_created < n_threads
+         && pthread_create (&shufflers[n_created].thread, NULL,
+                            shuffle_buckets, &shufflers[n_created]) == 0)
+    n_created++;
+  shuffle_buckets (&shufflers[0]);
+  for (size_t i = 1; i < n_created; i++)
+    pthread_join (shufflers[i].thread, NULL);
+  for (size_t i = 1; i < n_threads; i++)
+    randint_all_free (shufflers[i].source);
+
+  /* Close any buckets left when the output was cut short.  */
+  for (size_t i = sh.next_output; i < n_buckets; i++)
+    fclose (buckets[i].fp);
+
+  pthread_mutex_destroy (&sh.lock);
+  pthread_cond_destroy (&sh.turn);
+  free (shufflers);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -382,6 +766,12 @@ main (int argc, char **argv)
   char **input_lines = NULL;
   bool use_reservoir_sampling = false;
   bool repeat = false;
+  size_t buffer_size = 0;
+  size_t n_threads = 0;
+  char *input_buf = NULL;
+  size_t input_used IF_LINT ( = 0);
+  size_t input_limit = SIZE_MAX;
+  bool use_buckets = false;
 
   int optc;
   int n_operands;
@@ -401,7 +791,7 @@ main (int argc, char **argv)
 
   atexit (close_stdout);
 
-  while ((optc = getopt_long (argc, argv, "ei:n:o:rz", long_opts, NULL)) != -1)
+  while ((optc = getopt_long (argc, argv, "ei:n:o:rS:z", long_opts, NULL)) != -1)
     switch (optc)
       {
       case 'e':
@@ -467,6 +857,15 @@ main (int argc, char **argv)
         repeat = true;
         break;
 
+      case 'S':
+        buffer_size = spill_buffer_size_opt (optarg);
+        break;
+
+      case PARALLEL_OPTION:
+        n_threads = xdectoumax (optarg, 1, SIZE_MAX, "",
+                                _("invalid number of threads"), 0);
+        break;
+
       case 'z':
         eolbyte = '\0';
         break;
@@ -522,8 +921,19 @@ main (int argc, char **argv)
       if (repeat || head_lines == SIZE_MAX
           || input_size () <= RESERVOIR_MIN_INPUT)
         {
-          n_lines = read_input (stdin, eolbyte, &input_lines);
+          /* Lines to repeat must all be in memory.  Otherwise, if the
+             input does not fit in the buffer, shuffle it through
+             temporary files.  */
+          if (! repeat)
+            {
+              if (! buffer_size)
+                buffer_size = spill_default_buffer_size ();
+              input_limit = MAX (buffer_size, SPILL_MIN_BUFFER_SIZE);
+            }
+          n_lines = read_input (stdin, eolbyte, input_limit, &input_buf,
+                                &input_used, &input_lines);
           line = input_lines;
+          use_buckets = n_lines == SIZE_MAX;
         }
       else
         {
@@ -538,6 +948,7 @@ main (int argc, char **argv)
 
   randint_source = randint_all_new (random_source,
                                     (use_reservoir_sampling || repeat
+                                     || use_buckets
                                      ? SIZE_MAX
                                      : randperm_bound (ahead_lines, n_lines)));
   if (! randint_source)
@@ -552,13 +963,40 @@ main (int argc, char **argv)
       ahead_lines = n_lines;
     }
 
+  struct bucket *buckets = NULL;
+  size_t n_buckets = 0;
+  size_t budget = 0;
+  if (use_buckets)
+    {
+      /* Scatter the lines among temporary files, each to be read into
+         memory and shuffled in turn, possibly by several threads.
+         The threads other than the first get their own random numbers,
+         so use just one with --random-source, for reproducibility.  */
+      if (random_source)
+        n_threads = 1;
+      else if (! n_threads)
+        {
+          unsigned long int np = num_processors (NPROC_CURRENT_OVERRIDABLE);
+          n_threads = MIN (np, DEFAULT_MAX_THREADS);
+        }
+      budget = MAX (input_limit / n_threads / 2, SPILL_MIN_BUFFER_SIZE / 2);
+
+      off_t rest = input_size ();
+      uintmax_t total = (rest == OFF_T_MAX ? UINTMAX_MAX
+                         : input_used + (uintmax_t) rest);
+      n_buckets = bucket_count (total, budget);
+      buckets = new_buckets (n_buckets);
+      scatter (stdin, eolbyte, input_buf, input_used + 1, input_used,
+               buckets, n_buckets, randint_source);
+    }
+
   /* Close stdin now, rather than earlier, so that randint_all_new
      doesn't have to worry about opening something other than
      stdin.  */
   if (! (head_lines == 0 || echo || input_range || fclose (stdin) == 0))
     die (EXIT_FAILURE, errno, _("read error"));
 
-  if (!repeat)
+  if (!repeat && !use_buckets)
     permutation = randperm_new (randint_source, ahead_lines, n_lines);
 
   if (outfile && ! freopen (outfile, "w", stdout))
@@ -582,7 +1020,13 @@ main (int argc, char **argv)
     }
   else
     {
-      if (use_reservoir_sampling)
+      if (use_buckets)
+        {
+          output_buckets (buckets, n_buckets, eolbyte, ahead_lines, budget,
+                          n_threads, randint_source);
+          i = 0;
+        }
+      else if (use_reservoir_sampling)
         i = write_permuted_output_reservoir (n_lines, reservoir, permutation);
       else if (input_range)
         i = write_permuted_numbers (ahead_lines, lo_input,
@@ -595,6 +1039,7 @@ main (int argc, char **argv)
     die (EXIT_FAILURE, errno, _("write error"));
 
 #ifdef lint
+  free (buckets);
   free (permutation);
   randint_all_free (randint_source);
   if (input_lines)
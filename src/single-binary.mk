@@ -19,6 +19,7 @@ src_libsinglebin_chroot_a_CFLAGS = "-Dmain=single_binary_main_chroot (int, char
 # Command df
 noinst_LIBRARIES += src/libsinglebin_df.a
 src_libsinglebin_df_a_SOURCES =   src/df.c src/find-mount-point.c
+src_libsinglebin_df_a_ldadd =   $(LIB_CLOCK_GETTIME)  $(LIB_PTHREAD)
 src_libsinglebin_df_a_CFLAGS = "-Dmain=single_binary_main_df (int, char **);  int single_binary_main_df"  -Dusage=_usage_df $(src_coreutils_CFLAGS)
 # Command hostid
 noinst_LIBRARIES += src/libsinglebin_hostid.a
@@ -100,15 +101,18 @@ src_libsinglebin_chcon_a_ldadd =   $(LIB_SELINUX)
 src_libsinglebin_chcon_a_CFLAGS = "-Dmain=single_binary_main_chcon (int, char **);  int single_binary_main_chcon"  -Dusage=_usage_chcon $(src_coreutils_CFLAGS)
 # Command chgrp
 noinst_LIBRARIES += src/libsinglebin_chgrp.a
-src_libsinglebin_chgrp_a_SOURCES =   src/chgrp.c src/chown-core.c
+src_libsinglebin_chgrp_a_SOURCES =   src/chgrp.c src/chown-core.c src/fts-jobs.c
+src_libsinglebin_chgrp_a_ldadd =   $(LIB_PTHREAD)
 src_libsinglebin_chgrp_a_CFLAGS = "-Dmain=single_binary_main_chgrp (int, char **);  int single_binary_main_chgrp"  -Dusage=_usage_chgrp $(src_coreutils_CFLAGS)
 # Command chmod
 noinst_LIBRARIES += src/libsinglebin_chmod.a
-src_libsinglebin_chmod_a_SOURCES = src/chmod.c
+src_libsinglebin_chmod_a_SOURCES =   src/chmod.c src/fts-jobs.c
+src_libsinglebin_chmod_a_ldadd =   $(LIB_PTHREAD)
 src_libsinglebin_chmod_a_CFLAGS = "-Dmain=single_binary_main_chmod (int, char **);  int single_binary_main_chmod"  -Dusage=_usage_chmod $(src_coreutils_CFLAGS)
 # Command chown
 noinst_LIBRARIES += src/libsinglebin_chown.a
-src_libsinglebin_chown_a_SOURCES =   src/chown.c src/chown-core.c
+src_libsinglebin_chown_a_SOURCES =   src/chown.c src/chown-core.c src/fts-jobs.c
+src_libsinglebin_chown_a_ldadd =   $(LIB_PTHREAD)
 src_libsinglebin_chown_a_CFLAGS = "-Dmain=single_binary_main_chown (int, char **);  int single_binary_main_chown"  -Dusage=_usage_chown $(src_coreutils_CFLAGS)
 # Command cksum
 noinst_LIBRARIES += src/libsinglebin_cksum.a
@@ -116,7 +120,7 @@ src_libsinglebin_cksum_a_SOURCES = src/cksum.c
 src_libsinglebin_cksum_a_CFLAGS = "-Dmain=single_binary_main_cksum (int, char **);  int single_binary_main_cksum"  -Dusage=_usage_cksum $(src_coreutils_CFLAGS)
 # Command comm
 noinst_LIBRARIES += src/libsinglebin_comm.a
-src_libsinglebin_comm_a_SOURCES = src/comm.c
+src_libsinglebin_comm_a_SOURCES =   src/comm.c src/line-reader.c
 src_libsinglebin_comm_a_CFLAGS = "-Dmain=single_binary_main_comm (int, char **);  int single_binary_main_comm"  -Dusage=_usage_comm $(src_coreutils_CFLAGS)
 # Command cp
 noinst_LIBRARIES += src/libsinglebin_cp.a
@@ -178,7 +182,7 @@ src_libsinglebin_expr_a_CFLAGS = "-Dmain=single_binary_main_expr (int, char **);
 # Command factor
 noinst_LIBRARIES += src/libsinglebin_factor.a
 src_libsinglebin_factor_a_SOURCES = src/factor.c
-src_libsinglebin_factor_a_ldadd =   $(LIB_GMP)  $(LIBICONV)
+src_libsinglebin_factor_a_ldadd =   $(LIB_GMP)  $(LIBICONV)  $(LIB_PTHREAD)
 src_libsinglebin_factor_a_CFLAGS = "-Dmain=single_binary_main_factor (int, char **);  int single_binary_main_factor"  -Dusage=_usage_factor $(src_coreutils_CFLAGS)
 # Command false
 noinst_LIBRARIES += src/libsinglebin_false.a
@@ -213,7 +217,7 @@ src_libsinglebin_id_a_ldadd =   $(LIB_SELINUX)  $(LIB_SMACK)
 src_libsinglebin_id_a_CFLAGS = "-Dmain=single_binary_main_id (int, char **);  int single_binary_main_id"  -Dusage=_usage_id $(src_coreutils_CFLAGS)
 # Command join
 noinst_LIBRARIES += src/libsinglebin_join.a
-src_libsinglebin_join_a_SOURCES = src/join.c
+src_libsinglebin_join_a_SOURCES =   src/join.c src/line-reader.c src/spill.c
 src_libsinglebin_join_a_CFLAGS = "-Dmain=single_binary_main_join (int, char **);  int single_binary_main_join"  -Dusage=_usage_join $(src_coreutils_CFLAGS)
 # Command kill
 noinst_LIBRARIES += src/libsinglebin_kill.a
@@ -235,7 +239,7 @@ src_libsinglebin_logname_a_CFLAGS = "-Dmain=single_binary_main_logname (int, cha
 # Command ls
 noinst_LIBRARIES += src/libsinglebin_ls.a
 src_libsinglebin_ls_a_SOURCES =   src/ls.c src/ls-ls.c
-src_libsinglebin_ls_a_ldadd =   $(LIB_SELINUX)  $(LIB_SMACK)  $(LIB_CLOCK_GETTIME)  $(LIB_CAP)  $(LIB_HAS_ACL)
+src_libsinglebin_ls_a_ldadd =   $(LIB_SELINUX)  $(LIB_SMACK)  $(LIB_CLOCK_GETTIME)  $(LIB_CAP)  $(LIB_HAS_ACL)  $(LIB_PTHREAD)
 src_libsinglebin_ls_a_CFLAGS = "-Dmain=single_binary_main_ls (int, char **);  int single_binary_main_ls"  -Dusage=_usage_ls $(src_coreutils_CFLAGS)
 # Command md5sum
 noinst_LIBRARIES += src/libsinglebin_md5sum.a
@@ -281,7 +285,7 @@ src_libsinglebin_nohup_a_SOURCES = src/nohup.c
 src_libsinglebin_nohup_a_CFLAGS = "-Dmain=single_binary_main_nohup (int, char **);  int single_binary_main_nohup"  -Dusage=_usage_nohup $(src_coreutils_CFLAGS)
 # Command numfmt
 noinst_LIBRARIES += src/libsinglebin_numfmt.a
-src_libsinglebin_numfmt_a_SOURCES =   src/numfmt.c src/set-fields.c
+src_libsinglebin_numfmt_a_SOURCES =   src/numfmt.c src/set-fields.c src/line-reader.c
 src_libsinglebin_numfmt_a_CFLAGS = "-Dmain=single_binary_main_numfmt (int, char **);  int single_binary_main_numfmt"  -Dusage=_usage_numfmt $(src_coreutils_CFLAGS)
 # Command od
 noinst_LIBRARIES += src/libsinglebin_od.a
@@ -377,12 +381,13 @@ src_libsinglebin_sha512sum_a_CPPFLAGS =   -DHASH_ALGO_SHA512=1 $(AM_CPPFLAGS)
 # Command shred
 noinst_LIBRARIES += src/libsinglebin_shred.a
 src_libsinglebin_shred_a_SOURCES = src/shred.c
-src_libsinglebin_shred_a_ldadd =   $(LIB_FDATASYNC)
+src_libsinglebin_shred_a_ldadd =   $(LIB_FDATASYNC)  $(LIB_PTHREAD)
 src_libsinglebin_shred_a_CFLAGS = "-Dmain=single_binary_main_shred (int, char **);  int single_binary_main_shred"  -Dusage=_usage_shred $(src_coreutils_CFLAGS)
 # Command shuf
 noinst_LIBRARIES += src/libsinglebin_shuf.a
-src_libsinglebin_shuf_a_SOURCES = src/shuf.c
+src_libsinglebin_shuf_a_SOURCES =   src/shuf.c src/line-reader.c src/spill.c
 src_libsinglebin_shuf_a_CFLAGS = "-Dmain=single_binary_main_shuf (int, char **);  int single_binary_main_shuf"  -Dusage=_usage_shuf $(src_coreutils_CFLAGS)
+src_libsinglebin_shuf_a_ldadd =   $(SHUF_LIBM)  $(LIB_PTHREAD)
 # Command sleep
 noinst_LIBRARIES += src/libsinglebin_sleep.a
 src_libsinglebin_sleep_a_SOURCES = src/sleep.c
@@ -400,7 +405,7 @@ src_libsinglebin_split_a_CFLAGS = "-Dmain=single_binary_main_split (int, char **
 # Command stat
 noinst_LIBRARIES += src/libsinglebin_stat.a
 src_libsinglebin_stat_a_SOURCES =   src/stat.c src/find-mount-point.c
-src_libsinglebin_stat_a_ldadd =   $(LIB_SELINUX)  $(LIB_NVPAIR)
+src_libsinglebin_stat_a_ldadd =   $(LIB_SELINUX)  $(LIB_NVPAIR)  $(LIB_PTHREAD)
 src_libsinglebin_stat_a_CFLAGS = "-Dmain=single_binary_main_stat (int, char **);  int single_binary_main_stat"  -Dusage=_usage_stat $(src_coreutils_CFLAGS)
 # Command sum
 noinst_LIBRARIES += src/libsinglebin_sum.a
@@ -465,7 +470,7 @@ src_libsinglebin_unexpand_a_SOURCES =   src/unexpand.c src/expand-common.c
 src_libsinglebin_unexpand_a_CFLAGS = "-Dmain=single_binary_main_unexpand (int, char **);  int single_binary_main_unexpand"  -Dusage=_usage_unexpand $(src_coreutils_CFLAGS)
 # Command uniq
 noinst_LIBRARIES += src/libsinglebin_uniq.a
-src_libsinglebin_uniq_a_SOURCES = src/uniq.c
+src_libsinglebin_uniq_a_SOURCES =   src/uniq.c src/line-reader.c src/spill.c
 src_libsinglebin_uniq_a_CFLAGS = "-Dmain=single_binary_main_uniq (int, char **);  int single_binary_main_uniq"  -Dusage=_usage_uniq $(src_coreutils_CFLAGS)
 # Command unlink
 noinst_LIBRARIES += src/libsinglebin_unlink.a
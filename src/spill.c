@@ -0,0 +1,113 @@
+/* spill -- helpers for programs that spill their data to temporary files
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "system.h"
+#include "die.h"
+#include "filenamecat.h"
+#include "physmem.h"
+#include "quote.h"
+#include "xstrtol.h"
+
+#include "spill.h"
+
+#ifndef DEFAULT_TMPDIR
+# define DEFAULT_TMPDIR "/tmp"
+#endif
+
+size_t
+spill_default_buffer_size (void)
+{
+  /* Use the available memory or 1/8 of total memory, whichever
+     is greater, as sort does.  */
+  double avail = physmem_available ();
+  double total = physmem_total ();
+  double mem = MAX (avail, total / 8);
+  return mem < SIZE_MAX ? mem : SIZE_MAX;
+}
+
+size_t
+spill_buffer_size_opt (char const *opt)
+{
+  uintmax_t size;
+  char *end;
+  enum strtol_error e = xstrtoumax (opt, &end, 10, &size, "bEGKkMmPTYZ");
+
+  if (e == LONGINT_OK && ISDIGIT (end[-1]))
+    {
+      if (UINTMAX_MAX / 1024 < size)
+        e = LONGINT_OVERFLOW;
+      size *= 1024;
+    }
+
+  if (e == LONGINT_OVERFLOW)
+    return SIZE_MAX;
+  if (e != LONGINT_OK || size == 0)
+    die (EXIT_FAILURE, 0, "%s: %s", opt, _("invalid buffer size"));
+
+  return MIN (size, SIZE_MAX);
+}
+
+FILE *
+spill_temp_file (char const *template)
+{
+  char const *temp_dir = getenv ("TMPDIR");
+  if (! (temp_dir && *temp_dir))
+    temp_dir = DEFAULT_TMPDIR;
+  char *file = file_name_concat (temp_dir, template, NULL);
+  int fd = mkostemp (file, O_CLOEXEC);
+  if (fd < 0)
+    die (EXIT_FAILURE, errno, _("cannot create temporary file in %s"),
+         quoteaf (temp_dir));
+  unlink (file);
+  free (file);
+
+  FILE *fp = fdopen (fd, "w+");
+  if (! fp)
+    die (EXIT_FAILURE, errno, _("cannot create temporary file in %s"),
+         quoteaf (temp_dir));
+  return fp;
+}
+
+uint64_t
+spill_hash (char const *key, size_t len, bool ignore_case)
+{
+  /* FNV-1a.  */
+  uint64_t h = 0xcbf29ce484222325;
+  if (ignore_case)
+    for (size_t i = 0; i < len; i++)
+      h = (h ^ toupper (to_uchar (key[i]))) * 0x100000001b3;
+  else
+    for (size_t i = 0; i < len; i++)
+      h = (h ^ to_uchar (key[i])) * 0x100000001b3;
+
+  /* Mix the high bits, which select the partition, into the low ones,
+     which callers use to select a slot of their tables.  */
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  return h;
+}
+
+int
+spill_part (uint64_t h, int depth)
+{
+  return (h >> (64 - SPILL_PART_BITS * (depth + 1))) & (SPILL_PARTS - 1);
+}
@@ -0,0 +1,56 @@
+/* spill -- helpers for programs that spill their data to temporary files
+
+   Copyright (C) 2020 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef SPILL_H
+# define SPILL_H
+
+# include <stdio.h>
+
+/* The number of temporary files into which the data that does not fit
+   in memory is partitioned by the hash values of its keys, and the
+   number of bits of a hash value that select the partition.  */
+enum { SPILL_PART_BITS = 4, SPILL_PARTS = 1 << SPILL_PART_BITS };
+
+/* The number of partitioning levels the 64-bit hash values allow.  */
+enum { SPILL_MAX_DEPTH = 64 / SPILL_PART_BITS - 1 };
+
+/* The minimum memory to use, so that partitioning cannot create an
+   excessive number of temporary files.  */
+enum { SPILL_MIN_BUFFER_SIZE = 256 * 1024 };
+
+/* Return the default --buffer-size.  */
+extern size_t spill_default_buffer_size (void);
+
+/* Convert the --buffer-size argument OPT to size_t, exiting upon error.
+   As with sort, a number without a suffix is in units of 1024 bytes.  */
+extern size_t spill_buffer_size_opt (char const *opt);
+
+/* Create an unlinked temporary file from TEMPLATE, a file name ending
+   in "XXXXXX", in $TMPDIR or the default directory, and return a stream
+   to read and write it.  Exit upon failure.  */
+extern FILE *spill_temp_file (char const *template) _GL_ATTRIBUTE_MALLOC;
+
+/* Return the hash value of the key KEY of length LEN, ignoring the
+   case of letters if IGNORE_CASE.  */
+extern uint64_t spill_hash (char const *key, size_t len, bool ignore_case)
+  _GL_ATTRIBUTE_PURE;
+
+/* Return the partition of the key with hash value H at level DEPTH,
+   from 0 to SPILL_PARTS - 1.  */
+extern int spill_part (uint64_t h, int depth) _GL_ATTRIBUTE_CONST;
+
+#endif
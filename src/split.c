@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <getopt.h>
+#include <poll.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -60,6 +61,40 @@ static int *open_pipes;
 static size_t open_pipes_alloc;
 static size_t n_open_pipes;
 
+/* The maximum number of filter commands to run at once.  */
+static size_t n_jobs = 1;
+
+/* If true, write to the filter commands without blocking, buffering
+   what their pipes do not accept, so that the commands can run in
+   parallel and a slow one does not hold up the others.  */
+static bool async_filters;
+
+/* With ASYNC_FILTERS, the output to a filter command.  */
+struct output
+{
+  char *name;			/* The value of FILE for the command.  */
+  int fd;			/* The pipe to the command, or -1.  */
+  pid_t pid;			/* The command's process ID.  */
+  char *buf;			/* Data not yet written to the pipe.  */
+  size_t start;			/* Offset of that data in BUF.  */
+  size_t len;			/* Length of that data.  */
+  size_t size;			/* Allocated size of BUF.  */
+  bool closing;			/* Close the pipe once BUF is written.  */
+  bool broken;			/* The command no longer reads its input.  */
+};
+
+/* The outputs whose commands have not been waited for, oldest first,
+   and the one being written by cwrite.  */
+static struct output **outputs;
+static size_t outputs_alloc;
+static size_t n_outputs;
+static struct output *cur_output;
+
+/* The number of bytes buffered for all outputs, and the number per
+   job beyond which to wait for the commands to read them.  */
+static size_t output_buffered;
+enum { OUTPUT_BUFFER_MAX = 8 * IO_BUFSIZE };
+
 /* Blocked signals.  */
 static sigset_t oldblocked;
 static sigset_t newblocked;
@@ -109,6 +144,10 @@ static bool elide_empty_files;
    input to output, which is much slower, so disabled by default.  */
 static bool unbuffered;
 
+/* If true, copy byte ranges of a regular input file to the output
+   within the kernel, rather than reading and writing them.  */
+static bool use_copy_range;
+
 /* The character marking end of line.  Defaults to \n below.  */
 static int eolchar = -1;
 
@@ -126,7 +165,8 @@ enum
   VERBOSE_OPTION = CHAR_MAX + 1,
   FILTER_OPTION,
   IO_BLKSIZE_OPTION,
-  ADDITIONAL_SUFFIX_OPTION
+  ADDITIONAL_SUFFIX_OPTION,
+  PARALLEL_OPTION
 };
 
 static struct option const longopts[] =
@@ -144,6 +184,7 @@ static struct option const longopts[] =
   {"hex-suffixes", optional_argument, NULL, 'x'},
   {"filter", required_argument, NULL, FILTER_OPTION},
   {"verbose", no_argument, NULL, VERBOSE_OPTION},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"separator", required_argument, NULL, 't'},
   {"-io-blksize", required_argument, NULL,
    IO_BLKSIZE_OPTION}, /* do not document */
@@ -249,6 +290,7 @@ default size is 1000 lines, and default PREFIX is 'x'.\n\
       --filter=COMMAND    write to shell COMMAND; file name is $FILE\n\
   -l, --lines=NUMBER      put NUMBER lines/records per output file\n\
   -n, --number=CHUNKS     generate CHUNKS output files; see explanation below\n\
+      --parallel=N        with --filter, run up to N commands at once\n\
   -t, --separator=SEP     use SEP instead of newline as the record separator;\n\
                             '\\0' (zero) specifies the NUL character\n\
   -u, --unbuffered        immediately copy input to output with '-n r/...'\n\
@@ -532,6 +574,57 @@ create (const char *name)
     }
 }
 
+/* Remove FD, which has been closed, from the open pipes.  */
+static void
+forget_pipe (int fd)
+{
+  int j;
+  for (j = 0; j < n_open_pipes; ++j)
+    {
+      if (open_pipes[j] == fd)
+        {
+          open_pipes[j] = open_pipes[--n_open_pipes];
+          break;
+        }
+    }
+}
+
+/* Wait for the filter command with process ID PID, run with FILE=NAME,
+   and report its failure.  */
+static void
+wait_filter (pid_t pid, char const *name)
+{
+  int wstatus = 0;
+  if (waitpid (pid, &wstatus, 0) == -1 && errno != ECHILD)
+    die (EXIT_FAILURE, errno, _("waiting for child process"));
+  if (WIFSIGNALED (wstatus))
+    {
+      int sig = WTERMSIG (wstatus);
+      if (sig != SIGPIPE)
+        {
+          char signame[MAX (SIG2STR_MAX, INT_BUFSIZE_BOUND (int))];
+          if (sig2str (sig, signame) != 0)
+            sprintf (signame, "%d", sig);
+          error (sig + 128, 0,
+                 _("with FILE=%s, signal %s from command: %s"),
+                 quotef (name), signame, filter_command);
+        }
+    }
+  else if (WIFEXITED (wstatus))
+    {
+      int ex = WEXITSTATUS (wstatus);
+      if (ex != 0)
+        error (ex, 0, _("with FILE=%s, exit %d from command: %s"),
+               quotef (name), ex, filter_command);
+    }
+  else
+    {
+      /* shouldn't happen.  */
+      die (EXIT_FAILURE, 0,
+           _("unknown status from command (0x%X)"), wstatus + 0u);
+    }
+}
+
 /* Close the output file, and do any associated cleanup.
    If FP and FD are both specified, they refer to the same open file;
    in this case FP is closed, but FD is still used in cleanup.  */
@@ -544,48 +637,175 @@ closeout (FILE *fp, int fd, pid_t pid, char const *name)
     {
       if (fp == NULL && close (fd) < 0)
         die (EXIT_FAILURE, errno, "%s", quotef (name));
-      int j;
-      for (j = 0; j < n_open_pipes; ++j)
-        {
-          if (open_pipes[j] == fd)
-            {
-              open_pipes[j] = open_pipes[--n_open_pipes];
-              break;
-            }
-        }
+      forget_pipe (fd);
     }
   if (pid > 0)
+    wait_filter (pid, name);
+}
+
+/* Start the filter command with FILE=NAME, and return its output,
+   whose pipe does not block.  */
+static struct output *
+output_open (char const *name)
+{
+  int fd = create (name);
+  int flags = fcntl (fd, F_GETFL);
+  if (flags < 0 || fcntl (fd, F_SETFL, flags | O_NONBLOCK) != 0)
+    die (EXIT_FAILURE, errno, "%s", quotef (name));
+
+  struct output *o = xzalloc (sizeof *o);
+  o->name = xstrdup (name);
+  o->fd = fd;
+  o->pid = filter_pid;
+  filter_pid = 0;
+  if (n_outputs == outputs_alloc)
+    outputs = x2nrealloc (outputs, &outputs_alloc, sizeof *outputs);
+  outputs[n_outputs++] = o;
+  return o;
+}
+
+/* Write to O as much of the BYTES bytes at BP as its pipe accepts
+   without blocking, and return the number of bytes written.
+   If the command no longer reads its input, mark O as broken.  */
+static size_t
+output_send (struct output *o, char const *bp, size_t bytes)
+{
+  size_t sent = 0;
+  while (sent < bytes && ! o->broken)
     {
-      int wstatus = 0;
-      if (waitpid (pid, &wstatus, 0) == -1 && errno != ECHILD)
-        die (EXIT_FAILURE, errno, _("waiting for child process"));
-      if (WIFSIGNALED (wstatus))
-        {
-          int sig = WTERMSIG (wstatus);
-          if (sig != SIGPIPE)
-            {
-              char signame[MAX (SIG2STR_MAX, INT_BUFSIZE_BOUND (int))];
-              if (sig2str (sig, signame) != 0)
-                sprintf (signame, "%d", sig);
-              error (sig + 128, 0,
-                     _("with FILE=%s, signal %s from command: %s"),
-                     quotef (name), signame, filter_command);
-            }
-        }
-      else if (WIFEXITED (wstatus))
+      ssize_t n = write (o->fd, bp + sent, MIN (bytes - sent, SSIZE_MAX));
+      if (0 <= n)
+        sent += n;
+      else if (errno == EAGAIN)
+        break;
+      else if (ignorable (errno))
+        o->broken = true;
+      else if (errno != EINTR)
+        die (EXIT_FAILURE, errno, "%s", quotef (o->name));
+    }
+  return sent;
+}
+
+/* Write what the pipe of O accepts of its buffered data,
+   and close the pipe if O is closing and nothing remains.  */
+static void
+output_flush (struct output *o)
+{
+  size_t n = o->len ? output_send (o, o->buf + o->start, o->len) : 0;
+  if (o->broken)
+    n = o->len;
+  o->start += n;
+  o->len -= n;
+  output_buffered -= n;
+
+  if (! o->len)
+    {
+      o->start = 0;
+      if (o->closing && 0 <= o->fd)
         {
-          int ex = WEXITSTATUS (wstatus);
-          if (ex != 0)
-            error (ex, 0, _("with FILE=%s, exit %d from command: %s"),
-                   quotef (name), ex, filter_command);
+          if (close (o->fd) != 0 && ! ignorable (errno))
+            die (EXIT_FAILURE, errno, "%s", quotef (o->name));
+          forget_pipe (o->fd);
+          o->fd = -1;
         }
-      else
+    }
+}
+
+/* Wait until the pipe of at least one output with buffered data
+   accepts more, and write to it.  */
+static void
+output_wait (void)
+{
+  static struct pollfd *fds;
+  static size_t fds_alloc;
+  static struct output **polled;
+  size_t n_fds = 0;
+
+  if (fds_alloc < n_outputs)
+    {
+      free (fds);
+      free (polled);
+      fds_alloc = n_outputs;
+      fds = xnmalloc (fds_alloc, sizeof *fds);
+      polled = xnmalloc (fds_alloc, sizeof *polled);
+    }
+
+  for (size_t i = 0; i < n_outputs; i++)
+    if (outputs[i]->len)
+      {
+        fds[n_fds].fd = outputs[i]->fd;
+        fds[n_fds].events = POLLOUT;
+        polled[n_fds++] = outputs[i];
+      }
+
+  if (poll (fds, n_fds, -1) < 0)
+    {
+      if (errno == EINTR)
+        return;
+      die (EXIT_FAILURE, errno, _("error waiting for output"));
+    }
+
+  for (size_t i = 0; i < n_fds; i++)
+    if (fds[i].revents)
+      output_flush (polled[i]);
+}
+
+/* Write the BYTES bytes at BP to O, buffering what its pipe does not
+   accept, and wait while too much data is buffered.  */
+static void
+output_write (struct output *o, char const *bp, size_t bytes)
+{
+  if (! o->len)
+    {
+      size_t n = output_send (o, bp, bytes);
+      bp += n;
+      bytes -= n;
+    }
+  if (o->broken || ! bytes)
+    return;
+
+  if (o->size - o->start - o->len < bytes)
+    {
+      memmove (o->buf, o->buf + o->start, o->len);
+      o->start = 0;
+      if (o->size - o->len < bytes)
         {
-          /* shouldn't happen.  */
-          die (EXIT_FAILURE, 0,
-               _("unknown status from command (0x%X)"), wstatus + 0u);
+          o->size = o->len + bytes;
+          o->buf = x2realloc (o->buf, &o->size);
         }
     }
+  memcpy (o->buf + o->start + o->len, bp, bytes);
+  o->len += bytes;
+  output_buffered += bytes;
+
+  while (n_jobs * OUTPUT_BUFFER_MAX < output_buffered)
+    output_wait ();
+}
+
+/* Close the pipe of O once its buffered data is written.  */
+static void
+output_close (struct output *o)
+{
+  o->closing = true;
+  output_flush (o);
+}
+
+/* Wait for the oldest output, which must be closing, to be written,
+   and for its command to finish.  */
+static void
+output_reap (void)
+{
+  struct output *o = outputs[0];
+  while (0 <= o->fd)
+    output_wait ();
+  wait_filter (o->pid, o->name);
+
+  if (o == cur_output)
+    cur_output = NULL;
+  free (o->buf);
+  free (o->name);
+  free (o);
+  memmove (outputs, outputs + 1, --n_outputs * sizeof *outputs);
 }
 
 /* Write BYTES bytes at BP to an output file.
@@ -596,6 +816,23 @@ closeout (FILE *fp, int fd, pid_t pid, char const *name)
 static bool
 cwrite (bool new_file_flag, const char *bp, size_t bytes)
 {
+  if (async_filters)
+    {
+      if (new_file_flag)
+        {
+          if (!bp && bytes == 0 && elide_empty_files)
+            return true;
+          if (cur_output)
+            output_close (cur_output);
+          while (n_jobs <= n_outputs)
+            output_reap ();
+          next_file_name ();
+          cur_output = output_open (outfile);
+        }
+      output_write (cur_output, bp, bytes);
+      return ! cur_output->broken;
+    }
+
   if (new_file_flag)
     {
       if (!bp && bytes == 0 && elide_empty_files)
@@ -617,6 +854,38 @@ cwrite (bool new_file_flag, const char *bp, size_t bytes)
     }
 }
 
+/* Copy up to N bytes from standard input to OFD within the kernel,
+   advancing both file offsets, and return the number of bytes copied.
+   This is less than N only at end of input, or if copy_file_range
+   fails.  Either way, stop using it, and let the caller fall back on
+   reading and writing, which then detects the end of input (that some
+   file systems like /proc misreport to copy_file_range) or diagnoses
+   any persistent error.  */
+
+static uintmax_t
+copy_range (int ofd, uintmax_t n)
+{
+  uintmax_t copied = 0;
+#if HAVE_COPY_FILE_RANGE
+  while (copied < n)
+    {
+      ssize_t c = copy_file_range (STDIN_FILENO, NULL, ofd, NULL,
+                                   MIN (n - copied, SSIZE_MAX), 0);
+      if (c <= 0)
+        {
+          use_copy_range = false;
+          break;
+        }
+      copied += c;
+    }
+#else
+  (void) ofd;
+  (void) n;
+  use_copy_range = false;
+#endif
+  return copied;
+}
+
 /* Split into pieces of exactly N_BYTES bytes.
    Use buffer BUF, whose size is BUFSIZE.
    BUF contains the first INITIAL_READ input bytes.  */
@@ -649,6 +918,20 @@ bytes_split (uintmax_t n_bytes, char *buf, size_t bufsize, size_t initial_read,
               new_file_flag = true;
             }
 
+          if (use_copy_range && ! new_file_flag)
+            {
+              /* Copy the rest of the current file without reading it.
+                 Each new file is still started by reading a buffer.  */
+              uintmax_t copied = copy_range (output_desc, to_write);
+              if (copied == to_write)
+                {
+                  to_write = n_bytes;
+                  new_file_flag = !max_files || (opened < max_files);
+                  continue;
+                }
+              to_write -= copied;
+            }
+
           n_read = safe_read (STDIN_FILENO, buf, bufsize);
           if (n_read == SAFE_READ_ERROR)
             die (EXIT_FAILURE, errno, "%s", quotef (infile));
@@ -1016,6 +1299,11 @@ bytes_chunk_extract (uintmax_t k, uintmax_t n, char *buf, size_t bufsize,
         }
       else
         {
+          if (use_copy_range)
+            {
+              start += copy_range (STDOUT_FILENO, end - start);
+              continue;
+            }
           n_read = safe_read (STDIN_FILENO, buf, bufsize);
           if (n_read == SAFE_READ_ERROR)
             die (EXIT_FAILURE, errno, "%s", quotef (infile));
@@ -1036,6 +1324,7 @@ typedef struct of_info
   int ofd;
   FILE *ofile;
   int opid;
+  struct output *out;
 } of_t;
 
 enum
@@ -1151,6 +1440,7 @@ lines_rr (uintmax_t k, uintmax_t n, char *buf, size_t bufsize)
           files[i_file].ofd = OFD_NEW;
           files[i_file].ofile = NULL;
           files[i_file].opid = 0;
+          files[i_file].out = NULL;
         }
       i_file = 0;
       file_limit = false;
@@ -1199,39 +1489,53 @@ lines_rr (uintmax_t k, uintmax_t n, char *buf, size_t bufsize)
             }
           else
             {
-              /* Secure file descriptor. */
-              file_limit |= ofile_open (files, i_file, n);
-              if (unbuffered)
+              if (async_filters)
+                {
+                  struct output **o = &files[i_file].out;
+                  if (! *o)
+                    *o = output_open (files[i_file].of_name);
+                  output_write (*o, bp, to_write);
+                  if (! (*o)->broken)
+                    wrote = true;
+                }
+              else
                 {
-                  /* Note writing to fd, rather than flushing the FILE gives
-                     an 8% performance benefit, due to reduced data copying.  */
-                  if (full_write (files[i_file].ofd, bp, to_write) != to_write
-                      && ! ignorable (errno))
+                  /* Secure file descriptor. */
+                  file_limit |= ofile_open (files, i_file, n);
+                  if (unbuffered)
+                    {
+                      /* Note writing to fd, rather than flushing the FILE
+                         gives an 8% performance benefit, due to reduced
+                         data copying.  */
+                      if (full_write (files[i_file].ofd, bp, to_write)
+                          != to_write && ! ignorable (errno))
+                        {
+                          die (EXIT_FAILURE, errno, "%s",
+                               quotef (files[i_file].of_name));
+                        }
+                    }
+                  else if (fwrite (bp, to_write, 1, files[i_file].ofile) != 1
+                           && ! ignorable (errno))
                     {
                       die (EXIT_FAILURE, errno, "%s",
                            quotef (files[i_file].of_name));
                     }
-                }
-              else if (fwrite (bp, to_write, 1, files[i_file].ofile) != 1
-                       && ! ignorable (errno))
-                {
-                  die (EXIT_FAILURE, errno, "%s",
-                       quotef (files[i_file].of_name));
-                }
 
-              if (! ignorable (errno))
-                wrote = true;
+                  if (! ignorable (errno))
+                    wrote = true;
 
-              if (file_limit)
-                {
-                  if (fclose (files[i_file].ofile) != 0)
+                  if (file_limit)
                     {
-                      die (EXIT_FAILURE, errno, "%s",
-                           quotef (files[i_file].of_name));
+                      if (fclose (files[i_file].ofile) != 0)
+                        {
+                          die (EXIT_FAILURE, errno, "%s",
+                               quotef (files[i_file].of_name));
+                        }
+                      files[i_file].ofile = NULL;
+                      files[i_file].ofd = OFD_APPEND;
                     }
-                  files[i_file].ofile = NULL;
-                  files[i_file].ofd = OFD_APPEND;
                 }
+
               if (next && ++i_file == n)
                 {
                   wrapped = true;
@@ -1257,6 +1561,14 @@ no_filters:
       int ceiling = (wrapped ? n : i_file);
       for (i_file = 0; i_file < n; i_file++)
         {
+          if (async_filters)
+            {
+              if (! files[i_file].out && !elide_empty_files)
+                files[i_file].out = output_open (files[i_file].of_name);
+              if (files[i_file].out)
+                output_close (files[i_file].out);
+              continue;
+            }
           if (i_file >= ceiling && !elide_empty_files)
             file_limit |= ofile_open (files, i_file, n);
           if (files[i_file].ofd >= 0)
@@ -1306,6 +1618,7 @@ main (int argc, char **argv)
   int c;
   int digits_optind = 0;
   off_t file_size = OFF_T_MAX;
+  bool parallel = false;
 
   initialize_main (&argc, &argv);
   set_program_name (argv[0]);
@@ -1508,6 +1821,12 @@ main (int argc, char **argv)
           verbose = true;
           break;
 
+        case PARALLEL_OPTION:
+          n_jobs = xdectoumax (optarg, 1, SIZE_MAX / OUTPUT_BUFFER_MAX, "",
+                               _("invalid number of parallel commands"), 0);
+          parallel = true;
+          break;
+
         case_GETOPT_HELP_CHAR;
 
         case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
@@ -1523,6 +1842,12 @@ main (int argc, char **argv)
       usage (EXIT_FAILURE);
     }
 
+  if (parallel && ! filter_command)
+    {
+      error (0, 0, _("--parallel is only valid with --filter"));
+      usage (EXIT_FAILURE);
+    }
+
   /* Handle default case.  */
   if (split_type == type_undef)
     {
@@ -1578,6 +1903,8 @@ main (int argc, char **argv)
   if (fstat (STDIN_FILENO, &in_stat_buf) != 0)
     die (EXIT_FAILURE, errno, "%s", quotef (infile));
 
+  use_copy_range = S_ISREG (in_stat_buf.st_mode) && ! filter_command;
+
   bool specified_buf_size = !! in_blk_size;
   if (! specified_buf_size)
     in_blk_size = io_blksize (in_stat_buf);
@@ -1611,6 +1938,7 @@ main (int argc, char **argv)
      as there may still be other streams expecting input from us.  */
   if (filter_command)
     {
+      async_filters = 1 < n_jobs;
       struct sigaction act;
       sigemptyset (&newblocked);
       sigaction (SIGPIPE, NULL, &act);
@@ -1663,6 +1991,10 @@ main (int argc, char **argv)
   if (close (STDIN_FILENO) != 0)
     die (EXIT_FAILURE, errno, "%s", quotef (infile));
   closeout (NULL, output_desc, filter_pid, outfile);
+  if (cur_output)
+    output_close (cur_output);
+  while (n_outputs)
+    output_reap ();
 
   return EXIT_SUCCESS;
 }
@@ -28,9 +28,11 @@
 # define USE_STATVFS 0
 #endif
 
+#include <assert.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdalign.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <pwd.h>
 #include <grp.h>
@@ -60,18 +62,21 @@
 
 #include "areadlink.h"
 #include "argmatch.h"
+#include "argv-iter.h"
 #include "die.h"
 #include "error.h"
 #include "file-type.h"
 #include "filemode.h"
 #include "fs.h"
 #include "getopt.h"
+#include "idcache.h"
 #include "mountlist.h"
 #include "quote.h"
 #include "stat-size.h"
 #include "stat-time.h"
 #include "strftime.h"
 #include "find-mount-point.h"
+#include "xdectoint.h"
 #include "xvasprintf.h"
 #include "statx.h"
 
@@ -198,7 +203,9 @@ static char const fmt_terse_selinux[] = "%n %s %b %f %u %g %D %i %h %t %T"
 
 enum
 {
-  PRINTF_OPTION = CHAR_MAX + 1
+  PRINTF_OPTION = CHAR_MAX + 1,
+  FILES0_FROM_OPTION,
+  PARALLEL_OPTION
 };
 
 enum cached_mode
@@ -222,10 +229,15 @@ static struct option const long_options[] =
 {
   {"dereference", no_argument, NULL, 'L'},
   {"file-system", no_argument, NULL, 'f'},
+  {"files0-from", required_argument, NULL, FILES0_FROM_OPTION},
   {"format", required_argument, NULL, 'c'},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"printf", required_argument, NULL, PRINTF_OPTION},
   {"terse", no_argument, NULL, 't'},
   {"cached", required_argument, NULL, 0},
+  /* Keep the abbreviation --p meaning --printf, as it did before
+     --parallel was added.  */
+  {"p", required_argument, NULL, PRINTF_OPTION},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
   {NULL, 0, NULL, 0}
@@ -234,6 +246,9 @@ static struct option const long_options[] =
 /* Whether to follow symbolic links;  True for --dereference (-L).  */
 static bool follow_links;
 
+/* Whether to display file system status;  True for --file-system (-f).  */
+static bool stat_file_system;
+
 /* Whether to interpret backslash-escape sequences.
    True for --printf=FMT, not for --format=FMT (-c).  */
 static bool interpret_backslash_escapes;
@@ -674,21 +689,44 @@ make_format (char *pformat, size_t prefix_len, char const *allowed_flags,
   strcpy (dst, suffix);
 }
 
+/* The functions below output ARG as directed by the prefix of a format
+   in PFORMAT.  A bare "%", the most common prefix, is output directly
+   rather than with printf, which must parse the format each time.  */
+
 static void
 out_string (char *pformat, size_t prefix_len, char const *arg)
 {
+  if (prefix_len == 1)
+    {
+      fputs (arg, stdout);
+      return;
+    }
   make_format (pformat, prefix_len, "-", "s");
   printf (pformat, arg);
 }
 static int
 out_int (char *pformat, size_t prefix_len, intmax_t arg)
 {
+  if (prefix_len == 1)
+    {
+      char buf[INT_BUFSIZE_BOUND (intmax_t)];
+      char const *p = imaxtostr (arg, buf);
+      fputs (p, stdout);
+      return strlen (p);
+    }
   make_format (pformat, prefix_len, "'-+ 0", PRIdMAX);
   return printf (pformat, arg);
 }
 static int
 out_uint (char *pformat, size_t prefix_len, uintmax_t arg)
 {
+  if (prefix_len == 1)
+    {
+      char buf[INT_BUFSIZE_BOUND (uintmax_t)];
+      char const *p = umaxtostr (arg, buf);
+      fputs (p, stdout);
+      return strlen (p);
+    }
   make_format (pformat, prefix_len, "'-0", PRIuMAX);
   return printf (pformat, arg);
 }
@@ -1054,10 +1092,10 @@ getenv_quoting_style (void)
 /* Equivalent to quotearg(), but explicit to avoid syntax checks.  */
 #define quoteN(x) quotearg_style (get_quoting_style (NULL), x)
 
-/* Output a single-character \ escape.  */
+/* Return the character of a single-character \ escape.  */
 
-static void
-print_esc_char (char c)
+static char
+esc_char (char c)
 {
   switch (c)
     {
@@ -1092,7 +1130,7 @@ print_esc_char (char c)
       error (0, 0, _("warning: unrecognized escape '\\%c'"), c);
       break;
     }
-  putchar (c);
+  return c;
 }
 
 static size_t _GL_ATTRIBUTE_PURE
@@ -1106,29 +1144,54 @@ format_code_offset (char const* directive)
   return fmt_char - directive;
 }
 
-/* Print the information specified by the format string, FORMAT,
-   calling PRINT_FUNC for each %-directive encountered.
-   Return zero upon success, nonzero upon failure.  */
-static bool ATTRIBUTE_WARN_UNUSED_RESULT
-print_it (char const *format, int fd, char const *filename,
-          bool (*print_func) (char *, size_t, unsigned int,
-                              int, char const *, void const *),
-          void const *data)
+/* Add 2 to accommodate our conversion of the stat '%s' format string
+   to the longer printf '%llu' one.  */
+enum
+  {
+    MAX_ADDITIONAL_BYTES =
+      (MAX (sizeof PRIdMAX,
+            MAX (sizeof PRIoMAX, MAX (sizeof PRIuMAX, sizeof PRIxMAX)))
+       - 1)
+  };
+
+/* A %-directive of a format, and the literal text output before it.  */
+struct directive
 {
-  bool fail = false;
+  char const *text;		/* The text, with any escapes interpreted.  */
+  size_t text_len;
+  char const *prefix;		/* The directive up to its conversion,
+                                   such as "%-10".  */
+  size_t prefix_len;
+  unsigned int conv;		/* The conversion, or 0 after the last text.  */
+};
 
-  /* Add 2 to accommodate our conversion of the stat '%s' format string
-     to the longer printf '%llu' one.  */
-  enum
-    {
-      MAX_ADDITIONAL_BYTES =
-        (MAX (sizeof PRIdMAX,
-              MAX (sizeof PRIoMAX, MAX (sizeof PRIuMAX, sizeof PRIxMAX)))
-         - 1)
-    };
-  size_t n_alloc = strlen (format) + MAX_ADDITIONAL_BYTES + 1;
-  char *dest = xmalloc (n_alloc);
+/* A format string, parsed once by compile_format for all the files
+   printed with it.  */
+struct format
+{
+  struct directive *directives;	/* Ended by one with CONV 0.  */
+  char *text;			/* The text of the directives.  */
+  char *pformat;		/* Room for a directive to be converted
+                                   to a printf format.  */
+};
+
+/* Return the format string FORMAT, compiled for print_it.  Diagnose
+   any invalid directive.  FORMAT must not be freed while in use.  */
+static struct format *
+compile_format (char const *format)
+{
+  size_t format_len = strlen (format);
+  size_t n_directives = 1;
   char const *b;
+  for (b = format; *b; b++)
+    n_directives += *b == '%';
+
+  struct format *f = xmalloc (sizeof *f);
+  struct directive *d = f->directives = xnmalloc (n_directives, sizeof *d);
+  char *text = f->text = xmalloc (format_len + 1);
+  f->pformat = xmalloc (format_len + MAX_ADDITIONAL_BYTES + 1);
+  d->text = text;
+
   for (b = format; *b; b++)
     {
       switch (*b)
@@ -1137,27 +1200,32 @@ print_it (char const *format, int fd, char const *filename,
           {
             size_t len = format_code_offset (b);
             char const *fmt_char = b + len;
-            memcpy (dest, b, len);
-            b += len;
 
             switch (*fmt_char)
               {
               case '\0':
-                --b;
-                FALLTHROUGH;
               case '%':
                 if (1 < len)
                   {
+                    char *dest = f->pformat;
+                    memcpy (dest, b, len);
                     dest[len] = *fmt_char;
                     dest[len + 1] = '\0';
                     die (EXIT_FAILURE, 0, _("%s: invalid directive"),
                          quote (dest));
                   }
-                putchar ('%');
+                *text++ = '%';
+                /* Stop at the end of FORMAT.  */
+                b = *fmt_char ? fmt_char : fmt_char - 1;
                 break;
               default:
-                fail |= print_func (dest, len, to_uchar (*fmt_char),
-                                    fd, filename, data);
+                d->text_len = text - d->text;
+                d->prefix = b;
+                d->prefix_len = len;
+                d->conv = to_uchar (*fmt_char);
+                d++;
+                d->text = text;
+                b = fmt_char;
                 break;
               }
             break;
@@ -1166,7 +1234,7 @@ print_it (char const *format, int fd, char const *filename,
         case '\\':
           if ( ! interpret_backslash_escapes)
             {
-              putchar ('\\');
+              *text++ = '\\';
               break;
             }
           ++b;
@@ -1179,7 +1247,7 @@ print_it (char const *format, int fd, char const *filename,
                 {
                   esc_value = esc_value * 8 + octtobin (*b);
                 }
-              putchar (esc_value);
+              *text++ = esc_value;
               --b;
             }
           else if (*b == 'x' && isxdigit (to_uchar (b[1])))
@@ -1193,55 +1261,57 @@ print_it (char const *format, int fd, char const *filename,
                   ++b;
                   esc_value = esc_value * 16 + hextobin (*b);
                 }
-              putchar (esc_value);
+              *text++ = esc_value;
             }
           else if (*b == '\0')
             {
               error (0, 0, _("warning: backslash at end of format"));
-              putchar ('\\');
+              *text++ = '\\';
               /* Arrange to exit the loop.  */
               --b;
             }
           else
             {
-              print_esc_char (*b);
+              *text++ = esc_char (*b);
             }
           break;
 
         default:
-          putchar (*b);
+          *text++ = *b;
           break;
         }
     }
-  free (dest);
 
-  fputs (trailing_delim, stdout);
-
-  return fail;
+  d->text_len = text - d->text;
+  d->conv = 0;
+  return f;
 }
 
-/* Stat the file system and print what we find.  */
+/* Print the information specified by the compiled format, FORMAT,
+   calling PRINT_FUNC for each %-directive encountered.
+   Return zero upon success, nonzero upon failure.  */
 static bool ATTRIBUTE_WARN_UNUSED_RESULT
-do_statfs (char const *filename, char const *format)
+print_it (struct format const *format, int fd, char const *filename,
+          bool (*print_func) (char *, size_t, unsigned int,
+                              int, char const *, void const *),
+          void const *data)
 {
-  STRUCT_STATVFS statfsbuf;
+  bool fail = false;
+  struct directive const *d;
 
-  if (STREQ (filename, "-"))
+  for (d = format->directives; ; d++)
     {
-      error (0, 0, _("using %s to denote standard input does not work"
-                     " in file system mode"), quoteaf (filename));
-      return false;
+      fwrite (d->text, 1, d->text_len, stdout);
+      if (! d->conv)
+        break;
+      memcpy (format->pformat, d->prefix, d->prefix_len);
+      fail |= print_func (format->pformat, d->prefix_len, d->conv,
+                          fd, filename, data);
     }
 
-  if (STATFS (filename, &statfsbuf) != 0)
-    {
-      error (0, errno, _("cannot read file system information for %s"),
-             quoteaf (filename));
-      return false;
-    }
+  fputs (trailing_delim, stdout);
 
-  bool fail = print_it (format, -1, filename, print_statfs, &statfsbuf);
-  return ! fail;
+  return fail;
 }
 
 struct print_args {
@@ -1327,54 +1397,8 @@ format_to_mask (char const *format)
   return mask;
 }
 
-/* statx the file and print what we find */
-static bool ATTRIBUTE_WARN_UNUSED_RESULT
-do_stat (char const *filename, char const *format, char const *format2)
-{
-  int fd = STREQ (filename, "-") ? 0 : AT_FDCWD;
-  int flags = 0;
-  struct stat st;
-  struct statx stx = { 0, };
-  const char *pathname = filename;
-  struct print_args pa;
-  pa.st = &st;
-  pa.btime = (struct timespec) {-1, -1};
-
-  if (AT_FDCWD != fd)
-    {
-      pathname = "";
-      flags = AT_EMPTY_PATH;
-    }
-  else if (!follow_links)
-    {
-      flags = AT_SYMLINK_NOFOLLOW;
-    }
-
-  if (dont_sync)
-    flags |= AT_STATX_DONT_SYNC;
-  else if (force_sync)
-    flags |= AT_STATX_FORCE_SYNC;
-
-  fd = statx (fd, pathname, flags, format_to_mask (format), &stx);
-  if (fd < 0)
-    {
-      if (flags & AT_EMPTY_PATH)
-        error (0, errno, _("cannot stat standard input"));
-      else
-        error (0, errno, _("cannot statx %s"), quoteaf (filename));
-      return false;
-    }
-
-  if (S_ISBLK (stx.stx_mode) || S_ISCHR (stx.stx_mode))
-    format = format2;
-
-  statx_to_stat (&stx, &st);
-  if (stx.stx_mask & STATX_BTIME)
-    pa.btime = statx_timestamp_to_timespec (stx.stx_btime);
-
-  bool fail = print_it (format, fd, filename, print_stat, &pa);
-  return ! fail;
-}
+/* The fields for statx to get.  */
+static unsigned int statx_mask;
 
 #else /* USE_STATX */
 
@@ -1409,45 +1433,274 @@ get_birthtime (int fd, char const *filename, struct stat const *st)
 
   return ts;
 }
+#endif /* USE_STATX */
 
+/* The status of a file or its file system, as needed to print it.  */
+struct file_status
+{
+  int err;			/* The errno value upon failure, or 0.  */
+  int fd;			/* Standard input for "-", else -1.  */
+  struct stat st;
+  struct timespec btime;
+  STRUCT_STATVFS statfsbuf;	/* With --file-system.  */
+};
 
-/* stat the file and print what we find */
-static bool ATTRIBUTE_WARN_UNUSED_RESULT
-do_stat (char const *filename, char const *format,
-         char const *format2)
+/* Get the status of FILENAME into *FS, without reporting any failure,
+   so that this can be done by a helper thread.  */
+static void
+get_file_status (char const *filename, struct file_status *fs)
 {
-  int fd = STREQ (filename, "-") ? 0 : -1;
-  struct stat statbuf;
-  struct print_args pa;
-  pa.st = &statbuf;
-  pa.btime = (struct timespec) {-1, -1};
+  bool is_stdin = STREQ (filename, "-");
+  fs->err = 0;
+  fs->fd = is_stdin ? STDIN_FILENO : -1;
+  fs->btime = (struct timespec) {-1, -1};
 
-  if (0 <= fd)
+  if (stat_file_system)
     {
-      if (fstat (fd, &statbuf) != 0)
-        {
-          error (0, errno, _("cannot stat standard input"));
-          return false;
-        }
+      /* Standard input is diagnosed by print_file_status.  */
+      if (! is_stdin && STATFS (filename, &fs->statfsbuf) != 0)
+        fs->err = errno;
+      return;
+    }
+
+#if USE_STATX
+  int flags = (is_stdin ? AT_EMPTY_PATH
+               : follow_links ? 0 : AT_SYMLINK_NOFOLLOW);
+  struct statx stx = { 0, };
+
+  if (dont_sync)
+    flags |= AT_STATX_DONT_SYNC;
+  else if (force_sync)
+    flags |= AT_STATX_FORCE_SYNC;
+
+  if (statx (is_stdin ? STDIN_FILENO : AT_FDCWD, is_stdin ? "" : filename,
+             flags, statx_mask, &stx) != 0)
+    {
+      fs->err = errno;
+      return;
     }
+
+  statx_to_stat (&stx, &fs->st);
+  if (stx.stx_mask & STATX_BTIME)
+    fs->btime = statx_timestamp_to_timespec (stx.stx_btime);
+#else
   /* We can't use the shorter
      (follow_links?stat:lstat) (filename, &statbug)
      since stat might be a function-like macro.  */
-  else if ((follow_links
-            ? stat (filename, &statbuf)
-            : lstat (filename, &statbuf)) != 0)
+  if ((is_stdin ? fstat (STDIN_FILENO, &fs->st)
+       : follow_links ? stat (filename, &fs->st)
+       : lstat (filename, &fs->st)) != 0)
+    fs->err = errno;
+#endif
+}
+
+/* Print the status FS of FILENAME as specified by FORMAT, or by FORMAT2
+   for a device, or diagnose why it could not be got.
+   Return true if successful.  */
+static bool ATTRIBUTE_WARN_UNUSED_RESULT
+print_file_status (char const *filename, struct file_status *fs,
+                   struct format const *format,
+                   struct format const *format2)
+{
+  if (stat_file_system)
+    {
+      if (0 <= fs->fd)
+        {
+          error (0, 0, _("using %s to denote standard input does not work"
+                         " in file system mode"), quoteaf (filename));
+          return false;
+        }
+
+      if (fs->err)
+        {
+          error (0, fs->err,
+                 _("cannot read file system information for %s"),
+                 quoteaf (filename));
+          return false;
+        }
+
+      bool fail = print_it (format, -1, filename, print_statfs,
+                            &fs->statfsbuf);
+      return ! fail;
+    }
+
+  if (fs->err)
     {
-      error (0, errno, _("cannot stat %s"), quoteaf (filename));
+      if (0 <= fs->fd)
+        error (0, fs->err, _("cannot stat standard input"));
+      else
+#if USE_STATX
+        error (0, fs->err, _("cannot statx %s"), quoteaf (filename));
+#else
+        error (0, fs->err, _("cannot stat %s"), quoteaf (filename));
+#endif
       return false;
     }
 
-  if (S_ISBLK (statbuf.st_mode) || S_ISCHR (statbuf.st_mode))
+  if (S_ISBLK (fs->st.st_mode) || S_ISCHR (fs->st.st_mode))
     format = format2;
 
-  bool fail = print_it (format, fd, filename, print_stat, &pa);
+  struct print_args pa;
+  pa.st = &fs->st;
+  pa.btime = fs->btime;
+
+  bool fail = print_it (format, fs->fd, filename, print_stat, &pa);
   return ! fail;
 }
-#endif /* USE_STATX */
+
+/* Stat FILENAME, or its file system, and print what we find.  */
+static bool ATTRIBUTE_WARN_UNUSED_RESULT
+do_stat (char const *filename, struct format const *format,
+         struct format const *format2)
+{
+  struct file_status fs;
+  get_file_status (filename, &fs);
+  return print_file_status (filename, &fs, format, format2);
+}
+
+/* With --parallel, helper threads get the status of the files ahead
+   of the main thread, which prints them in order.  */
+
+/* The number of files queued per thread.  */
+enum { JOBS_PER_THREAD = 64 };
+
+/* A file whose status is to be got by a helper thread.  */
+struct stat_job
+{
+  char *filename;
+  bool done;
+  struct file_status status;
+};
+
+/* The jobs queued by the main thread, indexed by a count of jobs
+   modulo N_RING.  */
+static struct stat_job *ring;
+static size_t n_ring;
+static uintmax_t jobs_queued;	/* The number of jobs queued.  */
+static uintmax_t jobs_taken;	/* The number of those taken by a thread.  */
+static uintmax_t jobs_reported;	/* The number of those printed.  */
+static bool jobs_finished;	/* Whether all jobs have been queued.  */
+static pthread_t *threads;
+static size_t n_threads;
+
+/* Protects the above.  JOBS_COND is signaled when a job is queued,
+   and DONE_COND when one is done.  */
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+/* Get the status of the queued files, until all have been queued.  */
+static void *
+stat_jobs (void *arg _GL_UNUSED)
+{
+  pthread_mutex_lock (&jobs_lock);
+  while (true)
+    {
+      if (jobs_taken < jobs_queued)
+        {
+          struct stat_job *job = &ring[jobs_taken++ % n_ring];
+          pthread_mutex_unlock (&jobs_lock);
+
+          get_file_status (job->filename, &job->status);
+
+          pthread_mutex_lock (&jobs_lock);
+          job->done = true;
+          pthread_cond_signal (&done_cond);
+        }
+      else if (jobs_finished)
+        break;
+      else
+        pthread_cond_wait (&jobs_cond, &jobs_lock);
+    }
+  pthread_mutex_unlock (&jobs_lock);
+
+  return NULL;
+}
+
+/* Start up to N helper threads.  Make do with fewer threads if some
+   cannot be created, and return the number started.  */
+static size_t
+start_stat_jobs (size_t n)
+{
+  n_ring = n * JOBS_PER_THREAD;
+  ring = xnmalloc (n_ring, sizeof *ring);
+  threads = xnmalloc (n, sizeof *threads);
+  while (n_threads < n
+         && pthread_create (&threads[n_threads], NULL, stat_jobs, NULL) == 0)
+    n_threads++;
+  return n_threads;
+}
+
+/* Wait for the oldest queued job to be done, then print it.
+   Return true if successful.  */
+static bool
+report_job (struct format const *format, struct format const *format2)
+{
+  struct stat_job *job = &ring[jobs_reported % n_ring];
+
+  pthread_mutex_lock (&jobs_lock);
+  while (! job->done)
+    pthread_cond_wait (&done_cond, &jobs_lock);
+  pthread_mutex_unlock (&jobs_lock);
+
+  bool ok = print_file_status (job->filename, &job->status, format, format2);
+  free (job->filename);
+  jobs_reported++;
+  return ok;
+}
+
+/* Print the queued jobs, so that a diagnostic can be output after them.
+   Return true if successful.  */
+static bool
+flush_stat_jobs (struct format const *format, struct format const *format2)
+{
+  bool ok = true;
+  while (jobs_reported < jobs_queued)
+    ok &= report_job (format, format2);
+  return ok;
+}
+
+/* Queue FILENAME to be statted by a helper thread, first printing the
+   oldest job if the queue is full.  Return false if that failed.  */
+static bool
+queue_stat_job (char const *filename, struct format const *format,
+                struct format const *format2)
+{
+  bool ok = true;
+  if (jobs_queued - jobs_reported == n_ring)
+    ok = report_job (format, format2);
+
+  struct stat_job *job = &ring[jobs_queued % n_ring];
+  job->filename = xstrdup (filename);
+  job->done = false;
+
+  pthread_mutex_lock (&jobs_lock);
+  jobs_queued++;
+  pthread_cond_signal (&jobs_cond);
+  pthread_mutex_unlock (&jobs_lock);
+
+  return ok;
+}
+
+/* Print the queued jobs, then stop the threads.
+   Return true if successful.  */
+static bool
+finish_stat_jobs (struct format const *format, struct format const *format2)
+{
+  bool ok = flush_stat_jobs (format, format2);
+
+  pthread_mutex_lock (&jobs_lock);
+  jobs_finished = true;
+  pthread_cond_broadcast (&jobs_cond);
+  pthread_mutex_unlock (&jobs_lock);
+
+  for (size_t i = 0; i < n_threads; i++)
+    pthread_join (threads[i], NULL);
+
+  free (threads);
+  free (ring);
+  return ok;
+}
 
 
 /* Print stat info.  Return zero upon success, nonzero upon failure.  */
@@ -1458,8 +1711,7 @@ print_stat (char *pformat, size_t prefix_len, unsigned int m,
   struct print_args *parg = (struct print_args *) data;
   struct stat *statbuf = parg->st;
   struct timespec btime = parg->btime;
-  struct passwd *pw_ent;
-  struct group *gw_ent;
+  char const *name;
   bool fail = false;
 
   switch (m)
@@ -1511,17 +1763,15 @@ print_stat (char *pformat, size_t prefix_len, unsigned int m,
       out_uint (pformat, prefix_len, statbuf->st_uid);
       break;
     case 'U':
-      pw_ent = getpwuid (statbuf->st_uid);
-      out_string (pformat, prefix_len,
-                  pw_ent ? pw_ent->pw_name : "UNKNOWN");
+      name = getuser (statbuf->st_uid);
+      out_string (pformat, prefix_len, name ? name : "UNKNOWN");
       break;
     case 'g':
       out_uint (pformat, prefix_len, statbuf->st_gid);
       break;
     case 'G':
-      gw_ent = getgrgid (statbuf->st_gid);
-      out_string (pformat, prefix_len,
-                  gw_ent ? gw_ent->gr_name : "UNKNOWN");
+      name = getgroup (statbuf->st_gid);
+      out_string (pformat, prefix_len, name ? name : "UNKNOWN");
       break;
     case 'm':
       fail |= out_mount_point (filename, pformat, prefix_len, statbuf);
@@ -1688,7 +1938,10 @@ usage (int status)
     emit_try_help ();
   else
     {
-      printf (_("Usage: %s [OPTION]... FILE...\n"), program_name);
+      printf (_("\
+Usage: %s [OPTION]... FILE...\n\
+  or:  %s [OPTION]... --files0-from=F\n\
+"), program_name, program_name);
       fputs (_("\
 Display file or file system status.\n\
 "), stdout);
@@ -1706,6 +1959,10 @@ Display file or file system status.\n\
       fputs (_("\
   -c  --format=FORMAT   use the specified FORMAT instead of the default;\n\
                           output a newline after each use of FORMAT\n\
+      --files0-from=F   display the status of the NUL-terminated file names\n\
+                          specified in file F;\n\
+                          if F is -, then read names from standard input\n\
+      --parallel=N      get the status of up to N files at once\n\
       --printf=FORMAT   like --format, but interpret backslash escapes,\n\
                           and do not output a mandatory trailing newline;\n\
                           if you want a newline, include \\n in FORMAT\n\
@@ -1808,10 +2065,11 @@ int
 main (int argc, char *argv[])
 {
   int c;
-  bool fs = false;
   bool terse = false;
   char *format = NULL;
   char *format2;
+  char const *files_from = NULL;
+  size_t n_jobs = 1;
   bool ok = true;
 
   initialize_main (&argc, &argv);
@@ -1847,13 +2105,22 @@ main (int argc, char *argv[])
           break;
 
         case 'f':
-          fs = true;
+          stat_file_system = true;
           break;
 
         case 't':
           terse = true;
           break;
 
+        case FILES0_FROM_OPTION:
+          files_from = optarg;
+          break;
+
+        case PARALLEL_OPTION:
+          n_jobs = xdectoumax (optarg, 1, SIZE_MAX / JOBS_PER_THREAD, "",
+                               _("invalid number of threads"), 0);
+          break;
+
         case 0:
           switch (XARGMATCH ("--cached", optarg, cached_args, cached_modes))
             {
@@ -1880,12 +2147,44 @@ main (int argc, char *argv[])
         }
     }
 
-  if (argc == optind)
+  struct argv_iterator *ai;
+  FILE *files_stream = NULL;
+  if (files_from)
     {
-      error (0, 0, _("missing operand"));
-      usage (EXIT_FAILURE);
+      /* When using --files0-from=F, you may not specify any files
+         on the command-line.  */
+      if (optind < argc)
+        {
+          error (0, 0, _("extra operand %s"), quote (argv[optind]));
+          fprintf (stderr, "%s\n",
+                   _("file operands cannot be combined with --files0-from"));
+          usage (EXIT_FAILURE);
+        }
+
+      /* Open F rather than reopening standard input on it,
+         so that a file name of "-" in F still denotes standard input.  */
+      files_stream = (STREQ (files_from, "-") ? stdin
+                      : fopen (files_from, "r"));
+      if (! files_stream)
+        die (EXIT_FAILURE, errno, _("cannot open %s for reading"),
+             quoteaf (files_from));
+
+      ai = argv_iter_init_stream (files_stream);
+    }
+  else
+    {
+      if (argc == optind)
+        {
+          error (0, 0, _("missing operand"));
+          usage (EXIT_FAILURE);
+        }
+
+      ai = argv_iter_init_argv (argv + optind);
     }
 
+  if (!ai)
+    xalloc_die ();
+
   if (format)
     {
       if (strstr (format, "%N"))
@@ -1894,14 +2193,81 @@ main (int argc, char *argv[])
     }
   else
     {
-      format = default_format (fs, terse, /* device= */ false);
-      format2 = default_format (fs, terse, /* device= */ true);
+      format = default_format (stat_file_system, terse, /* device= */ false);
+      format2 = default_format (stat_file_system, terse, /* device= */ true);
+    }
+
+#if USE_STATX
+  statx_mask = format_to_mask (format);
+#endif
+
+  struct format *compiled = compile_format (format);
+  struct format *compiled2 = (format2 == format ? compiled
+                              : compile_format (format2));
+
+  if (1 < n_jobs)
+    start_stat_jobs (n_jobs);
+
+  while (true)
+    {
+      enum argv_iter_err ai_err;
+      char *file_name = argv_iter (ai, &ai_err);
+      if (!file_name)
+        {
+          switch (ai_err)
+            {
+            case AI_ERR_EOF:
+              goto argv_iter_done;
+            case AI_ERR_READ:
+              if (n_threads)
+                ok &= flush_stat_jobs (compiled, compiled2);
+              error (0, errno, _("%s: read error"), quotef (files_from));
+              ok = false;
+              goto argv_iter_done;
+            case AI_ERR_MEM:
+              xalloc_die ();
+            default:
+              assert (!"unexpected error code from argv_iter");
+            }
+        }
+
+      if (files_from && ((STREQ (files_from, "-") && STREQ (file_name, "-"))
+                         || !file_name[0]))
+        {
+          if (n_threads)
+            ok &= flush_stat_jobs (compiled, compiled2);
+          if (file_name[0])
+            {
+              /* Give a better diagnostic in an unusual case:
+                 printf - | stat --files0-from=- */
+              error (0, 0, _("when reading file names from stdin, "
+                             "no file name of %s allowed"),
+                     quoteaf (file_name));
+            }
+          else
+            {
+              /* Diagnose a zero-length file name.  When it's one
+                 among many, knowing the record number may help.  */
+              unsigned long int file_number = argv_iter_n_args (ai);
+              error (0, 0, "%s:%lu: %s", quotef (files_from),
+                     file_number, _("invalid zero-length file name"));
+            }
+          ok = false;
+        }
+      else if (n_threads)
+        ok &= queue_stat_job (file_name, compiled, compiled2);
+      else
+        ok &= do_stat (file_name, compiled, compiled2);
     }
+ argv_iter_done:
+
+  if (n_threads)
+    ok &= finish_stat_jobs (compiled, compiled2);
+  argv_iter_free (ai);
 
-  for (int i = optind; i < argc; i++)
-    ok &= (fs
-           ? do_statfs (argv[i], format)
-           : do_stat (argv[i], format, format2));
+  if (files_from && (ferror (files_stream) || fclose (files_stream) != 0)
+      && ok)
+    die (EXIT_FAILURE, 0, _("error reading %s"), quoteaf (files_from));
 
   return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -42,10 +42,14 @@ tac -r -s '.\|
 #include "system.h"
 
 #include <regex.h>
+#if HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 
 #include "die.h"
 #include "error.h"
 #include "filenamecat.h"
+#include "physmem.h"
 #include "safe-read.h"
 #include "stdlib--.h"
 #include "xbinary-io.h"
@@ -76,6 +80,23 @@ tac -r -s '.\|
 /* The number of bytes per atomic write. */
 #define WRITESIZE 8192
 
+/* The number of records to output with one writev call.  */
+#if defined IOV_MAX && IOV_MAX < 1024
+# define IOV_BATCH IOV_MAX
+#else
+# define IOV_BATCH 1024
+#endif
+
+/* Records shorter than this are copied into a staging buffer of
+   STAGE_SIZE bytes, as writing many short iovecs is slower than
+   copying them.  */
+#define MIN_IOV_RECORD 512
+#define STAGE_SIZE (128 * 1024)
+
+/* The least number of bytes of input to hold in memory, rather than
+   in a temporary file or reading it backward in blocks.  */
+#define MIN_MEMORY_BUDGET (8 * 1024 * 1024)
+
 /* The string that separates the records of the file. */
 static char const *separator;
 
@@ -185,6 +206,205 @@ output (const char *start, const char *past_end)
   bytes_in_buffer += bytes_to_add;
 }
 
+#if HAVE_SYS_UIO_H
+
+/* Records queued for output by 'output_record'.  */
+static struct iovec iov[IOV_BATCH];
+static int iov_count;
+
+/* Copies of short records queued for output.  */
+static char stage[STAGE_SIZE];
+static size_t staged;
+
+/* Write the queued records.  */
+
+static void
+flush_records (void)
+{
+  struct iovec *v = iov;
+  int n = iov_count;
+
+  while (n)
+    {
+      ssize_t written = writev (STDOUT_FILENO, v, n);
+      if (written <= 0)
+        {
+          if (written < 0 && errno == EINTR)
+            continue;
+          die (EXIT_FAILURE, written < 0 ? errno : ENOSPC, _("write error"));
+        }
+      size_t w = written;
+      for (; n && v->iov_len <= w; v++, n--)
+        w -= v->iov_len;
+      if (n)
+        {
+          v->iov_base = (char *) v->iov_base + w;
+          v->iov_len -= w;
+        }
+    }
+
+  iov_count = 0;
+  staged = 0;
+}
+#endif
+
+/* Print the record from START to PAST_END - 1, which stays in place
+   until 'flush_records' is called.  Where possible, the record is not
+   copied, but queued to be written with others in one system call.  */
+
+static void
+output_record (char const *start, char const *past_end)
+{
+#if HAVE_SYS_UIO_H
+  size_t len = past_end - start;
+  if (len == 0)
+    return;
+  if (iov_count == IOV_BATCH)
+    flush_records ();
+
+  if (len < MIN_IOV_RECORD)
+    {
+      if (STAGE_SIZE - staged < len)
+        flush_records ();
+      char *copy = stage + staged;
+      memcpy (copy, start, len);
+      staged += len;
+      if (iov_count
+          && (char *) iov[iov_count - 1].iov_base
+             + iov[iov_count - 1].iov_len == copy)
+        {
+          iov[iov_count - 1].iov_len += len;
+          return;
+        }
+      start = copy;
+    }
+
+  iov[iov_count].iov_base = (char *) start;
+  iov[iov_count].iov_len = len;
+  iov_count++;
+#else
+  output (start, past_end);
+#endif
+}
+
+/* Print in reverse the SIZE bytes at BUF, which are all of the input,
+   when the separator is a fixed string.  Search backward for the first
+   byte of the separator with memrchr, and output the records straight
+   from BUF.  */
+
+static void
+tac_mem (char const *buf, size_t size)
+{
+  char first_char = *separator;
+  char const *separator1 = separator + 1;
+  size_t match_length1 = match_length - 1;
+  bool first_time = true;
+
+  /* The end of the record not yet printed, and the end of the bytes
+     in which the next separator may start.  */
+  size_t past_end = size;
+  size_t search_end = size < match_length1 ? 0 : size - match_length1;
+
+  /* Flush any output buffered by 'output' for earlier files, as records
+     are written directly to the standard output.  */
+#if HAVE_SYS_UIO_H
+  output (NULL, NULL);
+  if (fflush (stdout) != 0)
+    die (EXIT_FAILURE, errno, _("write error"));
+#endif
+
+  while (true)
+    {
+      char const *match = memrchr (buf, first_char, search_end);
+      if (! match)
+        break;
+      size_t match_start = match - buf;
+      if (match_length1 && !STREQ_LEN (match + 1, separator1, match_length1))
+        {
+          search_end = match_start;
+          continue;
+        }
+
+      if (separator_ends_record)
+        {
+          size_t match_end = match_start + match_length;
+          if (!first_time || match_end != past_end)
+            output_record (buf + match_end, buf + past_end);
+          past_end = match_end;
+          first_time = false;
+        }
+      else
+        {
+          output_record (buf + match_start, buf + past_end);
+          past_end = match_start;
+        }
+
+      search_end = (match_start < match_length1
+                    ? 0 : match_start - match_length1);
+    }
+
+  output_record (buf, buf + past_end);
+#if HAVE_SYS_UIO_H
+  flush_records ();
+#endif
+}
+
+/* Return the number of bytes of input to hold in memory.  Like sort's
+   default buffer size, this is the available memory or one eighth of
+   total memory, whichever is greater.  */
+
+static size_t
+memory_budget (void)
+{
+  static size_t budget;
+  if (! budget)
+    {
+      double avail = physmem_available ();
+      double total = physmem_total ();
+      double mem = MAX (avail, total / 8);
+      budget = (mem < MIN_MEMORY_BUDGET ? MIN_MEMORY_BUDGET
+                : mem < SIZE_MAX / 2 ? mem : SIZE_MAX / 2);
+    }
+  return budget;
+}
+
+/* If the FILE_SIZE bytes of the seekable file open on INPUT_FD for
+   reading FILE fit in memory, read them and print them in reverse,
+   and return true, setting *OK to whether this was successful.
+   The file is read rather than mapped, so that if another process
+   truncates it meanwhile, tac does not die of SIGBUS.  */
+
+static bool
+tac_in_memory (int input_fd, const char *file, off_t file_size, bool *ok)
+{
+  if (! (sentinel_length && 0 < file_size && file_size <= memory_budget ()
+         && lseek (input_fd, 0, SEEK_SET) == 0))
+    return false;
+
+  size_t size = file_size;
+  char *buf = xmalloc (size);
+  size_t n_read = 0;
+  *ok = true;
+  while (n_read < size)
+    {
+      size_t nr = safe_read (input_fd, buf + n_read, size - n_read);
+      if (nr == SAFE_READ_ERROR)
+        {
+          error (0, errno, _("%s: read error"), quotef (file));
+          *ok = false;
+          break;
+        }
+      if (nr == 0)
+        break;
+      n_read += nr;
+    }
+
+  if (*ok)
+    tac_mem (buf, n_read);
+  free (buf);
+  return true;
+}
+
 /* Print in reverse the file open on descriptor FD for reading FILE.
    The file is already positioned at FILE_POS, which should be near its end.
    Return true if successful.  */
@@ -210,6 +430,10 @@ tac_seekable (int input_fd, const char *file, off_t file_pos)
   char const *separator1 = separator + 1; /* Speed optimization, non-regexp. */
   size_t match_length1 = match_length - 1; /* Speed optimization, non-regexp. */
 
+  bool ok;
+  if (tac_in_memory (input_fd, file, file_pos, &ok))
+    return ok;
+
   /* Arrange for the first read to lop off enough to leave the rest of the
      file a multiple of 'read_size'.  Since 'read_size' can change, this may
      not always hold during the program run, but since it usually will, leave
@@ -492,19 +716,28 @@ temp_stream (FILE **fp, char **file_name)
   return true;
 }
 
-/* Copy from file descriptor INPUT_FD (corresponding to the named FILE) to
-   a temporary file, and set *G_TMP and *G_TEMPFILE to the resulting stream
-   and file name.  Return the number of bytes copied, or -1 on error.  */
+/* Copy the N_READ bytes already read into BUF, then the rest of the
+   data from file descriptor INPUT_FD (corresponding to the named FILE),
+   to a temporary file, and set *G_TMP and *G_TEMPFILE to the resulting
+   stream and file name.  Return the number of bytes copied, or -1 on
+   error.  */
 
 static off_t
-copy_to_temp (FILE **g_tmp, char **g_tempfile, int input_fd, char const *file)
+copy_to_temp (FILE **g_tmp, char **g_tempfile, int input_fd, char const *file,
+              char const *buf, size_t n_read)
 {
   FILE *fp;
   char *file_name;
-  uintmax_t bytes_copied = 0;
+  uintmax_t bytes_copied = n_read;
   if (!temp_stream (&fp, &file_name))
     return -1;
 
+  if (fwrite (buf, 1, n_read, fp) != n_read)
+    {
+      error (0, errno, _("%s: write error"), quotef (file_name));
+      return -1;
+    }
+
   while (1)
     {
       size_t bytes_read = safe_read (input_fd, G_buffer, read_size);
@@ -539,7 +772,8 @@ copy_to_temp (FILE **g_tmp, char **g_tempfile, int input_fd, char const *file)
   return bytes_copied;
 }
 
-/* Copy INPUT_FD to a temporary, then tac that file.
+/* Read INPUT_FD into memory and tac it from there, or if it is larger
+   than the memory budget, copy it to a temporary, then tac that file.
    Return true if successful.  */
 
 static bool
@@ -547,7 +781,45 @@ tac_nonseekable (int input_fd, const char *file)
 {
   FILE *tmp_stream;
   char *tmp_file;
-  off_t bytes_copied = copy_to_temp (&tmp_stream, &tmp_file, input_fd, file);
+  char *buf = NULL;
+  size_t n_read = 0;
+
+  /* Regular expressions are searched for only in 'G_buffer'.  */
+  if (sentinel_length)
+    {
+      size_t budget = memory_budget ();
+
+      size_t bufsize = read_size;
+      buf = xmalloc (bufsize);
+      while (true)
+        {
+          if (n_read == bufsize)
+            {
+              if (budget <= bufsize)
+                break;
+              bufsize = MIN (bufsize * 2, budget);
+              buf = xrealloc (buf, bufsize);
+            }
+          size_t nr = safe_read (input_fd, buf + n_read, bufsize - n_read);
+          if (nr == SAFE_READ_ERROR)
+            {
+              error (0, errno, _("%s: read error"), quotef (file));
+              free (buf);
+              return false;
+            }
+          if (nr == 0)
+            {
+              tac_mem (buf, n_read);
+              free (buf);
+              return true;
+            }
+          n_read += nr;
+        }
+    }
+
+  off_t bytes_copied = copy_to_temp (&tmp_stream, &tmp_file, input_fd, file,
+                                     buf, n_read);
+  free (buf);
   if (bytes_copied < 0)
     return false;
 
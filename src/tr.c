@@ -27,6 +27,7 @@
 #include "die.h"
 #include "error.h"
 #include "fadvise.h"
+#include "ioblksize.h"
 #include "quote.h"
 #include "safe-read.h"
 #include "xbinary-io.h"
@@ -241,7 +242,7 @@ static bool truncate_set1 = false;
    It is set in main and used there and in validate().  */
 static bool translating;
 
-static char io_buf[BUFSIZ];
+static char io_buf[IO_BUFSIZE];
 
 static char const *const char_class_name[] =
 {
@@ -1510,6 +1511,306 @@ validate (struct Spec_list *s1, struct Spec_list *s2)
     }
 }
 
+/* Vectorized kernels.  Once validate and set_initialize have built the
+   lookup tables above, each table is examined to see whether it has a
+   shape that can be applied 16 bytes at a time: a translation that is
+   the identity except for a few ranges shifted by a constant (as with
+   case mapping or rot13), or a set whose membership can be decided by
+   two nibble-indexed shuffles (as with '\r', [:digit:] or [:space:]).
+   If not, or if the CPU lacks SSSE3, the table-driven loops are used.  */
+
+#if defined __x86_64__ && (4 < __GNUC__ + (9 <= __GNUC_MINOR__) \
+                           || defined __clang__)
+# define USE_SSSE3_KERNELS 1
+# include <tmmintrin.h>
+# define SSSE3_TARGET __attribute__ ((__target__ ("ssse3")))
+#else
+# define USE_SSSE3_KERNELS 0
+#endif
+
+/* When true, use the corresponding vectorized kernel.  */
+static bool xlate_kernel;
+static bool delete_kernel;
+static bool squeeze_kernel;
+
+#if USE_SSSE3_KERNELS
+
+/* The maximum number of shifted ranges the translation kernel handles.
+   Each range costs a handful of vector instructions per 16 bytes, so
+   beyond this the table lookup is as fast.  */
+enum { XLATE_RANGES_MAX = 4 };
+
+/* Characters FIRST through FIRST + SPAN are translated by adding DELTA
+   (modulo N_CHARS); all other characters are left alone.  */
+struct xlate_range
+{
+  unsigned char first;
+  unsigned char span;
+  unsigned char delta;
+};
+
+static struct xlate_range xlate_ranges[XLATE_RANGES_MAX];
+static int n_xlate_ranges;
+
+/* A character set in a form suitable for vector lookup: C is a member
+   if and only if (LO[C & 0xf] & HI[C >> 4]) != 0.  Each of the 16 rows
+   of the set (the characters sharing a high nibble) is assigned one
+   bit, so this works only for sets with at most 8 distinct rows.  */
+struct nibble_set
+{
+  unsigned char lo[16];
+  unsigned char hi[16];
+};
+
+static struct nibble_set delete_nibbles;
+static struct nibble_set squeeze_nibbles;
+
+/* For each 8-bit mask of deleted bytes, the shuffle that moves the
+   kept bytes of an 8-byte group to its start, and the number kept.  */
+static unsigned char compress_shuffle[256][8];
+static unsigned char compress_kept[256];
+
+/* Return true if the vectorized kernels can be used on this CPU.  */
+static bool
+ssse3_supported (void)
+{
+  return __builtin_cpu_supports ("ssse3");
+}
+
+/* Store in *NS the nibble form of the set IN_SET.
+   Return false if IN_SET has too many distinct rows.  */
+static bool
+nibble_set_init (struct nibble_set *ns, bool const *in_set)
+{
+  unsigned int rows[8];
+  int n_rows = 0;
+
+  memset (ns, 0, sizeof *ns);
+  for (int h = 0; h < 16; h++)
+    {
+      unsigned int row = 0;
+      for (int l = 0; l < 16; l++)
+        row |= (unsigned int) in_set[h << 4 | l] << l;
+      if (row == 0)
+        continue;
+
+      int k;
+      for (k = 0; k < n_rows && rows[k] != row; k++)
+        continue;
+      if (k == n_rows)
+        {
+          if (n_rows == 8)
+            return false;
+          rows[n_rows++] = row;
+          for (int l = 0; l < 16; l++)
+            if (row & (1u << l))
+              ns->lo[l] |= 1u << k;
+        }
+      ns->hi[h] = 1u << k;
+    }
+  return true;
+}
+
+/* Return a mask with all bits set in each byte of X that is
+   not a member of the set whose nibble tables are LO and HI.  */
+SSSE3_TARGET static inline __m128i
+nibble_nonmembers (__m128i x, __m128i lo, __m128i hi)
+{
+  __m128i low_nibbles = _mm_set1_epi8 (0x0f);
+  __m128i l = _mm_and_si128 (x, low_nibbles);
+  __m128i h = _mm_and_si128 (_mm_srli_epi16 (x, 4), low_nibbles);
+  __m128i r = _mm_and_si128 (_mm_shuffle_epi8 (lo, l),
+                             _mm_shuffle_epi8 (hi, h));
+  return _mm_cmpeq_epi8 (r, _mm_setzero_si128 ());
+}
+
+/* Translate the N bytes in BUF in place, using xlate_ranges.  */
+SSSE3_TARGET static void
+xlate_ssse3 (char *buf, size_t n)
+{
+  __m128i first[XLATE_RANGES_MAX];
+  __m128i span[XLATE_RANGES_MAX];
+  __m128i delta[XLATE_RANGES_MAX];
+  int n_ranges = n_xlate_ranges;
+  size_t i;
+
+  if (n_ranges == 0)
+    return;
+
+  for (int r = 0; r < n_ranges; r++)
+    {
+      first[r] = _mm_set1_epi8 (xlate_ranges[r].first);
+      span[r] = _mm_set1_epi8 (xlate_ranges[r].span);
+      delta[r] = _mm_set1_epi8 (xlate_ranges[r].delta);
+    }
+
+  for (i = 0; i + 16 <= n; i += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((void const *) (buf + i));
+      __m128i y = x;
+      for (int r = 0; r < n_ranges; r++)
+        {
+          /* X - FIRST <= SPAN, as unsigned bytes.  */
+          __m128i t = _mm_sub_epi8 (x, first[r]);
+          __m128i in_range = _mm_cmpeq_epi8 (_mm_min_epu8 (t, span[r]), t);
+          y = _mm_add_epi8 (y, _mm_and_si128 (in_range, delta[r]));
+        }
+      _mm_storeu_si128 ((void *) (buf + i), y);
+    }
+
+  for (; i < n; i++)
+    buf[i] = xlate[to_uchar (buf[i])];
+}
+
+/* Remove from the NR bytes in BUF those in the delete set,
+   and return the number of bytes kept.  */
+SSSE3_TARGET static size_t
+delete_ssse3 (char *buf, size_t nr)
+{
+  __m128i lo = _mm_loadu_si128 ((void const *) delete_nibbles.lo);
+  __m128i hi = _mm_loadu_si128 ((void const *) delete_nibbles.hi);
+  __m128i eight = _mm_set1_epi8 (8);
+  size_t n_saved = 0;
+  size_t i;
+
+  /* Stores never reach past BUF + I + 16, and the 16 bytes there
+     have already been loaded, so compacting in place is safe.  */
+  for (i = 0; i + 16 <= nr; i += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((void const *) (buf + i));
+      unsigned int deleted = ~_mm_movemask_epi8 (nibble_nonmembers (x, lo, hi))
+                             & 0xffff;
+      if (deleted == 0)
+        {
+          if (n_saved != i)
+            _mm_storeu_si128 ((void *) (buf + n_saved), x);
+          n_saved += 16;
+        }
+      else if (deleted != 0xffff)
+        {
+          unsigned int d_lo = deleted & 0xff;
+          unsigned int d_hi = deleted >> 8;
+          __m128i s_lo = _mm_loadl_epi64 ((void const *)
+                                          compress_shuffle[d_lo]);
+          __m128i s_hi = _mm_loadl_epi64 ((void const *)
+                                          compress_shuffle[d_hi]);
+          _mm_storel_epi64 ((void *) (buf + n_saved),
+                            _mm_shuffle_epi8 (x, s_lo));
+          n_saved += compress_kept[d_lo];
+          _mm_storel_epi64 ((void *) (buf + n_saved),
+                            _mm_shuffle_epi8 (x, _mm_add_epi8 (s_hi, eight)));
+          n_saved += compress_kept[d_hi];
+        }
+    }
+
+  for (; i < nr; i++)
+    if (!in_delete_set[to_uchar (buf[i])])
+      buf[n_saved++] = buf[i];
+
+  return n_saved;
+}
+
+/* Return the index of the first byte at or after I in the NR bytes of
+   BUF that is in the squeeze set and is either followed by a copy of
+   itself or is the last byte of BUF.  Return NR if there is none.  */
+SSSE3_TARGET static size_t
+squeeze_find_ssse3 (char const *buf, size_t i, size_t nr)
+{
+  __m128i lo = _mm_loadu_si128 ((void const *) squeeze_nibbles.lo);
+  __m128i hi = _mm_loadu_si128 ((void const *) squeeze_nibbles.hi);
+
+  for (; i + 16 < nr; i += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((void const *) (buf + i));
+      __m128i next = _mm_loadu_si128 ((void const *) (buf + i + 1));
+      __m128i repeats = _mm_andnot_si128 (nibble_nonmembers (x, lo, hi),
+                                          _mm_cmpeq_epi8 (x, next));
+      unsigned int m = _mm_movemask_epi8 (repeats);
+      if (m)
+        return i + __builtin_ctz (m);
+    }
+
+  for (; i < nr; i++)
+    if (in_squeeze_set[to_uchar (buf[i])]
+        && (i + 1 == nr || buf[i + 1] == buf[i]))
+      return i;
+
+  return nr;
+}
+
+/* Decide whether the translation table xlate can be applied by
+   xlate_ssse3, and if so, set up xlate_ranges.  */
+static void
+init_xlate_kernel (void)
+{
+  int n_ranges = 0;
+
+  if (!ssse3_supported ())
+    return;
+
+  for (int i = 0; i < N_CHARS; i++)
+    {
+      unsigned char delta = to_uchar (xlate[i]) - i;
+      if (delta == 0)
+        continue;
+      struct xlate_range *r = n_ranges ? &xlate_ranges[n_ranges - 1] : NULL;
+      if (r && r->first + r->span + 1 == i && r->delta == delta)
+        r->span++;
+      else
+        {
+          if (n_ranges == XLATE_RANGES_MAX)
+            return;
+          r = &xlate_ranges[n_ranges++];
+          r->first = i;
+          r->span = 0;
+          r->delta = delta;
+        }
+    }
+
+  n_xlate_ranges = n_ranges;
+  xlate_kernel = true;
+}
+
+/* Decide whether the delete set can be applied by delete_ssse3.  */
+static void
+init_delete_kernel (void)
+{
+  if (! (ssse3_supported () && nibble_set_init (&delete_nibbles,
+                                                in_delete_set)))
+    return;
+
+  for (int m = 0; m < 256; m++)
+    {
+      int kept = 0;
+      for (int b = 0; b < 8; b++)
+        if (! (m & (1 << b)))
+          compress_shuffle[m][kept++] = b;
+      compress_kept[m] = kept;
+    }
+
+  delete_kernel = true;
+}
+
+/* Decide whether the squeeze set can be searched by squeeze_find_ssse3.  */
+static void
+init_squeeze_kernel (void)
+{
+  squeeze_kernel = (ssse3_supported ()
+                    && nibble_set_init (&squeeze_nibbles, in_squeeze_set));
+}
+
+#else /* !USE_SSSE3_KERNELS */
+
+/* The kernels are never selected, so these are never called.  */
+static void init_xlate_kernel (void) { }
+static void init_delete_kernel (void) { }
+static void init_squeeze_kernel (void) { }
+# define xlate_ssse3(buf, n) abort ()
+# define delete_ssse3(buf, nr) (abort (), 0)
+# define squeeze_find_ssse3(buf, i, nr) (abort (), 0)
+
+#endif
+
 /* Read buffers of SIZE bytes via the function READER (if READER is
    NULL, read from stdin) until EOF.  When non-NULL, READER is either
    read_and_delete or read_and_xlate.  After each buffer is read, it is
@@ -1544,25 +1845,30 @@ squeeze_filter (char *buf, size_t size, size_t (*reader) (char *, size_t))
       if (char_to_squeeze == NOT_A_CHAR)
         {
           size_t out_len;
-          /* Here, by being a little tricky, we can get a significant
-             performance increase in most cases when the input is
-             reasonably large.  Since tr will modify the input only
-             if two consecutive (and identical) input characters are
-             in the squeeze set, we can step by two through the data
-             when searching for a character in the squeeze set.  This
-             means there may be a little more work in a few cases and
-             perhaps twice as much work in the worst cases where most
-             of the input is removed by squeezing repeats.  But most
-             uses of this functionality seem to remove less than 20-30%
-             of the input.  */
-          for (; i < nr && !in_squeeze_set[to_uchar (buf[i])]; i += 2)
-            continue;
-
-          /* There is a special case when i == nr and we've just
-             skipped a character (the last one in buf) that is in
-             the squeeze set.  */
-          if (i == nr && in_squeeze_set[to_uchar (buf[i - 1])])
-            --i;
+          if (squeeze_kernel)
+            i = squeeze_find_ssse3 (buf, i, nr);
+          else
+            {
+              /* Here, by being a little tricky, we can get a significant
+                 performance increase in most cases when the input is
+                 reasonably large.  Since tr will modify the input only
+                 if two consecutive (and identical) input characters are
+                 in the squeeze set, we can step by two through the data
+                 when searching for a character in the squeeze set.  This
+                 means there may be a little more work in a few cases and
+                 perhaps twice as much work in the worst cases where most
+                 of the input is removed by squeezing repeats.  But most
+                 uses of this functionality seem to remove less than
+                 20-30% of the input.  */
+              for (; i < nr && !in_squeeze_set[to_uchar (buf[i])]; i += 2)
+                continue;
+
+              /* There is a special case when i == nr and we've just
+                 skipped a character (the last one in buf) that is in
+                 the squeeze set.  */
+              if (i == nr && in_squeeze_set[to_uchar (buf[i - 1])])
+                --i;
+            }
 
           if (i >= nr)
             out_len = nr - begin;
@@ -1633,6 +1939,12 @@ read_and_delete (char *buf, size_t size)
       if (nr == 0)
         return 0;
 
+      if (delete_kernel)
+        {
+          n_saved = delete_ssse3 (buf, nr);
+          continue;
+        }
+
       /* This first loop may be a waste of code, but gives much
          better performance when no characters are deleted in
          the beginning of a buffer.  It just avoids the copying
@@ -1661,8 +1973,11 @@ read_and_xlate (char *buf, size_t size)
 {
   size_t bytes_read = plain_read (buf, size);
 
-  for (size_t i = 0; i < bytes_read; i++)
-    buf[i] = xlate[to_uchar (buf[i])];
+  if (xlate_kernel)
+    xlate_ssse3 (buf, bytes_read);
+  else
+    for (size_t i = 0; i < bytes_read; i++)
+      buf[i] = xlate[to_uchar (buf[i])];
 
   return bytes_read;
 }
@@ -1798,11 +2113,13 @@ main (int argc, char **argv)
   if (squeeze_repeats && non_option_args == 1)
     {
       set_initialize (s1, complement, in_squeeze_set);
+      init_squeeze_kernel ();
       squeeze_filter (io_buf, sizeof io_buf, plain_read);
     }
   else if (delete && non_option_args == 1)
     {
       set_initialize (s1, complement, in_delete_set);
+      init_delete_kernel ();
 
       while (true)
         {
@@ -1817,6 +2134,8 @@ main (int argc, char **argv)
     {
       set_initialize (s1, complement, in_delete_set);
       set_initialize (s2, false, in_squeeze_set);
+      init_delete_kernel ();
+      init_squeeze_kernel ();
       squeeze_filter (io_buf, sizeof io_buf, read_and_delete);
     }
   else if (translating)
@@ -1889,9 +2208,11 @@ main (int argc, char **argv)
             }
           assert (c1 == -1 || truncate_set1);
         }
+      init_xlate_kernel ();
       if (squeeze_repeats)
         {
           set_initialize (s2, false, in_squeeze_set);
+          init_squeeze_kernel ();
           squeeze_filter (io_buf, sizeof io_buf, read_and_xlate);
         }
       else
@@ -18,7 +18,8 @@
 
 /* The topological sort is done according to Algorithm T (Topological
    sort) in Donald E. Knuth, The Art of Computer Programming, Volume
-   1/Fundamental Algorithms, page 262.  */
+   1/Fundamental Algorithms, page 262, which processes a queue of the
+   items that have no remaining predecessors, as in Kahn's algorithm.  */
 
 #include <config.h>
 
@@ -30,6 +31,9 @@
 #include "die.h"
 #include "error.h"
 #include "fadvise.h"
+#include "hash.h"
+#include "hash-pjw.h"
+#include "obstack.h"
 #include "readtokens.h"
 #include "stdio--.h"
 #include "quote.h"
@@ -39,35 +43,74 @@
 
 #define AUTHORS proper_name ("Mark Kettenis")
 
+#define obstack_chunk_alloc xmalloc
+#define obstack_chunk_free free
+
 /* Token delimiters when reading from a file.  */
 #define DELIM " \t\n"
 
-/* Members of the list of successors.  */
-struct successor
+/* The initial number of items the table of items can hold.  */
+enum { INITIAL_TABLE_SIZE = 1024 };
+
+/* The state of an item in the search for a loop.  */
+enum visit
 {
-  struct item *suc;
-  struct successor *next;
+  UNVISITED,		/* Not yet searched from.  */
+  ON_PATH,		/* On the path currently being searched.  */
+  EXPLORED		/* No loop is reachable from this item.  */
 };
 
-/* Each string is held in core as the head of a list of successors.  */
+/* Each string is held in core with the array of its successors.  */
 struct item
 {
   const char *str;
-  struct item *left, *right;
-  int balance; /* -1, 0, or +1 */
-  size_t count;
-  struct item *qlink;
-  struct successor *top;
+  size_t count;			/* Predecessors not yet output.  */
+  struct item **top;		/* Successors, most recent first.  Those
+                                   removed to break a loop are NULL.  */
+  size_t n_successors;
+  size_t next_successor;	/* Next successor to search for a loop.  */
+  enum visit visit;
+};
+
+/* A relation read from the input: J precedes K.  */
+struct relation
+{
+  struct item *j;
+  struct item *k;
 };
 
-/* The head of the sorted list.  */
-static struct item *head = NULL;
+/* The strings to sort, and their items, allocated in bulk.  */
+static struct obstack arena;
+
+/* The items by string.  */
+static Hash_table *item_table;
+
+/* All items, in order of first appearance.  */
+static struct item **items;
+static size_t n_items;
+static size_t n_items_allocated;
+
+/* The relations, in input order.  */
+static struct relation *relations;
+static size_t n_relations;
+static size_t n_relations_allocated;
 
-/* The tail of the list of 'zeros', strings that have no predecessors.  */
-static struct item *zeros = NULL;
+/* The queue of items that have no predecessors left to be output.
+   Each item is queued exactly once.  */
+static struct item **queue;
+static size_t queue_head;
+static size_t queue_tail;
 
-/* Used for loop detection.  */
-static struct item *loop = NULL;
+/* The items that were not output before the first loop was found,
+   sorted by string, and the index of the first that may still be
+   searched for a loop.  */
+static struct item **remaining;
+static size_t n_remaining;
+static size_t next_remaining;
+
+/* The path of the current search for a loop.  */
+static struct item **path;
+static size_t path_len;
 
 /* The number of strings to sort.  */
 static size_t n_strings = 0;
@@ -97,173 +140,60 @@ Write totally ordered list consistent with the partial ordering in FILE.\n\
   exit (status);
 }
 
-/* Create a new item/node for STR.  */
-static struct item *
-new_item (const char *str)
+static size_t
+item_hash (void const *x, size_t table_size)
 {
-  struct item *k = xmalloc (sizeof *k);
-
-  k->str = (str ? xstrdup (str): NULL);
-  k->left = k->right = NULL;
-  k->balance = 0;
-
-  /* T1. Initialize (COUNT[k] <- 0 and TOP[k] <- ^).  */
-  k->count = 0;
-  k->qlink = NULL;
-  k->top = NULL;
+  struct item const *k = x;
+  return hash_pjw (k->str, table_size);
+}
 
-  return k;
+static bool
+item_compare (void const *x, void const *y)
+{
+  struct item const *a = x;
+  struct item const *b = y;
+  return STREQ (a->str, b->str);
 }
 
-/* Search binary tree rooted at *ROOT for STR.  Allocate a new tree if
-   *ROOT is NULL.  Insert a node/item for STR if not found.  Return
-   the node/item found/created for STR.
+static int
+compare_items (void const *x, void const *y)
+{
+  struct item const *const *a = x;
+  struct item const *const *b = y;
+  return strcmp ((*a)->str, (*b)->str);
+}
 
-   This is done according to Algorithm A (Balanced tree search and
-   insertion) in Donald E. Knuth, The Art of Computer Programming,
-   Volume 3/Searching and Sorting, pages 455--457.  */
+/* Return the item for STR, of length LEN, creating it if needed.  */
 
 static struct item *
-search_item (struct item *root, const char *str)
+search_item (const char *str, size_t len)
 {
-  struct item *p, *q, *r, *s, *t;
-  int a;
-
-  assert (root);
-
-  /* Make sure the tree is not empty, since that is what the algorithm
-     below expects.  */
-  if (root->right == NULL)
-    return (root->right = new_item (str));
-
-  /* A1. Initialize.  */
-  t = root;
-  s = p = root->right;
-
-  while (true)
+  /* Allocate the item first, so that the string is hashed only once,
+     and free it if the table already has the string.  */
+  struct item *k = obstack_alloc (&arena, sizeof *k);
+  k->str = obstack_copy0 (&arena, str, len);
+
+  struct item *found = hash_insert (item_table, k);
+  if (! found)
+    xalloc_die ();
+  if (found != k)
     {
-      /* A2. Compare.  */
-      a = strcmp (str, p->str);
-      if (a == 0)
-        return p;
-
-      /* A3 & A4.  Move left & right.  */
-      if (a < 0)
-        q = p->left;
-      else
-        q = p->right;
-
-      if (q == NULL)
-        {
-          /* A5. Insert.  */
-          q = new_item (str);
-
-          /* A3 & A4.  (continued).  */
-          if (a < 0)
-            p->left = q;
-          else
-            p->right = q;
-
-          /* A6. Adjust balance factors.  */
-          assert (!STREQ (str, s->str));
-          if (strcmp (str, s->str) < 0)
-            {
-              r = p = s->left;
-              a = -1;
-            }
-          else
-            {
-              r = p = s->right;
-              a = 1;
-            }
-
-          while (p != q)
-            {
-              assert (!STREQ (str, p->str));
-              if (strcmp (str, p->str) < 0)
-                {
-                  p->balance = -1;
-                  p = p->left;
-                }
-              else
-                {
-                  p->balance = 1;
-                  p = p->right;
-                }
-            }
-
-          /* A7. Balancing act.  */
-          if (s->balance == 0 || s->balance == -a)
-            {
-              s->balance += a;
-              return q;
-            }
-
-          if (r->balance == a)
-            {
-              /* A8. Single Rotation.  */
-              p = r;
-              if (a < 0)
-                {
-                  s->left = r->right;
-                  r->right = s;
-                }
-              else
-                {
-                  s->right = r->left;
-                  r->left = s;
-                }
-              s->balance = r->balance = 0;
-            }
-          else
-            {
-              /* A9. Double rotation.  */
-              if (a < 0)
-                {
-                  p = r->right;
-                  r->right = p->left;
-                  p->left = r;
-                  s->left = p->right;
-                  p->right = s;
-                }
-              else
-                {
-                  p = r->left;
-                  r->left = p->right;
-                  p->right = r;
-                  s->right = p->left;
-                  p->left = s;
-                }
-
-              s->balance = 0;
-              r->balance = 0;
-              if (p->balance == a)
-                s->balance = -a;
-              else if (p->balance == -a)
-                r->balance = a;
-              p->balance = 0;
-            }
-
-          /* A10. Finishing touch.  */
-          if (s == t->right)
-            t->right = p;
-          else
-            t->left = p;
+      obstack_free (&arena, k);
+      return found;
+    }
 
-          return q;
-        }
+  /* T1. Initialize (COUNT[k] <- 0 and TOP[k] <- ^).  */
+  k->count = 0;
+  k->top = NULL;
+  k->n_successors = 0;
+  k->next_successor = 0;
+  k->visit = UNVISITED;
 
-      /* A3 & A4.  (continued).  */
-      if (q->balance)
-        {
-          t = p;
-          s = q;
-        }
+  if (n_items == n_items_allocated)
+    items = X2NREALLOC (items, &n_items_allocated);
+  items[n_items++] = k;
 
-      p = q;
-    }
-
-  /* NOTREACHED */
+  return k;
 }
 
 /* Record the fact that J precedes K.  */
@@ -271,162 +201,161 @@ search_item (struct item *root, const char *str)
 static void
 record_relation (struct item *j, struct item *k)
 {
-  struct successor *p;
-
-  if (!STREQ (j->str, k->str))
+  if (j != k)
     {
       k->count++;
-      p = xmalloc (sizeof *p);
-      p->suc = k;
-      p->next = j->top;
-      j->top = p;
+      j->n_successors++;
+      if (n_relations == n_relations_allocated)
+        relations = X2NREALLOC (relations, &n_relations_allocated);
+      relations[n_relations].j = j;
+      relations[n_relations].k = k;
+      n_relations++;
     }
 }
 
-static bool
-count_items (struct item *unused _GL_UNUSED)
-{
-  n_strings++;
-  return false;
-}
+/* Build the successor arrays of all items from the relations,
+   with the successors of each item in reverse order of input.  */
 
-static bool
-scan_zeros (struct item *k)
+static void
+build_successors (void)
 {
-  /* Ignore strings that have already been printed.  */
-  if (k->count == 0 && k->str)
+  struct item **successors
+    = obstack_alloc (&arena, MAX (n_relations, 1) * sizeof *successors);
+
+  for (size_t i = 0; i < n_items; i++)
     {
-      if (head == NULL)
-        head = k;
-      else
-        zeros->qlink = k;
+      struct item *k = items[i];
+      k->top = successors;
+      successors += k->n_successors;
+      k->n_successors = 0;
+    }
 
-      zeros = k;
+  for (size_t i = n_relations; i-- > 0; )
+    {
+      struct item *j = relations[i].j;
+      j->top[j->n_successors++] = relations[i].k;
     }
 
-  return false;
+  IF_LINT (free (relations));
 }
 
-/* Try to detect the loop.  If we have detected that K is part of a
-   loop, print the loop on standard error, remove a relation to break
-   the loop, and return true.
-
-   The loop detection strategy is as follows: Realise that what we're
-   dealing with is essentially a directed graph.  If we find an item
-   that is part of a graph that contains a cycle we traverse the graph
-   in backwards direction.  In general there is no unique way to do
-   this, but that is no problem.  If we encounter an item that we have
-   encountered before, we know that we've found a cycle.  All we have
-   to do now is retrace our steps, printing out the items until we
-   encounter that item again.  (This is not necessarily the item that
-   we started from originally.)  Since the order in which the items
-   are stored in the tree is not related to the specified partial
-   ordering, we may need to walk the tree several times before the
-   loop has completely been constructed.  If the loop was found, the
-   global variable LOOP will be NULL.  */
+/* Output the items in the queue, adding to it the successors that
+   have no other predecessors left.  */
 
-static bool
-detect_loop (struct item *k)
+static void
+output_queue (void)
 {
-  if (k->count > 0)
+  while (queue_head < queue_tail)
     {
-      /* K does not have to be part of a cycle.  It is however part of
-         a graph that contains a cycle.  */
+      struct item *k = queue[queue_head++];
 
-      if (loop == NULL)
-        /* Start traversing the graph at K.  */
-        loop = k;
-      else
-        {
-          struct successor **p = &k->top;
+      /* T5. Output front of queue.  */
+      puts (k->str);
+      n_strings--;
 
-          while (*p)
-            {
-              if ((*p)->suc == loop)
-                {
-                  if (k->qlink)
-                    {
-                      /* We have found a loop.  Retrace our steps.  */
-                      while (loop)
-                        {
-                          struct item *tmp = loop->qlink;
-
-                          error (0, 0, "%s", (loop->str));
-
-                          /* Until we encounter K again.  */
-                          if (loop == k)
-                            {
-                              /* Remove relation.  */
-                              (*p)->suc->count--;
-                              *p = (*p)->next;
-                              break;
-                            }
-
-                          /* Tidy things up since we might have to
-                             detect another loop.  */
-                          loop->qlink = NULL;
-                          loop = tmp;
-                        }
-
-                      while (loop)
-                        {
-                          struct item *tmp = loop->qlink;
-
-                          loop->qlink = NULL;
-                          loop = tmp;
-                        }
-
-                      /* Since we have found the loop, stop walking
-                         the tree.  */
-                      return true;
-                    }
-                  else
-                    {
-                      k->qlink = loop;
-                      loop = k;
-                      break;
-                    }
-                }
-
-              p = &(*p)->next;
-            }
+      /* T6. Erase relations.  */
+      for (size_t i = 0; i < k->n_successors; i++)
+        {
+          struct item *s = k->top[i];
+          if (s && --s->count == 0)
+            queue[queue_tail++] = s;
         }
     }
-
-  return false;
 }
 
-/* Recurse (sub)tree rooted at ROOT, calling ACTION for each node.
-   Stop when ACTION returns true.  */
+/* Print the loop on PATH that K closes, and remove the relation of K
+   to the start of the loop to break it.  */
 
-static bool
-recurse_tree (struct item *root, bool (*action) (struct item *))
+static void
+break_loop (struct item *k)
 {
-  if (root->left == NULL && root->right == NULL)
-    return (*action) (root);
-  else
+  struct item **p = &k->top[k->next_successor];
+  struct item *start = *p;
+  size_t i = path_len;
+
+  while (path[i - 1] != start)
+    i--;
+  for (i--; i < path_len; i++)
+    error (0, 0, "%s", path[i]->str);
+
+  /* Remove relation.  */
+  *p = NULL;
+
+  /* Every item on PATH but the first has a predecessor on it, so the
+     path is left intact for the next search, unless its first item
+     now has no predecessors, and it and its successors may be output.
+     In that case the search starts over, but each item still resumes
+     from where it left off, as the relations already searched lead to
+     no loop.  */
+  if (--start->count == 0)
     {
-      if (root->left != NULL)
-        if (recurse_tree (root->left, action))
-          return true;
-      if ((*action) (root))
-        return true;
-      if (root->right != NULL)
-        if (recurse_tree (root->right, action))
-          return true;
+      queue[queue_tail++] = start;
+      while (path_len)
+        path[--path_len]->visit = UNVISITED;
     }
-
-  return false;
 }
 
-/* Walk the tree specified by the head ROOT, calling ACTION for
-   each node.  */
+/* Search the items not yet output for a loop, by depth-first search
+   from each in order of string, print the first loop found, and
+   remove a relation to break it.  Each relation is searched at most
+   once in all, as no loop is reachable from an item once searched.  */
 
 static void
-walk_tree (struct item *root, bool (*action) (struct item *))
+detect_loop (void)
 {
-  if (root->right)
-    recurse_tree (root->right, action);
+  if (! remaining)
+    {
+      remaining = xnmalloc (n_strings, sizeof *remaining);
+      for (size_t i = 0; i < n_items; i++)
+        if (items[i]->count)
+          remaining[n_remaining++] = items[i];
+      qsort (remaining, n_remaining, sizeof *remaining, compare_items);
+      path = xnmalloc (n_remaining, sizeof *path);
+    }
+
+  while (true)
+    {
+      if (path_len == 0)
+        {
+          struct item *root;
+
+          /* Every item left has a predecessor left, so there must be
+             a loop among them.  */
+          do
+            {
+              assert (next_remaining < n_remaining);
+              root = remaining[next_remaining++];
+            }
+          while (root->count == 0 || root->visit == EXPLORED);
+
+          next_remaining--;
+          root->visit = ON_PATH;
+          path[path_len++] = root;
+        }
+
+      struct item *k = path[path_len - 1];
+
+      if (k->next_successor == k->n_successors)
+        {
+          k->visit = EXPLORED;
+          path_len--;
+          continue;
+        }
+
+      struct item *s = k->top[k->next_successor];
+      if (!s || s->visit == EXPLORED)
+        k->next_successor++;
+      else if (s->visit == ON_PATH)
+        {
+          break_loop (k);
+          return;
+        }
+      else
+        {
+          s->visit = ON_PATH;
+          path[path_len++] = s;
+        }
+    }
 }
 
 /* Do a topological sort on FILE.   Return true if successful.  */
@@ -435,14 +364,16 @@ static bool
 tsort (const char *file)
 {
   bool ok = true;
-  struct item *root;
   struct item *j = NULL;
   struct item *k = NULL;
   token_buffer tokenbuffer;
   bool is_stdin = STREQ (file, "-");
 
-  /* Intialize the head of the tree will hold the strings we're sorting.  */
-  root = new_item (NULL);
+  obstack_init (&arena);
+  item_table = hash_initialize (INITIAL_TABLE_SIZE, NULL, item_hash,
+                                item_compare, NULL);
+  if (! item_table)
+    xalloc_die ();
 
   if (!is_stdin && ! freopen (file, "r", stdin))
     die (EXIT_FAILURE, errno, "%s", quotef (file));
@@ -460,7 +391,7 @@ tsort (const char *file)
 
       assert (len != 0);
 
-      k = search_item (root, tokenbuffer.buffer);
+      k = search_item (tokenbuffer.buffer, len);
       if (j)
         {
           /* T3. Record the relation.  */
@@ -475,60 +406,43 @@ tsort (const char *file)
     die (EXIT_FAILURE, 0, _("%s: input contains an odd number of tokens"),
          quotef (file));
 
-  /* T1. Initialize (N <- n).  */
-  walk_tree (root, count_items);
-
-  while (n_strings > 0)
-    {
-      /* T4. Scan for zeros.  */
-      walk_tree (root, scan_zeros);
-
-      while (head)
-        {
-          struct successor *p = head->top;
+  IF_LINT (free (tokenbuffer.buffer));
 
-          /* T5. Output front of queue.  */
-          puts (head->str);
-#ifdef lint
-          /* suppress valgrind "definitely lost" warnings.  */
-          void *head_str = (void *) head->str;
-          free (head_str);
-#endif
-          head->str = NULL;	/* Avoid printing the same string twice.  */
-          n_strings--;
+  /* T1. Initialize (N <- n).  */
+  n_strings = n_items;
+  build_successors ();
 
-          /* T6. Erase relations.  */
-          while (p)
-            {
-              p->suc->count--;
-              if (p->suc->count == 0)
-                {
-                  zeros->qlink = p->suc;
-                  zeros = p->suc;
-                }
-
-              p = p->next;
-            }
+  /* T4. Scan for zeros, in order of string.  */
+  queue = xnmalloc (n_items, sizeof *queue);
+  for (size_t i = 0; i < n_items; i++)
+    if (items[i]->count == 0)
+      queue[queue_tail++] = items[i];
+  qsort (queue, queue_tail, sizeof *queue, compare_items);
 
-          /* T7. Remove from queue.  */
-          head = head->qlink;
-        }
+  while (true)
+    {
+      output_queue ();
 
       /* T8.  End of process.  */
-      if (n_strings > 0)
-        {
-          /* The input contains a loop.  */
-          error (0, 0, _("%s: input contains a loop:"), quotef (file));
-          ok = false;
+      if (n_strings == 0)
+        break;
 
-          /* Print the loop and remove a relation to break it.  */
-          do
-            walk_tree (root, detect_loop);
-          while (loop);
-        }
+      /* The input contains a loop.  */
+      error (0, 0, _("%s: input contains a loop:"), quotef (file));
+      ok = false;
+
+      /* Print the loop and remove a relation to break it.  */
+      detect_loop ();
     }
 
-  IF_LINT (free (root));
+#ifdef lint
+  hash_free (item_table);
+  obstack_free (&arena, NULL);
+  free (items);
+  free (queue);
+  free (remaining);
+  free (path);
+#endif
 
   if (fclose (stdin) != 0)
     die (EXIT_FAILURE, errno, "%s",
@@ -24,14 +24,18 @@
 #include "system.h"
 #include "argmatch.h"
 #include "linebuffer.h"
+#include "line-reader.h"
 #include "die.h"
 #include "error.h"
 #include "fadvise.h"
+#include "obstack.h"
 #include "posixver.h"
 #include "stdio--.h"
 #include "xstrtol.h"
 #include "memcasecmp.h"
 #include "quote.h"
+#include "safe-read.h"
+#include "spill.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
 #define PROGRAM_NAME "uniq"
@@ -40,15 +44,8 @@
   proper_name ("Richard M. Stallman"), \
   proper_name ("David MacKenzie")
 
-#define SWAP_LINES(A, B)			\
-  do						\
-    {						\
-      struct linebuffer *_tmp;			\
-      _tmp = (A);				\
-      (A) = (B);				\
-      (B) = _tmp;				\
-    }						\
-  while (0)
+#define obstack_chunk_alloc xmalloc
+#define obstack_chunk_free free
 
 /* Number of fields to skip on each line when doing comparisons. */
 static size_t skip_fields;
@@ -134,9 +131,42 @@ static enum grouping_method const grouping_method_map[] =
 
 static enum grouping_method grouping = GM_NONE;
 
+enum hash_order
+{
+  /* Output distinct lines in the order first seen.  --hash[=first] */
+  HO_FIRST,
+
+  /* Output the most repeated lines first.  --hash=count */
+  HO_COUNT
+};
+
+static char const *const hash_order_string[] =
+{
+  "first", "count", NULL
+};
+
+static enum hash_order const hash_order_map[] =
+{
+  HO_FIRST, HO_COUNT
+};
+
+/* If true, detect repeated lines anywhere in the input using a hash
+   table, rather than only adjacent ones.  */
+static bool hash_mode;
+
+/* With --hash, the order in which to output the distinct lines.  */
+static enum hash_order hash_order;
+
+/* With --hash, the approximate number of bytes of memory to use for the
+   table before spilling lines with new keys to temporary files.
+   Zero means use a default based on the amount of physical memory.  */
+static size_t hash_buffer_size;
+
 enum
 {
-  GROUP_OPTION = CHAR_MAX + 1
+  GROUP_OPTION = CHAR_MAX + 1,
+  HASH_OPTION,
+  BUFFER_SIZE_OPTION
 };
 
 static struct option const longopts[] =
@@ -145,6 +175,8 @@ static struct option const longopts[] =
   {"repeated", no_argument, NULL, 'd'},
   {"all-repeated", optional_argument, NULL, 'D'},
   {"group", optional_argument, NULL, GROUP_OPTION},
+  {"hash", optional_argument, NULL, HASH_OPTION},
+  {"buffer-size", required_argument, NULL, BUFFER_SIZE_OPTION},
   {"ignore-case", no_argument, NULL, 'i'},
   {"unique", no_argument, NULL, 'u'},
   {"skip-fields", required_argument, NULL, 'f'},
@@ -192,6 +224,13 @@ With no options, matching lines are merged to the first occurrence.\n\
      fputs (_("\
       --group[=METHOD]  show all items, separating groups with an empty line;\n\
                           METHOD={separate(default),prepend,append,both}\n\
+"), stdout);
+     fputs (_("\
+      --hash[=ORDER]    detect repeated lines anywhere in the input, not\n\
+                          just adjacent ones, and output each distinct line\n\
+                          once; ORDER={first(default),count}\n\
+      --buffer-size=SIZE  with --hash, use about SIZE of memory for the\n\
+                            table before spilling to temporary files\n\
 "), stdout);
      fputs (_("\
   -i, --ignore-case     ignore differences in case when comparing\n\
@@ -215,6 +254,9 @@ characters.  Fields are skipped before chars.\n\
 \n\
 Note: 'uniq' does not detect repeated lines unless they are adjacent.\n\
 You may want to sort the input first, or use 'sort -u' without 'uniq'.\n\
+With --hash, -D and --group are not supported, and SIZE may be followed\n\
+by one of the multiplicative suffixes b, K, M, G, T, P, E, Z, Y,\n\
+with K (1024) being the default.\n\
 "), stdout);
       emit_ancillary_info (PROGRAM_NAME);
     }
@@ -313,14 +355,40 @@ writeline (struct linebuffer const *line,
   fwrite (line->buffer, sizeof (char), line->length, stdout);
 }
 
+/* The line most recently kept as the previous line, with the start of
+   its field to compare.  LINE is usually a view into the reader's
+   buffer, and is copied into STORE before that buffer is refilled.  */
+struct prev_line
+{
+  struct linebuffer line;
+  char *field;
+  struct linebuffer store;
+};
+
+static struct line_reader reader;
+
+/* Save the previous line ARG before the input buffer is refilled.  */
+
+static void
+keep_prev_line (void *arg)
+{
+  struct prev_line *prev = arg;
+
+  if (prev->line.length == 0)
+    return;
+  size_t field_offset = prev->field - prev->line.buffer;
+  if (line_reader_keep (&reader, &prev->line, &prev->store))
+    prev->field = prev->line.buffer + field_offset;
+}
+
 /* Process input file INFILE with output to OUTFILE.
    If either is "-", use the standard I/O stream for it instead. */
 
 static void
 check_file (const char *infile, const char *outfile, char delimiter)
 {
-  struct linebuffer lb1, lb2;
-  struct linebuffer *thisline, *prevline;
+  struct linebuffer thisline;
+  struct prev_line prev;
 
   if (! (STREQ (infile, "-") || freopen (infile, "r", stdin)))
     die (EXIT_FAILURE, errno, "%s", quotef (infile));
@@ -329,11 +397,13 @@ check_file (const char *infile, const char *outfile, char delimiter)
 
   fadvise (stdin, FADVISE_SEQUENTIAL);
 
-  thisline = &lb1;
-  prevline = &lb2;
+  line_reader_init (&reader, fileno (stdin), delimiter);
+  reader.before_refill = keep_prev_line;
+  reader.before_refill_arg = &prev;
 
-  initbuffer (thisline);
-  initbuffer (prevline);
+  initbuffer (&prev.line);
+  initbuffer (&prev.store);
+  prev.field = NULL;
 
   /* The duplication in the following 'if' and 'else' blocks is an
      optimization to distinguish between when we can print input
@@ -352,24 +422,20 @@ check_file (const char *infile, const char *outfile, char delimiter)
   */
   if (output_unique && output_first_repeated && countmode == count_none)
     {
-      char *prevfield IF_LINT ( = NULL);
       size_t prevlen IF_LINT ( = 0);
       bool first_group_printed = false;
 
-      while (!feof (stdin))
+      while (line_reader_next (&reader, &thisline))
         {
           char *thisfield;
           size_t thislen;
           bool new_group;
 
-          if (readlinebuffer_delim (thisline, stdin, delimiter) == 0)
-            break;
-
-          thisfield = find_field (thisline);
-          thislen = thisline->length - 1 - (thisfield - thisline->buffer);
+          thisfield = find_field (&thisline);
+          thislen = thisline.length - 1 - (thisfield - thisline.buffer);
 
-          new_group = (prevline->length == 0
-                       || different (thisfield, prevfield, thislen, prevlen));
+          new_group = (prev.line.length == 0
+                       || different (thisfield, prev.field, thislen, prevlen));
 
           if (new_group && grouping != GM_NONE
               && (grouping == GM_PREPEND || grouping == GM_BOTH
@@ -379,11 +445,11 @@ check_file (const char *infile, const char *outfile, char delimiter)
 
           if (new_group || grouping != GM_NONE)
             {
-              fwrite (thisline->buffer, sizeof (char),
-                      thisline->length, stdout);
+              fwrite (thisline.buffer, sizeof (char),
+                      thisline.length, stdout);
 
-              SWAP_LINES (prevline, thisline);
-              prevfield = thisfield;
+              prev.line = thisline;
+              prev.field = thisfield;
               prevlen = thislen;
               first_group_printed = true;
             }
@@ -393,30 +459,23 @@ check_file (const char *infile, const char *outfile, char delimiter)
     }
   else
     {
-      char *prevfield;
       size_t prevlen;
       uintmax_t match_count = 0;
       bool first_delimiter = true;
 
-      if (readlinebuffer_delim (prevline, stdin, delimiter) == 0)
+      if (! line_reader_next (&reader, &prev.line))
         goto closefiles;
-      prevfield = find_field (prevline);
-      prevlen = prevline->length - 1 - (prevfield - prevline->buffer);
+      prev.field = find_field (&prev.line);
+      prevlen = prev.line.length - 1 - (prev.field - prev.line.buffer);
 
-      while (!feof (stdin))
+      while (line_reader_next (&reader, &thisline))
         {
           bool match;
           char *thisfield;
           size_t thislen;
-          if (readlinebuffer_delim (thisline, stdin, delimiter) == 0)
-            {
-              if (ferror (stdin))
-                goto closefiles;
-              break;
-            }
-          thisfield = find_field (thisline);
-          thislen = thisline->length - 1 - (thisfield - thisline->buffer);
-          match = !different (thisfield, prevfield, thislen, prevlen);
+          thisfield = find_field (&thisline);
+          thislen = thisline.length - 1 - (thisfield - thisline.buffer);
+          match = !different (thisfield, prev.field, thislen, prevlen);
           match_count += match;
 
           if (match_count == UINTMAX_MAX)
@@ -444,26 +503,543 @@ check_file (const char *infile, const char *outfile, char delimiter)
 
           if (!match || output_later_repeated)
             {
-              writeline (prevline, match, match_count);
-              SWAP_LINES (prevline, thisline);
-              prevfield = thisfield;
+              writeline (&prev.line, match, match_count);
+              prev.line = thisline;
+              prev.field = thisfield;
               prevlen = thislen;
               if (!match)
                 match_count = 0;
             }
         }
 
-      writeline (prevline, false, match_count);
+      if (reader.errnum)
+        goto closefiles;
+      writeline (&prev.line, false, match_count);
     }
 
  closefiles:
-  if (ferror (stdin) || fclose (stdin) != 0)
-    die (EXIT_FAILURE, 0, _("error reading %s"), quoteaf (infile));
+  if (reader.errnum || fclose (stdin) != 0)
+    die (EXIT_FAILURE, reader.errnum, _("error reading %s"),
+         quoteaf (infile));
 
   /* stdout is handled via the atexit-invoked close_stdout function.  */
 
-  free (lb1.buffer);
-  free (lb2.buffer);
+  line_reader_free (&reader);
+  free (prev.store.buffer);
+}
+
+/* A distinct key, as represented by the first line having it.  */
+struct hash_entry
+{
+  uintmax_t seq;		/* Input line number of the first line.  */
+  uintmax_t count;		/* Number of lines having the key.  */
+  char *line;			/* The first line, including its delimiter.  */
+  size_t length;		/* Length of LINE.  */
+  char *key;			/* The key, within LINE.  */
+  size_t key_length;		/* Length of KEY.  */
+};
+
+/* A slot of the open-addressing table: INDEX is 0 if the slot is unused,
+   or else one more than the index of the entry, whose hash value is
+   copied here to avoid most accesses to the entries when probing.  */
+struct hash_slot
+{
+  uint64_t hash;
+  size_t index;
+};
+
+/* A table of the distinct keys seen.  */
+struct hash_table
+{
+  /* The slots, linearly probed.  N_SLOTS is a power of 2.  */
+  struct hash_slot *slots;
+  size_t n_slots;
+
+  /* The entries, in the order they were added, and their lines.  */
+  struct hash_entry *entries;
+  size_t n_entries;
+  size_t n_entries_allocated;
+  struct obstack arena;
+
+  /* Approximate number of bytes of memory in use.  */
+  size_t bytes;
+
+  /* The partitioning level: 0 for the table fed with the input, and
+     otherwise one more than that of the table whose file feeds it.  */
+  int depth;
+
+  /* True once no more keys fit, and lines with new keys are instead
+     written to PARTS.  */
+  bool full;
+  FILE *parts[SPILL_PARTS];
+};
+
+/* The size of the buffer for reading each run when merging.  */
+enum { HASH_RUN_BUFSIZE = 16 * 1024 };
+
+/* A sorted run of output records, as produced when the table spills.
+   All runs are written one after another to the same temporary file,
+   and each is read back through its own buffer when merging.  */
+struct hash_run
+{
+  off_t pos;			/* Offset of the next byte to read.  */
+  off_t end;			/* Offset of the end of the run.  */
+  char *buf;
+  size_t next;			/* Next unread byte in BUF.  */
+  size_t lim;			/* End of the data in BUF.  */
+
+  /* The record at the head of the run.  */
+  uintmax_t seq;
+  uintmax_t count;
+  struct linebuffer line;
+};
+
+static FILE *hash_run_file;
+static struct hash_run *hash_runs;
+static size_t n_hash_runs;
+static size_t n_hash_runs_allocated;
+
+/* Write to the temporary file FP a record of the line LINE of length
+   LEN, first seen at input line SEQ and seen COUNT times.  */
+
+static void
+write_record (FILE *fp, uintmax_t seq, uintmax_t count,
+              char const *line, size_t len)
+{
+  if (fwrite (&seq, sizeof seq, 1, fp) != 1
+      || fwrite (&count, sizeof count, 1, fp) != 1
+      || fwrite (&len, sizeof len, 1, fp) != 1
+      || fwrite (line, 1, len, fp) != len)
+    die (EXIT_FAILURE, errno, _("cannot write temporary file"));
+}
+
+/* Read from the temporary file FP a record written by write_record,
+   storing its line into LINE.  Return false at end of file.  */
+
+static bool
+read_record (FILE *fp, uintmax_t *seq, uintmax_t *count,
+             struct linebuffer *line)
+{
+  size_t len;
+
+  if (fread (seq, sizeof *seq, 1, fp) != 1)
+    {
+      if (ferror (fp))
+        die (EXIT_FAILURE, errno, _("cannot read temporary file"));
+      return false;
+    }
+  if (fread (count, sizeof *count, 1, fp) != 1
+      || fread (&len, sizeof len, 1, fp) != 1)
+    die (EXIT_FAILURE, ferror (fp) ? errno : 0,
+         _("cannot read temporary file"));
+  if (line->size < len)
+    {
+      free (line->buffer);
+      line->size = len;
+      line->buffer = x2nrealloc (NULL, &line->size, 1);
+    }
+  if (fread (line->buffer, 1, len, fp) != len)
+    die (EXIT_FAILURE, ferror (fp) ? errno : 0,
+         _("cannot read temporary file"));
+  line->length = len;
+  return true;
+}
+
+/* Return true if a distinct line seen COUNT times is to be output.  */
+
+static bool
+hash_selected (uintmax_t count)
+{
+  return count == 1 ? output_unique : output_first_repeated;
+}
+
+static void
+hash_init (struct hash_table *t, int depth)
+{
+  t->n_slots = 1024;
+  t->slots = xcalloc (t->n_slots, sizeof *t->slots);
+  t->entries = NULL;
+  t->n_entries = t->n_entries_allocated = 0;
+  obstack_init (&t->arena);
+  t->bytes = t->n_slots * sizeof *t->slots;
+  t->depth = depth;
+  t->full = false;
+  for (int i = 0; i < SPILL_PARTS; i++)
+    t->parts[i] = NULL;
+}
+
+static void
+hash_free (struct hash_table *t)
+{
+  free (t->slots);
+  free (t->entries);
+  obstack_free (&t->arena, NULL);
+}
+
+/* Double the number of slots in T.  */
+
+static void
+hash_grow (struct hash_table *t)
+{
+  size_t n_slots = t->n_slots * 2;
+  struct hash_slot *slots = xcalloc (n_slots, sizeof *slots);
+
+  for (size_t i = 0; i < t->n_slots; i++)
+    if (t->slots[i].index)
+      {
+        size_t j = t->slots[i].hash & (n_slots - 1);
+        while (slots[j].index)
+          j = (j + 1) & (n_slots - 1);
+        slots[j] = t->slots[i];
+      }
+
+  free (t->slots);
+  t->bytes += (n_slots - t->n_slots) * sizeof *slots;
+  t->slots = slots;
+  t->n_slots = n_slots;
+}
+
+/* Return true if a new entry for a line of length LEN fits in T.  */
+
+static bool
+hash_fits (struct hash_table const *t, size_t len)
+{
+  if (t->depth == SPILL_MAX_DEPTH)
+    return true;
+
+  /* Allow for the entry, and for the doubling of the slots and entries
+     that it may trigger.  */
+  size_t more = len + 2 * sizeof *t->entries;
+  if (t->n_slots <= 2 * (t->n_entries + 1))
+    more += 2 * t->n_slots * sizeof *t->slots;
+  return more <= hash_buffer_size && t->bytes <= hash_buffer_size - more;
+}
+
+/* Add to T the line LINE of length LEN, first seen at input line SEQ
+   and seen COUNT times.  If T is full and does not already have LINE's
+   key, write LINE to the temporary file for its partition instead.  */
+
+static void
+hash_add (struct hash_table *t, char *line, size_t len,
+          uintmax_t seq, uintmax_t count)
+{
+  struct linebuffer lb = { len, len, line };
+  char *key = find_field (&lb);
+  size_t key_length = MIN (check_chars, len - 1 - (key - line));
+  uint64_t h = spill_hash (key, key_length, ignore_case);
+  size_t mask = t->n_slots - 1;
+  size_t i;
+
+  for (i = h & mask; t->slots[i].index; i = (i + 1) & mask)
+    {
+      if (t->slots[i].hash != h)
+        continue;
+      struct hash_entry *e = &t->entries[t->slots[i].index - 1];
+      if (!different (e->key, key, e->key_length, key_length))
+        {
+          if (UINTMAX_MAX - e->count < count)
+            {
+              if (countmode == count_occurrences)
+                die (EXIT_FAILURE, 0, _("too many repeated lines"));
+              e->count = UINTMAX_MAX;
+            }
+          else
+            e->count += count;
+          return;
+        }
+    }
+
+  if (! t->full && ! hash_fits (t, len))
+    t->full = true;
+  if (t->full)
+    {
+      int part = spill_part (h, t->depth);
+      if (! t->parts[part])
+        t->parts[part] = spill_temp_file ("uniqXXXXXX");
+      write_record (t->parts[part], seq, count, line, len);
+      return;
+    }
+
+  if (t->n_entries == t->n_entries_allocated)
+    {
+      size_t old = t->n_entries_allocated;
+      t->entries = X2NREALLOC (t->entries, &t->n_entries_allocated);
+      t->bytes += (t->n_entries_allocated - old) * sizeof *t->entries;
+    }
+
+  struct hash_entry *e = &t->entries[t->n_entries];
+  e->seq = seq;
+  e->count = count;
+  e->line = obstack_copy (&t->arena, line, len);
+  e->length = len;
+  e->key = e->line + (key - line);
+  e->key_length = key_length;
+  t->bytes += len;
+  t->slots[i].hash = h;
+  t->slots[i].index = ++t->n_entries;
+
+  if (t->n_slots <= 2 * t->n_entries)
+    hash_grow (t);
+}
+
+/* Return true if a record first seen at SEQ1 and seen COUNT1 times is
+   to be output before one first seen at SEQ2 and seen COUNT2 times.  */
+
+static bool
+hash_before (uintmax_t seq1, uintmax_t count1,
+             uintmax_t seq2, uintmax_t count2)
+{
+  if (hash_order == HO_COUNT && count1 != count2)
+    return count1 > count2;
+  return seq1 < seq2;
+}
+
+static int
+compare_entries (void const *a, void const *b)
+{
+  struct hash_entry const *const *pa = a;
+  struct hash_entry const *const *pb = b;
+  struct hash_entry const *ea = *pa;
+  struct hash_entry const *eb = *pb;
+  return (hash_before (eb->seq, eb->count, ea->seq, ea->count)
+          - hash_before (ea->seq, ea->count, eb->seq, eb->count));
+}
+
+/* Output the selected entries of T in order, either to standard output
+   or, if TO_RUN, as a new sorted run.  Then process the lines that T
+   spilled to temporary files, adding their runs too.  */
+
+static void
+hash_finish (struct hash_table *t, bool to_run)
+{
+  struct hash_entry **sorted = xnmalloc (t->n_entries, sizeof *sorted);
+  size_t n = 0;
+  FILE *run = NULL;
+
+  /* The entries were added in input order, as the lines in the
+     temporary files are in input order too.  */
+  for (size_t i = 0; i < t->n_entries; i++)
+    if (hash_selected (t->entries[i].count))
+      sorted[n++] = &t->entries[i];
+  if (hash_order == HO_COUNT)
+    qsort (sorted, n, sizeof *sorted, compare_entries);
+
+  if (to_run && n)
+    {
+      if (! hash_run_file)
+        hash_run_file = spill_temp_file ("uniqXXXXXX");
+      run = hash_run_file;
+      if (n_hash_runs == n_hash_runs_allocated)
+        hash_runs = X2NREALLOC (hash_runs, &n_hash_runs_allocated);
+      hash_runs[n_hash_runs].pos = ftello (run);
+    }
+
+  for (size_t i = 0; i < n; i++)
+    {
+      struct hash_entry const *e = sorted[i];
+      if (run)
+        write_record (run, e->seq, e->count, e->line, e->length);
+      else
+        {
+          struct linebuffer lb = { e->length, e->length, e->line };
+          writeline (&lb, false, e->count - 1);
+        }
+    }
+  free (sorted);
+
+  if (run)
+    hash_runs[n_hash_runs++].end = ftello (run);
+
+  /* Release the memory of T before processing its partitions.  */
+  FILE *parts[SPILL_PARTS];
+  memcpy (parts, t->parts, sizeof parts);
+  int depth = t->depth;
+  hash_free (t);
+
+  for (int i = 0; i < SPILL_PARTS; i++)
+    if (parts[i])
+      {
+        struct hash_table part;
+        struct linebuffer lb;
+        uintmax_t seq, count;
+
+        if (fseeko (parts[i], 0, SEEK_SET) != 0)
+          die (EXIT_FAILURE, errno, _("cannot read temporary file"));
+        hash_init (&part, depth + 1);
+        initbuffer (&lb);
+        while (read_record (parts[i], &seq, &count, &lb))
+          hash_add (&part, lb.buffer, lb.length, seq, count);
+        free (lb.buffer);
+        fclose (parts[i]);
+        hash_finish (&part, true);
+      }
+}
+
+/* Copy N bytes from the run R, whose file descriptor is FD, to DST.  */
+
+static void
+run_read (struct hash_run *r, int fd, void *dst, size_t n)
+{
+  char *p = dst;
+
+  while (n)
+    {
+      if (r->next == r->lim)
+        {
+          size_t want = MIN (HASH_RUN_BUFSIZE, r->end - r->pos);
+          size_t got;
+          if (want == 0
+              || lseek (fd, r->pos, SEEK_SET) < 0
+              || (got = safe_read (fd, r->buf, want)) == SAFE_READ_ERROR
+              || got == 0)
+            die (EXIT_FAILURE, want ? errno : 0,
+                 _("cannot read temporary file"));
+          r->pos += got;
+          r->next = 0;
+          r->lim = got;
+        }
+      size_t copy = MIN (n, r->lim - r->next);
+      memcpy (p, r->buf + r->next, copy);
+      r->next += copy;
+      p += copy;
+      n -= copy;
+    }
+}
+
+/* Read the next record of the run R, whose file descriptor is FD, into
+   its head.  Return false at the end of the run.  */
+
+static bool
+run_next (struct hash_run *r, int fd)
+{
+  size_t len;
+
+  if (r->pos == r->end && r->next == r->lim)
+    return false;
+
+  run_read (r, fd, &r->seq, sizeof r->seq);
+  run_read (r, fd, &r->count, sizeof r->count);
+  run_read (r, fd, &len, sizeof len);
+  if (r->line.size < len)
+    {
+      free (r->line.buffer);
+      r->line.size = len;
+      r->line.buffer = x2nrealloc (NULL, &r->line.size, 1);
+    }
+  run_read (r, fd, r->line.buffer, len);
+  r->line.length = len;
+  return true;
+}
+
+/* Return true if the head of run A is to be output before that of B.  */
+
+static bool
+run_before (struct hash_run const *a, struct hash_run const *b)
+{
+  return hash_before (a->seq, a->count, b->seq, b->count);
+}
+
+/* Restore the heap order of the N runs in HEAP, whose element I may be
+   out of place by being too late.  */
+
+static void
+run_sift_down (struct hash_run **heap, size_t n, size_t i)
+{
+  struct hash_run *r = heap[i];
+
+  for (size_t child; (child = 2 * i + 1) < n; i = child)
+    {
+      if (child + 1 < n && run_before (heap[child + 1], heap[child]))
+        child++;
+      if (! run_before (heap[child], r))
+        break;
+      heap[i] = heap[child];
+    }
+  heap[i] = r;
+}
+
+/* Output the records of the sorted runs, merging them.  */
+
+static void
+hash_merge_runs (void)
+{
+  struct hash_run **heap = xnmalloc (n_hash_runs, sizeof *heap);
+  size_t n = n_hash_runs;
+  int fd = fileno (hash_run_file);
+
+  if (fflush (hash_run_file) != 0)
+    die (EXIT_FAILURE, errno, _("cannot write temporary file"));
+
+  for (size_t i = 0; i < n; i++)
+    {
+      struct hash_run *r = &hash_runs[i];
+      r->buf = xmalloc (HASH_RUN_BUFSIZE);
+      r->next = r->lim = 0;
+      initbuffer (&r->line);
+      run_next (r, fd);
+      heap[i] = r;
+    }
+  for (size_t i = n / 2; i-- != 0; )
+    run_sift_down (heap, n, i);
+
+  while (n)
+    {
+      struct hash_run *r = heap[0];
+
+      writeline (&r->line, false, r->count - 1);
+
+      if (! run_next (r, fd))
+        {
+          free (r->buf);
+          free (r->line.buffer);
+          heap[0] = heap[--n];
+        }
+      run_sift_down (heap, n, 0);
+    }
+
+  fclose (hash_run_file);
+  free (heap);
+  free (hash_runs);
+}
+
+/* Process input file INFILE with output to OUTFILE, as for check_file,
+   but detecting repeated lines anywhere in the input.  */
+
+static void
+hash_file (const char *infile, const char *outfile, char delimiter)
+{
+  struct hash_table table;
+  struct linebuffer line;
+  uintmax_t seq = 0;
+
+  if (! (STREQ (infile, "-") || freopen (infile, "r", stdin)))
+    die (EXIT_FAILURE, errno, "%s", quotef (infile));
+  if (! (STREQ (outfile, "-") || freopen (outfile, "w", stdout)))
+    die (EXIT_FAILURE, errno, "%s", quotef (outfile));
+
+  fadvise (stdin, FADVISE_SEQUENTIAL);
+
+  if (hash_buffer_size == 0)
+    hash_buffer_size = spill_default_buffer_size ();
+  hash_buffer_size = MAX (hash_buffer_size, SPILL_MIN_BUFFER_SIZE);
+
+  line_reader_init (&reader, fileno (stdin), delimiter);
+  hash_init (&table, 0);
+
+  while (line_reader_next (&reader, &line))
+    hash_add (&table, line.buffer, line.length, seq++, 1);
+
+  if (reader.errnum || fclose (stdin) != 0)
+    die (EXIT_FAILURE, reader.errnum, _("error reading %s"),
+         quoteaf (infile));
+  line_reader_free (&reader);
+
+  bool spilled = false;
+  for (int i = 0; i < SPILL_PARTS; i++)
+    spilled |= !!table.parts[i];
+  hash_finish (&table, spilled);
+  if (hash_run_file)
+    hash_merge_runs ();
 }
 
 enum Skip_field_option_type
@@ -594,6 +1170,17 @@ main (int argc, char **argv)
                                   grouping_method_map);
           break;
 
+        case HASH_OPTION:
+          hash_mode = true;
+          if (optarg)
+            hash_order = XARGMATCH ("--hash", optarg,
+                                    hash_order_string, hash_order_map);
+          break;
+
+        case BUFFER_SIZE_OPTION:
+          hash_buffer_size = spill_buffer_size_opt (optarg);
+          break;
+
         case 'f':
           skip_field_option_type = SFO_NEW;
           skip_fields = size_opt (optarg,
@@ -656,7 +1243,16 @@ main (int argc, char **argv)
       usage (EXIT_FAILURE);
     }
 
-  check_file (file[0], file[1], delimiter);
+  if (hash_mode && (output_later_repeated || grouping != GM_NONE))
+    {
+      error (0, 0, _("--hash is mutually exclusive with -D and --group"));
+      usage (EXIT_FAILURE);
+    }
+
+  if (hash_mode)
+    hash_file (file[0], file[1], delimiter);
+  else
+    check_file (file[0], file[1], delimiter);
 
   return EXIT_SUCCESS;
 }
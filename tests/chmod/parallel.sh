@@ -0,0 +1,74 @@
+#!/bin/sh
+# Verify that chmod, chown and chgrp -R --parallel=N change and report
+# the same files as without it.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ chmod chown chgrp
+skip_if_setgid_
+
+umask 022
+
+for d in a a/b a/b/c a/d; do
+  mkdir $d || framework_failure_
+  for f in 1 2 3 4 5 6 7 8 9; do
+    touch $d/$f || framework_failure_
+  done
+done
+ln -s nowhere a/dangle || framework_failure_
+# The directories must be changed before they are read.
+chmod 0 a/b/c a/d || framework_failure_
+cp -R a p || framework_failure_
+
+# The trees may be read in a different order, so compare sorted output.
+chmod -Rv u+rwx,go-w a > out || fail=1
+sort out > exp || framework_failure_
+chmod -Rv --parallel=3 u+rwx,go-w p > out || fail=1
+sed "s/'p\([/']\)/'a\\1/" out | sort > out2 || framework_failure_
+compare exp out2 || fail=1
+
+find a -printf '%m %P\n' | sort > exp || framework_failure_
+find p -printf '%m %P\n' | sort > out || framework_failure_
+compare exp out || fail=1
+test $(wc -l < exp) = 41 || fail=1
+
+chown -Rc --parallel=3 $(id -u) p > out || fail=1
+compare /dev/null out || fail=1
+chgrp -Rv --parallel=3 $(id -g) p > out || fail=1
+test $(grep -c retained out) = 41 || fail=1
+
+# Each hard link is reported as changed from the mode the last one set.
+mkdir h || framework_failure_
+for d in $(seq 20); do
+  mkdir h/$d || framework_failure_
+  for f in $(seq 30); do
+    touch h/$d/$f || framework_failure_
+  done
+  test $d = 1 || ln h/1/1 h/$d/link || framework_failure_
+done
+cp -a h q || framework_failure_
+chmod -Rv g+w h > out || fail=1
+sort out > exp || framework_failure_
+chmod -Rv --parallel=3 g+w q > out || fail=1
+sed "s/'q\([/']\)/'h\\1/" out | sort > out2 || framework_failure_
+compare exp out2 || fail=1
+test $(grep -Ec "^mode of 'h/(1/1|[0-9]*/link)' changed" exp) = 1 || fail=1
+
+returns_ 1 chmod -R --parallel=0 u+w p 2> err || fail=1
+grep 'invalid number of threads' err || fail=1
+
+Exit $fail
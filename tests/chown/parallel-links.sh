@@ -0,0 +1,54 @@
+#!/bin/sh
+# Verify that chown -R --parallel=N matches --from against the current
+# owner of a file reached through several hard or symbolic links.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ chown
+require_root_
+
+# Enough files for the jobs on each name of d1/f2 and d1/f3 to be queued
+# while fts reads the later directories.
+mkdir t || framework_failure_
+for d in $(seq 40); do
+  mkdir t/d$d || framework_failure_
+  for f in $(seq 30); do
+    touch t/d$d/f$f || framework_failure_
+  done
+  ln -s ../d1/f2 t/d$d/sl || framework_failure_
+  test $d = 1 || ln t/d1/f3 t/d$d/h || framework_failure_
+done
+chown -R 0:0 t || framework_failure_
+
+for opt in '' -L; do
+  rm -rf a p || framework_failure_
+  cp -a t a || framework_failure_
+  cp -a t p || framework_failure_
+
+  # The trees may be read in a different order, so compare sorted output.
+  chown -Rv $opt --from=0 1 a > out || fail=1
+  sort out > exp || framework_failure_
+  chown -Rv $opt --from=0 1 --parallel=8 p > out || fail=1
+  sed "s/'p\([/']\)/'a\\1/" out | sort > out2 || framework_failure_
+  compare exp out2 || fail=1
+done
+
+# Only the first name of each file was changed from root.
+test $(grep -Ec "^changed .*'a/d(1/f2|[0-9]*/sl)'" exp) = 1 || fail=1
+test $(grep -Ec "^changed .*'a/d(1/f3|[0-9]*/h)'" exp) = 1 || fail=1
+
+Exit $fail
@@ -0,0 +1,79 @@
+#!/bin/sh
+# Ensure df --timeout reports a file system that does not respond,
+# and otherwise outputs the same as without it.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ df
+require_gcc_shared_
+
+# Protect against inaccessible remote mounts etc.
+timeout 10 df || skip_ "df fails"
+
+# Sizes may change between runs, so compare only the names.
+df -a --output=source,target > exp || fail=1
+df -a --timeout=10 --output=source,target > out || fail=1
+compare exp out || fail=1
+
+returns_ 1 df --timeout=1x 2> err || fail=1
+grep 'invalid time interval' err || fail=1
+
+target=$(df --output=target . | tail -n1) || framework_failure_
+
+# Simulate a file system that does not respond.
+cat > k.c <<EOF || framework_failure_
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/statvfs.h>
+
+int statvfs (char const *file, struct statvfs *buf)
+{
+  static int (*statvfs_func) (char const *, struct statvfs *);
+
+  if (!statvfs_func)
+    statvfs_func = (int (*) (char const *, struct statvfs *))
+                   dlsym (RTLD_NEXT, "statvfs");
+
+  /* Prove that LD_PRELOAD works.  */
+  fclose (fopen ("x", "w"));
+
+  if (strcmp (file, "$target") == 0)
+    sleep (60);
+  return statvfs_func (file, buf);
+}
+EOF
+
+gcc_shared_ k.c k.so \
+  || framework_failure_ 'failed to build shared library'
+
+cleanup_() { unset LD_PRELOAD; }
+
+export LD_PRELOAD=$LD_PRELOAD:./k.so
+
+returns_ 1 timeout 10 df --timeout=0.5 --output=size,target . > out 2> err \
+  || fail=1
+test -f x || skip_ "internal test failure: maybe LD_PRELOAD doesn't work?"
+
+echo "- $target" > exp || framework_failure_
+tail -n1 out | sed 's/^ *//; s/  */ /g' > out2 || framework_failure_
+compare exp out2 || fail=1
+grep 'timed out' err || fail=1
+
+Exit $fail
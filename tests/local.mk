@@ -108,6 +108,7 @@ EXTRA_DIST +=			\
 
 all_root_tests =				\
   tests/chown/basic.sh				\
+  tests/chown/parallel-links.sh			\
   tests/cp/cp-a-selinux.sh			\
   tests/cp/preserve-gid.sh			\
   tests/cp/special-bits.sh			\
@@ -352,6 +353,7 @@ all_tests =					\
   tests/misc/sha384sum.pl			\
   tests/misc/sha512sum.pl			\
   tests/misc/shred-exact.sh			\
+  tests/misc/shred-parallel.sh			\
   tests/misc/shred-passes.sh			\
   tests/misc/shred-remove.sh			\
   tests/misc/shred-size.sh			\
@@ -383,6 +385,7 @@ all_tests =					\
   tests/misc/sort-NaN-infloop.sh		\
   tests/misc/sort-u-FMR.sh			\
   tests/split/filter.sh				\
+  tests/split/parallel.sh			\
   tests/split/suffix-auto-length.sh		\
   tests/split/suffix-length.sh			\
   tests/split/additional-suffix.sh		\
@@ -397,6 +400,7 @@ all_tests =					\
   tests/split/guard-input.sh			\
   tests/misc/stat-birthtime.sh			\
   tests/misc/stat-fmt.sh			\
+  tests/misc/stat-files0-from.pl		\
   tests/misc/stat-hyphen.sh			\
   tests/misc/stat-mount.sh			\
   tests/misc/stat-nanoseconds.sh		\
@@ -452,6 +456,7 @@ all_tests =					\
   tests/chmod/equals.sh				\
   tests/chmod/inaccessible.sh			\
   tests/chmod/octal.sh				\
+  tests/chmod/parallel.sh			\
   tests/chmod/setgid.sh				\
   tests/chmod/silent.sh				\
   tests/chmod/thru-dangling.sh			\
@@ -520,6 +525,7 @@ all_tests =					\
   tests/df/unreadable.sh			\
   tests/df/total-unprocessed.sh			\
   tests/df/no-mtab-status.sh			\
+  tests/df/timeout.sh				\
   tests/df/skip-duplicates.sh			\
   tests/df/skip-rootfs.sh			\
   tests/dd/ascii.sh				\
@@ -604,6 +610,8 @@ all_tests =					\
   tests/ls/follow-slink.sh			\
   tests/ls/getxattr-speedup.sh			\
   tests/ls/group-dirs.sh			\
+  tests/ls/sort-threads.sh			\
+  tests/ls/stream-unsorted.sh		\
   tests/ls/hex-option.sh			\
   tests/ls/infloop.sh				\
   tests/ls/inode.sh				\
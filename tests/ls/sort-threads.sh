@@ -0,0 +1,44 @@
+#!/bin/sh
+# Ensure that sorting a large directory with threads gives the same
+# order as sorting it with a single thread.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ ls
+expensive_
+
+# ls sorts with threads only with at least 65536 entries.
+mkdir dir || framework_failure_
+cd dir || framework_failure_
+seq -f 'f%g.c' 40000 | xargs touch || framework_failure_
+seq -f 'F%g' 30000 | xargs touch || framework_failure_
+seq -f '%g.h' 5000 | xargs mkdir || framework_failure_
+cd .. || framework_failure_
+
+for opt in '' -r -X -v -S --group-directories-first; do
+  for loc in C "$LOCALE_FR_UTF8"; do
+    test "$loc" = none && continue
+    OMP_NUM_THREADS=1 LC_ALL=$loc ls $opt dir > exp || fail=1
+    OMP_NUM_THREADS=4 LC_ALL=$loc ls $opt dir > out || fail=1
+    compare exp out || fail=1
+  done
+done
+
+# Check the order itself in the C locale.
+LC_ALL=C ls dir | LC_ALL=C sort -c || fail=1
+
+Exit $fail
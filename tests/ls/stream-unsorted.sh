@@ -0,0 +1,43 @@
+#!/bin/sh
+# Ensure that the unsorted -m and -R listings, which are printed while
+# the directory is being read, match the buffered listings.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ ls
+
+mkdir -p dir/a/b/c dir/d dir/e || framework_failure_
+touch dir/f dir/a/g dir/a/b/h dir/e/i || framework_failure_
+mkdir empty || framework_failure_
+
+# With -w0, -C separates names with two spaces and, unlike -m, lists
+# each directory only once it has been read entirely.
+for dir in dir dir/a empty; do
+  ls -U -R -C -w0 $dir > exp || fail=1
+  ls -U -R -m -w0 $dir | sed 's/, /  /g' > out || fail=1
+  compare exp out || fail=1
+
+  ls -U -R -C -w0 $dir | tr -s ' ' '\n' | sed '/^$/d' > exp || fail=1
+  ls -U -R -1 $dir | sed '/^$/d' > out || fail=1
+  compare exp out || fail=1
+done
+
+# Lines are still wrapped at the requested width.
+ls -U -m -w1 dir > out || fail=1
+test $(wc -l < out) = 4 || fail=1
+
+Exit $fail
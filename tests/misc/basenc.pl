@@ -65,6 +65,27 @@ my $base2msbf_ab = "0110000101100010";
 my $base2msbf_ab_nl = $base2msbf_ab;
 $base2msbf_ab_nl =~ s/(...)/\1\n/g; # Add newline every 3 characters
 
+# Return the base64 encoding of S.
+sub base64_of($)
+{
+  my ($s) = @_;
+  my @alphabet = ('A'..'Z', 'a'..'z', '0'..'9', '+', '/');
+  my $bits = unpack ('B*', $s);
+  $bits .= '0' x (-length ($bits) % 6);
+  my $out = join '', map { $alphabet[oct "0b$_"] } $bits =~ /(.{6})/g;
+  return $out . '=' x (-length ($out) % 4);
+}
+
+# Input long enough for the vectorized codecs, with all byte values
+# but newline, which OUT_SUBST below would remove from the output.
+my $bytes_in = join ('', map { chr } grep { $_ != 10 } 0..255) x 3;
+my $bytes_base64 = base64_of ($bytes_in);
+my $bytes_base64_nl = $bytes_base64;
+$bytes_base64_nl =~ s/(.{76})/$1\n/g;
+my $bytes_base16 = uc unpack ('H*', $bytes_in);
+my $bytes_base16_nl = $bytes_base16;
+$bytes_base16_nl =~ s/(.{76})/$1\n/g;
+
 my $try_help = "Try '$prog --help' for more information.\n";
 
 my @Tests =
@@ -100,6 +121,18 @@ my @Tests =
  ['b64_1',  '--base64',       {IN=>$base64_in},     {OUT=>$base64_out}],
  ['b64_2',  '--base64 -d',    {IN=>$base64_out},    {OUT=>$base64_in}],
  ['b64_3',  '--base64 -d -i', {IN=>'&'.$base64_out},{OUT=>$base64_in}],
+ ['b64_4',  '--base64 -w0',   {IN=>$bytes_in},        {OUT=>$bytes_base64}],
+ ['b64_5',  '--base64 -d',    {IN=>$bytes_base64_nl}, {OUT=>$bytes_in}],
+ ['b64_6',  '--base64 -d -i', {IN=>join ('&', $bytes_base64 =~ /(.{1,50})/g)},
+  {OUT=>$bytes_in}],
+ ['b64_7',  '--base64 -d',    {IN=>base64_of ('a') . $bytes_base64_nl},
+  {OUT=>'a' . $bytes_in}],
+ ['b64_8',  '--base64 -d',    {IN=>substr ($bytes_base64, 0, 200) . '*'
+                                   . substr ($bytes_base64, 200)},
+  {OUT=>substr ($bytes_in, 0, 150)}, {EXIT=>1},
+  {ERR=>"$prog: invalid input\n"}],
+ # Up to coreutils-8.32, a byte was lost at each 5KiB block boundary.
+ ['b64_9',  '--base64 -d',    {IN=>'YWFh' x 50000}, {OUT=>'aaa' x 50000}],
 
  ['b64u_1', '--base64url',       {IN=>$base64_in},       {OUT=>$base64url_out}],
  ['b64u_2', '--base64url -d',  {IN=>$base64url_out},        {OUT=>$base64_in}],
@@ -150,6 +183,12 @@ my @Tests =
  ['b16_7', '--base16 -d',     {IN=>'G'}, {EXIT=>1},
   {ERR=>"$prog: invalid input\n"}],
  ['b16_8', '--base16 -d',     {IN=>"AB\nCD"}, {OUT=>"\xAB\xCD"}],
+ ['b16_9', '--base16 -w0',    {IN=>$bytes_in},        {OUT=>$bytes_base16}],
+ ['b16_10', '--base16 -d',    {IN=>$bytes_base16_nl}, {OUT=>$bytes_in}],
+ ['b16_11', '--base16 -d',    {IN=>substr ($bytes_base16, 0, 100) . 'a'
+                                   . substr ($bytes_base16, 100)},
+  {OUT=>substr ($bytes_in, 0, 50)}, {EXIT=>1},
+  {ERR=>"$prog: invalid input\n"}],
 
 
 
@@ -31,6 +31,18 @@ my @inputs = ({IN=>{a=>"1\n3\n3\n3"}}, {IN=>{b=>"2\n2\n3\n3\n3"}});
 my @zinputs = ({IN=>{za=>"1\0003\0003\0003"}},
                {IN=>{zb=>"2\0002\0003\0003\0003"}});
 
+# Inputs larger than the read buffer, ending with a line longer than it.
+my $long = 'x' x 200000;
+my @long_inputs =
+  ({IN=>{la=>join ('', map {sprintf "%06d\n", $_} grep {$_ % 2 == 0} 0..99999)
+             . "$long\n"}},
+   {IN=>{lb=>join ('', map {sprintf "%06d\n", $_} grep {$_ % 3 == 0} 0..99999)
+             . "$long\n"}});
+my $long_out = join ('', map {($_ % 2 ? "\t" : $_ % 3 ? "" : "\t\t")
+                               . sprintf "%06d\n", $_}
+                         grep {$_ % 2 == 0 || $_ % 3 == 0} 0..99999)
+  . "\t\t$long\n";
+
 my @Tests =
   (
    # basic operation
@@ -174,6 +186,9 @@ my @Tests =
    # show summary only (-123), zero-terminated and with ',' as delimiter
    ['totalz-123', '--total', '-z123', '--output-delimiter=,', @zinputs,
     {OUT=>"1,2,3,total\000"} ],
+
+   # lines spanning refills of the input buffers
+   ['long', @long_inputs, {OUT=>$long_out} ],
  );
 
 my $save_temps = $ENV{DEBUG};
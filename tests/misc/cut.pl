@@ -168,6 +168,8 @@ my @Tests =
   ['zerot-4', '-z -d:', '-f1', {IN=>"a:1\0b:2"}, {OUT=>"a\0b\0"}],
   ['zerot-5', '-z -d:', '-f1-', {IN=>"a1:\0:"}, {OUT=>"a1:\0:\0"}],
   ['zerot-6', "-z -d ''", '-f1,2', '--ou=:', {IN=>"a\0b\0"}, {OUT=>"a:b\0"}],
+  # Up to coreutils-8.32, the final NUL was omitted here.
+  ['zerot-7', '-z -f2', {IN=>"a\t"}, {OUT=>"\0"}],
 
   # New functionality:
   ['out-delim1', '-c1-3,5-', '--output-d=:', {IN=>"abcdefg\n"},
@@ -227,6 +229,22 @@ my @Tests =
                                          {IN=>"123456\n"}, {OUT=>"1\n"}],
   ['EOL-subsumed-4', '--output-d=: -b1-2,2-3,3-',
                                         {IN=>"1234\n"}, {OUT=>"1234\n"}],
+
+  # Lines and fields that span input buffer boundaries.
+  ['long-f1', '-d, -f2', {IN=>('a' x 140000) . ",b,c\n"}, {OUT=>"b\n"}],
+  ['long-f2', '-d, -f1', {IN=>('a' x 140000) . ",b\n"},
+   {OUT=>('a' x 140000) . "\n"}],
+  ['long-f3', '-s -d, -f1', {IN=>('a' x 140000) . "\nx,y\n"}, {OUT=>"x\n"}],
+  ['long-f4', '-d, -f2', {IN=>('a' x 140000) . "\n"},
+   {OUT=>('a' x 140000) . "\n"}],
+  ['long-f5', '-d, -f2-', {IN=>"x," . ('a,' x 70000) . "\n"},
+   {OUT=>('a,' x 70000) . "\n"}],
+  ['long-b1', '-b 139999-140001', {IN=>('a' x 139999) . "bcd\n"},
+   {OUT=>"abc\n"}],
+  # An unterminated last line that ends with a delimiter has an empty
+  # last field.
+  ['trailing-delim-1', '-d, -f1,2 --output-d=:', {IN=>"a,"}, {OUT=>"a:\n"}],
+  ['trailing-delim-2', '-d, -f2', {IN=>"a,\nb,"}, {OUT=>"\n\n"}],
  );
 
 if ($mb_locale ne 'C')
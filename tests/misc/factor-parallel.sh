@@ -31,4 +31,28 @@ nprimes=$(seq 1e6 | odd | split -nr/4 --filter='factor' | primes | wc -l)
 
 test "$nprimes" = '78498' || fail=1
 
+# factor --parallel outputs in the order of the input,
+# diagnosing invalid numbers in turn.
+{ seq 100000 200000; echo x; seq 10 | sed 's/$/000000000000000000000000001/';
+  echo 2 3; } > in || framework_failure_
+returns_ 1 factor < in > exp 2>&1 || fail=1
+for n in 1 2 5; do
+  returns_ 1 factor --parallel=$n < in > out 2>&1 || fail=1
+  compare exp out || fail=1
+done
+returns_ 1 factor --parallel=0 < /dev/null || fail=1
+
+# Ensure word-size numbers are buffered correctly after the output line
+# of a multi-precision number, longer than PIPE_BUF.
+if grep '^#define HAVE_GMP 1' $CONFIG_HEADER > /dev/null; then
+  { echo 4; printf '1%01100d\n' 0
+    for i in 1 2 3 4; do echo 18446744073709551615; done; } > in ||
+    framework_failure_
+  for n in $(cat in); do factor $n || fail=1; done > exp
+  for opt in '' --parallel=2; do
+    factor $opt < in > out || fail=1
+    compare exp out || fail=1
+  done
+fi
+
 Exit $fail
@@ -90,7 +90,22 @@ my @Tests =
             ['bug-gmp-2_sup_256',
              '115792089237316195423570985008687907853'
              . '269984665640564039457584007913129639936',
-             {OUT => '2 'x255 . '2'}]);
+             {OUT => '2 'x255 . '2'}],
+            # Two large factors, beyond the reach of Pollard-rho.
+            ['gmp-ecm-a', '2007092735147181038456769542069801451399389',
+             {OUT => '208212732716620097 9639625343560795262561437'}],
+            ['gmp-ecm-b', '611563244927573939368834192415671436818512191',
+             {OUT => '657809384024971 929696747689386081914396241821'}],
+            ['gmp-power',
+             '28948022309329048855892746252171976962977213799489202546401021'
+             . '394546514198529',
+             {OUT => '170141183460469231731687303715884105727 '
+                     . '170141183460469231731687303715884105727'}],
+            ['gmp-power-b',
+             '28948282842311430201280935957881669768682672781057160722194920'
+             . '058700361447637120297116166360283',
+             {OUT => '1000003 'x3 . '170141183460469231731687303715884105727 '
+                     . '170141183460469231731687303715884105727'}]);
 
 # Prepend the command line argument and append a newline to end
 # of each expected 'OUT' string.
@@ -32,6 +32,18 @@ sub t_subst ($)
   return $s;
 }
 
+# Inputs larger than the read buffer, with a line longer than it
+# and a run of matching lines that spans several refills.
+my $long = 'x' x 200000;
+my @long_in =
+  (join ('', map {sprintf "%06d a\n", $_} grep {$_ % 2 == 0} 0..99999)
+   . "$long L\n" . join ('', map {"zzz $_\n"} 1..20000),
+   join ('', map {sprintf "%06d b\n", $_} grep {$_ % 3 == 0} 0..99999)
+   . "$long R\nzzz x\nzzz y\n");
+my $long_out = join ('', map {sprintf "%06d a b\n", $_}
+                         grep {$_ % 6 == 0} 0..99999)
+  . "$long L R\n" . join ('', map {"zzz $_ x\nzzz $_ y\n"} 1..20000);
+
 my @tv = (
 # test name
 #     flags       file-1 file-2    expected output   expected return code
@@ -302,6 +314,29 @@ my @tv = (
 ['z6', '-z -t ""',
  ["a\n1\n\0", "a\n1\n\0"], "a\n1\n\0"],
 
+['long-1', '', [@long_in], $long_out, 0],
+
+# --hash joins unsorted inputs, keeping the smaller file in memory and
+# writing output in the order of the other.
+['hash-1', '--hash', ["c 3\na 1\nd 4\nb 2\na 5\n", "b x\nz y\na w\n"],
+ "a 1 w\nb 2 x\na 5 w\n", 0],
+['hash-2', '--hash', ["b x\nz y\na w\n", "c 3\na 1\nd 4\nb 2\na 5\n"],
+ "a w 1\nb x 2\na w 5\n", 0],
+['hash-3', '--hash -a1 -a2', ["c 3\na 1\nd 4\nb 2\na 5\n", "b x\nz y\na w\n"],
+ "c 3\na 1 w\nd 4\nb 2 x\na 5 w\nz y\n", 0],
+['hash-4', '--hash -v1', ["c 3\na 1\nd 4\nb 2\na 5\n", "b x\nz y\na w\n"],
+ "c 3\nd 4\n", 0],
+['hash-5', '--hash -i -t:', ["c:3\na:1\na:5\n", "A:w\n"],
+ "a:1:w\na:5:w\n", 0],
+['hash-6', '--hash --header', ["k v\nc 3\na 1\n", "k2 v2\na z\n"],
+ "k v v2\na 1 z\n", 0],
+['hash-7', '--hash --buffer-size=0', ["", ""], "", 1,
+ "$prog: 0: invalid buffer size\n"],
+# Partition both inputs to temporary files, with the minimum buffer size.
+['hash-spill', '--hash --buffer-size=1',
+ [join ('', map {"k$_ a\n"} reverse 0..49999),
+  join ('', map {"k$_ b\n"} 49999..99999)], "k49999 a b\n", 0],
+
 );
 
 # Convert the above old-style test vectors to the newer
@@ -516,6 +516,15 @@ my @Tests =
      ['dbl-to-human-32','--to=iec 102399', {OUT=>"100K"}],
      ['dbl-to-human-33','--to=iec-i 102399', {OUT=>"100Ki"}],
 
+     # Integral values are converted with integer arithmetic
+     ['dbl-to-human-34','--to=si 999999999999999999', {OUT=>"1.0E"}],
+     ['dbl-to-human-35','--to=iec-i 1048575', {OUT=>"1.0Mi"}],
+     ['dbl-to-human-36','--to=si --round=towards-zero 999999',
+             {OUT=>"999K"}],
+     ['dbl-to-human-37','--to=iec --round=down -- -1025', {OUT=>"-1.1K"}],
+     ['dbl-to-human-38','--to=si --round=up -- -1999', {OUT=>"-1.9K"}],
+     ['dbl-to-human-39','-- -0', {OUT=>"0"}],
+
 
      # Default --round=from-zero
      ['round-1','--to-unit=1024 -- 6000 -6000',
@@ -40,6 +40,10 @@ while (defined (my $line = <FH>))
 close FH;
 my $proc_file_byte_count = $len;
 
+# Input with the extreme values of each integer width.
+my $ext = "\000\177\200\377\001\011\012\200"
+  . "\000\000\000\200\377\377\377\377";
+
 my @Tests =
     (
      # Skip the exact length of the input file.
@@ -64,6 +68,38 @@ my @Tests =
      ['wide-a',   '-a -w65537 -An', {IN=>{g=>'x'}}, {OUT=>"   x\n"}],
      ['wide-c',   '-c -w65537 -An', {IN=>{g=>'x'}}, {OUT=>"   x\n"}],
      ['wide-x', '-tx1 -w65537 -An', {IN=>{g=>'B'}}, {OUT=>" 42\n"}],
+
+     # Exercise the integer formatting at the extremes of each type.
+     ['int-d1', '-An -td1', {IN=>{g=>$ext}},
+      {OUT=>"    0  127 -128   -1    1    9   10 -128"
+            . "    0    0    0 -128   -1   -1   -1   -1\n"}],
+     ['int-u1', '-An -tu1', {IN=>{g=>$ext}},
+      {OUT=>"   0 127 128 255   1   9  10 128   0   0   0 128 255 255 255 255\n"}],
+     ['int-o1', '-An -to1', {IN=>{g=>$ext}},
+      {OUT=>" 000 177 200 377 001 011 012 200 000 000 000 200 377 377 377 377\n"}],
+     ['int-u2', '-An -tu2 --endian=big', {IN=>{g=>$ext}},
+      {OUT=>"   127 33023   265  2688     0   128 65535 65535\n"}],
+     ['int-d2', '-An -td2 --endian=little', {IN=>{g=>$ext}},
+      {OUT=>"  32512   -128   2305 -32758      0 -32768     -1     -1\n"}],
+     ['int-d4', '-An -td4 --endian=big', {IN=>{g=>$ext}},
+      {OUT=>"     8356095    17369728         128          -1\n"}],
+     ['int-o4', '-An -to4 --endian=little', {IN=>{g=>$ext}},
+      {OUT=>" 37740077400 20002404401 20000000000 37777777777\n"}],
+     ['int-u8', '-An -tu8 --endian=little', {IN=>{g=>$ext}},
+      {OUT=>"  9226196690808110848 18446744071562067968\n"}],
+     ['int-d8', '-An -td8 --endian=little', {IN=>{g=>$ext}},
+      {OUT=>" -9220547382901440768          -2147483648\n"}],
+     ['int-x8z', '-An -to8 -tx8z --endian=little', {IN=>{g=>$ext}},
+      {OUT=>" 1000120220077740077400 1777777777760000000000\n"
+            . "       800a0901ff807f00       ffffffff80000000  >................<\n"}],
+     ['int-mixed', '-w6 -tx2 -td1 --endian=little', {IN=>{g=>$ext}},
+      {OUT=>"0000000      7f00      ff80      0901\n"
+            . "           0  127 -128   -1    1    9\n"
+            . "0000006      800a      0000      8000\n"
+            . "          10 -128    0    0    0 -128\n"
+            . "0000014      ffff      ffff\n"
+            . "          -1   -1   -1   -1\n"
+            . "0000020\n"}],
     );
 
 my $save_temps = $ENV{DEBUG};
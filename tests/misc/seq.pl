@@ -156,6 +156,20 @@ my @Tests =
    ['fast-4', qw(1 2 4), {OUT => [qw(1 3)]}],
    ['fast-5', qw(1 4 4), {OUT => [qw(1)]}],
    ['fast-6', qw(1 1e0 4), {OUT => [qw(1 2 3 4)]}],
+   ['fast-7', qw(-3 -1), {OUT => [qw(-3 -2 -1)]}],
+   ['fast-8', qw(-0.3 0.15 0.3), {OUT => [qw(-0.30 -0.15 0.00 0.15 0.30)]}],
+   ['fast-9', qw(-w -10 7 20), {OUT => [qw(-10 -03 004 011 018)]}],
+   ['fast-10', qw(-w 1 -0.25 -1.0001),
+    {OUT => [qw(01.00 00.75 00.50 00.25 00.00 -0.25 -0.50 -0.75 -1.00)]}],
+   ['fast-11', qw(-s :: -2 0.5 0), {OUT => ['-2.0::-1.5::-1.0::-0.5::0.0']}],
+   ['fast-12', qw(1 7 30), {OUT => [qw(1 8 15 22 29)]}],
+   ['fast-13', qw(95 0.5 100.2),
+    {OUT => [qw(95.0 95.5 96.0 96.5 97.0 97.5 98.0 98.5 99.0 99.5 100.0)]}],
+   # Decimal operands are handled exactly, however many digits they have.
+   ['exact-1', qw(1 0.0000000000000000001 1.0000000000000000003),
+    {OUT => [qw(1.0000000000000000000 1.0000000000000000001
+                1.0000000000000000002 1.0000000000000000003)]}],
+   ['exact-2', "-$r -$p", {OUT => ["-$r", "-$q", "-$p"]}],
 
    # Ensure an INCREMENT of Zero is rejected.
    ['inc-zero-1',	qw(1 0 10), {EXIT => 1}, {ERR => $err_inc_zero}],
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Exercise shred --parallel=N.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ shred
+
+# Several buffers of random data, and a partial one.
+size=3500000
+head -c $size /dev/zero > zero || framework_failure_
+cp zero f || framework_failure_
+
+shred -n2 -x --parallel=3 f || fail=1
+test $(stat --printf=%s f) = $size || fail=1
+cmp zero f > /dev/null && fail=1
+
+# Two random passes write different data.
+cp f g || framework_failure_
+shred -n1 -x --parallel=2 f || fail=1
+cmp f g > /dev/null && fail=1
+
+# The pattern passes are not affected.
+shred -n0 -z -x --parallel=2 f || fail=1
+compare zero f || fail=1
+
+# With --random-source, the data written depends only on that source.
+seq 100000 > src || framework_failure_
+head -c 100000 /dev/zero > f || framework_failure_
+cp f g || framework_failure_
+shred -n3 -x --random-source=src f || fail=1
+shred -n3 -x --random-source=src --parallel=2 g || fail=1
+compare f g || fail=1
+
+returns_ 1 shred --parallel=0 f 2> err || fail=1
+grep 'invalid number of threads' err || fail=1
+
+Exit $fail
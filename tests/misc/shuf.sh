@@ -170,6 +170,47 @@ printf "A\nB\nC\nD\nE\n" | shuf --rep -n0 > exp || framework_failure_
 test \! -s exp ||
   { fail=1; echo "--repeat,STDIN,-n0 produced bad output">&2 ; }
 
+# Input larger than the buffer is shuffled through temporary files.
+seq 200000 > in || framework_failure_
+for opt in '' --parallel=1 --parallel=3; do
+  shuf -S 1 $opt in > out || { fail=1; echo "shuf -S 1 $opt failed">&2; }
+  compare in out > /dev/null &&
+    { fail=1; echo "shuf -S 1 $opt did not permute">&2; }
+  sort -n out > out1 || framework_failure_
+  compare in out1 || { fail=1; echo "shuf -S 1 $opt lost lines">&2; }
+done
+cat in | shuf -S 1 | sort -n > out1 || fail=1
+compare in out1 || { fail=1; echo "shuf -S 1 from a pipe lost lines">&2; }
+tr '\n' '\0' < in | shuf -z -S 1 | tr '\0' '\n' | sort -n > out1 || fail=1
+compare in out1 || { fail=1; echo "shuf -z -S 1 lost lines">&2; }
+
+# With --random-source, the result is reproducible.
+shuf -S 1 --parallel=3 --random-source=in in > out || fail=1
+shuf -S 1 --parallel=3 --random-source=in in > out1 || fail=1
+compare out out1 || { fail=1; echo "shuf -S 1 not reproducible">&2; }
+
+# An unusable temporary directory is diagnosed.
+returns_ 1 env TMPDIR=$PWD/no-such-dir shuf -S 1 in > /dev/null 2> err ||
+  fail=1
+grep 'cannot create temporary file' err > /dev/null || fail=1
+
+returns_ 1 shuf -S 0 < /dev/null || fail=1
+returns_ 1 shuf --parallel=0 < /dev/null || fail=1
+
+# Reservoir sampling, as used with -n for large or unseekable input,
+# outputs distinct whole lines, skipping lines longer than its buffer.
+{ seq 100000; printf 'x'; } | shuf -n 200000 | sort > out || fail=1
+{ seq 100000; echo x; } | sort | compare - out ||
+  { fail=1; echo "shuf -n lost lines">&2; }
+seq 100000 | shuf -n 1000 | sort -u | wc -l > out || framework_failure_
+echo 1000 | compare - out || { fail=1; echo "shuf -n repeated lines">&2; }
+for i in 1 2 3 4 5; do
+  printf "%0200000d\n" $i || framework_failure_
+done > long || framework_failure_
+cat long | shuf -n 2 | sort > out || fail=1
+test $(wc -c < out) -eq 400002 && grep -Fx -f out long > /dev/null ||
+  { fail=1; echo "shuf -n mishandled long lines">&2; }
+
 # shuf 8.25 mishandles input if stdin is closed, due to glibc bug#15589.
 # See coreutils bug#25029.
 shuf /dev/null <&- >out || fail=1
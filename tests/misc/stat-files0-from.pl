@@ -0,0 +1,92 @@
+#!/usr/bin/perl
+# Exercise stat's --files0-from and --parallel options.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+use strict;
+
+(my $program_name = $0) =~ s|.*/||;
+
+my $prog = 'stat';
+
+# Turn off localization of executable's output.
+@ENV{qw(LANGUAGE LANG LC_ALL)} = ('C') x 3;
+
+my $names = join '', map { "f$_\0" } 1..300;
+my $exp = join '', map { "f$_ 0\n" } 1..300;
+
+my @Tests =
+  (
+   # invalid extra command line argument
+   ['f-extra-arg', '--files0-from=- no-such', {IN=>"a"}, {EXIT=>1},
+    {ERR => "$prog: extra operand 'no-such'\n"
+        . "file operands cannot be combined with --files0-from\n"
+        . "Try '$prog --help' for more information.\n"}
+    ],
+
+   # missing input file
+   ['missing', '--files0-from=missing', {EXIT=>1},
+    {ERR => "$prog: cannot open 'missing' for reading: "
+     . "No such file or directory\n"}],
+
+   # input file name of '-'
+   ['minus-in-stdin', '--files0-from=-', '<', {IN=>{f=>'-'}}, {EXIT=>1},
+    {ERR => "$prog: when reading file names from stdin, no file name of"
+     . " '-' allowed\n"}],
+
+   # empty input
+   ['empty', '--files0-from=@AUX@', {AUX=>''}],
+   ['empty-nonreg', '--files0-from=/dev/null'],
+
+   # one NUL
+   ['nul-1', '--files0-from=-', '<', {IN=>"\0"}, {EXIT=>1},
+    {ERR => "$prog: -:1: invalid zero-length file name\n"}],
+
+   # one file name, no NUL
+   ['1', '-c "%n %s"', '--files0-from=-', '<',
+    {IN=>{f=>"g"}}, {AUX=>{g=>''}}, {OUT=>"g 0\n"}],
+
+   # two file names, with final NUL; a file is listed each time
+   ['2a', '-c "%n %s"', '--files0-from=-', '<',
+    {IN=>{f=>"g\0g\0"}}, {AUX=>{g=>''}}, {OUT=>"g 0\ng 0\n"}],
+
+   # Ensure that $prog processes FILEs following a zero-length name,
+   # and reports errors in order.
+   ['zero-len', '-c %n', '--files0-from=-', '<',
+    {IN=>{f=>"g\0\0no-such\0g\0"}}, {AUX=>{g=>''}},
+    {OUT=>"g\ng\n"},
+    {ERR => "$prog: -:2: invalid zero-length file name\n"
+     . "$prog: cannot stat 'no-such': No such file or directory\n"},
+    {ERR_SUBST => 's/cannot statx/cannot stat/'}, {EXIT=>1} ],
+
+   # Many files, statted by helper threads, are output in order.
+   ['parallel', '--parallel=3 -c "%n %s"', '--files0-from=-', '<',
+    {IN=>{f=>$names}}, (map { {AUX=>{"f$_"=>''}} } 1..300), {OUT=>$exp}],
+   ['parallel-args', '--parallel=2 --printf="%n\n" f1 f2 f3',
+    {AUX=>{f1=>''}}, {AUX=>{f2=>''}}, {AUX=>{f3=>''}},
+    {OUT=>"f1\nf2\nf3\n"}],
+   # --parallel does not make the abbreviation --p ambiguous.
+   ['p-printf', q{--p='%n\n' f1}, {AUX=>{f1=>''}}, {OUT=>"f1\n"}],
+   ['parallel-0', '--parallel=0 f1', {EXIT=>1},
+    {ERR => "$prog: invalid number of threads: '0': "
+     . "Numerical result out of range\n"}],
+  );
+
+my $save_temps = $ENV{DEBUG};
+my $verbose = $ENV{VERBOSE};
+
+my $fail = run_tests ($program_name, $prog, \@Tests, $save_temps, $verbose);
+exit $fail;
@@ -71,12 +71,22 @@ my @Tests =
    {IN=>".__x.___y.____z._1._2.__3.___4"},
    {OUT=>".___4.__3._2._1.____z.___y.__x"}],
 
-  ['pipe-bad-tmpdir',
+  # Nonseekable input is copied to a temporary file only when it
+  # does not fit in memory, or when the separator is a regex.
+  ['pipe-bad-tmpdir', qw(-r -s '\n'),
    {ENV => "TMPDIR=$bad_dir"},
    {IN_PIPE => "a\n"},
    {ERR_SUBST => "s,'$bad_dir': .*,...,"},
    {ERR => "$prog: failed to create temporary file in ...\n"},
    {EXIT => 1}],
+  ['pipe-mem',
+   {ENV => "TMPDIR=$bad_dir"},
+   {IN_PIPE => "a\nb\n"}, {OUT => "b\na\n"}],
+
+  # Matches of a separator of several bytes do not overlap,
+  # even where they straddle the boundary of a read.
+  ['opt-s-overlap', qw(-s 99), {IN=>"x" x 8191 . "999y"},
+   {OUT=>"y" . "x" x 8191 . "999"}],
 
   # coreutils-8.5's tac would double-free its primary buffer.
   ['double-free', {IN=>$long_line}, {OUT=>$long_line}],
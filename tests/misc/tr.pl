@@ -158,6 +158,27 @@ my @Tests =
 
   # Up to coreutils-6.9, this would provoke a failed assertion.
   ['no-abort-1', qw(-c a '[b*256]'), {IN=>'abc'}, {OUT=>'abb'}],
+
+  # Inputs longer than a vector, to exercise the block kernels
+  # and their handling of a partial final block.
+  ['blk-upper', qw(a-z A-Z), {IN=>'Hello, world! ' x 9},
+   {OUT=>'HELLO, WORLD! ' x 9}],
+  ['blk-rot13', qw(a-zA-Z n-za-mN-ZA-M), {IN=>'Uryyb, jbeyq! ' x 9},
+   {OUT=>'Hello, world! ' x 9}],
+  ['blk-high', qw('\\200-\\377' a), {IN=>"a\x80b\xffc" x 7},
+   {OUT=>'aabac' x 7}],
+  ['blk-del-cr', qw(-d '\\r'), {IN=>"line\r\n\r\r" x 11},
+   {OUT=>"line\n" x 11}],
+  ['blk-del-digit', qw(-d '[:digit:]'), {IN=>'a1b22c333d4444' x 5},
+   {OUT=>'abcd' x 5}],
+  ['blk-del-compl', qw(-cd a-c), {IN=>'xaxbxcxdxexf' x 7},
+   {OUT=>'abc' x 7}],
+  ['blk-squeeze', '-s', "' '", {IN=>'a  b   c    ' x 9},
+   {OUT=>'a b c ' x 9}],
+  ['blk-squeeze-edge', qw(-s x), {IN=>('y' x 15) . 'xxy' . ('y' x 14) . 'xx'},
+   {OUT=>('y' x 15) . 'xy' . ('y' x 14) . 'x'}],
+  ['blk-ds', '-ds', "'\\r'", "' '", {IN=>"a \r b\r\n" x 9},
+   {OUT=>"a b\n" x 9}],
 );
 
 @Tests = triple_test \@Tests;
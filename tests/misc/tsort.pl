@@ -31,6 +31,15 @@ my @Tests =
    ['cycle-2', {IN => {f => "t x\nt s\ns t\n"}}, {OUT => "s\nt\nx\n"},
     {EXIT => 1},
     {ERR => "tsort: f: input contains a loop:\ntsort: s\ntsort: t\n"} ],
+   ['cycle-3', {IN => {f => "a b b a c d d c\n"}}, {OUT => "a\nb\nc\nd\n"},
+    {EXIT => 1},
+    {ERR => "tsort: f: input contains a loop:\ntsort: a\ntsort: b\n"
+     . "tsort: f: input contains a loop:\ntsort: c\ntsort: d\n"} ],
+   ['cycle-4', {IN => {f => "x y y z z x z w x y\n"}},
+    {OUT => "x\ny\nz\nw\n"},
+    {EXIT => 1},
+    {ERR => "tsort: f: input contains a loop:\ntsort: x\ntsort: y\n"
+     . "tsort: z\n"} ],
 
    ['posix-1', {IN => "a b c c d e\ng g\nf g e f\nh h\n"},
     {OUT => "a\nc\nd\nh\nb\ne\nf\ng\n"}],
@@ -228,6 +228,33 @@ my @Tests =
         "  - 'separate'\n" .
         "  - 'both'\n" .
         "Try '$prog --help' for more information.\n"}],
+ # Test --hash, which detects non-adjacent repeated lines.
+ ['hash-1', '--hash', {IN=>"b\na\nb\nc\na\nb\n"}, {OUT=>"b\na\nc\n"}],
+ ['hash-2', '--hash -c', {IN=>"b\na\nb\nc\na\nb\n"},
+  {OUT=>"      3 b\n      2 a\n      1 c\n"}],
+ ['hash-3', '--hash=count -c', {IN=>"a\nb\nc\nb\nc\nc\nd\n"},
+  {OUT=>"      3 c\n      2 b\n      1 a\n      1 d\n"}],
+ ['hash-4', '--hash -d', {IN=>"b\na\nb\nc\na\nb\n"}, {OUT=>"b\na\n"}],
+ ['hash-5', '--hash -u', {IN=>"b\na\nb\nc\na\nb\n"}, {OUT=>"c\n"}],
+ ['hash-6', '--hash -i -f1', {IN=>"1 A\n2 b\n3 a\n4 B\n5 c"},
+  {OUT=>"1 A\n2 b\n5 c\n"}],
+ ['hash-7', '--hash -s1 -w2', {IN=>"xab1\nyab2\nxac3\n"},
+  {OUT=>"xab1\nxac3\n"}],
+ ['hash-8', '--hash -D', {IN=>""}, {OUT=>""}, {EXIT=>1},
+  {ERR=>"$prog: --hash is mutually exclusive with -D and --group\n" .
+        "Try 'uniq --help' for more information.\n"}],
+ ['hash-9', '--hash --buffer-size=0', {IN=>""}, {OUT=>""}, {EXIT=>1},
+  {ERR=>"$prog: 0: invalid buffer size\n"}],
+ # Spill to temporary files, with the minimum buffer size.
+ ['hash-spill', '--hash=count -c --buffer-size=1',
+  {IN=>join ('', map {"k" . ($_ % 20000) . "\n"} 0..59999) . "k5\n"},
+  {OUT=>"      4 k5\n"
+        . join ('', map {"      3 k$_\n"} grep {$_ != 5} 0..19999)}],
+ # Lines longer than the input buffer, and groups spanning its refills.
+ ['long-1', {IN=>("a" x 200000 . "\n") x 3 . "b\n"},
+  {OUT=>"a" x 200000 . "\nb\n"}],
+ ['long-2', '-c', {IN=>"x\n" x 100000}, {OUT=>" 100000 x\n"}],
+ ['long-3', '-f1', {IN=>join ('', map {"$_ k\n"} 1..50000)}, {OUT=>"1 k\n"}],
 );
 
 # Locale related tests
@@ -37,6 +37,7 @@ cat > k.c <<\EOF || framework_failure_
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 struct dirent *readdir (DIR *dirp)
 {
@@ -86,6 +87,56 @@ struct dirent *readdir (DIR *dirp)
   errno = ENOENT;
   return NULL;
 }
+
+/* On GNU/Linux, fts reads directories with getdents64 rather than
+   readdir, so simulate its failure too, likewise.  */
+ssize_t getdents64 (int fd, void *buf, size_t nbytes)
+{
+  static int count = 1;
+
+  static ssize_t (*real_getdents64)(int fd, void *buf, size_t nbytes);
+  if (! real_getdents64
+      && ! (real_getdents64 = dlsym (RTLD_NEXT, "getdents64")))
+    {
+      fprintf (stderr, "Failed to find getdents64()\n");
+      errno = ESRCH;
+      return -1;
+    }
+
+  /* Return the entries of the first read, renamed to trigger partial
+     read failure, ensuring we don't return ignored '.' or '..'  */
+  if (count++ == 1)
+    {
+      ssize_t n = real_getdents64 (fd, buf, nbytes);
+      if (n <= 0)
+        {
+          fprintf (stderr, "Failed to get dirent\n");
+          errno = ENOENT;
+          return -1;
+        }
+
+      /* Flag that LD_PRELOAD and above functions work.  */
+      fclose (fopen ("preloaded", "w"));
+
+      char const *readdir_partial = getenv ("READDIR_PARTIAL");
+      if (readdir_partial && *readdir_partial)
+        {
+          int i = 1;
+          for (char *p = buf; p < (char *) buf + n; )
+            {
+              struct dirent64 *d = (struct dirent64 *) p;
+              i++;
+              d->d_name[0]='0'+i; d->d_name[1]='\0';
+              p += d->d_reclen;
+            }
+          return n;
+        }
+    }
+
+  /* Fail.  */
+  errno = ENOENT;
+  return -1;
+}
 EOF
 
 # Then compile/link it:
@@ -63,4 +63,21 @@ for file in input /proc/version /sys/kernel/profiling; do
   test -f xad && fail=1
 done
 
+# Byte chunks of a regular file may be copied without reading them.
+# Ensure that gives the same pieces as reading from a pipe,
+# including when the input starts at a nonzero offset.
+rm -f x?? || framework_failure_
+seq 100000 > in || framework_failure_
+split -b 100000 in || fail=1
+cat x?? | compare - in || fail=1
+for k in 1 4 7; do
+  split -n $k/7 in > k-reg || fail=1
+  split -n $k/7 in | cat > k-pipe || fail=1
+  compare k-reg k-pipe || fail=1
+done
+rm -f x?? || framework_failure_
+(dd bs=1000 skip=1 count=0 && split -b 100000) < in || fail=1
+tail -c +1001 in > exp || framework_failure_
+cat x?? | compare exp - || fail=1
+
 Exit $fail
@@ -0,0 +1,65 @@
+#!/bin/sh
+# Exercise split's --parallel option, running --filter commands at once.
+
+# Copyright (C) 2020 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ split
+
+seq 100000 > in || framework_failure_
+
+# The output must not depend on the number of commands run at once.
+for mode in '-l 999' '-b 7777' '-C 5000' '-n 8' '-n l/8' '-n r/5' \
+            '-e -n r/300'; do
+  for jobs in 1 3; do
+    mkdir out-$jobs || framework_failure_
+    (cd out-$jobs &&
+     split $mode --parallel=$jobs --filter='cat > $FILE' ../in) || fail=1
+  done
+  diff -r out-1 out-3 || fail=1
+  rm -rf out-1 out-3 || framework_failure_
+done
+
+# Ensure commands do run at once.
+printf '%s\n' 1 2 3 > exp || framework_failure_
+seq 3 | timeout 10 split -l1 --parallel=3 \
+  --filter='echo $FILE > $FILE.started
+            while test $(ls x??.started | wc -l) -lt 3; do sleep .1; done
+            cat > $FILE' || fail=1
+cat xa? > out || framework_failure_
+compare exp out || fail=1
+rm -f x* || framework_failure_
+
+# Ensure that "endless" input is ignored when all filters finish.
+yes | timeout 10 split --parallel=2 --filter='head -c1 >$FILE.n' -n r/3 \
+  || fail=1
+stat -c%s x??.n > stat.out || framework_failure_
+printf '%s\n' 1 1 1 > stat.exp || framework_failure_
+compare stat.exp stat.out || fail=1
+
+# Ensure the failure of a command is diagnosed.
+seq 10 | returns_ 3 split -l2 --parallel=3 --filter='exit 3' 2>err || fail=1
+printf '%s\n' "split: with FILE=xaa, exit 3 from command: exit 3" > exp \
+  || framework_failure_
+compare exp err || fail=1
+
+returns_ 1 split --parallel=0 /dev/null 2>/dev/null || fail=1
+
+# --parallel without --filter would run nothing at once.
+returns_ 1 split --parallel=2 /dev/null 2>err || fail=1
+grep -- '--parallel is only valid with --filter' err || fail=1
+
+Exit $fail